@@ -58,6 +58,29 @@ default for subsequent invocations of Stellarium.
 Set the directory into which screenshots will be saved to I<dir>, 
 instead of the default (which is $HOME on *nix operating systems).
 
+=item B<--headless>
+
+Render frames without showing the window, in an offscreen framebuffer, save
+them as F<frame-00000.png>, F<frame-00001.png>... in the screenshot directory
+and quit. The program time advances by a fixed step between frames, whatever
+the time needed to draw them, so the same frames are rendered on every run.
+The OpenGL context still comes from the Qt platform plugin, use e.g.
+B<-platform offscreen> or a software OpenGL driver on machines without display.
+
+=item B<--frame-size> I<width>xI<height>
+
+Size of the headless frames in pixels, by default 1920x1080. It may be larger
+than the screen, up to the maximum render buffer size of the OpenGL driver.
+
+=item B<--frame-step> I<seconds>
+
+Program time between two headless frames, by default 0.04 s (25 frames per second).
+
+=item B<--frame-count> I<n>
+
+Number of headless frames to render, by default 1. With 0, frames are rendered
+until the startup script has finished.
+
 =item B<--startup-script> I<script>
 
 Specify name of startup script.
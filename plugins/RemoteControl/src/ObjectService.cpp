@@ -20,10 +20,13 @@
 #include "ObjectService.hpp"
 
 #include "SearchDialog.hpp"
+#include "SolarSystem.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
 #include "StelObjectMgr.hpp"
 #include "StelTranslator.hpp"
+#include "StelUtils.hpp"
 
 #include <QEventLoop>
 #include <QJsonArray>
@@ -35,12 +38,16 @@
 #include <QRunnable>
 #include <QWaitCondition>
 
+//limit of the number of dates of an ephemeris request
+static const double maxEphemerisEntries = 1000000.;
+
 ObjectService::ObjectService(const QByteArray &serviceName, QObject *parent) : AbstractAPIService(serviceName,parent)
 {
 	//this is run in the main thread
 	core = StelApp::getInstance().getCore();
 	objMgr = &StelApp::getInstance().getStelObjectMgr();
 	useStartOfWords = StelApp::getInstance().getSettings()->value("search/flag_start_words", false).toBool();
+	qRegisterMetaType<EphemerisEngine::Request>();
 }
 
 QStringList ObjectService::performSearch(const QString &text)
@@ -195,10 +202,66 @@ void ObjectService::getImpl(const QByteArray& operation, const APIParameters &pa
 			response.writeRequestError("missing type parameter");
 		}
 	}
+	else if(operation == "ephemeris")
+	{
+		//computes the positions of a solar system body over a range of dates
+		QString name = QString::fromUtf8(parameters.value("name"));
+		bool okFrom, okTo, okStep;
+		double fromJD = QString::fromUtf8(parameters.value("from")).toDouble(&okFrom);
+		double toJD = QString::fromUtf8(parameters.value("to")).toDouble(&okTo);
+		double step = QString::fromUtf8(parameters.value("step")).toDouble(&okStep);
+
+		if(name.isEmpty() || !okFrom || !okTo || !okStep)
+		{
+			response.writeRequestError("need parameters name, from, to, step");
+			return;
+		}
+		if(step <= 0. || toJD < fromJD || (toJD - fromJD) / step >= maxEphemerisEntries)
+		{
+			response.writeRequestError("invalid range of dates or step");
+			return;
+		}
+
+		EphemerisEngine::Request request;
+		QMetaObject::invokeMethod(this,"prepareEphemeris",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_RETURN_ARG(EphemerisEngine::Request,request),
+					  Q_ARG(QString,name),
+					  Q_ARG(double,fromJD),
+					  Q_ARG(double,step),
+					  Q_ARG(int,(int)((toJD - fromJD) / step) + 1));
+
+		if(!request.isValid())
+		{
+			response.setStatus(404,"not found");
+			response.setData("solar system object name not found");
+			return;
+		}
+
+		//the positions are computed here in the HTTP thread, without blocking the main thread
+		const QVector<EphemerisEngine::Entry> entries = EphemerisEngine::compute(request);
+		QJsonArray arr;
+		double ra, dec;
+		foreach(const EphemerisEngine::Entry& e, entries)
+		{
+			StelUtils::rectToSphe(&ra, &dec, e.j2000Pos);
+			QJsonObject obj;
+			obj.insert("jd", e.JD);
+			obj.insert("jde", e.JDE);
+			obj.insert("raJ2000", ra*180./M_PI);
+			obj.insert("decJ2000", dec*180./M_PI);
+			obj.insert("distance", e.distance);
+			obj.insert("phase-angle", e.phaseAngle);
+			obj.insert("elongation", e.elongation);
+			obj.insert("vmag", e.magnitude);
+			arr.append(obj);
+		}
+
+		response.writeJSON(QJsonDocument(arr));
+	}
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: find,info,listobjecttypes,listobjectsbytype");
+		response.writeRequestError("unsupported operation. GET: find,info,listobjecttypes,listobjectsbytype,ephemeris");
 	}
 }
 
@@ -214,3 +277,11 @@ QString ObjectService::getInfoString(const StelObjectP obj)
 {
 	return obj->getInfoString(core);
 }
+
+EphemerisEngine::Request ObjectService::prepareEphemeris(const QString &name, double fromJD, double step, int count)
+{
+	PlanetP obj = GETSTELMODULE(SolarSystem)->searchByEnglishName(name);
+	if(!obj)
+		return EphemerisEngine::Request();
+	return EphemerisEngine::prepare(obj, fromJD, step, count);
+}
@@ -21,6 +21,7 @@
 #define OBJECTSERVICE_HPP_
 
 #include "AbstractAPIService.hpp"
+#include "EphemerisEngine.hpp"
 #include "StelObjectType.hpp"
 
 #include <QStringList>
@@ -56,6 +57,9 @@ private slots:
 
 	//! Wrapper around obj->getInfoString
 	QString getInfoString(const StelObjectP obj);
+
+	//! Wrapper around EphemerisEngine::prepare, for the solar system body with the english name \p name
+	EphemerisEngine::Request prepareEphemeris(const QString& name, double fromJD, double step, int count);
 private:
 	StelCore* core;
 	StelObjectMgr* objMgr;
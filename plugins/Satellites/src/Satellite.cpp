@@ -87,6 +87,10 @@ Satellite::Satellite(const QString& identifier, const QVariantMap& map)
 	, phaseAngle(0.)
 	, lastEpochCompForOrbit(0.)
 	, epochTime(0.)
+	, angularSpeed(0.)
+	, observerData()
+	, orbitHead(0)
+	, orbitObserverChanged(false)
 {
 	// return initialized if the mandatory fields are not present
 	if (identifier.isEmpty())
@@ -425,7 +429,7 @@ float Satellite::getVMagnitude(const StelCore* core) const
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
 				myText = "";
 #endif
-				Vec3d Sun3d = pSatWrapper->getSunECIPos();
+				Vec3d Sun3d = pSatWrapper->getSunECIPos(observerData);
 				QVector3D sun(Sun3d.data()[0],Sun3d.data()[1],Sun3d.data()[2]);
 				QVector3D sunN = sun; sunN.normalize();
 
@@ -512,15 +516,14 @@ float Satellite::getVMagnitude(const StelCore* core) const
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-					StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
 					Vec3d topoRSunPos;
 					Vec3d observerECIPos;
 					Vec3d observerECIVel;
 
-					double  radLatitude    = loc.latitude * KDEG2RAD;
-					double  theta          = pSatWrapper->getEpoch().toThetaLMST(loc.longitude * KDEG2RAD);
+					double  radLatitude    = observerData.latitude;
+					double  theta          = pSatWrapper->getEpoch().toThetaLMST(observerData.longitude);
 
-					pSatWrapper->calcObserverECIPosition(observerECIPos, observerECIVel);
+					pSatWrapper->calcObserverECIPosition(observerData, observerECIPos, observerECIVel);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
 					myText += "ObsPos = " + observerECIPos.toString() + " (" + observerECIPos.toStringLonLat() + ")<br>\n";
 					myText += "ObsVel = " + observerECIVel.toString() + " (" + observerECIVel.toStringLonLat() + ")<br>\n";
@@ -645,8 +648,8 @@ void Satellite::setNewTleElements(const QString& tle1, const QString& tle2)
 	tleElements.second.append(tle2);
 
 	pSatWrapper = new gSatWrapper(id, tle1, tle2);
+	epochTime = 0.; // force the next computation
 	orbitPoints.clear();
-	visibilityPoints.clear();
 	
 	parseInternationalDesignator(tle1);
 }
@@ -656,37 +659,63 @@ void Satellite::update(double)
 	if (pSatWrapper && orbitValid)
 	{
 		StelCore* core = StelApp::getInstance().getCore();
-		epochTime = core->getJD() + timeShift; // We have "true" JD from core, satellites don't need JDE!
+		// We have "true" JD from core, satellites don't need JDE!
+		computePosition(core->getJD() + timeShift, gSatWrapper::getObserverData());
 
-		pSatWrapper->setEpoch(epochTime);
-		position                 = pSatWrapper->getTEMEPos();
-		velocity                 = pSatWrapper->getTEMEVel();
-		latLongSubPointPosition  = pSatWrapper->getSubPoint();
-		height                   = latLongSubPointPosition[2];
-		if (height <= 0.0)
-		{
-			// The orbit is no longer valid.  Causes include very out of date
-			// TLE, system date and time out of a reasonable range, and orbital
-			// degradation and re-entry of a satellite.  In any of these cases
-			// we might end up with a problem - usually a crash of Stellarium
-			// because of a div/0 or something.  To prevent this, we turn off
-			// the satellite.
-			qWarning() << "Satellite has invalid orbit:" << name << id;
-			orbitValid = false;
-			displayed = false; // He shouldn't be displayed!
-			return;
-		}
-
-		elAzPosition             = pSatWrapper->getAltAz();
-		elAzPosition.normalize();
+		// Compute orbit points to draw orbit line.
+		if (orbitValid && orbitDisplayed) computeOrbitPoints();
+	}
+}
 
-		pSatWrapper->getSlantRange(range, rangeRate);
-		visibility = pSatWrapper->getVisibilityPredict();
-		phaseAngle = pSatWrapper->getPhaseAngle();
+void Satellite::computePosition(double epoch, const gSatObserverData& observer)
+{
+	if (!pSatWrapper || !orbitValid)
+		return;
 
-		// Compute orbit points to draw orbit line.
-		if (orbitDisplayed) computeOrbitPoints();
+	epochTime = epoch;
+	observerData = observer;
+	pSatWrapper->setEpoch(epochTime);
+	position                 = pSatWrapper->getTEMEPos();
+	velocity                 = pSatWrapper->getTEMEVel();
+	latLongSubPointPosition  = pSatWrapper->getSubPoint();
+	height                   = latLongSubPointPosition[2];
+	if (height <= 0.0)
+	{
+		// The orbit is no longer valid.  Causes include very out of date
+		// TLE, system date and time out of a reasonable range, and orbital
+		// degradation and re-entry of a satellite.  In any of these cases
+		// we might end up with a problem - usually a crash of Stellarium
+		// because of a div/0 or something.  To prevent this, we turn off
+		// the satellite.
+		qWarning() << "Satellite has invalid orbit:" << name << id;
+		orbitValid = false;
+		displayed = false; // He shouldn't be displayed!
+		return;
 	}
+
+	elAzPosition             = pSatWrapper->getAltAz(observer);
+	elAzPosition.normalize();
+
+	pSatWrapper->getSlantRange(observer, range, rangeRate);
+	visibility = pSatWrapper->getVisibilityPredict(observer);
+	phaseAngle = pSatWrapper->getPhaseAngle(observer);
+
+	// Apparent angular speed: the component of the relative velocity
+	// perpendicular to the line of sight, divided by the range.
+	Vec3d observerECIPos, observerECIVel;
+	pSatWrapper->calcObserverECIPosition(observer, observerECIPos, observerECIVel);
+	const Vec3d slantRange = position - observerECIPos;
+	const Vec3d slantRangeVelocity = velocity - observerECIVel;
+	angularSpeed = (slantRange^slantRangeVelocity).length() / (range*range);
+}
+
+bool Satellite::needsUpdate(double epoch, double threshold) const
+{
+	// Keep the position for at most this time, measured in seconds, so
+	// that slow satellites still follow the changes of illumination.
+	static const double maxAge = 10.;
+	const double age = std::fabs(epoch - epochTime) * 86400.;
+	return age > maxAge || angularSpeed*age > threshold;
 }
 
 double Satellite::getDoppler(double freq) const
@@ -700,7 +729,11 @@ double Satellite::getDoppler(double freq) const
 void Satellite::recalculateOrbitLines(void)
 {
 	orbitPoints.clear();
-	visibilityPoints.clear();
+}
+
+void Satellite::updateOrbitLinesObserver(void)
+{
+	orbitObserverChanged = true;
 }
 
 SatFlags Satellite::getFlags()
@@ -846,29 +879,26 @@ void Satellite::drawOrbit(StelPainter& painter)
 
 	glDisable(GL_TEXTURE_2D);
 
-	QList<Vec3d>::iterator it= orbitPoints.begin();
-	it++;
-
 	QVector<Vec3d> vertexArray;
 	QVector<Vec4f> colorArray;
 	StelProjectorP prj = painter.getProjector();
 
-	vertexArray.resize(size);
-	colorArray.resize(size);
+	vertexArray.reserve(size);
+	colorArray.reserve(size);
 
 	painter.enableClientStates(true, false, false);
 	//Rest of points
 	for (int i=1; i<size; i++)
 	{
-		position.set(it->operator [](0), it->operator [](1), it->operator [](2));
-		it++;
+		const OrbitPoint& point = orbitPoints[(orbitHead+i)%size];
+		position = point.elAzPos;
 		position.normalize();
 
 		if (prj->project(position, onscreen)) // check position on the screen
 		{
 			vertexArray.append(position);
 			drawColor = invisibleSatelliteColor;
-			if (visibilityPoints[i] == VISIBLE)
+			if (point.visibility == VISIBLE)
 				drawColor = orbitColor;
 			colorArray.append(Vec4f(drawColor[0], drawColor[1], drawColor[2], hintBrightness * calculateOrbitSegmentIntensity(i)));
 		}
@@ -896,92 +926,74 @@ float Satellite::calculateOrbitSegmentIntensity(int segNum)
 
 void Satellite::computeOrbitPoints()
 {
-	gTimeSpan computeInterval(0, 0, 0, orbitLineSegmentDuration);
-	gTimeSpan orbitSpan(0, 0, 0, orbitLineSegments*orbitLineSegmentDuration/2);
-	gTime epochTm;
-	gTime epoch(epochTime);
-	gTime lastEpochComp(lastEpochCompForOrbit);
-	Vec3d elAzVector;
-	int diffSlots;
-
-
-	if (orbitPoints.isEmpty())//Setup orbitPoins
+	const int size = orbitLineSegments + 1;
+	const double step = orbitLineSegmentDuration / 86400.;
+	const double orbitSpan = (orbitLineSegments*orbitLineSegmentDuration/2) / 86400.;
+	// Same observer as the position at epochTime
+	const gSatObserverData& observer = observerData;
+	const double slots = (epochTime - lastEpochCompForOrbit) / step;
+	bool propagated = false;
+
+	if (orbitPoints.size() != size || std::fabs(slots) > orbitLineSegments)
+	{ // setup orbit points
+		orbitPoints.resize(size);
+		orbitHead = 0;
+		for (int i=0; i<size; i++)
+			computeOrbitPoint(epochTime - orbitSpan + i*step, observer, orbitPoints[i]);
+		lastEpochCompForOrbit = epochTime;
+		orbitObserverChanged = false;
+		propagated = true;
+	}
+	else
 	{
-		epochTm  = epoch - orbitSpan;
+		if (orbitObserverChanged)
+		{ // the positions don't depend on the observer, only reproject them
+			for (int i=0; i<size; i++)
+				updateOrbitPointObserver(observer, orbitPoints[i]);
+			orbitObserverChanged = false;
+		}
 
-		for (int i=0; i<=orbitLineSegments; i++)
+		const int diffSlots = (int)slots;
+		// clock runs forward: the oldest points are replaced by points after the newest one
+		for (int i=0; i<diffSlots; i++)
 		{
-			pSatWrapper->setEpoch(epochTm.getGmtTm());
-			elAzVector  = pSatWrapper->getAltAz();
-			orbitPoints.append(elAzVector);
-			visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-			epochTm    += computeInterval;
+			const double newest = orbitPoints[(orbitHead+size-1)%size].epoch;
+			computeOrbitPoint(newest + step, observer, orbitPoints[orbitHead]);
+			orbitHead = (orbitHead+1)%size;
 		}
-		lastEpochCompForOrbit = epochTime;
-	}
-	else if (epochTime > lastEpochCompForOrbit)
-	{ // compute next orbit point when clock runs forward
-
-		gTimeSpan diffTime = epoch - lastEpochComp;
-		diffSlots          = (int)(diffTime.getDblSeconds()/orbitLineSegmentDuration);
-
-		if (diffSlots > 0)
+		// clock runs backward: the newest points are replaced by points before the oldest one
+		for (int i=0; i<-diffSlots; i++)
 		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm  = epoch - orbitSpan;
-			}
-			else
-			{
-				epochTm   = lastEpochComp + orbitSpan + computeInterval;
-			}
-
-			for (int i=0; i<diffSlots; i++)
-			{
-				//remove points at beginning of list and add points at end.
-				orbitPoints.removeFirst();
-				visibilityPoints.removeFirst();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.append(elAzVector);
-				visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-				epochTm    += computeInterval;
-			}
-
-			lastEpochCompForOrbit = epochTime;
+			const double oldest = orbitPoints[orbitHead].epoch;
+			orbitHead = (orbitHead+size-1)%size;
+			computeOrbitPoint(oldest - step, observer, orbitPoints[orbitHead]);
 		}
-	}
-	else if (epochTime < lastEpochCompForOrbit)
-	{ // compute next orbit point when clock runs backward
-		gTimeSpan diffTime = lastEpochComp - epoch;
-		diffSlots          = (int)(diffTime.getDblSeconds()/orbitLineSegmentDuration);
-
-		if (diffSlots > 0)
+		if (diffSlots != 0)
 		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm   = epoch + orbitSpan;
-			}
-			else
-			{
-				epochTm   = epoch - orbitSpan - computeInterval;
-			}
-			for (int i=0; i<diffSlots; i++)
-			{ //remove points at end of list and add points at beginning.
-				orbitPoints.removeLast();
-				visibilityPoints.removeLast();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.push_front(elAzVector);
-				visibilityPoints.push_front(pSatWrapper->getVisibilityPredict());
-				epochTm -= computeInterval;
-
-			}
-			lastEpochCompForOrbit = epochTime;
+			// stay on the time grid of the points, so that the line doesn't drift
+			lastEpochCompForOrbit += diffSlots*step;
+			propagated = true;
 		}
 	}
+
+	// getVMagnitude() of the Iridium satellites uses the epoch of the wrapper
+	if (propagated)
+		pSatWrapper->setEpoch(epochTime);
+}
+
+void Satellite::computeOrbitPoint(double epoch, const gSatObserverData& observer, OrbitPoint& point)
+{
+	pSatWrapper->setEpoch(epoch);
+	point.epoch   = epoch;
+	point.temePos = pSatWrapper->getTEMEPos();
+	updateOrbitPointObserver(observer, point);
+}
+
+void Satellite::updateOrbitPointObserver(const gSatObserverData& observer, OrbitPoint& point)
+{
+	const gTime epoch(point.epoch);
+	point.elAzPos    = gSatWrapper::getAltAz(observer, epoch, point.temePos);
+	point.visibility = gSatWrapper::getVisibilityPredict(observer, epoch, point.temePos);
 }
 
 
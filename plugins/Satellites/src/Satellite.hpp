@@ -27,6 +27,7 @@
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 
 #include "StelObject.hpp"
 #include "StelTextureTypes.hpp"
@@ -152,12 +153,33 @@ public:
 	// calculate faders, new position
 	void update(double deltaTime);
 
+	//! Propagate the orbit to the given date (JD) and compute the position
+	//! dependent values, like update() but without the orbit line.
+	//! It doesn't use the Stellarium core and can be called from a worker
+	//! thread, as long as each satellite is handled by a single thread.
+	//! @param epoch the date, measured in Julian Days
+	//! @param observer observer and Sun data, see gSatWrapper::getObserverData()
+	void computePosition(double epoch, const gSatObserverData& observer);
+
+	//! Check whether the position must be recomputed for the given date.
+	//! The apparent motion since the last computation is estimated from the
+	//! angular speed seen by the observer at that time.
+	//! @param epoch the date, measured in Julian Days
+	//! @param threshold the angle in radians below which the position is kept
+	//! @return true if the estimated motion is above the threshold, or if the
+	//! last computation is too old
+	bool needsUpdate(double epoch, double threshold) const;
+
 	double getDoppler(double freq) const;
 	static float showLabels;
 	static double roundToDp(float n, int dp);
 
-	// when the observer location changes we need to
+	//! Drop the orbit line, it is computed again at the next update.
+	//! Needed when the orbit line parameters change.
 	void recalculateOrbitLines(void);
+	//! When the observer location changes, the orbit line points are
+	//! reprojected from their stored positions at the next update.
+	void updateOrbitLinesObserver(void);
 	
 	void setNew() {newlyAdded = true;}
 	bool isNew() const {return newlyAdded;}
@@ -182,8 +204,21 @@ public:
 	QString getOperationalStatus() const;
 
 private:
+	//! A point of the orbit line.
+	struct OrbitPoint
+	{
+		double epoch;     //measured in Julian Days
+		Vec3d temePos;    //measured in Km
+		Vec3d elAzPos;
+		int visibility;
+	};
+
 	//draw orbits methods
 	void computeOrbitPoints();
+	//! Propagate the orbit to the epoch and compute the point seen by the observer.
+	void computeOrbitPoint(double epoch, const gSatObserverData& observer, OrbitPoint& point);
+	//! Compute the observer dependent values of a point from its stored position.
+	static void updateOrbitPointObserver(const gSatObserverData& observer, OrbitPoint& point);
 	void drawOrbit(StelPainter& painter);
 	//! returns 0 - 1.0 for the DRAWORBIT_FADE_NUMBER segments at
 	//! each end of an orbit, with 1 in the middle.
@@ -272,8 +307,12 @@ private:
 	Vec3f    orbitColor;
 	double    lastEpochCompForOrbit; //measured in Julian Days
 	double    epochTime;  //measured in Julian Days
-	QList<Vec3d> orbitPoints; //orbit points represented by ElAzPos vectors
-	QList<int> visibilityPoints; //orbit visibility points
+	double    angularSpeed; //apparent speed seen by the observer at epochTime, measured in radians/s
+	gSatObserverData observerData; //observer and Sun data used for the computation at epochTime
+	//! Orbit points, kept in a ring buffer: the oldest point is at orbitHead.
+	QVector<OrbitPoint> orbitPoints;
+	int       orbitHead;
+	bool      orbitObserverChanged; //the observer location changed since the last update of orbitPoints
 };
 
 typedef QSharedPointer<Satellite> SatelliteP;
@@ -52,6 +52,9 @@
 #include <QVariantMap>
 #include <QVariant>
 #include <QDir>
+#include <QFutureSynchronizer>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 StelModule* SatellitesStelPluginInterface::getStelModule() const
 {
@@ -75,6 +78,9 @@ StelPluginInfo SatellitesStelPluginInterface::getPluginInfo() const
 
 Satellites::Satellites()
 	: satelliteListModel(NULL)
+	, updatePixelThreshold(0.5)
+	, flagParallelUpdate(true)
+	, forceUpdate(true)
 	, toolbarButton(NULL)
 	, earth(NULL)
 	, defaultHintColor(0.0f, 0.4f, 0.6f)
@@ -461,6 +467,8 @@ void Satellites::restoreDefaultSettings()
 	conf->setValue("orbit_fade_segments", 5);
 	conf->setValue("orbit_segment_duration", 20);
 	conf->setValue("realistic_mode_enabled", true);
+	conf->setValue("update_pixel_threshold", 0.5);
+	conf->setValue("flag_parallel_update", true);
 	
 	conf->endGroup(); // saveTleSources() opens it for itself
 	
@@ -625,6 +633,10 @@ void Satellites::loadSettings()
 	// realistic mode
 	setFlagRelisticMode(conf->value("realistic_mode_enabled", true).toBool());
 
+	// position updates
+	updatePixelThreshold = conf->value("update_pixel_threshold", 0.5).toDouble();
+	flagParallelUpdate = conf->value("flag_parallel_update", true).toBool();
+
 	conf->endGroup();
 }
 
@@ -653,6 +665,10 @@ void Satellites::saveSettings()
 	// realistic mode
 	conf->setValue("realistic_mode_enabled", getFlagRealisticMode());
 
+	// position updates
+	conf->setValue("update_pixel_threshold", updatePixelThreshold);
+	conf->setValue("flag_parallel_update", flagParallelUpdate);
+
 	conf->endGroup();
 	
 	// Update sources...
@@ -1264,7 +1280,12 @@ void Satellites::saveDownloadedUpdate(QNetworkReply* reply)
 
 void Satellites::updateObserverLocation(StelLocation)
 {
-	recalculateOrbitLines();
+	forceUpdate = true;
+	foreach(const SatelliteP& sat, satellites)
+	{
+		if (sat->initialized && sat->displayed && sat->orbitDisplayed)
+			sat->updateOrbitLinesObserver();
+	}
 }
 
 void Satellites::setOrbitLinesFlag(bool b)
@@ -1587,11 +1608,76 @@ void Satellites::update(double deltaTime)
 
 	hintFader.update((int)(deltaTime*1000));
 
+	StelCore* core = StelApp::getInstance().getCore();
+	// We have "true" JD from core, satellites don't need JDE!
+	const double epoch = core->getJD() + Satellite::timeShift;
+	const gSatObserverData observer = gSatWrapper::getObserverData();
+
+	// Satellites which moved less than the threshold since their last
+	// computation keep their position.
+	double threshold = 0.;
+	if (updatePixelThreshold>0. && !forceUpdate)
+		threshold = updatePixelThreshold / core->getProjection(StelCore::FrameAltAz)->getPixelPerRadAtCenter();
+	forceUpdate = false;
+
+	updatedSatellites.clear();
 	foreach(const SatelliteP& sat, satellites)
 	{
-		if (sat->initialized && sat->displayed)
-			sat->update(deltaTime);
+		if (sat->initialized && sat->displayed && sat->orbitValid && (threshold<=0. || sat->needsUpdate(epoch, threshold)))
+			updatedSatellites.append(sat.data());
+	}
+	computeSatellitePositions(updatedSatellites, epoch, observer, flagParallelUpdate);
+
+	// The orbit lines use the core, they are computed in the main thread.
+	foreach(Satellite* sat, updatedSatellites)
+	{
+		if (sat->orbitValid && sat->orbitDisplayed)
+			sat->computeOrbitPoints();
+	}
+}
+
+struct SatellitePositionJob
+{
+	const QVector<Satellite*>* satellites;
+	int begin;
+	int end;
+	double epoch;
+	const gSatObserverData* observer;
+};
+
+static void runSatellitePositionJob(SatellitePositionJob* job)
+{
+	for (int i=job->begin;i<job->end;++i)
+		job->satellites->at(i)->computePosition(job->epoch, *job->observer);
+}
+
+void Satellites::computeSatellitePositions(const QVector<Satellite*>& sats, double epoch,
+					   const gSatObserverData& observer, bool parallel)
+{
+	// Below this, the overhead of the threads is bigger than the gain
+	static const int minSatellitesPerJob = 128;
+	const int nbJobs = parallel ? qMin(sats.size()/minSatellitesPerJob, 4*QThreadPool::globalInstance()->maxThreadCount()) : 1;
+	if (nbJobs<=1)
+	{
+		SatellitePositionJob job = {&sats, 0, sats.size(), epoch, &observer};
+		runSatellitePositionJob(&job);
+		return;
+	}
+
+	QVector<SatellitePositionJob> jobs(nbJobs);
+	for (int j=0;j<nbJobs;++j)
+	{
+		SatellitePositionJob& job = jobs[j];
+		job.satellites = &sats;
+		job.begin = sats.size()*j/nbJobs;
+		job.end = sats.size()*(j+1)/nbJobs;
+		job.epoch = epoch;
+		job.observer = &observer;
 	}
+	QFutureSynchronizer<void> synchronizer;
+	for (int j=0;j<nbJobs;++j)
+		synchronizer.addFuture(QtConcurrent::run(runSatellitePositionJob, &jobs[j]));
+	synchronizer.waitForFinished();
 }
 
 void Satellites::draw(StelCore* core)
@@ -1706,6 +1792,7 @@ IridiumFlaresPredictionList Satellites::getIridiumFlaresPrediction()
 
 	pcore->setJD(iJD + 0.5 - pcore->getCurrentLocation().longitude / 360.f);
 	pcore->update(10); // force update to get new coordinates
+	const gSatObserverData observer = gSatWrapper::getObserverData();
 
 	IridiumFlaresPredictionList predictions;
 	predictions.clear();
@@ -1719,7 +1806,7 @@ IridiumFlaresPredictionList Satellites::getIridiumFlaresPrediction()
 			while (dt<1)
 			{
 				Satellite::timeShift = dt+delta;
-				sat.data()->update(0);
+				sat.data()->computePosition(pcore->getJD() + Satellite::timeShift, observer);
 
 				Vec3d pos = sat.data()->getAltAzPosApparent(pcore);
 				double lat = pos.latitude();
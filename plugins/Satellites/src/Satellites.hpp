@@ -32,6 +32,7 @@
 #include <QDir>
 #include <QUrl>
 #include <QVariantMap>
+#include <QVector>
 
 class StelButton;
 class Planet;
@@ -493,6 +494,11 @@ private:
 	//! Checks valid range dates of life of satellites
 	bool isValidRangeDates() const;
 
+	//! Compute the positions of the given satellites, see Satellite::computePosition().
+	//! @param parallel whether large lists can be split between worker threads
+	static void computeSatellitePositions(const QVector<Satellite*>& sats, double epoch,
+					      const gSatObserverData& observer, bool parallel);
+
 	//! Save a structure representing a satellite catalog to a JSON file.
 	//! If no path is specified, catalogPath is used.
 	//! @see createDataMap()
@@ -531,6 +537,15 @@ private:
 	
 	QList<SatelliteP> satellites;
 	SatellitesListModel* satelliteListModel;
+	//! The satellites recomputed by the last call to update().
+	QVector<Satellite*> updatedSatellites;
+	//! Satellites whose apparent motion since their last computation is below
+	//! this number of pixels keep their position. 0 recomputes all of them every frame.
+	double updatePixelThreshold;
+	//! Whether the positions can be computed in worker threads.
+	bool flagParallelUpdate;
+	//! Set when all positions must be recomputed (e.g. after a change of location).
+	bool forceUpdate;
 
 	QHash<QString, double> qsMagList;
 	
@@ -137,13 +137,46 @@ void gSatWrapper::setEpoch(double ai_julianDaysEpoch)
 }
 
 
+gSatObserverData gSatWrapper::getObserverLocation()
+{
+	StelLocation loc = StelApp::getInstance().getCore()->getCurrentLocation();
+	gSatObserverData obs;
+	obs.latitude  = loc.latitude * KDEG2RAD;
+	obs.longitude = loc.longitude * KDEG2RAD;
+	obs.altitude  = loc.altitude/1000;
+	obs.sunEquinoxEqPos.set(0., 0., 0.);
+	obs.sunAboveHorizon = false;
+	return obs;
+}
+
+gSatObserverData gSatWrapper::getObserverData()
+{
+	StelCore* core = StelApp::getInstance().getCore();
+	gSatObserverData obs = getObserverLocation();
+
+	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	Vec3d sunEquinoxEqPos  = solsystem->getSun()->getEquinoxEquatorialPos(core);
+	//sunEquinoxEqPos is measured in AU. we need meassure it in Km
+	obs.sunEquinoxEqPos.set(sunEquinoxEqPos[0]*AU, sunEquinoxEqPos[1]*AU, sunEquinoxEqPos[2]*AU);
+	obs.sunAboveHorizon = solsystem->getSun()->getAltAzPosGeometric(core)[2] > 0.0;
+	return obs;
+}
+
 void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity)
 {
+	calcObserverECIPosition(getObserverLocation(), epoch, ao_position, ao_velocity);
+}
+
+void gSatWrapper::calcObserverECIPosition(const gSatObserverData& obs, Vec3d& ao_position, Vec3d& ao_velocity)
+{
+	calcObserverECIPosition(obs, epoch, ao_position, ao_velocity);
+}
 
-	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
+void gSatWrapper::calcObserverECIPosition(const gSatObserverData& obs, const gTime& ai_epoch, Vec3d& ao_position, Vec3d& ao_velocity)
+{
 
-	double radLatitude = loc.latitude * KDEG2RAD;
-        double theta       = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
+	double radLatitude = obs.latitude;
+        double theta       = ai_epoch.toThetaLMST(obs.longitude);
 	double r;
 	double c,sq;
 
@@ -153,10 +186,10 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 	c = 1/std::sqrt(1 + __f*(__f - 2)*Sqr(sin(radLatitude)));
 	sq = Sqr(1 - __f)*c;
 
-	r = (KEARTHRADIUS*c + (loc.altitude/1000))*cos(radLatitude);
+	r = (KEARTHRADIUS*c + obs.altitude)*cos(radLatitude);
 	ao_position[0] = r * cos(theta);/*kilometers*/
 	ao_position[1] = r * sin(theta);
-	ao_position[2] = (KEARTHRADIUS*sq + (loc.altitude/1000))*sin(radLatitude);
+	ao_position[2] = (KEARTHRADIUS*sq + obs.altitude)*sin(radLatitude);
         ao_velocity[0] = -KMFACTOR*ao_position[1];/*kilometers/second*/
         ao_velocity[1] =  KMFACTOR*ao_position[0];
         ao_velocity[2] =  0;
@@ -165,19 +198,27 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 
 
 Vec3d gSatWrapper::getAltAz()
+{
+	return getAltAz(getObserverLocation(), epoch, getTEMEPos());
+}
+
+Vec3d gSatWrapper::getAltAz(const gSatObserverData& obs)
+{
+	return getAltAz(obs, epoch, getTEMEPos());
+}
+
+Vec3d gSatWrapper::getAltAz(const gSatObserverData& obs, const gTime& ai_epoch, const Vec3d& satECIPos)
 {
 
-	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
 	Vec3d topoSatPos;
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
 
-	double  radLatitude    = loc.latitude * KDEG2RAD;
-        double  theta          = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
+	double  radLatitude    = obs.latitude;
+        double  theta          = ai_epoch.toThetaLMST(obs.longitude);
 
-	calcObserverECIPosition(observerECIPos, observerECIVel);
+	calcObserverECIPosition(obs, ai_epoch, observerECIPos, observerECIVel);
 
-	Vec3d satECIPos  = getTEMEPos();
 	Vec3d slantRange = satECIPos - observerECIPos;
 
 	//top_s
@@ -197,12 +238,17 @@ Vec3d gSatWrapper::getAltAz()
 }
 
 void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRate)
+{
+	getSlantRange(getObserverLocation(), ao_slantRange, ao_slantRangeRate);
+}
+
+void  gSatWrapper::getSlantRange(const gSatObserverData& obs, double &ao_slantRange, double &ao_slantRangeRate)
 {
 
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
 
-	calcObserverECIPosition(observerECIPos, observerECIVel);
+	calcObserverECIPosition(obs, observerECIPos, observerECIVel);
 
 
         Vec3d satECIPos            = getTEMEPos();
@@ -215,48 +261,53 @@ void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRat
 }
 
 Vec3d gSatWrapper::getSunECIPos()
+{
+	return getSunECIPos(getObserverData(), epoch);
+}
+
+Vec3d gSatWrapper::getSunECIPos(const gSatObserverData& obs)
+{
+	return getSunECIPos(obs, epoch);
+}
+
+Vec3d gSatWrapper::getSunECIPos(const gSatObserverData& obs, const gTime& ai_epoch)
 {
 	// All positions in ECI system are positions referenced in a StelCore::EquinoxEq system centered in the earth centre
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
-	Vec3d sunECIPos;
-	Vec3d sunEquinoxEqPos;
-
-	calcObserverECIPosition(observerECIPos, observerECIVel);
-
-	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
-	sunEquinoxEqPos        = solsystem->getSun()->getEquinoxEquatorialPos(StelApp::getInstance().getCore());
 
-	//sunEquinoxEqPos is measured in AU. we need meassure it in Km
-	sunECIPos.set(sunEquinoxEqPos[0]*AU, sunEquinoxEqPos[1]*AU, sunEquinoxEqPos[2]*AU);
-	sunECIPos = sunECIPos + observerECIPos; //Change ref system centre
+	calcObserverECIPosition(obs, ai_epoch, observerECIPos, observerECIVel);
 
-	return sunECIPos;
+	return obs.sunEquinoxEqPos + observerECIPos; //Change ref system centre
 }
 
 // Operation getVisibilityPredict
 // @brief This operation predicts the satellite visibility contidions.
 int gSatWrapper::getVisibilityPredict()
 {
-	Vec3d satECIPos;
+	return getVisibilityPredict(getObserverData(), epoch, getTEMEPos());
+}
+
+int gSatWrapper::getVisibilityPredict(const gSatObserverData& obs)
+{
+	return getVisibilityPredict(obs, epoch, getTEMEPos());
+}
+
+int gSatWrapper::getVisibilityPredict(const gSatObserverData& obs, const gTime& ai_epoch, const Vec3d& satECIPos)
+{
 	Vec3d satAltAzPos;
 	Vec3d sunECIPos;
-	Vec3d sunAltAzPos;
 
 	double sunSatAngle, Dist;
 	int   visibility;
 
-	satAltAzPos = getAltAz();
+	satAltAzPos = getAltAz(obs, ai_epoch, satECIPos);
 
 	if (satAltAzPos[2] > 0)
 	{
-		satECIPos = getTEMEPos();
-		SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");		
-		sunAltAzPos        = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
-
-		sunECIPos = getSunECIPos();
+		sunECIPos = getSunECIPos(obs, ai_epoch);
 
-		if (sunAltAzPos[2] > 0.0)
+		if (obs.sunAboveHorizon)
 		{
 			visibility = RADAR_SUN;
 		}
@@ -283,7 +334,12 @@ int gSatWrapper::getVisibilityPredict()
 
 double gSatWrapper::getPhaseAngle()
 {
-	Vec3d sunECIPos = getSunECIPos();
+	return getPhaseAngle(getObserverData());
+}
+
+double gSatWrapper::getPhaseAngle(const gSatObserverData& obs)
+{
+	Vec3d sunECIPos = getSunECIPos(obs);
 	return sunECIPos.angle(getTEMEPos());
 }
 
@@ -42,6 +42,21 @@
 #define  RADAR_NIGHT 3
 #define  NOT_VISIBLE 4
 
+//! Observer and Sun data used by gSatWrapper.
+//! They are the same for all satellites at a given date, but reading them
+//! requires the Stellarium core. They are collected once on the main thread
+//! by gSatWrapper::getObserverData(), so that the methods taking this structure
+//! can be called from worker threads.
+//! @ingroup satellites
+struct gSatObserverData
+{
+	double latitude;      //!< radians
+	double longitude;     //!< radians
+	double altitude;      //!< km
+	Vec3d sunEquinoxEqPos; //!< Sun position in StelCore::FrameEquinoxEqu, measured in Km
+	bool sunAboveHorizon;
+};
+
 //! Wrapper allowing compatibility between gsat and Stellarium/Qt.
 //! @ingroup satellites
 class gSatWrapper
@@ -58,6 +73,10 @@ public:
 
 	void setEpoch(double ai_julianDaysEpoch);
 
+	//! Collect the observer and Sun data for the current date and location.
+	//! Must be called from the main thread.
+	static gSatObserverData getObserverData();
+
 	// Operation getTEMEPos
 	//! @brief This operation isolate gSatTEME getPos operation.
 	//! @return Vec3d with TEME position. Units measured in Km.
@@ -67,6 +86,8 @@ public:
 	//! @brief Get Sun positions in ECI system.
 	//! @return Vec3d with ECI position.
 	Vec3d getSunECIPos();
+	Vec3d getSunECIPos(const gSatObserverData& obs);
+	static Vec3d getSunECIPos(const gSatObserverData& obs, const gTime& ai_epoch);
 
 	// Operation getTEMEVel
 	//! @brief This operation isolate gSatTEME getVel operation.
@@ -89,6 +110,9 @@ public:
 	//!   Dr. T.S. Kelso
 	//!   http://www.celestrak.com/columns/v02n02/
 	Vec3d getAltAz();
+	Vec3d getAltAz(const gSatObserverData& obs);
+	//! Same as above, for a satellite at the given TEME position (measured in Km) and date.
+	static Vec3d getAltAz(const gSatObserverData& obs, const gTime& ai_epoch, const Vec3d& satECIPos);
 
         // Operation getSlantRange
         //! @brief This operation compute the slant range (distance between the
@@ -97,6 +121,7 @@ public:
         //! @param &ao_slantRangeRate Reference to a output variable where the method store the slant range variation in Km/s
         //! @return void
 	void  getSlantRange(double &ao_slantRange, double &ao_slantRangeRate); //meassured in km and km/s
+	void  getSlantRange(const gSatObserverData& obs, double &ao_slantRange, double &ao_slantRangeRate);
 
 
         // Operation getVisibilityPredict
@@ -115,8 +140,12 @@ public:
         //!   Fundamentals of Astrodynamis and Applications (Third Edition) pg 898
         //!   David A. Vallado
         int getVisibilityPredict();
+	int getVisibilityPredict(const gSatObserverData& obs);
+	//! Same as above, for a satellite at the given TEME position (measured in Km) and date.
+	static int getVisibilityPredict(const gSatObserverData& obs, const gTime& ai_epoch, const Vec3d& satECIPos);
 
 	double getPhaseAngle();
+	double getPhaseAngle(const gSatObserverData& obs);
 	gTime	getEpoch() { return epoch; }
 
 
@@ -134,9 +163,14 @@ public:
         //! @param[out] ao_position Observer ECI position vector measured in Km
         //! @param[out] ao_vel Observer ECI velocity vector measured in Km/s
         void calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_vel);
+	void calcObserverECIPosition(const gSatObserverData& obs, Vec3d& ao_position, Vec3d& ao_vel);
+	static void calcObserverECIPosition(const gSatObserverData& obs, const gTime& ai_epoch, Vec3d& ao_position, Vec3d& ao_vel);
 
 
 private:
+	//! Same as getObserverData() without the Sun, for the overloads which don't need it.
+	static gSatObserverData getObserverLocation();
+
 	gSatTEME *pSatellite;
         gTime	 epoch;
 
@@ -22,6 +22,7 @@
 #include "StelUtils.hpp"
 
 #include <QSettings>
+#include <QSize>
 #include <QDateTime>
 #include <QDebug>
 #include <iostream>
@@ -79,6 +80,12 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 			#endif
 			#endif
 			  << "--screenshot-dir        : Specify directory to save screenshots\n"
+			  << "--headless              : Render frames offscreen without showing the window,\n"
+			  << "                          save them in the screenshot directory and quit\n"
+			  << "--frame-size            : Size of the headless frames, e.g. 8192x8192 (default 1920x1080)\n"
+			  << "--frame-step            : Program time between headless frames in seconds (default 0.04)\n"
+			  << "--frame-count           : Number of headless frames, or 0 to render until\n"
+			  << "                          the startup script has finished (default 1)\n"
 			  << "--startup-script        : Specify name of startup script\n"
 			  << "--home-planet           : Specify observer planet (English name)\n"
 			  << "--altitude              : Specify observer altitude in meters\n"
@@ -173,6 +180,10 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 	float fov;
 	QString landscapeId, homePlanet, longitude, latitude, skyDate, skyTime;
 	QString projectionType, screenshotDir, multiresImage, startupScript;
+	bool headless;
+	QString frameSize;
+	double frameStep;
+	int frameCount;
 #ifdef ENABLE_SPOUT
 	QString spoutStr, spoutName;
 #endif
@@ -193,6 +204,10 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		screenshotDir = argsGetOptionWithArg(argList, "", "--screenshot-dir", "").toString();
 		multiresImage = argsGetOptionWithArg(argList, "", "--multires-image", "").toString();
 		startupScript = argsGetOptionWithArg(argList, "", "--startup-script", "").toString();
+		headless = argsGetOption(argList, "", "--headless");
+		frameSize = argsGetOptionWithArg(argList, "", "--frame-size", "1920x1080").toString();
+		frameStep = argsGetOptionWithArg(argList, "", "--frame-step", 0.04).toDouble();
+		frameCount = argsGetOptionWithArg(argList, "", "--frame-count", 1).toInt();
 #ifdef ENABLE_SPOUT
 		// For now, we default to spout=sky when no extra option is given. Later, we should also accept "all".
 		// Unfortunately, this still throws an exception when no optarg string is given.
@@ -266,6 +281,25 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		qApp->setProperty("onetime_startup_script", startupScript);
 	}
 
+	if (headless)
+	{
+		QRegExp sizeRx("(\\d+)x(\\d+)");
+		QSize size(1920, 1080);
+		if (sizeRx.exactMatch(frameSize) && sizeRx.cap(1).toInt()>0 && sizeRx.cap(2).toInt()>0)
+			size = QSize(sizeRx.cap(1).toInt(), sizeRx.cap(2).toInt());
+		else
+			qWarning() << "WARNING: --frame-size argument has unrecognised format (I want WIDTHxHEIGHT)";
+		if (frameStep<=0.)
+		{
+			qWarning() << "WARNING: --frame-step must be positive, using 0.04 s";
+			frameStep = 0.04;
+		}
+		qApp->setProperty("headless", true);
+		qApp->setProperty("headless_frame_size", size);
+		qApp->setProperty("headless_frame_step", frameStep);
+		qApp->setProperty("headless_frame_count", qMax(frameCount, 0));
+	}
+
 	if (fov>0.0) confSettings->setValue("navigation/init_fov", fov);
 	if (!projectionType.isEmpty()) confSettings->setValue("projection/type", projectionType);
 	if (!screenshotDir.isEmpty())
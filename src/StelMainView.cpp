@@ -28,6 +28,10 @@
 #include "StelTranslator.hpp"
 #include "StelUtils.hpp"
 #include "StelActionMgr.hpp"
+#include "StelFrameCapture.hpp"
+#ifndef DISABLE_SCRIPTING
+#include "StelScriptMgr.hpp"
+#endif
 #include "StelOpenGL.hpp"
 
 #include <QDebug>
@@ -59,6 +63,7 @@
 #ifdef Q_OS_WIN
 	#include <QPinchGesture>
 #endif
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLShader>
 #include <QOpenGLShaderProgram>
 #include <QGLFramebufferObject>
@@ -241,6 +246,10 @@ void StelSkyItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
 	previousPaintTime = now;
 
 	painter->beginNativePainting();
+	// The screenshots read at the previous frame are ready now
+	StelFrameCapture* frameCapture = StelMainView::getInstance().frameCapture;
+	if (frameCapture)
+		frameCapture->processReads();
 	glClearColor(0, 0, 0, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
 	StelApp::getInstance().update(dt);
@@ -432,7 +441,9 @@ StelMainView::StelMainView(QWidget* parent)
 	  flagOverwriteScreenshots(false),
 	  screenShotPrefix("stellarium-"),
 	  screenShotDir(""),
-	  cursorTimeout(-1.f), flagCursorTimeout(false), minFpsTimer(NULL), maxfps(10000.f)
+	  frameCapture(NULL),
+	  cursorTimeout(-1.f), flagCursorTimeout(false), minFpsTimer(NULL), maxfps(10000.f),
+	  flagHeadless(false), headlessFrameCount(1), headlessFrame(0), headlessFbo(NULL)
 {
 	StelApp::initStatic();
 	
@@ -560,8 +571,10 @@ void StelMainView::init(QSettings* conf)
 	glWidget->makeCurrent();
 #endif
 
-	// Should be check of requirements disabled?
-	if (conf->value("main/check_requirements", true).toBool())
+	flagHeadless = qApp->property("headless")==true;
+
+	// Should be check of requirements disabled? Nobody would see the warnings in headless mode.
+	if (!flagHeadless && conf->value("main/check_requirements", true).toBool())
 	{
 		// Find out lots of debug info about supported version of OpenGL and vendor/renderer.
 		processOpenGLdiagnosticsAndWarnings(conf, glWidget);
@@ -599,6 +612,15 @@ void StelMainView::init(QSettings* conf)
 
 	bool fullscreen = conf->value("video/fullscreen", true).toBool();
 
+	if (flagHeadless)
+	{
+		// The window is never shown, its size is the one of the frames
+		headlessFrameSize = qApp->property("headless_frame_size").toSize();
+		headlessFrameCount = qApp->property("headless_frame_count").toInt();
+		size = headlessFrameSize;
+		fullscreen = false;
+	}
+
 	// Without this, the screen is not shown on a Mac + we should use resize() for correct work of fullscreen/windowed mode switch. --AW WTF???
 	resize(size);
 
@@ -621,7 +643,7 @@ void StelMainView::init(QSettings* conf)
 		setGeometry(geometry() & screenGeom);
 		setFullScreen(true);
 	}
-	else
+	else if (!flagHeadless)
 	{
 		setFullScreen(false);
 		int x = conf->value("video/screen_x", 0).toInt();
@@ -630,6 +652,9 @@ void StelMainView::init(QSettings* conf)
 	}
 
 	flagInvertScreenShotColors = conf->value("main/invert_screenshots_colors", false).toBool();
+	frameCapture = new StelFrameCapture(this);
+	frameCapture->setImageFormat(StelFrameCapture::stringToImageFormat(conf->value("main/screenshot_format", "png").toString()));
+	frameCapture->setMaxQueueSize(conf->value("main/screenshot_queue_size", QThread::idealThreadCount()).toInt());
 	setFlagCursorTimeout(conf->value("gui/flag_mouse_cursor_timeout", false).toBool());
 	setCursorTimeout(conf->value("gui/mouse_cursor_timeout", 10.f).toFloat());
 	maxfps = conf->value("video/maximum_fps",10000.f).toFloat();
@@ -664,7 +689,10 @@ void StelMainView::init(QSettings* conf)
 		StelApp::getInstance().dumpModuleActionPriorities(StelModule::ActionHandleKeys);
 	}
 #endif
-	startMainLoop();
+	if (flagHeadless)
+		startHeadlessRendering();
+	else
+		startMainLoop();
 }
 
 void StelMainView::updateNightModeProperty(bool b)
@@ -1143,6 +1171,89 @@ void StelMainView::startMainLoop()
 	minFpsChanged();
 }
 
+void StelMainView::startHeadlessRendering()
+{
+	const double frameStep = qApp->property("headless_frame_step").toDouble();
+	StelApp::setFixedTimeStep(frameStep);
+	headlessFrame = 0;
+	qDebug() << "Headless rendering of" << (headlessFrameCount>0 ? QString::number(headlessFrameCount) : QString("script")) << "frames of"
+		 << headlessFrameSize.width() << "x" << headlessFrameSize.height() << "every" << frameStep << "s in"
+		 << QDir::toNativeSeparators(StelFileMgr::getScreenshotDir());
+	// Each frame is rendered from the event loop, so that the scripts and the downloads go on between frames
+	QTimer::singleShot(0, this, SLOT(renderHeadlessFrame()));
+}
+
+void StelMainView::renderHeadlessFrame()
+{
+	glWidget->makeCurrent();
+	StelApp& app = StelApp::getInstance();
+	const int w = headlessFrameSize.width();
+	const int h = headlessFrameSize.height();
+	if (!headlessFbo)
+	{
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+		if (w>maxSize || h>maxSize)
+		{
+			qWarning() << "ERROR headless frame size" << w << "x" << h << "exceeds the maximum OpenGL render buffer size" << maxSize;
+			finishHeadlessRendering();
+			return;
+		}
+		headlessFbo = new QOpenGLFramebufferObject(w, h, QOpenGLFramebufferObject::CombinedDepthStencil);
+		if (!headlessFbo->isValid())
+		{
+			qWarning() << "ERROR cannot create the headless framebuffer of" << w << "x" << h;
+			finishHeadlessRendering();
+			return;
+		}
+		app.glWindowHasBeenResized(0, 0, w, h);
+	}
+
+	headlessFbo->bind();
+	glViewport(0, 0, w, h);
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	// The time step is the fixed one of the program clock
+	frameCapture->processReads();
+	app.update(StelApp::getFixedTimeStep());
+	app.draw();
+	frameCapture->setFlagInvertColors(flagInvertScreenShotColors);
+	frameCapture->capture(w, h, StelFileMgr::getScreenshotDir() + QString("/frame-%1").arg(headlessFrame, 5, 10, QLatin1Char('0')));
+	headlessFbo->release();
+	++headlessFrame;
+
+	bool finished = headlessFrameCount>0 && headlessFrame>=headlessFrameCount;
+#ifndef DISABLE_SCRIPTING
+	if (headlessFrameCount<=0)
+		finished = !app.getScriptMgr().scriptIsRunning();
+#else
+	if (headlessFrameCount<=0)
+		finished = true;
+#endif
+	if (finished)
+		finishHeadlessRendering();
+	else
+		QTimer::singleShot(0, this, SLOT(renderHeadlessFrame()));
+}
+
+void StelMainView::finishHeadlessRendering()
+{
+	qDebug() << "Headless rendering finished after" << headlessFrame << "frames";
+	glWidget->makeCurrent();
+	frameCapture->finish();
+	if (frameCapture->getNbStalls()>0)
+		qDebug() << "The frames waited" << frameCapture->getStallTime() << "ms in total for the encoding threads";
+	delete headlessFbo;
+	headlessFbo = NULL;
+	// Back to the system clock, so that the script waits don't wait for frames which won't come
+	StelApp::setFixedTimeStep(0.);
+#ifndef DISABLE_SCRIPTING
+	if (StelApp::getInstance().getScriptMgr().scriptIsRunning())
+		StelApp::getInstance().getScriptMgr().stopScript();
+#endif
+	qApp->quit();
+}
+
 void StelMainView::minFpsChanged()
 {
 	if (minFpsTimer!=NULL)
@@ -1224,6 +1335,10 @@ void StelMainView::keyReleaseEvent(QKeyEvent* event)
 //! Delete openGL textures (to call before the GLContext disappears)
 void StelMainView::deinitGL()
 {
+	// The last screenshots are read from their pixel buffers before the GL context disappears
+	glWidget->makeCurrent();
+	delete frameCapture;
+	frameCapture = NULL;
 	StelApp::getInstance().deinit();
 	delete gui;
 	gui = NULL;
@@ -1240,14 +1355,6 @@ void StelMainView::saveScreenShot(const QString& filePrefix, const QString& save
 void StelMainView::doScreenshot(void)
 {
 	QFileInfo shotDir;
-#if STEL_USE_NEW_OPENGL_WIDGETS
-	QImage im = glWidget->grabFramebuffer();
-#else
-	QImage im = glWidget->grabFrameBuffer();
-#endif
-	if (flagInvertScreenShotColors)
-		im.invertPixels();
-
 	if (screenShotDir == "")
 		shotDir = QFileInfo(StelFileMgr::getScreenshotDir());
 	else
@@ -1264,23 +1371,27 @@ void StelMainView::doScreenshot(void)
 		return;
 	}
 
-	QFileInfo shotPath;
+	QString shotPath;
 	if (flagOverwriteScreenshots)
+		shotPath = shotDir.filePath() + "/" + screenShotPrefix;
+	else
+		shotPath = frameCapture->getNextFileName(shotDir.filePath(), screenShotPrefix);
+	qDebug() << "INFO Saving screenshot in file: " << QDir::toNativeSeparators(shotPath + frameCapture->getFileExtension());
+
+	// The pixels are read asynchronously and saved by a worker thread
+	glWidget->makeCurrent();
+	frameCapture->setFlagInvertColors(flagInvertScreenShotColors);
+	if (headlessFbo)
 	{
-		shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + ".png");
+		// In headless mode the window is never drawn, the last frame is in the offscreen framebuffer
+		headlessFbo->bind();
+		frameCapture->capture(headlessFbo->width(), headlessFbo->height(), shotPath);
+		headlessFbo->release();
 	}
 	else
 	{
-		for (int j=0; j<100000; ++j)
-		{
-			shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + QString("%1").arg(j, 3, 10, QLatin1Char('0')) + ".png");
-			if (!shotPath.exists())
-				break;
-		}
-	}
-	qDebug() << "INFO Saving screenshot in file: " << QDir::toNativeSeparators(shotPath.filePath());
-	if (!im.save(shotPath.filePath())) {
-		qWarning() << "WARNING failed to write screenshot to: " << QDir::toNativeSeparators(shotPath.filePath());
+		const qreal ratio = glWidget->devicePixelRatio();
+		frameCapture->capture(qRound(glWidget->width()*ratio), qRound(glWidget->height()*ratio), shotPath);
 	}
 }
 
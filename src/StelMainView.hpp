@@ -24,6 +24,7 @@
 #include <QGraphicsView>
 #include <QEventLoop>
 #include <QOpenGLContext>
+#include <QSize>
 
 // This define (only used here and in StelMainView.cpp) is temporarily used
 // to allow uncompromised compiling while the migration to the new QOpenGL... classes
@@ -38,6 +39,8 @@ class QGLWidget;
 class StelQGLWidget;
 #endif
 class QMoveEvent;
+class QOpenGLFramebufferObject;
+class StelFrameCapture;
 class QResizeEvent;
 class StelGuiBase;
 class QMoveEvent;
@@ -163,10 +166,17 @@ private slots:
 	void doScreenshot(void);
 	void minFpsChanged();
 	void updateNightModeProperty(bool b);
+	//! Render and save the next frame of the headless mode, and schedule the following one.
+	void renderHeadlessFrame();
 
 private:
 	//! Start the display loop
 	void startMainLoop();
+	//! Start rendering the frames of the headless mode, set by the --headless command line option.
+	//! The window is never shown, the frames are drawn in an offscreen framebuffer with a fixed time step.
+	void startHeadlessRendering();
+	//! Release the headless framebuffer and quit the program.
+	void finishHeadlessRendering();
 	
 	//! provide extended OpenGL diagnostics in logfile.
 	void dumpOpenGLdiagnostics() const;
@@ -200,6 +210,8 @@ private:
 
 	QString screenShotPrefix;
 	QString screenShotDir;
+	//! Reads the screenshots and the headless frames, and saves them in worker threads
+	StelFrameCapture* frameCapture;
 
 	// Number of second before the mouse cursor disappears
 	float cursorTimeout;
@@ -213,6 +225,14 @@ private:
 	float minfps;
 	//! The maximum desired frame rate in frame per second.
 	float maxfps;
+
+	//! Whether the frames are rendered offscreen, without window
+	bool flagHeadless;
+	QSize headlessFrameSize;
+	//! Number of frames to render, 0 to render until the startup script has finished
+	int headlessFrameCount;
+	int headlessFrame;
+	QOpenGLFramebufferObject* headlessFbo;
 };
 
 
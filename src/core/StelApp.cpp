@@ -40,6 +40,7 @@
 #include "ToastMgr.hpp"
 #include "StelActionMgr.hpp"
 #include "StelPropertyMgr.hpp"
+#include "StelProfiler.hpp"
 #include "StelProgressController.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelLocaleMgr.hpp"
@@ -62,6 +63,7 @@
 #include <iostream>
 #include <QDebug>
 #include <QFile>
+#include <QFont>
 #include <QFileInfo>
 #include <QMouseEvent>
 #include <QNetworkAccessManager>
@@ -188,6 +190,8 @@ Q_IMPORT_PLUGIN(RemoteSyncStelPluginInterface)
 StelApp* StelApp::singleton = NULL;
 qint64 StelApp::startMSecs = 0;
 float StelApp::animationScale = 1.f;
+double StelApp::fixedTimeStep = 0.;
+double StelApp::fixedClockMSecs = 0.;
 
 void StelApp::initStatic()
 {
@@ -210,6 +214,7 @@ StelApp::StelApp(QObject* parent)
 	, skyCultureMgr(NULL)
 	, actionMgr(NULL)
 	, propMgr(NULL)
+	, profiler(NULL)
 	, textureMgr(NULL)
 	, stelObjectMgr(NULL)
 	, planetLocationMgr(NULL)
@@ -269,10 +274,14 @@ StelApp::~StelApp()
 {
 	qDebug() << qPrintable(QString("Downloaded %1 files (%2 kbytes) in a session of %3 sec (average of %4 kB/s + %5 files from cache (%6 kB)).").arg(nbDownloadedFiles).arg(totalDownloadedSize/1024).arg(getTotalRunTime()).arg((double)(totalDownloadedSize/1024)/getTotalRunTime()).arg(nbUsedCache).arg(totalUsedCacheSize/1024));
 
-	stelObjectMgr->unSelect();
-	moduleMgr->unloadModule("StelVideoMgr", false);  // We need to delete it afterward
-	moduleMgr->unloadModule("StelSkyLayerMgr", false);  // We need to delete it afterward
-	moduleMgr->unloadModule("StelObjectMgr", false);// We need to delete it afterward
+	// The modules are not loaded when only initCore() was called
+	if (stelObjectMgr)
+	{
+		stelObjectMgr->unSelect();
+		moduleMgr->unloadModule("StelVideoMgr", false);  // We need to delete it afterward
+		moduleMgr->unloadModule("StelSkyLayerMgr", false);  // We need to delete it afterward
+		moduleMgr->unloadModule("StelObjectMgr", false);// We need to delete it afterward
+	}
 	StelModuleMgr* tmp = moduleMgr;
 	moduleMgr = new StelModuleMgr(); // Create a secondary instance to avoid crashes at other deinit
 	delete tmp; tmp=NULL;
@@ -288,6 +297,7 @@ StelApp::~StelApp()
 	delete moduleMgr; moduleMgr=NULL; // Delete the secondary instance
 	delete actionMgr; actionMgr = NULL;
 	delete propMgr; propMgr = NULL;
+	delete profiler; profiler = NULL;
 
 	Q_ASSERT(singleton);
 	singleton = NULL;
@@ -388,21 +398,29 @@ void StelApp::initScriptMgr()
 void StelApp::initScriptMgr() {}
 #endif
 
-void StelApp::init(QSettings* conf)
+void StelApp::initCore(QSettings* conf)
 {
 	confSettings = conf;
 
-	devicePixelsPerPixel = QOpenGLContext::currentContext()->screen()->devicePixelRatio();
-
 	setBaseFontSize(confSettings->value("gui/base_font_size", 13).toInt());
 	
+	// The modules are registered in the property manager
+	propMgr = new StelPropertyMgr();
+
 	core = new StelCore();
 	if (saveProjW!=-1 && saveProjH!=-1)
 		core->windowHasBeenResized(0, 0, saveProjW, saveProjH);
 
-	// Initialize AFTER creation of openGL context
 	textureMgr = new StelTextureMgr();
 	textureMgr->init();
+}
+
+void StelApp::init(QSettings* conf)
+{
+	devicePixelsPerPixel = QOpenGLContext::currentContext()->screen()->devicePixelRatio();
+
+	// Initialize AFTER creation of openGL context
+	initCore(conf);
 
 	networkAccessManager = new QNetworkAccessManager(this);
 	// Activate http cache if Qt version >= 4.5
@@ -418,10 +436,13 @@ void StelApp::init(QSettings* conf)
 	connect(networkAccessManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(reportFileDownloadFinished(QNetworkReply*)));
 
 	//create non-StelModule managers
-	propMgr = new StelPropertyMgr();
 	localeMgr = new StelLocaleMgr();
 	skyCultureMgr = new StelSkyCultureMgr();
 	propMgr->registerObject(skyCultureMgr);
+	profiler = new StelProfiler();
+	profiler->setFlagEnabled(confSettings->value("main/flag_profiler", false).toBool());
+	profiler->setFlagOverlay(confSettings->value("main/flag_profiler_overlay", false).toBool());
+	propMgr->registerObject(profiler);
 	planetLocationMgr = new StelLocationMgr();
 	actionMgr = new StelActionMgr();
 
@@ -631,6 +652,15 @@ void StelApp::update(double deltaTime)
 	if (!initialized)
 		return;
 
+	profiler->beginFrame();
+	StelProfileScope profileScope("update");
+
+	if (fixedTimeStep>0.)
+	{
+		fixedClockMSecs += fixedTimeStep*1000.;
+		deltaTime = fixedTimeStep;
+	}
+
 	++frame;
 	timefr+=deltaTime;
 	if (timefr-timeBase > 1.)
@@ -648,6 +678,7 @@ void StelApp::update(double deltaTime)
 	// Send the event to every StelModule
 	foreach (StelModule* i, moduleMgr->getCallOrders(StelModule::ActionUpdate))
 	{
+		StelProfileScope moduleScope(i->metaObject()->className());
 		i->update(deltaTime);
 	}
 
@@ -685,22 +716,56 @@ void StelApp::draw()
 	int drawFbo;
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &drawFbo);
 
-	prepareRenderBuffer();
-	core->preDraw();
-
-	const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
-	foreach(StelModule* module, modules)
 	{
-		module->draw(core);
-	}
-	core->postDraw();
+		StelProfileScope profileScope("draw", true);
+		prepareRenderBuffer();
+		core->preDraw();
+
+		const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
+		foreach(StelModule* module, modules)
+		{
+			StelProfileScope moduleScope(module->metaObject()->className(), true);
+			module->draw(core);
+		}
+		core->postDraw();
 #ifdef ENABLE_SPOUT
-	// At this point, the sky scene has been drawn, but no GUI panels.
-	if(spoutSender)
-		spoutSender->captureAndSendFrame(drawFbo);
+		// At this point, the sky scene has been drawn, but no GUI panels.
+		if(spoutSender)
+			spoutSender->captureAndSendFrame(drawFbo);
 #endif
-	applyRenderBuffer(drawFbo);
+		applyRenderBuffer(drawFbo);
+	}
+
+	// Start the texture loads requested by the modules
+	textureMgr->update();
+
+	if (profiler->getFlagEnabled() && profiler->getFlagOverlay())
+		drawProfilerOverlay();
+}
 
+void StelApp::drawProfilerOverlay()
+{
+	StelPainter sPainter(core->getProjection2d());
+	QFont font("Courier");
+	font.setStyleHint(QFont::Monospace);
+	font.setPixelSize(getBaseFontSize());
+	sPainter.setFont(font);
+	sPainter.setColor(1.f, 1.f, 0.f, 0.9f);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// The lines start from the top left corner of the viewport
+	const QStringList lines = profiler->getOverlayLines();
+	const QFontMetrics metrics = sPainter.getFontMetrics();
+	const float x = 10.f;
+	float y = core->getProjection2d()->getViewportHeight() - 10.f;
+	foreach (const QString& line, lines)
+	{
+		y -= metrics.height();
+		if (y<0.f)
+			break;
+		sPainter.drawText(x, y, line);
+	}
 }
 
 /*************************************************************************
@@ -860,13 +925,26 @@ void StelApp::updateI18n()
 // Return the time since when stellarium is running in second.
 double StelApp::getTotalRunTime()
 {
-	return (double)(QDateTime::currentMSecsSinceEpoch() - StelApp::startMSecs)/1000.;
+	return (getCurrentMSecs() - StelApp::startMSecs)/1000.;
 }
 
 // Return the scaled time since when stellarium is running in second.
 double StelApp::getAnimationTime()
 {
-	return (double)(QDateTime::currentMSecsSinceEpoch() - StelApp::startMSecs)*StelApp::animationScale/1000.;
+	return (getCurrentMSecs() - StelApp::startMSecs)*StelApp::animationScale/1000.;
+}
+
+double StelApp::getCurrentMSecs()
+{
+	return fixedTimeStep>0. ? fixedClockMSecs : (double)QDateTime::currentMSecsSinceEpoch();
+}
+
+void StelApp::setFixedTimeStep(double seconds)
+{
+	// The fixed clock starts from the current time so that the program time doesn't jump
+	if (fixedTimeStep<=0. && seconds>0.)
+		fixedClockMSecs = QDateTime::currentMSecsSinceEpoch();
+	fixedTimeStep = qMax(seconds, 0.);
 }
 
 void StelApp::reportFileDownloadFinished(QNetworkReply* reply)
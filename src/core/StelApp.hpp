@@ -46,6 +46,7 @@ class StelMainScriptAPIProxy;
 class StelScriptMgr;
 class StelActionMgr;
 class StelPropertyMgr;
+class StelProfiler;
 class StelProgressController;
 
 #ifdef 	ENABLE_SPOUT
@@ -84,6 +85,11 @@ public:
 
 	//! Initialize core and all the modules.
 	void init(QSettings* conf);
+	//! Initialize only the settings, the property manager, the core and the texture manager, which is the
+	//! first step of init(). It doesn't need an OpenGL context, so the computations of the modules can be
+	//! used without the main window, e.g. in the unit tests. The modules created by the caller can then be
+	//! registered in the module manager, and the observer set with StelCore::setObserver().
+	void initCore(QSettings* conf);
 	//! Deinitialize core and all the modules.
 	void deinit();
 
@@ -132,6 +138,9 @@ public:
 	//! Return the property manager
 	StelPropertyMgr* getStelPropertyManager() {return propMgr;}
 
+	//! Return the frame profiler
+	StelProfiler* getProfiler() {return profiler;}
+
 	//! Get the video manager
 	StelVideoMgr* getStelVideoMgr() {return videoMgr;}
 
@@ -246,6 +255,18 @@ public slots:
 	//! Return the scaled time for animated objects
 	static double getAnimationTime();
 
+	//! Get the time of the program clock in milliseconds since the epoch.
+	//! It is the system time, unless a fixed time step is set with setFixedTimeStep().
+	static double getCurrentMSecs();
+
+	//! Make the program clock advance by a fixed step at each update() instead of following the system time,
+	//! so that rendering a sequence of frames gives the same images whatever the time needed to draw them.
+	//! It is meant to be set once at startup, for the headless rendering mode.
+	//! @param seconds the time step, or 0 to follow the system time.
+	static void setFixedTimeStep(double seconds);
+	//! Get the fixed time step of the program clock in seconds, or 0 if it follows the system time.
+	static double getFixedTimeStep() {return fixedTimeStep;}
+
 	//! Report that a download occured. This is used for statistics purposes.
 	//! Connect this slot to QNetworkAccessManager::finished() slot to obtain statistics at the end of the program.
 	void reportFileDownloadFinished(QNetworkReply* reply);
@@ -282,6 +303,8 @@ private:
 	//! Used internally to set the viewport effects.
 	//! @param drawFbo the OpenGL fbo we need to render into.
 	void applyRenderBuffer(int drawFbo=0);
+	//! Draw the timings of the profiler over the sky.
+	void drawProfilerOverlay();
 
 	// The StelApp singleton
 	static StelApp* singleton;
@@ -304,6 +327,9 @@ private:
 	//Property manager for the application
 	StelPropertyMgr* propMgr;
 
+	// Profiler of the frames, measuring the time spent in each module
+	StelProfiler* profiler;
+
 	// Textures manager for the application
 	StelTextureMgr* textureMgr;
 
@@ -367,6 +393,11 @@ private:
 	static qint64 startMSecs;
 	static float animationScale;
 
+	// Fixed time step of the program clock, 0 when it follows the system time
+	static double fixedTimeStep;
+	// Program clock in milliseconds when the time step is fixed
+	static double fixedClockMSecs;
+
 	// Temporary variables used to store the last gl window resize
 	// if the core was not yet initialized
 	int saveProjW;
@@ -40,17 +40,20 @@
 #include "StelPropertyMgr.hpp"
 #include "StelFileMgr.hpp"
 #include "EphemWrapper.hpp"
+#include "EphemCache.hpp"
 #include "precession.h"
 
 #include <QSettings>
 #include <QDebug>
 #include <QMetaEnum>
 #include <QTimeZone>
+#include <QHash>
 #include <QFile>
 #include <QDir>
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 // Init statics transfo matrices
 // See vsop87.doc:
@@ -84,6 +87,7 @@ StelCore::StelCore()
 	, milliSecondsOfLastJDUpdate(0.)
 	, jdOfLastJDUpdate(0.)
 	, flagUseDST(true)
+	, deltaTCacheGeneration(0)
 	, deltaTCustomNDot(-26.0)
 	, deltaTCustomYear(1820.0)
 	, de430Available(false)
@@ -93,9 +97,10 @@ StelCore::StelCore()
 {
 	setObjectName("StelCore");
 	registerMathMetaTypes();
+	invalidateDeltaTCache();
 
 	toneReproducer = new StelToneReproducer();
-	milliSecondsOfLastJDUpdate = QDateTime::currentMSecsSinceEpoch();
+	milliSecondsOfLastJDUpdate = StelApp::getCurrentMSecs();
 
 	QSettings* conf = StelApp::getInstance().getSettings();
 	// Create and initialize the default projector params
@@ -1144,6 +1149,7 @@ void StelCore::setObserver(StelObserver *obs)
 {
 	delete position;
 	position = obs;
+	updateTransformMatrices();
 }
 
 // Smoothly move the observer to the given location
@@ -1171,55 +1177,111 @@ void StelCore::moveObserverTo(const StelLocation& target, double duration, doubl
 	}
 }
 
-float StelCore::getUTCOffset(const double JD) const
+void StelCore::updateTimeZoneTransitions(const QString& name) const
 {
-	int year, month, day, hour, minute, second;
-	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
-	StelUtils::getTimeFromJulianDay(JD, &hour, &minute, &second);
-	// as analogous to second statement in getJDFromDate, nkerr
-	if ( year <= 0 )
+	TimeZoneTransitions& t = timeZoneTransitions;
+	t.name = name;
+	t.JD.clear();
+	t.offset.clear();
+	t.standardOffset.clear();
+	t.firstJD = t.lastJD = 0.;
+	QDateTime first(QDate(1847, 12, 1), QTime(0, 0, 0), Qt::UTC);
+	const QDateTime last(QDate(2100, 1, 1), QTime(0, 0, 0), Qt::UTC);
+	if (name=="system_default")
 	{
-		year = year - 1;
+		// The local time of the system is used, which is only reliable from 1970
+		t.zone = QTimeZone(QTimeZone::systemTimeZoneId());
+		first = QDateTime(QDate(1970, 1, 1), QTime(0, 0, 0), Qt::UTC);
 	}
-	//getTime/DateFromJulianDay returns UTC time, not local time
-	QDateTime universal(QDate(year, month, day), QTime(hour, minute, second), Qt::UTC);
-	if (!universal.isValid())
+	else
+		t.zone = QTimeZone(name.toUtf8());
+	if (!t.zone.isValid() || !t.zone.hasTransitions())
+		return;
+
+	const QTimeZone::OffsetData start = t.zone.offsetData(first);
+	t.JD << StelUtils::qDateTimeToJd(first);
+	t.offset << start.offsetFromUtc;
+	t.standardOffset << start.standardTimeOffset;
+	const QTimeZone::OffsetDataList transitions = t.zone.transitions(first, last);
+	for (int i=0; i<transitions.size(); ++i)
 	{
-		//qWarning() << "JD " << QString("%1").arg(JD) << " out of bounds of QT help with GMT shift, using current datetime";
-		// Assumes the GMT shift was always the same before year -4710
-		universal = QDateTime(QDate(-4710, month, day), QTime(hour, minute, second), Qt::UTC);
+		const QTimeZone::OffsetData& d = transitions.at(i);
+		t.JD << StelUtils::qDateTimeToJd(d.atUtc.toUTC());
+		t.offset << d.offsetFromUtc;
+		t.standardOffset << d.standardTimeOffset;
 	}
+	t.firstJD = t.JD.first();
+	t.lastJD = StelUtils::qDateTimeToJd(last);
+}
+
+float StelCore::getUTCOffset(const double JD) const
+{
+	const StelLocation& loc = getCurrentLocation();
+	const QString tzName = getCurrentTimeZone();
 
-	StelLocation loc = getCurrentLocation();
-	QString tzName = getCurrentTimeZone();
-	QTimeZone* tz = new QTimeZone(tzName.toUtf8());
+	QMutexLocker locker(&timeZoneMutex);
+	if (tzName!=timeZoneTransitions.name)
+		updateTimeZoneTransitions(tzName);
+	const TimeZoneTransitions& t = timeZoneTransitions;
+	const bool isEarth = loc.planetName=="Earth";
+	const bool useZone = tzName=="system_default" || (isEarth && !t.zone.isValid() && !QString("LMST LTST").contains(tzName));
 
 	int shiftInSeconds = 0;
-	if (tzName=="system_default" || (loc.planetName=="Earth" && !tz->isValid() && !QString("LMST LTST").contains(tzName)))
+	// The zone has no precomputed offsets when it is not valid
+	if (JD>=t.firstJD && JD<t.lastJD && (useZone || (isEarth && JD>=StelCore::TZ_ERA_BEGINNING)))
 	{
-		QDateTime local = universal.toLocalTime();
-		//Both timezones should be interpreted as UTC because secsTo() converts both
-		//times to UTC if their zones have different daylight saving time rules.
-		local.setTimeSpec(Qt::UTC);
-		shiftInSeconds = universal.secsTo(local);
+		// Find the last transition before JD in the precomputed offsets
+		const int i = std::upper_bound(t.JD.constBegin(), t.JD.constEnd(), JD) - t.JD.constBegin() - 1;
+		if (useZone || getUseDST())
+			shiftInSeconds = t.offset.at(i);
+		else
+			shiftInSeconds = t.standardOffset.at(i);
 	}
 	else
 	{
-		// The first adoption of a standard time was on December 1, 1847 in Great Britain
-		if (tz->isValid() && loc.planetName=="Earth" && JD>=StelCore::TZ_ERA_BEGINNING)
+		int year, month, day, hour, minute, second;
+		StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
+		StelUtils::getTimeFromJulianDay(JD, &hour, &minute, &second);
+		// as analogous to second statement in getJDFromDate, nkerr
+		if ( year <= 0 )
 		{
-			if (getUseDST())
-				shiftInSeconds = tz->offsetFromUtc(universal);
-			else
-				shiftInSeconds = tz->standardTimeOffset(universal);
+			year = year - 1;
+		}
+		//getTime/DateFromJulianDay returns UTC time, not local time
+		QDateTime universal(QDate(year, month, day), QTime(hour, minute, second), Qt::UTC);
+		if (!universal.isValid())
+		{
+			//qWarning() << "JD " << QString("%1").arg(JD) << " out of bounds of QT help with GMT shift, using current datetime";
+			// Assumes the GMT shift was always the same before year -4710
+			universal = QDateTime(QDate(-4710, month, day), QTime(hour, minute, second), Qt::UTC);
 		}
-		else
-			shiftInSeconds = (loc.longitude/15.f)*3600.f; // Local Mean Solar Time
-
-		if (tzName=="LTST")
-			shiftInSeconds += getSolutionEquationOfTime(JD)*60;
 
+		if (useZone)
+		{
+			QDateTime local = universal.toLocalTime();
+			//Both timezones should be interpreted as UTC because secsTo() converts both
+			//times to UTC if their zones have different daylight saving time rules.
+			local.setTimeSpec(Qt::UTC);
+			shiftInSeconds = universal.secsTo(local);
+		}
+		else
+		{
+			// The first adoption of a standard time was on December 1, 1847 in Great Britain
+			if (t.zone.isValid() && isEarth && JD>=StelCore::TZ_ERA_BEGINNING)
+			{
+				if (getUseDST())
+					shiftInSeconds = t.zone.offsetFromUtc(universal);
+				else
+					shiftInSeconds = t.zone.standardTimeOffset(universal);
+			}
+			else
+				shiftInSeconds = (loc.longitude/15.f)*3600.f; // Local Mean Solar Time
+		}
 	}
+	locker.unlock();
+
+	if (!useZone && tzName=="LTST")
+		shiftInSeconds += getSolutionEquationOfTime(JD)*60;
 
 	float shiftInHours = shiftInSeconds / 3600.0f;
 	return shiftInHours;
@@ -1673,11 +1735,11 @@ void StelCore::updateTime(double deltaTime)
 {
 	if (getRealTimeSpeed())
 	{
-		JD.first = jdOfLastJDUpdate + (QDateTime::currentMSecsSinceEpoch() - milliSecondsOfLastJDUpdate) / 1000.0 * JD_SECOND;
+		JD.first = jdOfLastJDUpdate + (StelApp::getCurrentMSecs() - milliSecondsOfLastJDUpdate) / 1000.0 * JD_SECOND;
 	}
 	else
 	{
-		JD.first = jdOfLastJDUpdate + (QDateTime::currentMSecsSinceEpoch() - milliSecondsOfLastJDUpdate) / 1000.0 * timeSpeed;
+		JD.first = jdOfLastJDUpdate + (StelApp::getCurrentMSecs() - milliSecondsOfLastJDUpdate) / 1000.0 * timeSpeed;
 	}
 
 	// Fix time limits to -100000 to +100000 to prevent bugs
@@ -1714,7 +1776,7 @@ void StelCore::resetSync()
 	//use currentMsecsSinceEpoch directly instead of StelApp::getTotalRuntime,
 	//because the StelApp::startMSecs gets subtracted anyways in update()
 	//also changed to qint64 to increase precision
-	milliSecondsOfLastJDUpdate = QDateTime::currentMSecsSinceEpoch();
+	milliSecondsOfLastJDUpdate = StelApp::getCurrentMSecs();
 	emit timeSyncOccurred(jdOfLastJDUpdate);
 }
 
@@ -1753,8 +1815,42 @@ double StelCore::getDeltaT() const
 }
 
 
+void StelCore::invalidateDeltaTCache()
+{
+	QMutexLocker locker(&deltaTCacheMutex);
+	++deltaTCacheGeneration;
+	if (deltaTCacheGeneration==1)
+	{
+		for (int i=0; i<DeltaTCacheSize; ++i)
+			deltaTCache[i].generation = 0;
+	}
+}
+
 // compute and return DeltaT in seconds. Try not to call it directly, current DeltaT, JD, and JDE are available.
 double StelCore::computeDeltaT(const double JD) const
+{
+	// The same dates are often computed again: by each planet in a frame, or by the ephemeris of the same period
+	DeltaTCacheEntry& entry = deltaTCache[qHash(JD) & (DeltaTCacheSize-1)];
+	deltaTCacheMutex.lock();
+	const int generation = deltaTCacheGeneration;
+	if (entry.generation==generation && entry.JD==JD)
+	{
+		const double DeltaT = entry.deltaT;
+		deltaTCacheMutex.unlock();
+		return DeltaT;
+	}
+	deltaTCacheMutex.unlock();
+
+	const double DeltaT = computeDeltaTUncached(JD);
+
+	QMutexLocker locker(&deltaTCacheMutex);
+	entry.JD = JD;
+	entry.deltaT = DeltaT;
+	entry.generation = generation;
+	return DeltaT;
+}
+
+double StelCore::computeDeltaTUncached(const double JD) const
 {
 	double DeltaT = 0.;
 	double ndot = 0.;
@@ -2269,11 +2365,13 @@ bool StelCore::de431IsActive()
 void StelCore::setDe430Active(bool status)
 {
 	de430Active = de430Available && status;
+	invalidateDeltaTCache();
 }
 
 void StelCore::setDe431Active(bool status)
 {
 	de431Active = de431Available && status;
+	invalidateDeltaTCache();
 }
 
 void StelCore::initEphemeridesFunctions()
@@ -2313,6 +2411,10 @@ void StelCore::initEphemeridesFunctions()
 		EphemWrapper::init_de431(de431FilePath.toStdString().c_str());
 	}
 	setDe431Active(de431Available && conf->value("astro/flag_use_de431", false).toBool());
+
+	//<-- VSOP87/ELP82B cache -->
+	// Maximum difference with the full series in AU, 0 to always evaluate the series.
+	EphemCache::setAccuracy(conf->value("astro/ephemeris_cache_accuracy", 1e-9).toDouble());
 }
 
 // Methods for finding constellation from J2000 position.
@@ -28,7 +28,10 @@
 #include <QString>
 #include <QStringList>
 #include <QTime>
+#include <QTimeZone>
 #include <QPair>
+#include <QMutex>
+#include <QVector>
 
 class StelToneReproducer;
 class StelSkyDrawer;
@@ -216,6 +219,8 @@ public:
 	Vec3d altAzToJ2000(const Vec3d& v, RefractionMode refMode=RefractionAuto) const;
 	Vec3d j2000ToAltAz(const Vec3d& v, RefractionMode refMode=RefractionAuto) const;
 	void j2000ToAltAzInPlaceNoRefraction(Vec3f* v) const {v->transfo4d(matJ2000ToAltAz);}
+	//! Get the matrix used by j2000ToAltAzInPlaceNoRefraction(), e.g. for doing the same transformation on many vectors at once.
+	const Mat4d& getJ2000ToAltAzMatrix() const {return matJ2000ToAltAz;}
 	Vec3d galacticToJ2000(const Vec3d& v) const;
 	Vec3d supergalacticToJ2000(const Vec3d& v) const;
 	Vec3d equinoxEquToJ2000(const Vec3d& v) const;
@@ -279,6 +284,8 @@ public:
 	//! Get the informations on the current location
 	const StelLocation& getCurrentLocation() const;
 	//! Get the UTC offset on the current location (in hours)
+	//! The offsets of the current time zone are precomputed from 1847 to 2100, so that this is cheap to call many times.
+	//! It can be called from any thread.
 	float getUTCOffset(const double JD) const;
 
 	QString getCurrentTimeZone() const;
@@ -292,6 +299,7 @@ public:
 	const StelObserver* getCurrentObserver() const;
 
 	//! Replaces the current observer. StelCore assumes ownership of the observer.
+	//! The transformation matrices are updated for the new observer at the current date.
 	void setObserver(StelObserver* obs);
 
 	SphericalCap getVisibleSkyArea() const;
@@ -359,7 +367,7 @@ public slots:
 	QStringList getAllProjectionTypeKeys() const;
 
 	//! Set the current algorithm for time correction (DeltaT)
-	void setCurrentDeltaTAlgorithm(DeltaTAlgorithm algorithm) { currentDeltaTAlgorithm=algorithm; }
+	void setCurrentDeltaTAlgorithm(DeltaTAlgorithm algorithm) { currentDeltaTAlgorithm=algorithm; invalidateDeltaTCache(); }
 	//! Get the current algorithm for time correction (DeltaT)
 	DeltaTAlgorithm getCurrentDeltaTAlgorithm() const { return currentDeltaTAlgorithm; }
 	//! Get description of the current algorithm for time correction
@@ -471,6 +479,7 @@ public slots:
 	//! @return DeltaT in seconds
 	//! @note Thanks to Rob van Gent which create a collection from many formulas for calculation of Delta-T: http://www.staff.science.uu.nl/~gent0113/deltat/deltat.htm
 	//! @note Use this only if needed, prefer calling getDeltaT() for access to the current value.
+	//! @note The last computed values are cached until the algorithm or its parameters change. It can be called from any thread.
 	double computeDeltaT(const double JD) const;
 	//! Get current DeltaT.
 	double getDeltaT() const;
@@ -650,13 +659,13 @@ public slots:
 
 	//! Set central year for custom equation for calculation of Delta-T
 	//! @param y the year, e.g. 1820
-	void setDeltaTCustomYear(float y) { deltaTCustomYear=y; }
+	void setDeltaTCustomYear(float y) { deltaTCustomYear=y; invalidateDeltaTCache(); }
 	//! Set n-dot for custom equation for calculation of Delta-T
 	//! @param v the n-dot value, e.g. -26.0
-	void setDeltaTCustomNDot(float v) { deltaTCustomNDot=v; }
+	void setDeltaTCustomNDot(float v) { deltaTCustomNDot=v; invalidateDeltaTCache(); }
 	//! Set coefficients for custom equation for calculation of Delta-T
 	//! @param c the coefficients, e.g. -20,0,32
-	void setDeltaTCustomEquationCoefficients(Vec3f c) { deltaTCustomEquationCoeff=c; }
+	void setDeltaTCustomEquationCoefficients(Vec3f c) { deltaTCustomEquationCoeff=c; invalidateDeltaTCache(); }
 
 	//! Get central year for custom equation for calculation of Delta-T
 	float getDeltaTCustomYear() const { return deltaTCustomYear; }
@@ -731,6 +740,13 @@ private:
 
 	void registerMathMetaTypes();
 
+	//! Compute DeltaT without looking in the cache.
+	double computeDeltaTUncached(const double JD) const;
+	//! Forget the cached DeltaT values, to call when the algorithm or its parameters change.
+	void invalidateDeltaTCache();
+	//! Precompute the offsets of a time zone, with timeZoneMutex locked.
+	void updateTimeZoneTransitions(const QString& name) const;
+
 
 	// Matrices used for every coordinate transfo
 	Mat4d matHeliocentricEclipticJ2000ToAltAz; // Transform from heliocentric ecliptic Cartesian (VSOP87A) to topocentric (StelObserver) altazimuthal coordinate
@@ -770,6 +786,31 @@ private:
 	QString currentTimeZone;
 	bool flagUseDST;
 
+	//! The offsets of a time zone between the dates where they change, to avoid converting dates with QTimeZone
+	struct TimeZoneTransitions
+	{
+		QString name;		// name of the zone as in currentTimeZone, empty if not computed yet
+		QTimeZone zone;
+		double firstJD, lastJD;	// range of the precomputed offsets
+		QVector<double> JD;	// JD (UT) from which the offsets apply, increasing
+		QVector<int> offset;	// offset from UTC in seconds, with the daylight saving time
+		QVector<int> standardOffset;	// offset from UTC in seconds, without the daylight saving time
+	};
+	mutable TimeZoneTransitions timeZoneTransitions;
+	mutable QMutex timeZoneMutex;
+
+	//! DeltaT values already computed, indexed by a hash of the JD
+	struct DeltaTCacheEntry
+	{
+		double JD;
+		double deltaT;
+		int generation;		// value of deltaTCacheGeneration when it was computed
+	};
+	static const int DeltaTCacheSize = 256;
+	mutable DeltaTCacheEntry deltaTCache[DeltaTCacheSize];
+	int deltaTCacheGeneration;
+	mutable QMutex deltaTCacheMutex;
+
 	// Variables for custom equation of Delta-T
 	Vec3f deltaTCustomEquationCoeff;
 	float deltaTCustomNDot;
@@ -0,0 +1,241 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelFrameCapture.hpp"
+#include "StelOpenGL.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <cstring>
+
+// Maximum number of reads waiting in pixel buffers. Beyond this the oldest one is mapped at once,
+// even if the GPU may not have finished it.
+static const int maxPendingReads = 3;
+
+//! Pixels to encode in a worker thread
+struct FrameEncodeJob
+{
+	QByteArray pixels;	// RGBA, bottom row first
+	int width, height;
+	bool invert;
+	StelFrameCapture::ImageFormat format;
+	QString fileName;	// with extension
+};
+
+static void runFrameEncodeJob(FrameEncodeJob* job)
+{
+	// The alpha of the framebuffer is left below 1 by blending, the screenshots are opaque
+	const QImage rgbx(reinterpret_cast<const uchar*>(job->pixels.constData()), job->width, job->height, job->width*4, QImage::Format_RGBX8888);
+	// OpenGL rows start from the bottom
+	QImage im = rgbx.mirrored();
+	if (job->invert)
+		im.invertPixels();
+	const char* format = job->format==StelFrameCapture::ImageTIFF ? "TIFF" : (job->format==StelFrameCapture::ImageRaw ? "PPM" : "PNG");
+	if (!im.save(job->fileName, format))
+		qWarning() << "WARNING failed to write screenshot to:" << QDir::toNativeSeparators(job->fileName);
+	delete job;
+}
+
+StelFrameCapture::StelFrameCapture(QObject* parent)
+	: QObject(parent)
+	, imageFormat(ImagePNG)
+	, maxQueueSize(qMax(QThread::idealThreadCount(), 1))
+	, flagInvertColors(false)
+	, pixelBuffersAvailable(-1)
+	, nbCaptured(0)
+	, nbStalls(0)
+	, stallTime(0.)
+	, lastStallReport(0)
+{
+}
+
+StelFrameCapture::~StelFrameCapture()
+{
+	finish();
+	qDeleteAll(freeBuffers);
+}
+
+StelFrameCapture::ImageFormat StelFrameCapture::stringToImageFormat(const QString& s)
+{
+	const QString f = s.toLower();
+	if (f=="tiff" || f=="tif")
+		return ImageTIFF;
+	if (f=="raw" || f=="ppm")
+		return ImageRaw;
+	return ImagePNG;
+}
+
+QString StelFrameCapture::getFileExtension() const
+{
+	switch (imageFormat)
+	{
+		case ImageTIFF:
+			return ".tif";
+		case ImageRaw:
+			return ".ppm";
+		default:
+			return ".png";
+	}
+}
+
+QString StelFrameCapture::getNextFileName(const QString& dir, const QString& prefix)
+{
+	const QString base = dir + "/" + prefix;
+	int j = nextFileNumbers.value(base, 0);
+	// Files may have been added by someone else since the last call
+	while (j<100000 && QFileInfo(base + QString("%1").arg(j, 3, 10, QLatin1Char('0')) + getFileExtension()).exists())
+		++j;
+	nextFileNumbers.insert(base, j+1);
+	return base + QString("%1").arg(j, 3, 10, QLatin1Char('0'));
+}
+
+bool StelFrameCapture::usePixelBuffers()
+{
+#ifndef QT_OPENGL_ES_2
+	if (pixelBuffersAvailable<0)
+	{
+		// The buffers are mapped with glMapBuffer, which can't read on OpenGL ES
+		QOpenGLContext* context = QOpenGLContext::currentContext();
+		pixelBuffersAvailable = context && !context->isOpenGLES() && context->format().version()>=qMakePair(2, 1);
+		qDebug() << "Screenshots use" << (pixelBuffersAvailable ? "asynchronous pixel buffer reads" : "synchronous reads");
+	}
+	return pixelBuffersAvailable>0;
+#else
+	return false;
+#endif
+}
+
+void StelFrameCapture::capture(int width, int height, const QString& fileName)
+{
+	++nbCaptured;
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	if (!usePixelBuffers())
+	{
+		QByteArray pixels(width*height*4, Qt::Uninitialized);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		encode(pixels, width, height, fileName);
+		return;
+	}
+
+	QOpenGLBuffer* buffer;
+	if (!freeBuffers.isEmpty())
+		buffer = freeBuffers.takeLast();
+	else
+	{
+		buffer = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+		buffer->setUsagePattern(QOpenGLBuffer::StreamRead);
+		buffer->create();
+	}
+	buffer->bind();
+	if (buffer->size()!=width*height*4)
+		buffer->allocate(width*height*4);
+	// Returns at once, the transfer is done by the GPU after the pending drawing commands
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	buffer->release();
+
+	PendingRead read;
+	read.buffer = buffer;
+	read.width = width;
+	read.height = height;
+	read.fileName = fileName;
+	read.age = 0;
+	pendingReads.append(read);
+	while (pendingReads.size()>maxPendingReads)
+		finishRead(pendingReads.takeFirst());
+}
+
+void StelFrameCapture::processReads()
+{
+	while (!pendingReads.isEmpty() && pendingReads.first().age>0)
+		finishRead(pendingReads.takeFirst());
+	for (int i=0; i<pendingReads.size(); ++i)
+		++pendingReads[i].age;
+}
+
+void StelFrameCapture::finishRead(const PendingRead& read)
+{
+	QByteArray pixels(read.width*read.height*4, Qt::Uninitialized);
+	read.buffer->bind();
+	const void* data = read.buffer->map(QOpenGLBuffer::ReadOnly);
+	if (data)
+	{
+		std::memcpy(pixels.data(), data, pixels.size());
+		read.buffer->unmap();
+	}
+	read.buffer->release();
+	freeBuffers.append(read.buffer);
+	if (!data)
+	{
+		qWarning() << "WARNING cannot map the pixels of screenshot" << QDir::toNativeSeparators(read.fileName);
+		return;
+	}
+	encode(pixels, read.width, read.height, read.fileName);
+}
+
+void StelFrameCapture::encode(const QByteArray& pixels, int width, int height, const QString& fileName)
+{
+	// Forget the finished encodings
+	while (!encodings.isEmpty() && encodings.first().isFinished())
+		encodings.removeFirst();
+	if (encodings.size()>=maxQueueSize)
+	{
+		// Back-pressure: the workers don't keep up with the captures
+		QElapsedTimer timer;
+		timer.start();
+		while (encodings.size()>=maxQueueSize)
+			encodings.takeFirst().waitForFinished();
+		const double ms = timer.nsecsElapsed()*1e-6;
+		++nbStalls;
+		stallTime += ms;
+		emit backPressure(maxQueueSize, ms);
+		const qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if (now-lastStallReport>5000)
+		{
+			lastStallReport = now;
+			qWarning() << "Screenshot encoding can't keep up:" << nbStalls << "waits for a total of" << stallTime << "ms in" << nbCaptured
+				   << "images, with" << maxQueueSize << "images encoded at the same time";
+		}
+	}
+
+	FrameEncodeJob* job = new FrameEncodeJob;
+	job->pixels = pixels;
+	job->width = width;
+	job->height = height;
+	job->invert = flagInvertColors;
+	job->format = imageFormat;
+	job->fileName = fileName + getFileExtension();
+	encodings.append(QtConcurrent::run(runFrameEncodeJob, job));
+}
+
+void StelFrameCapture::finish()
+{
+	while (!pendingReads.isEmpty())
+		finishRead(pendingReads.takeFirst());
+	while (!encodings.isEmpty())
+		encodings.takeFirst().waitForFinished();
+}
@@ -0,0 +1,134 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELFRAMECAPTURE_HPP_
+#define _STELFRAMECAPTURE_HPP_
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QOpenGLBuffer;
+
+//! @class StelFrameCapture
+//! Save images of the framebuffer without stalling the rendering.
+//! The pixels are read into pixel buffer objects, which are only mapped at the next frame when the GPU has
+//! finished the transfer. They are then encoded and written by worker threads.
+//! The number of images being encoded is bounded: when the workers can't keep up, capture() waits for the oldest
+//! one, and the waits are reported by the backPressure() signal.
+//! Without pixel buffer objects (OpenGL ES), the pixels are read synchronously, the encoding is still threaded.
+//! All the methods must be called from the thread of the OpenGL context.
+class StelFrameCapture : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! The image file formats.
+	enum ImageFormat
+	{
+		ImagePNG,	//!< Compressed PNG (.png)
+		ImageTIFF,	//!< TIFF (.tif), needs the Qt TIFF image plugin
+		ImageRaw	//!< Uncompressed binary PPM (.ppm), the fastest to write
+	};
+
+	StelFrameCapture(QObject* parent=NULL);
+	//! Wait for the pending images, the OpenGL context must be current.
+	~StelFrameCapture();
+
+	//! Get the format from its name: "png", "tiff" or "raw". PNG is returned for unknown names.
+	static ImageFormat stringToImageFormat(const QString& s);
+	void setImageFormat(ImageFormat f) {imageFormat=f;}
+	ImageFormat getImageFormat() const {return imageFormat;}
+	//! Get the file extension of the current format, with the dot.
+	QString getFileExtension() const;
+
+	//! Set the maximum number of images being encoded at the same time.
+	void setMaxQueueSize(int n) {maxQueueSize=qMax(n, 1);}
+	int getMaxQueueSize() const {return maxQueueSize;}
+
+	//! Set whether the colors of the images are inverted.
+	void setFlagInvertColors(bool b) {flagInvertColors=b;}
+
+	//! Get the next file name of a numbered sequence, like dir/prefix042.png, without extension.
+	//! The directory is only scanned for the first free number at the first call for a sequence, the next
+	//! numbers are kept in memory, so that images still being written are not overwritten.
+	QString getNextFileName(const QString& dir, const QString& prefix);
+
+	//! Read the pixels of the bound framebuffer and save them to a file.
+	//! @param width, height the size of the framebuffer
+	//! @param fileName the path of the file, without extension.
+	void capture(int width, int height, const QString& fileName);
+
+	//! Hand the pixels read at the previous frames to the encoding threads.
+	//! Call it once per frame, with the OpenGL context current.
+	void processReads();
+
+	//! Wait for all the reads and encodings to be finished.
+	void finish();
+
+	//! Get the number of images passed to capture().
+	int getNbCapturedImages() const {return nbCaptured;}
+	//! Get the number of times capture() had to wait for a worker.
+	int getNbStalls() const {return nbStalls;}
+	//! Get the total time spent waiting for the workers in milliseconds.
+	double getStallTime() const {return stallTime;}
+
+signals:
+	//! Emitted when the encoding queue was full and capture() waited for a worker.
+	//! @param queueSize the maximum number of images being encoded
+	//! @param stallMs the time spent waiting, in milliseconds
+	void backPressure(int queueSize, double stallMs);
+
+private:
+	//! Pixels being read into a pixel buffer object
+	struct PendingRead
+	{
+		QOpenGLBuffer* buffer;
+		int width, height;
+		QString fileName;
+		int age;		// number of processReads() since the read was issued
+	};
+
+	//! Whether pixel buffer objects can be used with the current context.
+	bool usePixelBuffers();
+	//! Map a pixel buffer, copy its pixels and pass them to the encoding threads.
+	void finishRead(const PendingRead& read);
+	//! Pass pixels to the encoding threads, waiting if the queue is full.
+	void encode(const QByteArray& pixels, int width, int height, const QString& fileName);
+
+	ImageFormat imageFormat;
+	int maxQueueSize;
+	bool flagInvertColors;
+	int pixelBuffersAvailable;	// -1 if not checked yet
+
+	QHash<QString, int> nextFileNumbers;
+	QList<PendingRead> pendingReads;
+	QVector<QOpenGLBuffer*> freeBuffers;
+	QList<QFuture<void> > encodings;
+
+	int nbCaptured;
+	int nbStalls;
+	double stallTime;
+	qint64 lastStallReport;
+};
+
+#endif // _STELFRAMECAPTURE_HPP_
@@ -88,7 +88,7 @@ static const TopLevelTriangle icosahedron_triangles[20] =
         {{ 8, 9, 5}}  //  8
     };
 
-StelGeodesicGrid::StelGeodesicGrid(const int lev) : maxLevel(lev<0?0:lev), lastMaxSearchlevel(-1)
+StelGeodesicGrid::StelGeodesicGrid(const int lev) : maxLevel(lev<0?0:lev)
 {
 	if (maxLevel > 0)
 	{
@@ -112,7 +112,6 @@ StelGeodesicGrid::StelGeodesicGrid(const int lev) : maxLevel(lev<0?0:lev), lastM
 	{
 		triangles = 0;
 	}
-	cacheSearchResult = new GeodesicSearchResult(*this);
 }
 
 StelGeodesicGrid::~StelGeodesicGrid(void)
@@ -122,8 +121,8 @@ StelGeodesicGrid::~StelGeodesicGrid(void)
 		for (int i=maxLevel-1;i>=0;i--) delete[] triangles[i];
 		delete[] triangles;
 	}
-	delete cacheSearchResult;
-	cacheSearchResult = NULL;
+	qDeleteAll(searchCache);
+	searchCache.clear();
 }
 
 void StelGeodesicGrid::getTriangleCorners(int lev,int index,
@@ -310,8 +309,19 @@ int StelGeodesicGrid::getZoneNumberForPoint(const Vec3f &v,int searchLevel) cons
 }
 
 
+// Same test as SphericalCap::contains(), also keeping the smallest distance between the tested points and the plane of the cap.
+// As long as the cap moves less than this distance, no point can cross the border of the cap.
+static inline bool containsWithMargin(const SphericalCap& cap, const Vec3f& v, double& margin)
+{
+	const double m = v[0]*cap.n[0]+v[1]*cap.n[1]+v[2]*cap.n[2]-cap.d;
+	const double a = std::fabs(m);
+	if (a<margin)
+		margin = a;
+	return m>=0.;
+}
+
 // First iteration on the icosahedron base triangles
-void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
+double StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
                                int **inside_list,int **border_list,
                                int maxSearchLevel) const
 {
@@ -329,12 +339,13 @@ void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
 #else
 	bool corner_inside[12][convex.size()];
 #endif
+	double margin = 2.;
 	for (int h=0;h<convex.size();h++)
 	{
 		const SphericalCap& half_space(convex.at(h));
 		for (int i=0;i<12;i++)
 		{
-			corner_inside[i][h] = half_space.contains(icosahedron_corners[i]);
+			corner_inside[i][h] = containsWithMargin(half_space, icosahedron_corners[i], margin);
 		}
 	}
 	for (int i=0;i<20;i++)
@@ -344,12 +355,13 @@ void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
 		            corner_inside[icosahedron_triangles[i].corners[0]],
 		            corner_inside[icosahedron_triangles[i].corners[1]],
 		            corner_inside[icosahedron_triangles[i].corners[2]],
-		            inside_list,border_list,maxSearchLevel);
+		            inside_list,border_list,maxSearchLevel,margin);
 	}
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 	delete[] halfs_used;
 	for(int ci=0; ci < 12; ci++) delete[] corner_inside[ci];
 #endif
+	return margin;
 }
 
 void StelGeodesicGrid::searchZones(int lev,int index,
@@ -360,7 +372,8 @@ void StelGeodesicGrid::searchZones(int lev,int index,
                                const bool *corner1_inside,
                                const bool *corner2_inside,
                                int **inside_list,int **border_list,
-                               const int maxSearchLevel) const
+                               const int maxSearchLevel,
+                               double& margin) const
 {
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 	int *halfs_used = new int[halfSpacesUsed];
@@ -416,26 +429,26 @@ void StelGeodesicGrid::searchZones(int lev,int index,
 			{
 				const int i = halfs_used[h];
 				const SphericalCap& half_space(convex.at(i));
-				edge0_inside[i] = half_space.contains(t.e0);
-				edge1_inside[i] = half_space.contains(t.e1);
-				edge2_inside[i] = half_space.contains(t.e2);
+				edge0_inside[i] = containsWithMargin(half_space, t.e0, margin);
+				edge1_inside[i] = containsWithMargin(half_space, t.e1, margin);
+				edge2_inside[i] = containsWithMargin(half_space, t.e2, margin);
 			}
 			searchZones(lev,index+0,
 			            convex,halfs_used,halfs_used_count,
 			            corner0_inside,edge2_inside,edge1_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+1,
 			            convex,halfs_used,halfs_used_count,
 			            edge2_inside,corner1_inside,edge0_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+2,
 			            convex,halfs_used,halfs_used_count,
 			            edge1_inside,edge0_inside,corner2_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+3,
 			            convex,halfs_used,halfs_used_count,
 			            edge0_inside,edge1_inside,edge2_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 			delete[] edge0_inside;
 			delete[] edge1_inside;
@@ -455,16 +468,31 @@ end:
 *************************************************************************/
 const GeodesicSearchResult* StelGeodesicGrid::search(const QVector<SphericalCap>& convex, int maxSearchLevel) const
 {
-	// Try to use the cached version
-	if (maxSearchLevel==lastMaxSearchlevel && convex==lastSearchRegion)
+	// Try to use a cached version
+	for (int i=0;i<searchCache.size();i++)
 	{
-		return cacheSearchResult;
+		bool exact;
+		if (searchCache.at(i)->isValidFor(convex, maxSearchLevel, &exact))
+		{
+			if (exact)
+				++searchStatistics.exactHits;
+			else
+				++searchStatistics.nearHits;
+			if (i>0)
+				searchCache.move(i, 0);
+			return searchCache.first();
+		}
 	}
-	// Else recompute it and update cache parameters
-	lastMaxSearchlevel = maxSearchLevel;
-	lastSearchRegion = convex;
-	cacheSearchResult->search(convex, maxSearchLevel);
-	return cacheSearchResult;
+	// Else recompute it in the least recently used result
+	++searchStatistics.misses;
+	GeodesicSearchResult* result;
+	if (searchCache.size()<SearchCacheSize)
+		result = new GeodesicSearchResult(*this);
+	else
+		result = searchCache.takeLast();
+	searchCache.prepend(result);
+	result->search(convex, maxSearchLevel);
+	return result;
 }
 
 
@@ -472,7 +500,9 @@ GeodesicSearchResult::GeodesicSearchResult(const StelGeodesicGrid &grid)
 		:grid(grid),
 		zones(new int*[grid.getMaxLevel()+1]),
 		inside(new int*[grid.getMaxLevel()+1]),
-		border(new int*[grid.getMaxLevel()+1])
+		border(new int*[grid.getMaxLevel()+1]),
+		searchLevel(-1),
+		margin(0.)
 {
 	for (int i=0;i<=grid.getMaxLevel();i++)
 	{
@@ -498,7 +528,33 @@ void GeodesicSearchResult::search(const QVector<SphericalCap>& convex, int maxSe
 		inside[i] = zones[i];
 		border[i] = zones[i]+StelGeodesicGrid::nrOfZones(i);
 	}
-	grid.searchZones(convex,inside,border,maxSearchLevel);
+	searchLevel = maxSearchLevel;
+	region = convex;
+	margin = grid.searchZones(convex,inside,border,maxSearchLevel);
+}
+
+bool GeodesicSearchResult::isValidFor(const QVector<SphericalCap>& convex, int maxSearchLevel, bool* exact) const
+{
+	*exact = false;
+	if (maxSearchLevel!=searchLevel || convex.size()!=region.size())
+		return false;
+	// For a tested corner v (|v|=1) and a cap moved from (n,d) to (n',d'):
+	// |(v*n'-d') - (v*n-d)| <= |n'-n| + |d'-d|
+	// so no test can change if each cap moved less than the margin, and the same zones would be found.
+	bool same = true;
+	for (int i=0;i<convex.size();i++)
+	{
+		const SphericalCap& a = convex.at(i);
+		const SphericalCap& b = region.at(i);
+		if (a==b)
+			continue;
+		same = false;
+		// The corners are stored in floats, so their length can be a bit more than 1
+		if (((a.n-b.n).length()+std::fabs(a.d-b.d))*1.000001>=margin)
+			return false;
+	}
+	*exact = same;
+	return true;
 }
 
 void GeodesicSearchInsideIterator::reset(void)
@@ -37,6 +37,8 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 
 #include "StelSphereGeometry.hpp"
 
+#include <QList>
+
 class GeodesicSearchResult;
 
 //! @class StelGeodesicGrid
@@ -77,10 +79,28 @@ public:
 	int getPartnerTriangle(int lev, int index) const;
 	
 	//! Return a search result matching the given spatial region
-	//! The result is cached, meaning that it is very fast to search the same region consecutively
-	//! @return a GeodesicSearchResult instance which must be used with GeodesicSearchBorderIterator and GeodesicSearchInsideIterator
+	//! The last results are cached, meaning that it is very fast to search again one of the last regions.
+	//! A cached result is also returned for a region which moved so little since it was searched that no zone corner
+	//! can have crossed the border of a cap: a new search would give exactly the same zones.
+	//! @return a GeodesicSearchResult instance which must be used with GeodesicSearchBorderIterator and GeodesicSearchInsideIterator.
+	//! It stays valid until SearchCacheSize other regions are searched.
 	const GeodesicSearchResult* search(const QVector<SphericalCap>& convex, int maxSearchLevel) const;
 
+	//! Number of search results kept in the cache.
+	static const int SearchCacheSize = 4;
+
+	//! Counters of the calls to search().
+	struct SearchStatistics
+	{
+		SearchStatistics() : exactHits(0), nearHits(0), misses(0) {}
+		int exactHits;	//!< the region was the one of a cached result
+		int nearHits;	//!< the region was close enough to the one of a cached result
+		int misses;	//!< the zones had to be searched
+	};
+	//! Get the counters of the calls to search(), to check the efficiency of the cache.
+	const SearchStatistics& getSearchStatistics() const {return searchStatistics;}
+	void resetSearchStatistics() {searchStatistics = SearchStatistics();}
+
 private:
 	friend class GeodesicSearchResult;
 	
@@ -99,7 +119,8 @@ private:
 	//! in inside[l1] for some l1 < l.
 	//! In order to restrict search depth set maxSearchLevel < maxLevel,
 	//! for full search depth set maxSearchLevel = maxLevel,
-	void searchZones(const QVector<SphericalCap>& convex,
+	//! @return the smallest distance between a tested corner and the plane of a cap.
+	double searchZones(const QVector<SphericalCap>& convex,
 					 int **inside,int **border,int maxSearchLevel) const;
 	
 	const Vec3f& getTriangleCorner(int lev, int index, int cornerNumber) const;
@@ -121,7 +142,8 @@ private:
 	                 const bool *corner0_inside,
 	                 const bool *corner1_inside,
 	                 const bool *corner2_inside,
-	                 int **inside,int **border,int maxSearchLevel) const;
+	                 int **inside,int **border,int maxSearchLevel,
+	                 double& margin) const;
 
 	const int maxLevel;
 	struct Triangle
@@ -132,10 +154,9 @@ private:
 	// 20*(4^0+4^1+...+4^n)=20*(4*(4^n)-1)/3 triangles total
 	// 2+10*4^n corners
 	
-	//! A cached search result used to avoid doing twice the same search
-	mutable GeodesicSearchResult* cacheSearchResult;
-	mutable int lastMaxSearchlevel;
-	mutable QVector<SphericalCap> lastSearchRegion;
+	//! The cached search results used to avoid doing twice the same search, the most recently used first
+	mutable QList<GeodesicSearchResult*> searchCache;
+	mutable SearchStatistics searchStatistics;
 };
 
 class GeodesicSearchResult
@@ -150,11 +171,19 @@ private:
 	friend class StelGeodesicGrid;
 	
 	void search(const QVector<SphericalCap>& convex, int maxSearchLevel);
+	//! Return whether the zones found for the searched region are also the ones of the given region.
+	bool isValidFor(const QVector<SphericalCap>& convex, int maxSearchLevel, bool* exact) const;
 	
 	const StelGeodesicGrid &grid;
 	int **const zones;
 	int **const inside;
 	int **const border;
+
+	//! The searched region, -1 if no search was done
+	int searchLevel;
+	QVector<SphericalCap> region;
+	//! Smallest distance between the corners tested by the search and the planes of the caps of the region
+	double margin;
 };
 
 class GeodesicSearchBorderIterator
@@ -0,0 +1,164 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelNameIndex.hpp"
+
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+
+// Order of the suffixes, the name index makes the order of equal suffixes deterministic
+struct StelNameIndex::EntryLess
+{
+	EntryLess(const QVector<QString>& akeys) : keys(akeys) {}
+	bool operator()(const Entry& a, const Entry& b) const
+	{
+		const int c = QStringRef::compare(keys.at(a.name).midRef(a.pos), keys.at(b.name).midRef(b.pos));
+		return c<0 || (c==0 && a.name<b.name);
+	}
+	const QVector<QString>& keys;
+};
+
+// Compare a suffix with a searched text, for the binary search
+struct StelNameIndex::EntryPrefixLess
+{
+	EntryPrefixLess(const QVector<QString>& akeys) : keys(akeys) {}
+	bool operator()(const Entry& a, const QString& key) const
+	{
+		return QStringRef::compare(keys.at(a.name).midRef(a.pos), key)<0;
+	}
+	const QVector<QString>& keys;
+};
+
+// Order of the names in the results
+struct NameIndexLess
+{
+	NameIndexLess(const QVector<QString>& akeys) : keys(akeys) {}
+	bool operator()(int a, int b) const
+	{
+		const int c = QString::compare(keys.at(a), keys.at(b));
+		return c<0 || (c==0 && a<b);
+	}
+	const QVector<QString>& keys;
+};
+
+StelNameIndex::StelNameIndex() : nbSortedEntries(0)
+{
+}
+
+void StelNameIndex::insert(const QString& name, bool prefixOnly)
+{
+	if (name.isEmpty())
+		return;
+	const int n = names.size();
+	names.append(name);
+	keys.append(name.toUpper());
+	Entry e;
+	e.name = n;
+	const int nbEntries = prefixOnly ? 1 : keys.last().size();
+	for (e.pos=0; e.pos<nbEntries; ++e.pos)
+		entries.append(e);
+}
+
+void StelNameIndex::clear()
+{
+	names.clear();
+	keys.clear();
+	entries.clear();
+	nbSortedEntries = 0;
+}
+
+void StelNameIndex::sortEntries() const
+{
+	if (nbSortedEntries==entries.size())
+		return;
+	// Only the new entries are sorted, then merged with the others
+	EntryLess less(keys);
+	std::sort(entries.begin()+nbSortedEntries, entries.end(), less);
+	std::inplace_merge(entries.begin(), entries.begin()+nbSortedEntries, entries.end(), less);
+	nbSortedEntries = entries.size();
+}
+
+void StelNameIndex::findRange(const QString& key, int& begin, int& end) const
+{
+	sortEntries();
+	QVector<Entry>::const_iterator first = std::lower_bound(entries.constBegin(), entries.constEnd(), key, EntryPrefixLess(keys));
+	begin = first - entries.constBegin();
+	end = begin;
+	while (end<entries.size() && keys.at(entries.at(end).name).midRef(entries.at(end).pos).startsWith(key))
+		++end;
+}
+
+QStringList StelNameIndex::getNames(QVector<int>& nameIndices, int maxNbItem) const
+{
+	// Keep the first index of each distinct name, so that only the returned names need to be sorted
+	QHash<QString, int> firstIndices;
+	firstIndices.reserve(nameIndices.size());
+	foreach (int i, nameIndices)
+	{
+		QHash<QString, int>::iterator it = firstIndices.find(names.at(i));
+		if (it==firstIndices.end())
+			firstIndices.insert(names.at(i), i);
+		else if (i<it.value())
+			it.value() = i;
+	}
+	nameIndices = firstIndices.values().toVector();
+	const int nbItems = qMin(maxNbItem, nameIndices.size());
+	std::partial_sort(nameIndices.begin(), nameIndices.begin()+nbItems, nameIndices.end(), NameIndexLess(keys));
+	QStringList result;
+	for (int i=0; i<nbItems; ++i)
+		result.append(names.at(nameIndices.at(i)));
+	return result;
+}
+
+QStringList StelNameIndex::findPrefix(const QString& prefix, int maxNbItem) const
+{
+	if (maxNbItem<=0)
+		return QStringList();
+	const QString key = prefix.toUpper();
+	sortEntries();
+	// The whole names are the suffixes at position 0, they come in alphabetical order.
+	QVector<int> nameIndices;
+	QSet<QString> found;
+	QVector<Entry>::const_iterator it = std::lower_bound(entries.constBegin(), entries.constEnd(), key, EntryPrefixLess(keys));
+	for (; it!=entries.constEnd() && found.size()<maxNbItem; ++it)
+	{
+		const QString& k = keys.at(it->name);
+		if (!k.midRef(it->pos).startsWith(key))
+			break;
+		if (it->pos!=0 || found.contains(names.at(it->name)))
+			continue;
+		found.insert(names.at(it->name));
+		nameIndices.append(it->name);
+	}
+	return getNames(nameIndices, maxNbItem);
+}
+
+QStringList StelNameIndex::findSubstring(const QString& text, int maxNbItem) const
+{
+	if (maxNbItem<=0)
+		return QStringList();
+	int begin, end;
+	findRange(text.toUpper(), begin, end);
+	QVector<int> nameIndices;
+	nameIndices.reserve(end-begin);
+	for (int i=begin; i<end; ++i)
+		nameIndices.append(entries.at(i).name);
+	return getNames(nameIndices, maxNbItem);
+}
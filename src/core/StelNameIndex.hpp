@@ -0,0 +1,85 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELNAMEINDEX_HPP_
+#define _STELNAMEINDEX_HPP_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelNameIndex
+//! Index of object names for the auto-completion of StelObjectModule::listMatchingObjects().
+//! The suffixes of the upper case names are kept in a sorted array, so that finding the names
+//! starting with, or containing, a given text is a binary search instead of a scan of all names.
+//! Names can be added at any time, they are merged in the sorted array at the next query.
+class StelNameIndex
+{
+public:
+	StelNameIndex();
+
+	//! Add a name to the index.
+	//! @param name the name, as it is returned by the queries.
+	//! @param prefixOnly if true, the name is only found by findPrefix(). Use it for designations
+	//! like catalog numbers, which are not searched by their middle, and save the memory of their suffixes.
+	void insert(const QString& name, bool prefixOnly=false);
+
+	//! Remove all the names.
+	void clear();
+
+	//! Get the number of names in the index.
+	int size() const {return names.size();}
+
+	//! Find the names starting with a given text, ignoring the case.
+	//! @param prefix the beginning of the names
+	//! @param maxNbItem the maximum number of names returned
+	//! @return the names in alphabetical order of their upper case form, without duplicates.
+	QStringList findPrefix(const QString& prefix, int maxNbItem) const;
+
+	//! Find the names containing a given text, ignoring the case.
+	//! Names added with prefixOnly are only found if they start with the text.
+	//! @param text the searched text
+	//! @param maxNbItem the maximum number of names returned
+	//! @return the names in alphabetical order of their upper case form, without duplicates.
+	QStringList findSubstring(const QString& text, int maxNbItem) const;
+
+private:
+	//! A suffix of a name
+	struct Entry
+	{
+		int name;	// index in names and keys
+		int pos;	// start of the suffix in the key
+	};
+	struct EntryLess;
+	struct EntryPrefixLess;
+
+	//! Sort the entries added since the last query.
+	void sortEntries() const;
+	//! Get the range of sorted entries starting with the upper case text.
+	void findRange(const QString& key, int& begin, int& end) const;
+	//! Get at most maxNbItem distinct names from a list of name indices, in the order of their keys.
+	QStringList getNames(QVector<int>& nameIndices, int maxNbItem) const;
+
+	QVector<QString> names;
+	QVector<QString> keys;		// upper case names
+	mutable QVector<Entry> entries;
+	mutable int nbSortedEntries;	// entries after this one were added since the last sort
+};
+
+#endif // _STELNAMEINDEX_HPP_
@@ -54,6 +54,11 @@ StelPainter::BasicShaderVars StelPainter::basicShaderVars;
 StelPainter::TexturesShaderVars StelPainter::texturesShaderVars;
 StelPainter::BasicShaderVars StelPainter::colorShaderVars;
 StelPainter::TexturesColorShaderVars StelPainter::texturesColorShaderVars;
+QOpenGLShaderProgram* StelPainter::projectionShaderProgram=NULL;
+StelPainter::ProjectionShaderVars StelPainter::projectionShaderVars;
+QHash<int, StelPainter::RetainedArray*> StelPainter::retainedArrays;
+QVector<StelPainter::RetainedArray*> StelPainter::releasedRetainedArrays;
+int StelPainter::nextRetainedArrayId = 0;
 
 StelPainter::GLState::GLState()
 {
@@ -1431,6 +1436,159 @@ void StelPainter::drawStelVertexArray(const StelVertexArray& arr, bool checkDisc
 	enableClientStates(false);
 }
 
+int StelPainter::retainArray(const StelVertexArray& arr)
+{
+	RetainedArray* ra = new RetainedArray();
+	ra->arr = arr;
+	const int id = nextRetainedArrayId++;
+	retainedArrays.insert(id, ra);
+	return id;
+}
+
+void StelPainter::releaseRetainedArray(int id)
+{
+	RetainedArray* ra = retainedArrays.take(id);
+	if (!ra)
+		return;
+	if (ra->vertexBuffer.isCreated())
+		releasedRetainedArrays.append(ra);
+	else
+		delete ra;
+}
+
+void StelPainter::deleteReleasedArrays()
+{
+	foreach (RetainedArray* ra, releasedRetainedArrays)
+	{
+		ra->vertexBuffer.destroy();
+		ra->indexBuffer.destroy();
+		delete ra;
+	}
+	releasedRetainedArrays.clear();
+}
+
+bool StelPainter::getShaderProjectionParams(StelProjectionParams& params) const
+{
+	// The projections with discontinuities need the triangles to be checked on the CPU
+	if (!projectionShaderProgram || !prj->getProjectionParams(params) || prj->hasDiscontinuity())
+		return false;
+	switch (params.type)
+	{
+		case StelProjectionPerspective:
+		case StelProjectionEqualArea:
+		case StelProjectionStereographic:
+		case StelProjectionFisheye:
+		case StelProjectionOrthographic:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void StelPainter::drawRetainedArray(int id, bool checkDiscontinuity)
+{
+	RetainedArray* ra = retainedArrays.value(id);
+	Q_ASSERT(ra);
+	if (!ra || ra->arr.vertex.isEmpty())
+		return;
+	if (!releasedRetainedArrays.isEmpty())
+		deleteReleasedArrays();
+
+	StelProjectionParams params;
+	if (!getShaderProjectionParams(params))
+	{
+		drawStelVertexArray(ra->arr, checkDiscontinuity);
+		return;
+	}
+
+	const StelVertexArray& arr = ra->arr;
+	if (!ra->vertexBuffer.isCreated())
+	{
+		// The shader works in single precision, like the CPU projection after the model view transformation
+		const int n = arr.vertex.size();
+		QVector<float> data;
+		data.reserve(n*3 + (arr.isTextured() ? n*2 : 0) + (arr.isColored() ? n*3 : 0));
+		for (int i=0; i<n; ++i)
+			data << arr.vertex.at(i)[0] << arr.vertex.at(i)[1] << arr.vertex.at(i)[2];
+		ra->texCoordOffset = data.size()*sizeof(float);
+		if (arr.isTextured())
+		{
+			for (int i=0; i<n; ++i)
+				data << arr.texCoords.at(i)[0] << arr.texCoords.at(i)[1];
+		}
+		ra->colorOffset = data.size()*sizeof(float);
+		if (arr.isColored())
+		{
+			for (int i=0; i<n; ++i)
+				data << arr.colors.at(i)[0] << arr.colors.at(i)[1] << arr.colors.at(i)[2];
+		}
+		ra->vertexBuffer.create();
+		ra->vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		ra->vertexBuffer.bind();
+		ra->vertexBuffer.allocate(data.constData(), data.size()*sizeof(float));
+		ra->vertexBuffer.release();
+		if (arr.isIndexed())
+		{
+			ra->indexBuffer.create();
+			ra->indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+			ra->indexBuffer.bind();
+			ra->indexBuffer.allocate(arr.indices.constData(), arr.indices.size()*sizeof(unsigned short));
+			ra->indexBuffer.release();
+		}
+	}
+
+	const Mat4f& m = getProjector()->getProjectionMatrix();
+	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+	const double* mv = params.modelView;
+	const QMatrix4x4 qModelView(mv[0], mv[4], mv[8], mv[12], mv[1], mv[5], mv[9], mv[13], mv[2], mv[6], mv[10], mv[14], mv[3], mv[7], mv[11], mv[15]);
+
+	QOpenGLShaderProgram* pr = projectionShaderProgram;
+	const ProjectionShaderVars& vars = projectionShaderVars;
+	pr->bind();
+	pr->setUniformValue(vars.projectionMatrix, qMat);
+	pr->setUniformValue(vars.modelView, qModelView);
+	pr->setUniformValue(vars.projectionType, (GLint)params.type);
+	pr->setUniformValue(vars.widthStretch, params.widthStretch);
+	pr->setUniformValue(vars.viewportCenter, params.viewportCenter[0], params.viewportCenter[1]);
+	pr->setUniformValue(vars.viewportScale, params.flipHorz*params.pixelPerRad, params.flipVert*params.pixelPerRad);
+	pr->setUniformValue(vars.depthParams, params.zNear, params.oneOverZNearMinusZFar);
+	pr->setUniformValue(vars.useTexture, (GLint)arr.isTextured());
+
+	ra->vertexBuffer.bind();
+	pr->setAttributeBuffer(vars.vertex, GL_FLOAT, 0, 3);
+	pr->enableAttributeArray(vars.vertex);
+	if (arr.isTextured())
+	{
+		pr->setAttributeBuffer(vars.texCoord, GL_FLOAT, ra->texCoordOffset, 2);
+		pr->enableAttributeArray(vars.texCoord);
+	}
+	// Like the other shaders, the vertex colors replace the current color
+	if (arr.isColored())
+	{
+		pr->setAttributeBuffer(vars.color, GL_FLOAT, ra->colorOffset, 3);
+		pr->enableAttributeArray(vars.color);
+	}
+	else
+		pr->setAttributeValue(vars.color, currentColor[0], currentColor[1], currentColor[2], currentColor[3]);
+
+	if (arr.isIndexed())
+	{
+		ra->indexBuffer.bind();
+		glDrawElements(arr.primitiveType, arr.indices.size(), GL_UNSIGNED_SHORT, 0);
+		ra->indexBuffer.release();
+	}
+	else
+		glDrawArrays(arr.primitiveType, 0, arr.vertex.size());
+
+	pr->disableAttributeArray(vars.vertex);
+	if (arr.isTextured())
+		pr->disableAttributeArray(vars.texCoord);
+	if (arr.isColored())
+		pr->disableAttributeArray(vars.color);
+	ra->vertexBuffer.release();
+	pr->release();
+}
+
 void StelPainter::drawSphericalTriangles(const StelVertexArray& va, bool textured, bool colored, const SphericalCap* clippingCap, bool doSubDivide, double maxSqDistortion)
 {
 	if (va.vertex.isEmpty())
@@ -1972,6 +2130,105 @@ void StelPainter::initGLShaders()
 	texturesColorShaderVars.vertex = texturesColorShaderProgram->attributeLocation("vertex");
 	texturesColorShaderVars.color = texturesColorShaderProgram->attributeLocation("color");
 	texturesColorShaderVars.texture = texturesColorShaderProgram->uniformLocation("tex");
+
+	// Projection of the retained arrays, the formulas are the forward() methods of StelProjectorClasses.cpp.
+	// FLT_MAX is replaced by 1e15, which is also far outside of the viewport and fits in a GLSL ES highp float.
+	QOpenGLShader vshaderProjection(QOpenGLShader::Vertex);
+	const QString vshaderProjectionSrc = QString(
+		"attribute highp vec3 vertex;\n"
+		"attribute mediump vec2 texCoord;\n"
+		"attribute mediump vec4 color;\n"
+		"uniform highp mat4 projectionMatrix;\n"
+		"uniform highp mat4 modelView;\n"
+		"uniform int projectionType;\n"
+		"uniform highp float widthStretch;\n"
+		"uniform highp vec2 viewportCenter;\n"
+		"uniform highp vec2 viewportScale;\n"
+		"uniform highp vec2 depthParams;\n"
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec4 outColor;\n"
+		"void main(void)\n"
+		"{\n"
+		"    highp vec3 v = (modelView*vec4(vertex, 1.)).xyz;\n"
+		"    highp float r = length(v);\n"
+		"    highp vec3 p = vec3(1e15, 1e15, -1e15);\n"
+		"    if (projectionType==%1)\n"
+		"    {\n"
+		"        if (v.z<0.) p = vec3(v.x*widthStretch/(-v.z), v.y/(-v.z), r);\n"
+		"        else if (v.z>0.) p = vec3(v.x*widthStretch/v.z, v.y/v.z, -1e15);\n"
+		"    }\n"
+		"    else if (projectionType==%2)\n"
+		"    {\n"
+		"        highp float f = sqrt(2./(r*(r-v.z)));\n"
+		"        p = vec3(v.x*f*widthStretch, v.y*f, r);\n"
+		"    }\n"
+		"    else if (projectionType==%3)\n"
+		"    {\n"
+		"        highp float h = 0.5*(r-v.z);\n"
+		"        if (h>0.) p = vec3(v.x*widthStretch/h, v.y/h, r);\n"
+		"        else p.z = 0.;\n"
+		"    }\n"
+		"    else if (projectionType==%4)\n"
+		"    {\n"
+		"        highp float rq1 = v.x*v.x + v.y*v.y;\n"
+		"        if (rq1>0.)\n"
+		"        {\n"
+		"            highp float h = sqrt(rq1);\n"
+		"            highp float f = atan(h, -v.z)/h;\n"
+		"            p = vec3(v.x*f*widthStretch, v.y*f, sqrt(rq1 + v.z*v.z));\n"
+		"        }\n"
+		"        else if (v.z<0.) p = vec3(0., 0., 1.);\n"
+		"        else p.z = 0.;\n"
+		"    }\n"
+		"    else\n"
+		"    {\n"
+		"        p = vec3(v.x*widthStretch/r, v.y/r, r);\n"
+		"    }\n"
+		"    gl_Position = projectionMatrix*vec4(viewportCenter + viewportScale*p.xy, (p.z-depthParams.x)*depthParams.y, 1.);\n"
+		"    texc = texCoord;\n"
+		"    outColor = color;\n"
+		"}\n").arg(StelProjectionPerspective).arg(StelProjectionEqualArea).arg(StelProjectionStereographic).arg(StelProjectionFisheye);
+	vshaderProjection.compileSourceCode(vshaderProjectionSrc);
+	if (!vshaderProjection.log().isEmpty()) { qWarning() << "StelPainter: Warnings while compiling vshaderProjection: " << vshaderProjection.log(); }
+
+	QOpenGLShader fshaderProjection(QOpenGLShader::Fragment);
+	const char *fshaderProjectionSrc =
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec4 outColor;\n"
+		"uniform sampler2D tex;\n"
+		"uniform bool useTexture;\n"
+		"void main(void)\n"
+		"{\n"
+		"    if (useTexture)\n"
+		"        gl_FragColor = texture2D(tex, texc)*outColor;\n"
+		"    else\n"
+		"        gl_FragColor = outColor;\n"
+		"}\n";
+	fshaderProjection.compileSourceCode(fshaderProjectionSrc);
+	if (!fshaderProjection.log().isEmpty()) { qWarning() << "StelPainter: Warnings while compiling fshaderProjection: " << fshaderProjection.log(); }
+
+	projectionShaderProgram = new QOpenGLShaderProgram(QOpenGLContext::currentContext());
+	projectionShaderProgram->addShader(&vshaderProjection);
+	projectionShaderProgram->addShader(&fshaderProjection);
+	if (!linkProg(projectionShaderProgram, "projectionShaderProgram"))
+	{
+		// The retained arrays will be projected by the CPU
+		delete projectionShaderProgram;
+		projectionShaderProgram = NULL;
+		return;
+	}
+	projectionShaderVars.projectionMatrix = projectionShaderProgram->uniformLocation("projectionMatrix");
+	projectionShaderVars.modelView = projectionShaderProgram->uniformLocation("modelView");
+	projectionShaderVars.projectionType = projectionShaderProgram->uniformLocation("projectionType");
+	projectionShaderVars.widthStretch = projectionShaderProgram->uniformLocation("widthStretch");
+	projectionShaderVars.viewportCenter = projectionShaderProgram->uniformLocation("viewportCenter");
+	projectionShaderVars.viewportScale = projectionShaderProgram->uniformLocation("viewportScale");
+	projectionShaderVars.depthParams = projectionShaderProgram->uniformLocation("depthParams");
+	projectionShaderVars.useTexture = projectionShaderProgram->uniformLocation("useTexture");
+	projectionShaderVars.vertex = projectionShaderProgram->attributeLocation("vertex");
+	projectionShaderVars.texCoord = projectionShaderProgram->attributeLocation("texCoord");
+	projectionShaderVars.color = projectionShaderProgram->attributeLocation("color");
+	projectionShaderVars.texture = projectionShaderProgram->uniformLocation("tex");
 }
 
 
@@ -1985,7 +2242,16 @@ void StelPainter::deinitGLShaders()
 	texturesShaderProgram = NULL;
 	delete texturesColorShaderProgram;
 	texturesColorShaderProgram = NULL;
+	delete projectionShaderProgram;
+	projectionShaderProgram = NULL;
 	texCache.clear();
+	// The arrays stay registered, their buffers would be created again with a new context
+	deleteReleasedArrays();
+	foreach (RetainedArray* ra, retainedArrays)
+	{
+		ra->vertexBuffer.destroy();
+		ra->indexBuffer.destroy();
+	}
 }
 
 
@@ -28,6 +28,9 @@
 #include <QString>
 #include <QVarLengthArray>
 #include <QFontMetrics>
+#include <QHash>
+#include <QOpenGLBuffer>
+#include <QVector>
 
 class QOpenGLShaderProgram;
 
@@ -281,6 +284,20 @@ public:
 	//! @param checkDiscontinuity will check and suppress discontinuities if necessary.
 	void drawStelVertexArray(const StelVertexArray& arr, bool checkDiscontinuity=true);
 
+	//! Register a vertex array which doesn't change between frames, like the constellation art or a landscape polygon.
+	//! Its vertices, texture coordinates, colors and indices are uploaded once in OpenGL buffers at the first draw,
+	//! so no OpenGL context is needed here.
+	//! @return an identifier for drawRetainedArray() and releaseRetainedArray().
+	static int retainArray(const StelVertexArray& arr);
+
+	//! Forget a vertex array registered with retainArray(). The buffers are freed when an OpenGL context is current.
+	static void releaseRetainedArray(int id);
+
+	//! Draw a vertex array registered with retainArray(), like drawStelVertexArray().
+	//! For projections without discontinuity and with a linear model view transformation, the vertices are projected by the
+	//! vertex shader from the OpenGL buffers. Otherwise they are projected by the CPU like drawStelVertexArray().
+	void drawRetainedArray(int id, bool checkDiscontinuity=true);
+
 	//! Link an opengl program and show a message in case of error or warnings.
 	//! @return true if the link was successful.
 	static bool linkProg(class QOpenGLShaderProgram* prog, const QString& name);
@@ -385,6 +402,42 @@ private:
 	static TexturesColorShaderVars texturesColorShaderVars;
 
 
+	//! A vertex array registered with retainArray()
+	struct RetainedArray
+	{
+		RetainedArray() : indexBuffer(QOpenGLBuffer::IndexBuffer), texCoordOffset(0), colorOffset(0) {}
+		StelVertexArray arr;		// for the projection by the CPU
+		QOpenGLBuffer vertexBuffer;	// vertices, then texture coordinates, then colors
+		QOpenGLBuffer indexBuffer;
+		int texCoordOffset;		// in bytes in vertexBuffer
+		int colorOffset;
+	};
+	static QHash<int, RetainedArray*> retainedArrays;
+	static QVector<RetainedArray*> releasedRetainedArrays;
+	static int nextRetainedArrayId;
+	//! Free the buffers of the released arrays, an OpenGL context must be current.
+	static void deleteReleasedArrays();
+	//! Get the state used by the projection shader.
+	//! @return false if the vertices have to be projected by the CPU.
+	bool getShaderProjectionParams(StelProjectionParams& params) const;
+
+	static QOpenGLShaderProgram* projectionShaderProgram;
+	struct ProjectionShaderVars {
+		int projectionMatrix;
+		int modelView;
+		int projectionType;
+		int widthStretch;
+		int viewportCenter;
+		int viewportScale;
+		int depthParams;
+		int useTexture;
+		int vertex;
+		int texCoord;
+		int color;
+		int texture;
+	};
+	static ProjectionShaderVars projectionShaderVars;
+
 	//! The descriptor for the current opengl vertex array
 	ArrayDesc vertexArray;
 	//! The descriptor for the current opengl texture coordinate array
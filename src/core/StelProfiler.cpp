@@ -0,0 +1,455 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelProfiler.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QOpenGLContext>
+#include <QThread>
+#ifndef QT_OPENGL_ES_2
+#include <QOpenGLTimerQuery>
+#endif
+#include <algorithm>
+
+// Maximum number of GPU samples waiting for their result. Beyond this, the GPU is not measured until the
+// results come back, so that a driver never returning them doesn't make the list grow forever.
+static const int maxPendingGpuSamples = 64;
+
+// Upper limits of the histogram bins, in milliseconds
+static const float histogramBinLimits[StelProfiler::NbHistogramBins-1] = {0.05f, 0.1f, 0.25f, 0.5f, 1.f, 2.5f, 5.f, 10.f, 25.f, 50.f, 100.f};
+
+StelProfiler* StelProfiler::instance = NULL;
+
+StelProfiler::StelProfiler(QObject* parent)
+	: QObject(parent)
+	, flagEnabled(false)
+	, flagOverlay(false)
+	, frameStart(0)
+	, lastReport(0)
+	, nbFrames(0)
+	, gpuTimerAvailable(-1)
+{
+	setObjectName("StelProfiler");
+	clock.start();
+	clear();
+	instance = this;
+}
+
+StelProfiler::~StelProfiler()
+{
+	clear();
+#ifndef QT_OPENGL_ES_2
+	qDeleteAll(freeTimerQueries);
+#endif
+	freeTimerQueries.clear();
+	if (instance==this)
+		instance = NULL;
+}
+
+const float* StelProfiler::getHistogramBinLimits()
+{
+	return histogramBinLimits;
+}
+
+void StelProfiler::History::add(float ms)
+{
+	values[pos] = ms;
+	pos = (pos+1)%HistorySize;
+	if (size<HistorySize)
+		++size;
+}
+
+StelProfiler::Statistics StelProfiler::History::getStatistics() const
+{
+	Statistics s;
+	for (int i=0; i<NbHistogramBins; ++i)
+		s.histogram[i] = 0;
+	s.count = size;
+	if (size==0)
+		return s;
+	float sorted[HistorySize];
+	std::copy(values, values+size, sorted);
+	std::sort(sorted, sorted+size);
+	double sum = 0.;
+	for (int i=0; i<size; ++i)
+	{
+		sum += sorted[i];
+		const int bin = std::upper_bound(histogramBinLimits, histogramBinLimits+NbHistogramBins-1, sorted[i]) - histogramBinLimits;
+		++s.histogram[bin];
+	}
+	s.mean = sum/size;
+	s.min = sorted[0];
+	s.max = sorted[size-1];
+	s.median = sorted[size/2];
+	s.p95 = sorted[qMin(size-1, (int)(0.95f*size))];
+	return s;
+}
+
+void StelProfiler::clear()
+{
+#ifndef QT_OPENGL_ES_2
+	for (int i=0; i<pendingGpuSamples.size(); ++i)
+	{
+		freeTimerQueries.append(pendingGpuSamples.at(i).begin);
+		if (pendingGpuSamples.at(i).end)
+			freeTimerQueries.append(pendingGpuSamples.at(i).end);
+	}
+#endif
+	pendingGpuSamples.clear();
+	counters.clear();
+	nodes.clear();
+	Node frame;
+	frame.name = "frame";
+	nodes.append(frame);
+	stack.clear();
+	stackGpuSamples.clear();
+	nbFrames = 0;
+}
+
+void StelProfiler::setFlagEnabled(bool b)
+{
+	if (b==flagEnabled)
+		return;
+	flagEnabled = b;
+	if (!b)
+		clear();
+	emit flagEnabledChanged(b);
+}
+
+void StelProfiler::setCounter(const QString& name, qint64 value)
+{
+	if (flagEnabled)
+		counters.insert(name, value);
+}
+
+void StelProfiler::setFlagOverlay(bool b)
+{
+	if (b==flagOverlay)
+		return;
+	flagOverlay = b;
+	emit flagOverlayChanged(b);
+}
+
+void StelProfiler::beginFrame()
+{
+	if (!flagEnabled)
+		return;
+	const qint64 now = clock.nsecsElapsed();
+	if (!stack.isEmpty())
+	{
+		// Scopes still open at the end of the frame are closed here
+		while (stack.size()>1)
+			leaveScope();
+		nodes[0].frameTime = now-frameStart;
+		nodes[0].frameCalls = 1;
+		for (int i=0; i<nodes.size(); ++i)
+		{
+			Node& node = nodes[i];
+			if (node.frameCalls==0)
+				continue;
+			node.cpu.add(node.frameTime*1e-6f);
+			node.frameTime = 0;
+			node.frameCalls = 0;
+		}
+		++nbFrames;
+	}
+	stack.clear();
+	stackGpuSamples.clear();
+	stack.append(0);
+	stackGpuSamples.append(-1);
+	frameStart = now;
+	collectGpuSamples();
+
+	if (now-lastReport>1000000000LL)
+	{
+		lastReport = now;
+		if (receivers(SIGNAL(reportChanged(QString)))>0)
+			emit reportChanged(getReport());
+	}
+}
+
+int StelProfiler::getChild(int parent, const char* name)
+{
+	const QVector<int>& children = nodes.at(parent).children;
+	for (int i=0; i<children.size(); ++i)
+	{
+		// The names are usually the same pointers, compare the strings only if they differ
+		const char* n = nodes.at(children.at(i)).name;
+		if (n==name || qstrcmp(n, name)==0)
+			return children.at(i);
+	}
+	Node node;
+	node.name = name;
+	node.parent = parent;
+	node.depth = nodes.at(parent).depth+1;
+	nodes.append(node);
+	const int index = nodes.size()-1;
+	nodes[parent].children.append(index);
+	return index;
+}
+
+bool StelProfiler::enterScope(const char* name, bool gpu)
+{
+	if (!flagEnabled || stack.isEmpty() || QThread::currentThread()!=thread())
+		return false;
+	const int node = getChild(stack.last(), name);
+	int gpuSample = -1;
+#ifndef QT_OPENGL_ES_2
+	if (gpu && pendingGpuSamples.size()<maxPendingGpuSamples && hasGpuTimer())
+	{
+		QOpenGLTimerQuery* query = getTimerQuery();
+		if (query)
+		{
+			query->recordTimestamp();
+			GpuSample sample;
+			sample.node = node;
+			sample.begin = query;
+			sample.end = NULL;
+			pendingGpuSamples.append(sample);
+			gpuSample = pendingGpuSamples.size()-1;
+		}
+	}
+#else
+	Q_UNUSED(gpu);
+#endif
+	stack.append(node);
+	stackGpuSamples.append(gpuSample);
+	nodes[node].entered = clock.nsecsElapsed();
+	return true;
+}
+
+void StelProfiler::leaveScope()
+{
+	// The frame can't be left, and scopes may have been cleared by disabling the profiler
+	if (stack.size()<=1)
+		return;
+	Node& node = nodes[stack.last()];
+	node.frameTime += clock.nsecsElapsed()-node.entered;
+	++node.frameCalls;
+	const int gpuSample = stackGpuSamples.last();
+	stack.removeLast();
+	stackGpuSamples.removeLast();
+#ifndef QT_OPENGL_ES_2
+	if (gpuSample>=0)
+	{
+		QOpenGLTimerQuery* query = getTimerQuery();
+		if (query)
+		{
+			query->recordTimestamp();
+			pendingGpuSamples[gpuSample].end = query;
+		}
+	}
+#else
+	Q_UNUSED(gpuSample);
+#endif
+}
+
+bool StelProfiler::hasGpuTimer() const
+{
+#ifndef QT_OPENGL_ES_2
+	if (gpuTimerAvailable<0)
+	{
+		QOpenGLContext* context = QOpenGLContext::currentContext();
+		if (!context)
+			return false;
+		const QSurfaceFormat format = context->format();
+		gpuTimerAvailable = !context->isOpenGLES() &&
+			(format.version()>=qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query"));
+		qDebug() << "StelProfiler: GPU timer queries" << (gpuTimerAvailable ? "available" : "not available");
+	}
+	return gpuTimerAvailable>0;
+#else
+	return false;
+#endif
+}
+
+QOpenGLTimerQuery* StelProfiler::getTimerQuery()
+{
+#ifndef QT_OPENGL_ES_2
+	if (!freeTimerQueries.isEmpty())
+		return freeTimerQueries.takeLast();
+	QOpenGLTimerQuery* query = new QOpenGLTimerQuery();
+	if (!query->create())
+	{
+		qWarning() << "StelProfiler: can't create a GPU timer query, the GPU is not measured";
+		delete query;
+		gpuTimerAvailable = 0;
+		return NULL;
+	}
+	return query;
+#else
+	return NULL;
+#endif
+}
+
+void StelProfiler::collectGpuSamples()
+{
+#ifndef QT_OPENGL_ES_2
+	// The samples are in the order of their beginning, the results come in the same order
+	int nbDone = 0;
+	for (; nbDone<pendingGpuSamples.size(); ++nbDone)
+	{
+		const GpuSample& sample = pendingGpuSamples.at(nbDone);
+		if (sample.end==NULL)
+		{
+			// The scope was left without recording the end, which is only possible if the query creation failed
+			freeTimerQueries.append(sample.begin);
+			continue;
+		}
+		if (!sample.end->isResultAvailable())
+			break;
+		const quint64 begin = sample.begin->waitForResult();
+		const quint64 end = sample.end->waitForResult();
+		nodes[sample.node].gpu.add(end>begin ? (end-begin)*1e-6f : 0.f);
+		freeTimerQueries.append(sample.begin);
+		freeTimerQueries.append(sample.end);
+	}
+	pendingGpuSamples.remove(0, nbDone);
+#endif
+}
+
+int StelProfiler::findNode(const QString& path) const
+{
+	int node = 0;
+	const QStringList names = path.split('/', QString::SkipEmptyParts);
+	foreach (const QString& name, names)
+	{
+		const QByteArray n = name.toUtf8();
+		const QVector<int>& children = nodes.at(node).children;
+		int found = -1;
+		for (int i=0; i<children.size() && found<0; ++i)
+		{
+			if (n==nodes.at(children.at(i)).name)
+				found = children.at(i);
+		}
+		if (found<0)
+			return -1;
+		node = found;
+	}
+	return node;
+}
+
+bool StelProfiler::getStatistics(const QString& path, Statistics& stats, bool gpu) const
+{
+	const int node = findNode(path);
+	if (node<0)
+		return false;
+	stats = gpu ? nodes.at(node).gpu.getStatistics() : nodes.at(node).cpu.getStatistics();
+	return true;
+}
+
+static QJsonObject statisticsToJson(const StelProfiler::Statistics& s)
+{
+	QJsonObject o;
+	o.insert("count", s.count);
+	o.insert("mean", s.mean);
+	o.insert("min", s.min);
+	o.insert("max", s.max);
+	o.insert("median", s.median);
+	o.insert("p95", s.p95);
+	QJsonArray histogram;
+	for (int i=0; i<StelProfiler::NbHistogramBins; ++i)
+		histogram.append(s.histogram[i]);
+	o.insert("histogram", histogram);
+	return o;
+}
+
+QJsonObject StelProfiler::nodeToJson(int index) const
+{
+	const Node& node = nodes.at(index);
+	QJsonObject o;
+	o.insert("name", QString::fromUtf8(node.name));
+	o.insert("cpu", statisticsToJson(node.cpu.getStatistics()));
+	if (node.gpu.size>0)
+		o.insert("gpu", statisticsToJson(node.gpu.getStatistics()));
+	if (!node.children.isEmpty())
+	{
+		QJsonArray children;
+		for (int i=0; i<node.children.size(); ++i)
+			children.append(nodeToJson(node.children.at(i)));
+		o.insert("children", children);
+	}
+	return o;
+}
+
+QJsonObject StelProfiler::getReportObject() const
+{
+	QJsonObject report;
+	report.insert("enabled", flagEnabled);
+	report.insert("frames", nbFrames);
+	report.insert("gpuTimer", gpuTimerAvailable>0);
+	QJsonArray limits;
+	for (int i=0; i<NbHistogramBins-1; ++i)
+		limits.append(histogramBinLimits[i]);
+	report.insert("histogramLimits", limits);
+	report.insert("frame", nodeToJson(0));
+	QJsonObject countersObject;
+	for (QMap<QString, qint64>::ConstIterator it=counters.constBegin(); it!=counters.constEnd(); ++it)
+		countersObject.insert(it.key(), (double)it.value());
+	report.insert("counters", countersObject);
+	return report;
+}
+
+QString StelProfiler::getReport() const
+{
+	return QString::fromUtf8(QJsonDocument(getReportObject()).toJson(QJsonDocument::Compact));
+}
+
+bool StelProfiler::saveReport(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "StelProfiler: can't write the report in" << QDir::toNativeSeparators(fileName);
+		return false;
+	}
+	file.write(QJsonDocument(getReportObject()).toJson(QJsonDocument::Indented));
+	return true;
+}
+
+QStringList StelProfiler::getOverlayLines() const
+{
+	QStringList lines;
+	// Depth first traversal, in the order in which the scopes were first entered
+	QVector<int> toVisit;
+	toVisit.append(0);
+	while (!toVisit.isEmpty())
+	{
+		const int index = toVisit.takeLast();
+		const Node& node = nodes.at(index);
+		for (int i=node.children.size()-1; i>=0; --i)
+			toVisit.append(node.children.at(i));
+		const Statistics cpu = node.cpu.getStatistics();
+		QString line = QString("%1%2").arg(QString(2*node.depth, ' ')).arg(QString::fromUtf8(node.name), -32);
+		line += QString(" %1 ms (p95 %2)").arg(cpu.mean, 7, 'f', 2).arg(cpu.p95, 7, 'f', 2);
+		if (node.gpu.size>0)
+		{
+			const Statistics gpu = node.gpu.getStatistics();
+			line += QString("  GPU %1 ms").arg(gpu.mean, 7, 'f', 2);
+		}
+		lines.append(line);
+	}
+	for (QMap<QString, qint64>::ConstIterator it=counters.constBegin(); it!=counters.constEnd(); ++it)
+		lines.append(QString("%1 %2").arg(it.key(), -32).arg(it.value()));
+	return lines;
+}
@@ -0,0 +1,217 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELPROFILER_HPP_
+#define _STELPROFILER_HPP_
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QOpenGLTimerQuery;
+
+//! @class StelProfiler
+//! Hierarchical profiler of the frames.
+//! The time spent in nested scopes (see StelProfileScope) is measured on the CPU, and on the GPU with OpenGL timer
+//! queries when they are available. The last frames are kept for each scope, so that the statistics and the histogram
+//! of the durations follow the current state of the program.
+//! The profiler is registered in the StelPropertyMgr under the name "StelProfiler", the JSON report
+//! is the "StelProfiler.report" property.
+//! Only the scopes entered in the thread of the profiler are recorded, the others are ignored.
+//! The modules can also publish counters, like the number of textures being loaded, shown after the scopes.
+class StelProfiler : public QObject
+{
+	Q_OBJECT
+	Q_PROPERTY(bool enabled READ getFlagEnabled WRITE setFlagEnabled NOTIFY flagEnabledChanged)
+	Q_PROPERTY(bool overlayVisible READ getFlagOverlay WRITE setFlagOverlay NOTIFY flagOverlayChanged)
+	Q_PROPERTY(QString report READ getReport NOTIFY reportChanged)
+
+public:
+	//! Number of frames kept for the statistics of each scope.
+	static const int HistorySize = 240;
+	//! Number of bins of the histograms, see getHistogramBinLimits().
+	static const int NbHistogramBins = 12;
+
+	StelProfiler(QObject* parent=NULL);
+	~StelProfiler();
+
+	//! Get the profiler of the application, or NULL if there is none.
+	static StelProfiler* getInstance() {return instance;}
+
+	//! Close the current frame and start a new one. The time between two calls is the duration of the "frame" scope.
+	void beginFrame();
+
+	//! Enter a scope, nested in the current scope. Use StelProfileScope instead of calling this directly.
+	//! @param name the name of the scope. It must stay valid until the end of the program, like a string literal or a class name.
+	//! @param gpu if true, the time spent by the GPU is also measured. GPU scopes can be nested.
+	//! @return false if nothing is recorded, then leaveScope() must not be called.
+	bool enterScope(const char* name, bool gpu=false);
+	//! Leave the current scope.
+	void leaveScope();
+
+	//! Set the current value of a counter. Nothing is recorded when the profiler is disabled.
+	//! @param name the name of the counter, like "textures/loading".
+	void setCounter(const QString& name, qint64 value);
+	//! Get the current value of a counter, or -1 if it was never set.
+	qint64 getCounter(const QString& name) const {return counters.value(name, -1);}
+
+	//! Statistics of the durations of a scope over the last frames, in milliseconds.
+	struct Statistics
+	{
+		Statistics() : count(0), mean(0.f), min(0.f), max(0.f), median(0.f), p95(0.f) {}
+		int count;
+		float mean, min, max, median, p95;
+		int histogram[NbHistogramBins];
+	};
+
+	//! Get the upper limits of the histogram bins in milliseconds. The last bin has no upper limit.
+	static const float* getHistogramBinLimits();
+
+	//! Get the statistics of a scope.
+	//! @param path the names of the scopes from the frame, separated by '/', like "draw/StarMgr".
+	//! @param gpu whether to get the GPU time instead of the CPU time.
+	//! @return false if the scope was never entered.
+	bool getStatistics(const QString& path, Statistics& stats, bool gpu=false) const;
+
+	//! Get the report of all the scopes as a JSON document.
+	QString getReport() const;
+	//! Get the report as a JSON object.
+	QJsonObject getReportObject() const;
+
+	//! Get the lines of the on-screen overlay: one line per scope, indented by depth.
+	QStringList getOverlayLines() const;
+
+	bool getFlagEnabled() const {return flagEnabled;}
+	bool getFlagOverlay() const {return flagOverlay;}
+
+public slots:
+	//! Enable or disable the profiler. Disabling it clears the recorded scopes.
+	void setFlagEnabled(bool b);
+	//! Set whether the overlay is drawn over the sky.
+	void setFlagOverlay(bool b);
+	//! Write the JSON report in a file.
+	//! @return false if the file can't be written.
+	bool saveReport(const QString& fileName) const;
+
+signals:
+	void flagEnabledChanged(bool);
+	void flagOverlayChanged(bool);
+	//! Emitted about once per second while the profiler is enabled, when the report has new data.
+	void reportChanged(const QString&);
+
+private:
+	//! Rolling record of the durations of a scope
+	struct History
+	{
+		History() : pos(0), size(0) {}
+		void add(float ms);
+		Statistics getStatistics() const;
+		float values[HistorySize];
+		int pos;
+		int size;
+	};
+
+	struct Node
+	{
+		Node() : name(NULL), parent(-1), depth(0), frameTime(0), frameCalls(0), entered(0) {}
+		const char* name;
+		int parent;
+		int depth;
+		QVector<int> children;
+		qint64 frameTime;	// nanoseconds spent in the current frame
+		int frameCalls;
+		qint64 entered;		// time of the last enterScope()
+		History cpu;
+		History gpu;
+	};
+
+	//! A pair of timestamp queries waiting for their result
+	struct GpuSample
+	{
+		int node;
+		QOpenGLTimerQuery* begin;
+		QOpenGLTimerQuery* end;
+	};
+
+	//! Get the child of a node with the given name, creating it if needed.
+	int getChild(int parent, const char* name);
+	//! Find a node from its path, or return -1.
+	int findNode(const QString& path) const;
+	QJsonObject nodeToJson(int node) const;
+	void clear();
+
+	//! Read the results of the finished GPU queries.
+	void collectGpuSamples();
+	QOpenGLTimerQuery* getTimerQuery();
+	bool hasGpuTimer() const;
+
+	static StelProfiler* instance;
+
+	bool flagEnabled;
+	bool flagOverlay;
+	QVector<Node> nodes;		// nodes[0] is the frame
+	QVector<int> stack;		// the entered scopes, with the frame at the bottom
+	QVector<int> stackGpuSamples;	// index in pendingGpuSamples of the sample started by the scopes of the stack, or -1
+	QElapsedTimer clock;
+	qint64 frameStart;
+	qint64 lastReport;
+	int nbFrames;
+	QMap<QString, qint64> counters;
+
+	QVector<GpuSample> pendingGpuSamples;
+	QVector<QOpenGLTimerQuery*> freeTimerQueries;
+	mutable int gpuTimerAvailable;	// -1 if not checked yet
+};
+
+//! @class StelProfileScope
+//! Measure the time spent in a C++ scope with the StelProfiler of the application.
+//! \code
+//! void SolarSystem::computePositions(double dateJDE, const Vec3d& observerPos)
+//! {
+//!	StelProfileScope profileScope("SolarSystem::computePositions");
+//!	...
+//! }
+//! \endcode
+//! It costs a test when the profiler is disabled.
+class StelProfileScope
+{
+public:
+	//! @param name the name of the scope, which must stay valid until the end of the program.
+	//! @param gpu whether to measure the time spent by the GPU too.
+	explicit StelProfileScope(const char* name, bool gpu=false)
+		: profiler(StelProfiler::getInstance())
+	{
+		if (profiler && (!profiler->getFlagEnabled() || !profiler->enterScope(name, gpu)))
+			profiler = NULL;
+	}
+	~StelProfileScope()
+	{
+		if (profiler)
+			profiler->leaveScope();
+	}
+private:
+	Q_DISABLE_COPY(StelProfileScope)
+	StelProfiler* profiler;
+};
+
+#endif // _STELPROFILER_HPP_
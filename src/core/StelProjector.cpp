@@ -305,8 +305,51 @@ bool StelProjector::project(const Vec3f& v, Vec3f& win) const
 	return projectInPlace(win);
 }
 
+bool StelProjector::getProjectionParams(StelProjectionParams& params) const
+{
+	params.type = getProjectionType();
+	if (params.type==StelProjectionNone || !modelViewTransform->isLinear())
+		return false;
+	const Mat4d m = modelViewTransform->getApproximateLinearTransfo();
+	for (int i=0;i<16;++i)
+		params.modelView[i] = m[i];
+	params.widthStretch = widthStretch;
+	params.viewportCenter[0] = viewportCenter[0];
+	params.viewportCenter[1] = viewportCenter[1];
+	params.flipHorz = flipHorz;
+	params.flipVert = flipVert;
+	params.pixelPerRad = pixelPerRad;
+	params.zNear = zNear;
+	params.oneOverZNearMinusZFar = oneOverZNearMinusZFar;
+	return true;
+}
+
+// Number of vectors converted to structure of arrays at a time on the stack by the batched projections
+static const int projectionBlockSize = 256;
+
 void StelProjector::project(int n, const Vec3d* in, Vec3f* out)
 {
+	StelProjectionParams params;
+	if (getProjectionParams(params))
+	{
+		double x[projectionBlockSize], y[projectionBlockSize], z[projectionBlockSize];
+		float wx[projectionBlockSize], wy[projectionBlockSize], wz[projectionBlockSize];
+		for (int begin=0; begin<n; begin+=projectionBlockSize)
+		{
+			const int count = qMin(projectionBlockSize, n-begin);
+			for (int i=0; i<count; ++i)
+			{
+				x[i] = in[begin+i][0];
+				y[i] = in[begin+i][1];
+				z[i] = in[begin+i][2];
+			}
+			projectBatch(params, count, x, y, z, wx, wy, wz);
+			for (int i=0; i<count; ++i)
+				out[begin+i].set(wx[i], wy[i], wz[i]);
+		}
+		return;
+	}
+
 	Vec3d v;
 	for (int i = 0; i < n; ++i, ++out)
 	{
@@ -322,6 +365,28 @@ void StelProjector::project(int n, const Vec3d* in, Vec3f* out)
 
 void StelProjector::project(int n, const Vec3f* in, Vec3f* out)
 {
+	StelProjectionParams params;
+	if (getProjectionParams(params))
+	{
+		// The model view transformation is done in double precision, like for Vec3d input
+		double x[projectionBlockSize], y[projectionBlockSize], z[projectionBlockSize];
+		float wx[projectionBlockSize], wy[projectionBlockSize], wz[projectionBlockSize];
+		for (int begin=0; begin<n; begin+=projectionBlockSize)
+		{
+			const int count = qMin(projectionBlockSize, n-begin);
+			for (int i=0; i<count; ++i)
+			{
+				x[i] = in[begin+i][0];
+				y[i] = in[begin+i][1];
+				z[i] = in[begin+i][2];
+			}
+			projectBatch(params, count, x, y, z, wx, wy, wz);
+			for (int i=0; i<count; ++i)
+				out[begin+i].set(wx[i], wy[i], wz[i]);
+		}
+		return;
+	}
+
 	for (int i = 0; i < n; ++i, ++out)
 	{
 		*out=in[i];
@@ -460,6 +525,31 @@ bool StelProjector::unProject(double x, double y, Vec3d &v) const
 	return rval;
 }
 
+void StelProjector::unProject(int n, const Vec2f* win, Vec3d* out) const
+{
+	StelProjectionParams params;
+	if (!getProjectionParams(params))
+	{
+		for (int i=0; i<n; ++i)
+			unProject(win[i][0], win[i][1], out[i]);
+		return;
+	}
+	double wx[projectionBlockSize], wy[projectionBlockSize];
+	double x[projectionBlockSize], y[projectionBlockSize], z[projectionBlockSize];
+	for (int begin=0; begin<n; begin+=projectionBlockSize)
+	{
+		const int count = qMin(projectionBlockSize, n-begin);
+		for (int i=0; i<count; ++i)
+		{
+			wx[i] = win[begin+i][0];
+			wy[i] = win[begin+i][1];
+		}
+		unProjectBatch(params, count, wx, wy, x, y, z);
+		for (int i=0; i<count; ++i)
+			out[begin+i].set(x[i], y[i], z[i]);
+	}
+}
+
 bool StelProjector::projectLineCheck(const Vec3d& v1, Vec3d& win1, const Vec3d& v2, Vec3d& win2) const
 
 {
@@ -22,6 +22,7 @@
 #define _STELPROJECTOR_HPP_
 
 #include "StelProjectorType.hpp"
+#include "StelProjectorKernels.hpp"
 #include "VecMath.hpp"
 #include "StelSphereGeometry.hpp"
 
@@ -61,6 +62,8 @@ public:
 		virtual ModelViewTranformP clone() const=0;
 
 		virtual Mat4d getApproximateLinearTransfo() const=0;
+		//! Return whether the transformation is exactly getApproximateLinearTransfo().
+		virtual bool isLinear() const {return false;}
 	};
 
 	class Mat4dTransform: public ModelViewTranform
@@ -73,6 +76,7 @@ public:
         void backward(Vec3f& v) const;
         void combine(const Mat4d& m);
         Mat4d getApproximateLinearTransfo() const;
+        bool isLinear() const {return true;}
         ModelViewTranformP clone() const;
 
 	private:
@@ -229,6 +233,8 @@ public:
 	//! @return true if the projected coordinate is valid.
 	bool project(const Vec3f& v, Vec3f& win) const;
 
+	//! Project n vectors from the current frame into the viewport.
+	//! The projections of StelProjectorClasses.hpp use the SIMD kernels of StelProjectorKernels.hpp.
 	virtual void project(int n, const Vec3d* in, Vec3f* out);
 
 	virtual void project(int n, const Vec3f* in, Vec3f* out);
@@ -261,6 +267,9 @@ public:
 	//! @return true if the projected coordinate is valid.
 	bool unProject(const Vec3d& win, Vec3d& v) const;
 	bool unProject(double x, double y, Vec3d& v) const;
+	//! Project n points from the viewport frame into the current frame, like the method above
+	//! but without the validity of the points.
+	void unProject(int n, const Vec2f* win, Vec3d* out) const;
 
 	//! Project the vectors v1 and v2 from the current frame into the viewport.
 	//! @param v1 the first vector in the current frame.
@@ -314,6 +323,10 @@ protected:
 	//! Initialize the bounding cap.
 	virtual void computeBoundingCap();
 
+	//! Return the formulas of forward() and backward(), for the batched projections.
+	//! Subclasses overriding these methods with other formulas must return StelProjectionNone.
+	virtual StelProjectionType getProjectionType() const {return StelProjectionNone;}
+
 	ModelViewTranformP modelViewTransform;	// Operator to apply (if not NULL) before the modelview projection step
 
 	float flipHorz,flipVert;            // Whether to flip in horizontal or vertical directions
@@ -331,8 +344,14 @@ protected:
 	float devicePixelsPerPixel;         // The number of device pixel per "Device Independent Pixels" (value is usually 1, but 2 for mac retina screens)
 	float widthStretch;                 // A factor to adapt to special installation setups, e.g. multi-projector with edge blending. Allow to stretch/squeeze projected content. Larger than 1 means the image is stretched wider.
 private:
+	// For unit tests
+	friend class TestStelProjectorKernels;
+
 	//! Initialise the StelProjector from a param instance.
 	void init(const StelProjectorParams& param);
+	//! Get the state used by projectBatch() and unProjectBatch().
+	//! @return false if the projection or the model view transformation can't be batched.
+	bool getProjectionParams(StelProjectionParams& params) const;
 };
 
 #endif // _STELPROJECTOR_HPP_
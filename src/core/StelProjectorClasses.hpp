@@ -35,6 +35,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionPerspective;}
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, double) const {return false;}
@@ -53,6 +54,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionEqualArea;}
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, double) const {return false;}
@@ -65,27 +67,13 @@ public:
 	virtual QString getNameI18() const;
 	virtual QString getDescriptionI18() const;
 	virtual float getMaxFov() const {return 235.f;}
-	virtual void project(int n, const Vec3d* in, Vec3f* out)
-	{
-		Vec3d v;
-		for (int i = 0; i < n; ++i, ++out)
-		{
-			v = in[i];
-			modelViewTransform->forward(v);
-			out->set(v[0], v[1], v[2]);
-			StelProjectorStereographic::forward(*out);
-			out->set(viewportCenter[0] + flipHorz * pixelPerRad * (*out)[0],
-				viewportCenter[1] + flipVert * pixelPerRad * (*out)[1],
-				((*out)[2] - zNear) * oneOverZNearMinusZFar);
-		}
-	}
-
 	bool forward(Vec3f &v) const;
 	bool backward(Vec3d &v) const;
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionStereographic;}
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, double) const {return false;}
@@ -104,6 +92,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionFisheye;}
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, double) const {return false;}
@@ -116,26 +105,13 @@ public:
 	virtual QString getNameI18() const;
 	virtual QString getDescriptionI18() const;
 	virtual float getMaxFov() const {return 360.f;}
-	virtual void project(int n, const Vec3d* in, Vec3f* out)
-	{
-		Vec3d v;
-		for (int i = 0; i < n; ++i)
-		{
-			v = in[i];
-			modelViewTransform->forward(v);
-			out[i].set(v[0], v[1], v[2]);
-			StelProjectorHammer::forward(out[i]);
-			out[i][0] = viewportCenter[0] + flipHorz * pixelPerRad * out[i][0];
-			out[i][1] = viewportCenter[1] + flipVert * pixelPerRad * out[i][1];
-			out[i][2] = (out[i][2] - zNear) * oneOverZNearMinusZFar;
-		}
-	}
 	bool forward(Vec3f &v) const;
 	bool backward(Vec3d &v) const;
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionHammer;}
 	virtual bool hasDiscontinuity() const {return true;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d& p1, const Vec3d& p2) const {return p1[0]*p2[0]<0 && !(p1[2]<0 && p2[2]<0);}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d& capN, double capD) const
@@ -161,6 +137,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionCylinder;}
 	virtual bool hasDiscontinuity() const {return true;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d& p1, const Vec3d& p2) const
 	{
@@ -189,6 +166,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionMercator;}
 	virtual bool hasDiscontinuity() const {return true;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d& p1, const Vec3d& p2) const
 	{
@@ -217,6 +195,7 @@ public:
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
 protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionOrthographic;}
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, double) const {return false;}
@@ -230,6 +209,8 @@ public:
 	virtual QString getDescriptionI18() const;
 	bool forward(Vec3f &win) const;
 	bool backward(Vec3d &v) const;
+protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionSinusoidal;}
 };
 
 class StelProjectorMiller : public StelProjectorMercator
@@ -241,6 +222,8 @@ public:
 	virtual float getMaxFov() const {return 175.f * 4.f/3.f;} // or 180?
 	bool forward(Vec3f &win) const;
 	bool backward(Vec3d &v) const;
+protected:
+	virtual StelProjectionType getProjectionType() const {return StelProjectionMiller;}
 };
 
 class StelProjector2d : public StelProjector
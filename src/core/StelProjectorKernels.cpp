@@ -0,0 +1,1052 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelProjectorKernels.hpp"
+
+#include <QtGlobal>
+#include <cmath>
+#include <limits>
+
+// The SIMD kernels are compiled with function attributes, so that the rest of
+// the program does not need to be compiled with -mavx2. The CPU is checked at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define PROJECTORKERNELS_X86
+# define PROJECTORKERNELS_TARGET_SSE2 __attribute__((target("sse2")))
+# define PROJECTORKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+# include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# define PROJECTORKERNELS_X86
+# define PROJECTORKERNELS_TARGET_SSE2
+# define PROJECTORKERNELS_TARGET_AVX2
+# include <immintrin.h>
+# include <intrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#ifndef M_PI_2
+#define M_PI_2 1.57079632679489661923
+#endif
+#ifndef M_SQRT2
+#define M_SQRT2 1.41421356237309504880
+#endif
+
+/*************************************************************************
+ Scalar implementation, with the same operations as the StelProjector classes
+*************************************************************************/
+static inline void forwardScalar(StelProjectionType type, float widthStretch, float v[3])
+{
+	switch (type)
+	{
+		case StelProjectionPerspective:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			if (v[2] < 0) {
+				v[0] *= (-widthStretch/v[2]);
+				v[1] /= (-v[2]);
+				v[2] = r;
+			}
+			else if (v[2] > 0) {
+				v[0] *= widthStretch/v[2];
+				v[1] /= v[2];
+				v[2] = -std::numeric_limits<float>::max();
+			}
+			else {
+				v[0] = std::numeric_limits<float>::max();
+				v[1] = std::numeric_limits<float>::max();
+				v[2] = -std::numeric_limits<float>::max();
+			}
+			break;
+		}
+		case StelProjectionEqualArea:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float f = std::sqrt(2.f/(r*(r-v[2])));
+			v[0] *= f*widthStretch;
+			v[1] *= f;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionStereographic:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float h = 0.5f*(r-v[2]);
+			if (h <= 0.f) {
+				v[0] = std::numeric_limits<float>::max();
+				v[1] = std::numeric_limits<float>::max();
+				v[2] = -std::numeric_limits<float>::min();
+				break;
+			}
+			const float f = 1.f / h;
+			v[0] *= f*widthStretch;
+			v[1] *= f;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionFisheye:
+		{
+			const float rq1 = v[0]*v[0] + v[1]*v[1];
+			if (rq1 > 0.f) {
+				const float h = std::sqrt(rq1);
+				const float f = std::atan2(h,-v[2]) / h;
+				v[0] *= f*widthStretch;
+				v[1] *= f;
+				v[2] = std::sqrt(rq1 + v[2]*v[2]);
+			}
+			else if (v[2] < 0.f) {
+				v[0] = 0.f;
+				v[1] = 0.f;
+				v[2] = 1.f;
+			}
+			else {
+				v[0] = std::numeric_limits<float>::max();
+				v[1] = std::numeric_limits<float>::max();
+				v[2] = std::numeric_limits<float>::min();
+			}
+			break;
+		}
+		case StelProjectionHammer:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float alpha = std::atan2(v[0],-v[2]);
+			const float cosDelta = std::sqrt(1.f-v[1]*v[1]/(r*r));
+			float z = std::sqrt(1.+cosDelta*std::cos(alpha/2.f));
+			v[0] = 2.f*M_SQRT2*cosDelta*std::sin(alpha/2.f)/z * widthStretch;
+			v[1] = M_SQRT2*v[1]/r/z;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionCylinder:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float alpha = std::atan2(v[0],-v[2]);
+			const float delta = std::asin(v[1]/r);
+			v[0] = alpha*widthStretch;
+			v[1] = delta;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionMercator:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float sin_delta = v[1]/r;
+			v[0] = std::atan2(v[0],-v[2]) *widthStretch;
+			v[1] = 0.5f*std::log((1.f+sin_delta)/(1.f-sin_delta));
+			v[2] = r;
+			break;
+		}
+		case StelProjectionOrthographic:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float h = 1.f/r;
+			v[0] *= h *widthStretch;
+			v[1] *= h;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionSinusoidal:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float alpha = std::atan2(v[0],-v[2]);
+			const float delta = std::asin(v[1]/r);
+			v[0] = alpha*std::cos(delta) *widthStretch;
+			v[1] = delta;
+			v[2] = r;
+			break;
+		}
+		case StelProjectionMiller:
+		{
+			const float r = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+			const float sin_delta = v[1]/r;
+			const float delta=asin(sin_delta);
+			v[0] = std::atan2(v[0],-v[2]) * widthStretch;
+			v[1] = 1.25f*asinh(tan(0.8f*delta));
+			v[2] = r;
+			break;
+		}
+		default:
+			Q_ASSERT(0);
+	}
+}
+
+static inline void backwardScalar(StelProjectionType type, double widthStretch, double v[3])
+{
+	v[0] /= widthStretch;
+	switch (type)
+	{
+		case StelProjectionPerspective:
+			v[2] = std::sqrt(1.0/(1.0+v[0]*v[0]+v[1]*v[1]));
+			v[0] *= v[2];
+			v[1] *= v[2];
+			v[2] = -v[2];
+			break;
+		case StelProjectionEqualArea:
+		{
+			const double dq = v[0]*v[0] + v[1]*v[1];
+			double l = 1.0 - 0.25*dq;
+			if (l < 0)
+			{
+				v[0] = 0.0;
+				v[1] = 0.0;
+				v[2] = 1.0;
+			}
+			else
+			{
+				l = std::sqrt(l);
+				v[0] *= l;
+				v[1] *= l;
+				v[2] = 0.5*dq - 1.0;
+			}
+			break;
+		}
+		case StelProjectionStereographic:
+		{
+			const double lqq = 0.25*(v[0]*v[0] + v[1]*v[1]);
+			v[2] = lqq - 1.0;
+			const double f = 1.0 / (lqq + 1.0);
+			v[0] *= f;
+			v[1] *= f;
+			v[2] *= f;
+			break;
+		}
+		case StelProjectionFisheye:
+		{
+			const double a = std::sqrt(v[0]*v[0]+v[1]*v[1]);
+			const double f = (a > 0.0) ? (std::sin(a) / a) : 1.0;
+			v[0] *= f;
+			v[1] *= f;
+			v[2] = -std::cos(a);
+			break;
+		}
+		case StelProjectionHammer:
+		{
+			const double zsq = 1.-0.25*0.25*v[0]*v[0]-0.5*0.5*v[1]*v[1];
+			const double z = zsq<0. ? 0. : std::sqrt(zsq);
+			const double alpha = 2.*std::atan2(z*v[0],(2.*(2.*zsq-1.)));
+			const double delta = std::asin(v[1]*z);
+			const double cd = std::cos(delta);
+			v[2] = - cd * std::cos(alpha);
+			v[0] = cd * std::sin(alpha);
+			v[1] = v[1]*z;
+			break;
+		}
+		case StelProjectionCylinder:
+		{
+			const double cd = std::cos(v[1]);
+			const double alpha=v[0];
+			v[2] = - cd * std::cos(alpha);
+			v[0] = cd * std::sin(alpha);
+			v[1] = std::sin(v[1]);
+			break;
+		}
+		case StelProjectionMercator:
+		{
+			const double E = std::exp(v[1]);
+			const double h = E*E;
+			const double h1 = 1.0/(1.0+h);
+			const double sin_delta = (h-1.0)*h1;
+			const double cos_delta = 2.0*E*h1;
+			v[2] = - cos_delta * std::cos(v[0]);
+			v[0] = cos_delta * std::sin(v[0]);
+			v[1] = sin_delta;
+			break;
+		}
+		case StelProjectionOrthographic:
+		{
+			const double dq = v[0]*v[0] + v[1]*v[1];
+			double h = 1.0 - dq;
+			if (h < 0) {
+				h = 1.0/std::sqrt(dq);
+				v[0] *= h;
+				v[1] *= h;
+				v[2] = 0.0;
+				break;
+			}
+			v[2] = -std::sqrt(h);
+			break;
+		}
+		case StelProjectionSinusoidal:
+		{
+			const double cd = std::cos(v[1]);
+			const double pcd = v[0]/cd;
+			if (v[0]<-M_PI*cd || v[0]>M_PI*cd)
+			{
+				v[0] = -cd;
+				v[1] = 1.0;
+				const double s = 1.0/std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+				v[0] *= s;
+				v[1] *= s;
+				v[2] *= s;
+				break;
+			}
+			v[2] = -cd * std::cos(pcd);
+			v[0] = cd * std::sin(pcd);
+			v[1] = std::sin(v[1]);
+			break;
+		}
+		case StelProjectionMiller:
+		{
+			const double lat = 1.25*atan(sinh(0.8*v[1]));
+			const double lng = v[0];
+			const double cos_lat=cos(lat);
+			v[0] = cos_lat*sin(lng);
+			v[1] = sin(lat);
+			v[2]= -cos_lat*cos(lng);
+			break;
+		}
+		default:
+			Q_ASSERT(0);
+	}
+}
+
+static void projectBatchScalar(const StelProjectionParams& p, int begin, int end,
+			       const double* x, const double* y, const double* z, float* wx, float* wy, float* wz)
+{
+	const double* m = p.modelView;
+	const float sx = p.flipHorz * p.pixelPerRad;
+	const float sy = p.flipVert * p.pixelPerRad;
+	float v[3];
+	for (int i=begin; i<end; ++i)
+	{
+		// Same as Vector3::transfo4d()
+		v[0] = m[0]*x[i] + m[4]*y[i] + m[8]*z[i] + m[12];
+		v[1] = m[1]*x[i] + m[5]*y[i] + m[9]*z[i] + m[13];
+		v[2] = m[2]*x[i] + m[6]*y[i] + m[10]*z[i] + m[14];
+		forwardScalar(p.type, p.widthStretch, v);
+		wx[i] = p.viewportCenter[0] + sx * v[0];
+		wy[i] = p.viewportCenter[1] + sy * v[1];
+		wz[i] = (v[2] - p.zNear) * p.oneOverZNearMinusZFar;
+	}
+}
+
+static void unProjectBatchScalar(const StelProjectionParams& p, int begin, int end,
+				 const double* wx, const double* wy, double* x, double* y, double* z)
+{
+	const double* m = p.modelView;
+	double v[3];
+	for (int i=begin; i<end; ++i)
+	{
+		v[0] = p.flipHorz * (wx[i] - p.viewportCenter[0]) / p.pixelPerRad;
+		v[1] = p.flipVert * (wy[i] - p.viewportCenter[1]) / p.pixelPerRad;
+		v[2] = 0;
+		backwardScalar(p.type, p.widthStretch, v);
+		// Same as Mat4dTransform::backward(), the matrix is orthogonal
+		const double tx = v[0] - m[12];
+		const double ty = v[1] - m[13];
+		const double tz = v[2] - m[14];
+		x[i] = m[0]*tx + m[1]*ty + m[2]*tz;
+		y[i] = m[4]*tx + m[5]*ty + m[6]*tz;
+		z[i] = m[8]*tx + m[9]*ty + m[10]*tz;
+	}
+}
+
+// Projections having vector code in unProjectBatch()
+static bool hasVectorBackward(StelProjectionType type)
+{
+	return type==StelProjectionPerspective || type==StelProjectionEqualArea
+	    || type==StelProjectionStereographic || type==StelProjectionOrthographic;
+}
+
+#ifdef PROJECTORKERNELS_X86
+
+/*************************************************************************
+ SSE2 implementation, 4 vectors at a time for projectBatch() and 2 points
+ at a time for unProjectBatch().
+ The model view transformation is done in double precision like the scalar code.
+ atan2() and log() use the polynomials of the Cephes library, the results
+ are within a few float ulp of the scalar code.
+*************************************************************************/
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128 sse2Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128d sse2Select(__m128d mask, __m128d a, __m128d b)
+{
+	return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128 sse2Length(__m128 x, __m128 y, __m128 z)
+{
+	return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128 sse2Atan2(__m128 y, __m128 x)
+{
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 ax = _mm_andnot_ps(signBit, x);
+	const __m128 ay = _mm_andnot_ps(signBit, y);
+	// atan(t) with t in [0, 1], the angle is rebuilt from the octant
+	const __m128 swap = _mm_cmpgt_ps(ay, ax);
+	const __m128 den = _mm_max_ps(ax, ay);
+	__m128 t = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), den), _mm_cmpgt_ps(den, _mm_setzero_ps()));
+	const __m128 reduce = _mm_cmpgt_ps(t, _mm_set1_ps(0.414213562373095f));
+	t = sse2Select(reduce, _mm_div_ps(_mm_sub_ps(t, one), _mm_add_ps(t, one)), t);
+	const __m128 z = _mm_mul_ps(t, t);
+	__m128 p = _mm_set1_ps(8.05374449538e-2f);
+	p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.38776856032e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+	p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(3.33329491539e-1f));
+	__m128 r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+	r = _mm_add_ps(r, _mm_and_ps(reduce, _mm_set1_ps((float)(M_PI/4.))));
+	r = sse2Select(swap, _mm_sub_ps(_mm_set1_ps((float)M_PI_2), r), r);
+	r = sse2Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps((float)M_PI), r), r);
+	return _mm_or_ps(r, _mm_and_ps(signBit, y));
+}
+
+// Only for positive normal numbers
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128 sse2Log(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128i xi = _mm_castps_si128(x);
+	// x = m*2^e with m in [0.5, 1)
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(126)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(xi, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F000000)));
+	const __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+	e = _mm_sub_ps(e, _mm_and_ps(small, one));
+	m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), one);
+	const __m128 z = _mm_mul_ps(m, m);
+	__m128 p = _mm_set1_ps(7.0376836292e-2f);
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.1514610310e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.1676998740e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.2420140846e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.4249322787e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.6668057665e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(2.0000714765e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.4999993993e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(3.3333331174e-1f));
+	__m128 y = _mm_mul_ps(_mm_mul_ps(p, m), z);
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static inline void sse2Forward(StelProjectionType type, float widthStretch, __m128& x, __m128& y, __m128& z)
+{
+	const __m128 ws = _mm_set1_ps(widthStretch);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	const __m128 maxFloat = _mm_set1_ps(std::numeric_limits<float>::max());
+	switch (type)
+	{
+		case StelProjectionPerspective:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 az = _mm_andnot_ps(signBit, z);
+			const __m128 front = _mm_cmplt_ps(z, zero);
+			const __m128 valid = _mm_or_ps(front, _mm_cmpgt_ps(z, zero));
+			x = sse2Select(valid, _mm_mul_ps(x, _mm_div_ps(ws, az)), maxFloat);
+			y = sse2Select(valid, _mm_div_ps(y, az), maxFloat);
+			z = sse2Select(front, r, _mm_xor_ps(maxFloat, signBit));
+			break;
+		}
+		case StelProjectionEqualArea:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 f = _mm_sqrt_ps(_mm_div_ps(_mm_set1_ps(2.f), _mm_mul_ps(r, _mm_sub_ps(r, z))));
+			x = _mm_mul_ps(x, _mm_mul_ps(f, ws));
+			y = _mm_mul_ps(y, f);
+			z = r;
+			break;
+		}
+		case StelProjectionStereographic:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 h = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(r, z));
+			const __m128 valid = _mm_cmpgt_ps(h, zero);
+			const __m128 f = _mm_div_ps(one, h);
+			x = sse2Select(valid, _mm_mul_ps(x, _mm_mul_ps(f, ws)), maxFloat);
+			y = sse2Select(valid, _mm_mul_ps(y, f), maxFloat);
+			z = sse2Select(valid, r, _mm_set1_ps(-std::numeric_limits<float>::min()));
+			break;
+		}
+		case StelProjectionFisheye:
+		{
+			const __m128 rq1 = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+			const __m128 h = _mm_sqrt_ps(rq1);
+			const __m128 f = _mm_div_ps(sse2Atan2(h, _mm_xor_ps(z, signBit)), h);
+			const __m128 valid = _mm_cmpgt_ps(rq1, zero);
+			const __m128 front = _mm_cmplt_ps(z, zero);
+			x = sse2Select(valid, _mm_mul_ps(x, _mm_mul_ps(f, ws)), _mm_andnot_ps(front, maxFloat));
+			y = sse2Select(valid, _mm_mul_ps(y, f), _mm_andnot_ps(front, maxFloat));
+			z = sse2Select(valid, _mm_sqrt_ps(_mm_add_ps(rq1, _mm_mul_ps(z, z))),
+				       sse2Select(front, one, _mm_set1_ps(std::numeric_limits<float>::min())));
+			break;
+		}
+		case StelProjectionHammer:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 h = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(z, z)));
+			// cos(alpha/2) and sin(alpha/2) from cos(alpha) = -z/h, without cancellation
+			const __m128 hu = _mm_add_ps(h, _mm_andnot_ps(signBit, z));
+			const __m128 big = _mm_div_ps(hu, h);
+			const __m128 small = _mm_div_ps(_mm_mul_ps(x, x), _mm_mul_ps(h, hu));
+			const __m128 front = _mm_cmple_ps(z, zero);
+			const __m128 valid = _mm_cmpgt_ps(h, zero);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 cosHalf = _mm_sqrt_ps(_mm_mul_ps(half, sse2Select(valid, sse2Select(front, big, small), _mm_set1_ps(2.f))));
+			const __m128 sinHalf = _mm_or_ps(_mm_sqrt_ps(_mm_mul_ps(half, _mm_and_ps(valid, sse2Select(front, small, big)))), _mm_and_ps(signBit, x));
+			const __m128 cosDelta = _mm_sqrt_ps(_mm_sub_ps(one, _mm_div_ps(_mm_mul_ps(y, y), _mm_mul_ps(r, r))));
+			const __m128 zz = _mm_sqrt_ps(_mm_add_ps(one, _mm_mul_ps(cosDelta, cosHalf)));
+			x = _mm_mul_ps(_mm_div_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps((float)(2.*M_SQRT2)), cosDelta), sinHalf), zz), ws);
+			y = _mm_div_ps(_mm_div_ps(_mm_mul_ps(_mm_set1_ps((float)M_SQRT2), y), r), zz);
+			z = r;
+			break;
+		}
+		case StelProjectionCylinder:
+		case StelProjectionSinusoidal:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 h = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(z, z)));
+			__m128 alpha = sse2Atan2(x, _mm_xor_ps(z, signBit));
+			// asin(y/r), better conditioned near the poles
+			const __m128 delta = sse2Atan2(y, h);
+			if (type==StelProjectionSinusoidal)
+				alpha = _mm_mul_ps(alpha, _mm_div_ps(h, r));
+			x = _mm_mul_ps(alpha, ws);
+			y = delta;
+			z = r;
+			break;
+		}
+		case StelProjectionMercator:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 sinDelta = _mm_div_ps(y, r);
+			x = _mm_mul_ps(sse2Atan2(x, _mm_xor_ps(z, signBit)), ws);
+			y = _mm_mul_ps(_mm_set1_ps(0.5f), sse2Log(_mm_div_ps(_mm_add_ps(one, sinDelta), _mm_sub_ps(one, sinDelta))));
+			z = r;
+			break;
+		}
+		case StelProjectionOrthographic:
+		{
+			const __m128 r = sse2Length(x, y, z);
+			const __m128 h = _mm_div_ps(one, r);
+			x = _mm_mul_ps(x, _mm_mul_ps(h, ws));
+			y = _mm_mul_ps(y, h);
+			z = r;
+			break;
+		}
+		default:
+		{
+			float vx[4], vy[4], vz[4], v[3];
+			_mm_storeu_ps(vx, x);
+			_mm_storeu_ps(vy, y);
+			_mm_storeu_ps(vz, z);
+			for (int l=0;l<4;++l)
+			{
+				v[0] = vx[l]; v[1] = vy[l]; v[2] = vz[l];
+				forwardScalar(type, widthStretch, v);
+				vx[l] = v[0]; vy[l] = v[1]; vz[l] = v[2];
+			}
+			x = _mm_loadu_ps(vx);
+			y = _mm_loadu_ps(vy);
+			z = _mm_loadu_ps(vz);
+		}
+	}
+}
+
+// Row k of the model view transformation for 4 vectors, see Vector3::transfo4d()
+PROJECTORKERNELS_TARGET_SSE2
+static inline __m128 sse2TransformRow(const double* m, int k, const __m128d* x, const __m128d* y, const __m128d* z)
+{
+	const __m128d m0 = _mm_set1_pd(m[k]), m1 = _mm_set1_pd(m[k+4]), m2 = _mm_set1_pd(m[k+8]), m3 = _mm_set1_pd(m[k+12]);
+	const __m128d lo = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0, x[0]), _mm_mul_pd(m1, y[0])), _mm_mul_pd(m2, z[0])), m3);
+	const __m128d hi = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0, x[1]), _mm_mul_pd(m1, y[1])), _mm_mul_pd(m2, z[1])), m3);
+	return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static int projectBatchSSE2(const StelProjectionParams& p, int n, const double* x, const double* y, const double* z, float* wx, float* wy, float* wz)
+{
+	const __m128 cx = _mm_set1_ps(p.viewportCenter[0]), cy = _mm_set1_ps(p.viewportCenter[1]);
+	const __m128 sx = _mm_set1_ps(p.flipHorz * p.pixelPerRad), sy = _mm_set1_ps(p.flipVert * p.pixelPerRad);
+	const __m128 zNear = _mm_set1_ps(p.zNear), zScale = _mm_set1_ps(p.oneOverZNearMinusZFar);
+	int i = 0;
+	for (;i+4<=n;i+=4)
+	{
+		const __m128d ix[2] = {_mm_loadu_pd(x+i), _mm_loadu_pd(x+i+2)};
+		const __m128d iy[2] = {_mm_loadu_pd(y+i), _mm_loadu_pd(y+i+2)};
+		const __m128d iz[2] = {_mm_loadu_pd(z+i), _mm_loadu_pd(z+i+2)};
+		__m128 vx = sse2TransformRow(p.modelView, 0, ix, iy, iz);
+		__m128 vy = sse2TransformRow(p.modelView, 1, ix, iy, iz);
+		__m128 vz = sse2TransformRow(p.modelView, 2, ix, iy, iz);
+		sse2Forward(p.type, p.widthStretch, vx, vy, vz);
+		_mm_storeu_ps(wx+i, _mm_add_ps(cx, _mm_mul_ps(sx, vx)));
+		_mm_storeu_ps(wy+i, _mm_add_ps(cy, _mm_mul_ps(sy, vy)));
+		_mm_storeu_ps(wz+i, _mm_mul_ps(_mm_sub_ps(vz, zNear), zScale));
+	}
+	return i;
+}
+
+PROJECTORKERNELS_TARGET_SSE2
+static int unProjectBatchSSE2(const StelProjectionParams& p, int n, const double* wx, const double* wy, double* x, double* y, double* z)
+{
+	if (!hasVectorBackward(p.type))
+		return 0;
+	const double* m = p.modelView;
+	const __m128d cx = _mm_set1_pd(p.viewportCenter[0]), cy = _mm_set1_pd(p.viewportCenter[1]);
+	const __m128d fx = _mm_set1_pd(p.flipHorz), fy = _mm_set1_pd(p.flipVert);
+	const __m128d ppr = _mm_set1_pd(p.pixelPerRad), ws = _mm_set1_pd(p.widthStretch);
+	const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.), quarter = _mm_set1_pd(0.25);
+	const __m128d signBit = _mm_set1_pd(-0.);
+	int i = 0;
+	for (;i+2<=n;i+=2)
+	{
+		__m128d vx = _mm_div_pd(_mm_div_pd(_mm_mul_pd(fx, _mm_sub_pd(_mm_loadu_pd(wx+i), cx)), ppr), ws);
+		__m128d vy = _mm_div_pd(_mm_mul_pd(fy, _mm_sub_pd(_mm_loadu_pd(wy+i), cy)), ppr);
+		__m128d vz;
+		const __m128d dq = _mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy));
+		switch (p.type)
+		{
+			case StelProjectionPerspective:
+			{
+				const __m128d s = _mm_sqrt_pd(_mm_div_pd(one, _mm_add_pd(_mm_add_pd(one, _mm_mul_pd(vx, vx)), _mm_mul_pd(vy, vy))));
+				vx = _mm_mul_pd(vx, s);
+				vy = _mm_mul_pd(vy, s);
+				vz = _mm_xor_pd(s, signBit);
+				break;
+			}
+			case StelProjectionEqualArea:
+			{
+				const __m128d l = _mm_sub_pd(one, _mm_mul_pd(quarter, dq));
+				const __m128d outside = _mm_cmplt_pd(l, zero);
+				const __m128d sl = _mm_sqrt_pd(_mm_max_pd(l, zero));
+				vx = _mm_andnot_pd(outside, _mm_mul_pd(vx, sl));
+				vy = _mm_andnot_pd(outside, _mm_mul_pd(vy, sl));
+				vz = sse2Select(outside, one, _mm_sub_pd(_mm_mul_pd(_mm_set1_pd(0.5), dq), one));
+				break;
+			}
+			case StelProjectionStereographic:
+			{
+				const __m128d lqq = _mm_mul_pd(quarter, dq);
+				const __m128d f = _mm_div_pd(one, _mm_add_pd(lqq, one));
+				vx = _mm_mul_pd(vx, f);
+				vy = _mm_mul_pd(vy, f);
+				vz = _mm_mul_pd(_mm_sub_pd(lqq, one), f);
+				break;
+			}
+			default: // StelProjectionOrthographic
+			{
+				const __m128d h = _mm_sub_pd(one, dq);
+				const __m128d outside = _mm_cmplt_pd(h, zero);
+				const __m128d f = _mm_div_pd(one, _mm_sqrt_pd(dq));
+				vx = sse2Select(outside, _mm_mul_pd(vx, f), vx);
+				vy = sse2Select(outside, _mm_mul_pd(vy, f), vy);
+				vz = _mm_andnot_pd(outside, _mm_xor_pd(_mm_sqrt_pd(_mm_max_pd(h, zero)), signBit));
+				break;
+			}
+		}
+		const __m128d tx = _mm_sub_pd(vx, _mm_set1_pd(m[12]));
+		const __m128d ty = _mm_sub_pd(vy, _mm_set1_pd(m[13]));
+		const __m128d tz = _mm_sub_pd(vz, _mm_set1_pd(m[14]));
+		_mm_storeu_pd(x+i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[0]), tx), _mm_mul_pd(_mm_set1_pd(m[1]), ty)), _mm_mul_pd(_mm_set1_pd(m[2]), tz)));
+		_mm_storeu_pd(y+i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[4]), tx), _mm_mul_pd(_mm_set1_pd(m[5]), ty)), _mm_mul_pd(_mm_set1_pd(m[6]), tz)));
+		_mm_storeu_pd(z+i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[8]), tx), _mm_mul_pd(_mm_set1_pd(m[9]), ty)), _mm_mul_pd(_mm_set1_pd(m[10]), tz)));
+	}
+	return i;
+}
+
+/*************************************************************************
+ AVX2 implementation, 8 vectors at a time for projectBatch() and 4 points
+ at a time for unProjectBatch(). Same operations as the SSE2 code.
+*************************************************************************/
+PROJECTORKERNELS_TARGET_AVX2
+static inline __m256 avx2Length(__m256 x, __m256 y, __m256 z)
+{
+	return _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static inline __m256 avx2Atan2(__m256 y, __m256 x)
+{
+	const __m256 signBit = _mm256_set1_ps(-0.f);
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 ax = _mm256_andnot_ps(signBit, x);
+	const __m256 ay = _mm256_andnot_ps(signBit, y);
+	const __m256 swap = _mm256_cmp_ps(ay, ax, _CMP_GT_OQ);
+	const __m256 den = _mm256_max_ps(ax, ay);
+	__m256 t = _mm256_and_ps(_mm256_div_ps(_mm256_min_ps(ax, ay), den), _mm256_cmp_ps(den, _mm256_setzero_ps(), _CMP_GT_OQ));
+	const __m256 reduce = _mm256_cmp_ps(t, _mm256_set1_ps(0.414213562373095f), _CMP_GT_OQ);
+	t = _mm256_blendv_ps(t, _mm256_div_ps(_mm256_sub_ps(t, one), _mm256_add_ps(t, one)), reduce);
+	const __m256 z = _mm256_mul_ps(t, t);
+	__m256 p = _mm256_set1_ps(8.05374449538e-2f);
+	p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.38776856032e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.99777106478e-1f));
+	p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(3.33329491539e-1f));
+	__m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), t), t);
+	r = _mm256_add_ps(r, _mm256_and_ps(reduce, _mm256_set1_ps((float)(M_PI/4.))));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps((float)M_PI_2), r), swap);
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps((float)M_PI), r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+	return _mm256_or_ps(r, _mm256_and_ps(signBit, y));
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static inline __m256 avx2Log(__m256 x)
+{
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256i xi = _mm256_castps_si256(x);
+	__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+	const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+	e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+	m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+	const __m256 z = _mm256_mul_ps(m, m);
+	__m256 p = _mm256_set1_ps(7.0376836292e-2f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-1.1514610310e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(1.1676998740e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-1.2420140846e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(1.4249322787e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-1.6668057665e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(2.0000714765e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-2.4999993993e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(3.3333331174e-1f));
+	__m256 y = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+	y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+	y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+	return _mm256_add_ps(_mm256_add_ps(m, y), _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static inline void avx2Forward(StelProjectionType type, float widthStretch, __m256& x, __m256& y, __m256& z)
+{
+	const __m256 ws = _mm256_set1_ps(widthStretch);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 signBit = _mm256_set1_ps(-0.f);
+	const __m256 maxFloat = _mm256_set1_ps(std::numeric_limits<float>::max());
+	switch (type)
+	{
+		case StelProjectionPerspective:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 az = _mm256_andnot_ps(signBit, z);
+			const __m256 front = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+			const __m256 valid = _mm256_cmp_ps(z, zero, _CMP_NEQ_OQ);
+			x = _mm256_blendv_ps(maxFloat, _mm256_mul_ps(x, _mm256_div_ps(ws, az)), valid);
+			y = _mm256_blendv_ps(maxFloat, _mm256_div_ps(y, az), valid);
+			z = _mm256_blendv_ps(_mm256_xor_ps(maxFloat, signBit), r, front);
+			break;
+		}
+		case StelProjectionEqualArea:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 f = _mm256_sqrt_ps(_mm256_div_ps(_mm256_set1_ps(2.f), _mm256_mul_ps(r, _mm256_sub_ps(r, z))));
+			x = _mm256_mul_ps(x, _mm256_mul_ps(f, ws));
+			y = _mm256_mul_ps(y, f);
+			z = r;
+			break;
+		}
+		case StelProjectionStereographic:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 h = _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_sub_ps(r, z));
+			const __m256 valid = _mm256_cmp_ps(h, zero, _CMP_GT_OQ);
+			const __m256 f = _mm256_div_ps(one, h);
+			x = _mm256_blendv_ps(maxFloat, _mm256_mul_ps(x, _mm256_mul_ps(f, ws)), valid);
+			y = _mm256_blendv_ps(maxFloat, _mm256_mul_ps(y, f), valid);
+			z = _mm256_blendv_ps(_mm256_set1_ps(-std::numeric_limits<float>::min()), r, valid);
+			break;
+		}
+		case StelProjectionFisheye:
+		{
+			const __m256 rq1 = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+			const __m256 h = _mm256_sqrt_ps(rq1);
+			const __m256 f = _mm256_div_ps(avx2Atan2(h, _mm256_xor_ps(z, signBit)), h);
+			const __m256 valid = _mm256_cmp_ps(rq1, zero, _CMP_GT_OQ);
+			const __m256 front = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+			x = _mm256_blendv_ps(_mm256_andnot_ps(front, maxFloat), _mm256_mul_ps(x, _mm256_mul_ps(f, ws)), valid);
+			y = _mm256_blendv_ps(_mm256_andnot_ps(front, maxFloat), _mm256_mul_ps(y, f), valid);
+			z = _mm256_blendv_ps(_mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::min()), one, front),
+					     _mm256_sqrt_ps(_mm256_add_ps(rq1, _mm256_mul_ps(z, z))), valid);
+			break;
+		}
+		case StelProjectionHammer:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 h = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(z, z)));
+			const __m256 hu = _mm256_add_ps(h, _mm256_andnot_ps(signBit, z));
+			const __m256 big = _mm256_div_ps(hu, h);
+			const __m256 small = _mm256_div_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(h, hu));
+			const __m256 front = _mm256_cmp_ps(z, zero, _CMP_LE_OQ);
+			const __m256 valid = _mm256_cmp_ps(h, zero, _CMP_GT_OQ);
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 cosHalf = _mm256_sqrt_ps(_mm256_mul_ps(half, _mm256_blendv_ps(_mm256_set1_ps(2.f), _mm256_blendv_ps(small, big, front), valid)));
+			const __m256 sinHalf = _mm256_or_ps(_mm256_sqrt_ps(_mm256_mul_ps(half, _mm256_and_ps(valid, _mm256_blendv_ps(big, small, front)))), _mm256_and_ps(signBit, x));
+			const __m256 cosDelta = _mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_div_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(r, r))));
+			const __m256 zz = _mm256_sqrt_ps(_mm256_add_ps(one, _mm256_mul_ps(cosDelta, cosHalf)));
+			x = _mm256_mul_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps((float)(2.*M_SQRT2)), cosDelta), sinHalf), zz), ws);
+			y = _mm256_div_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps((float)M_SQRT2), y), r), zz);
+			z = r;
+			break;
+		}
+		case StelProjectionCylinder:
+		case StelProjectionSinusoidal:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 h = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(z, z)));
+			__m256 alpha = avx2Atan2(x, _mm256_xor_ps(z, signBit));
+			const __m256 delta = avx2Atan2(y, h);
+			if (type==StelProjectionSinusoidal)
+				alpha = _mm256_mul_ps(alpha, _mm256_div_ps(h, r));
+			x = _mm256_mul_ps(alpha, ws);
+			y = delta;
+			z = r;
+			break;
+		}
+		case StelProjectionMercator:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 sinDelta = _mm256_div_ps(y, r);
+			x = _mm256_mul_ps(avx2Atan2(x, _mm256_xor_ps(z, signBit)), ws);
+			y = _mm256_mul_ps(_mm256_set1_ps(0.5f), avx2Log(_mm256_div_ps(_mm256_add_ps(one, sinDelta), _mm256_sub_ps(one, sinDelta))));
+			z = r;
+			break;
+		}
+		case StelProjectionOrthographic:
+		{
+			const __m256 r = avx2Length(x, y, z);
+			const __m256 h = _mm256_div_ps(one, r);
+			x = _mm256_mul_ps(x, _mm256_mul_ps(h, ws));
+			y = _mm256_mul_ps(y, h);
+			z = r;
+			break;
+		}
+		default:
+		{
+			float vx[8], vy[8], vz[8], v[3];
+			_mm256_storeu_ps(vx, x);
+			_mm256_storeu_ps(vy, y);
+			_mm256_storeu_ps(vz, z);
+			for (int l=0;l<8;++l)
+			{
+				v[0] = vx[l]; v[1] = vy[l]; v[2] = vz[l];
+				forwardScalar(type, widthStretch, v);
+				vx[l] = v[0]; vy[l] = v[1]; vz[l] = v[2];
+			}
+			x = _mm256_loadu_ps(vx);
+			y = _mm256_loadu_ps(vy);
+			z = _mm256_loadu_ps(vz);
+		}
+	}
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static inline __m256 avx2TransformRow(const double* m, int k, const __m256d* x, const __m256d* y, const __m256d* z)
+{
+	const __m256d m0 = _mm256_set1_pd(m[k]), m1 = _mm256_set1_pd(m[k+4]), m2 = _mm256_set1_pd(m[k+8]), m3 = _mm256_set1_pd(m[k+12]);
+	const __m256d lo = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m0, x[0]), _mm256_mul_pd(m1, y[0])), _mm256_mul_pd(m2, z[0])), m3);
+	const __m256d hi = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m0, x[1]), _mm256_mul_pd(m1, y[1])), _mm256_mul_pd(m2, z[1])), m3);
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static int projectBatchAVX2(const StelProjectionParams& p, int n, const double* x, const double* y, const double* z, float* wx, float* wy, float* wz)
+{
+	const __m256 cx = _mm256_set1_ps(p.viewportCenter[0]), cy = _mm256_set1_ps(p.viewportCenter[1]);
+	const __m256 sx = _mm256_set1_ps(p.flipHorz * p.pixelPerRad), sy = _mm256_set1_ps(p.flipVert * p.pixelPerRad);
+	const __m256 zNear = _mm256_set1_ps(p.zNear), zScale = _mm256_set1_ps(p.oneOverZNearMinusZFar);
+	int i = 0;
+	for (;i+8<=n;i+=8)
+	{
+		const __m256d ix[2] = {_mm256_loadu_pd(x+i), _mm256_loadu_pd(x+i+4)};
+		const __m256d iy[2] = {_mm256_loadu_pd(y+i), _mm256_loadu_pd(y+i+4)};
+		const __m256d iz[2] = {_mm256_loadu_pd(z+i), _mm256_loadu_pd(z+i+4)};
+		__m256 vx = avx2TransformRow(p.modelView, 0, ix, iy, iz);
+		__m256 vy = avx2TransformRow(p.modelView, 1, ix, iy, iz);
+		__m256 vz = avx2TransformRow(p.modelView, 2, ix, iy, iz);
+		avx2Forward(p.type, p.widthStretch, vx, vy, vz);
+		_mm256_storeu_ps(wx+i, _mm256_add_ps(cx, _mm256_mul_ps(sx, vx)));
+		_mm256_storeu_ps(wy+i, _mm256_add_ps(cy, _mm256_mul_ps(sy, vy)));
+		_mm256_storeu_ps(wz+i, _mm256_mul_ps(_mm256_sub_ps(vz, zNear), zScale));
+	}
+	return i;
+}
+
+PROJECTORKERNELS_TARGET_AVX2
+static int unProjectBatchAVX2(const StelProjectionParams& p, int n, const double* wx, const double* wy, double* x, double* y, double* z)
+{
+	if (!hasVectorBackward(p.type))
+		return 0;
+	const double* m = p.modelView;
+	const __m256d cx = _mm256_set1_pd(p.viewportCenter[0]), cy = _mm256_set1_pd(p.viewportCenter[1]);
+	const __m256d fx = _mm256_set1_pd(p.flipHorz), fy = _mm256_set1_pd(p.flipVert);
+	const __m256d ppr = _mm256_set1_pd(p.pixelPerRad), ws = _mm256_set1_pd(p.widthStretch);
+	const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.), quarter = _mm256_set1_pd(0.25);
+	const __m256d signBit = _mm256_set1_pd(-0.);
+	int i = 0;
+	for (;i+4<=n;i+=4)
+	{
+		__m256d vx = _mm256_div_pd(_mm256_div_pd(_mm256_mul_pd(fx, _mm256_sub_pd(_mm256_loadu_pd(wx+i), cx)), ppr), ws);
+		__m256d vy = _mm256_div_pd(_mm256_mul_pd(fy, _mm256_sub_pd(_mm256_loadu_pd(wy+i), cy)), ppr);
+		__m256d vz;
+		const __m256d dq = _mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy));
+		switch (p.type)
+		{
+			case StelProjectionPerspective:
+			{
+				const __m256d s = _mm256_sqrt_pd(_mm256_div_pd(one, _mm256_add_pd(_mm256_add_pd(one, _mm256_mul_pd(vx, vx)), _mm256_mul_pd(vy, vy))));
+				vx = _mm256_mul_pd(vx, s);
+				vy = _mm256_mul_pd(vy, s);
+				vz = _mm256_xor_pd(s, signBit);
+				break;
+			}
+			case StelProjectionEqualArea:
+			{
+				const __m256d l = _mm256_sub_pd(one, _mm256_mul_pd(quarter, dq));
+				const __m256d outside = _mm256_cmp_pd(l, zero, _CMP_LT_OQ);
+				const __m256d sl = _mm256_sqrt_pd(_mm256_max_pd(l, zero));
+				vx = _mm256_andnot_pd(outside, _mm256_mul_pd(vx, sl));
+				vy = _mm256_andnot_pd(outside, _mm256_mul_pd(vy, sl));
+				vz = _mm256_blendv_pd(_mm256_sub_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), dq), one), one, outside);
+				break;
+			}
+			case StelProjectionStereographic:
+			{
+				const __m256d lqq = _mm256_mul_pd(quarter, dq);
+				const __m256d f = _mm256_div_pd(one, _mm256_add_pd(lqq, one));
+				vx = _mm256_mul_pd(vx, f);
+				vy = _mm256_mul_pd(vy, f);
+				vz = _mm256_mul_pd(_mm256_sub_pd(lqq, one), f);
+				break;
+			}
+			default: // StelProjectionOrthographic
+			{
+				const __m256d h = _mm256_sub_pd(one, dq);
+				const __m256d outside = _mm256_cmp_pd(h, zero, _CMP_LT_OQ);
+				const __m256d f = _mm256_div_pd(one, _mm256_sqrt_pd(dq));
+				vx = _mm256_blendv_pd(vx, _mm256_mul_pd(vx, f), outside);
+				vy = _mm256_blendv_pd(vy, _mm256_mul_pd(vy, f), outside);
+				vz = _mm256_andnot_pd(outside, _mm256_xor_pd(_mm256_sqrt_pd(_mm256_max_pd(h, zero)), signBit));
+				break;
+			}
+		}
+		const __m256d tx = _mm256_sub_pd(vx, _mm256_set1_pd(m[12]));
+		const __m256d ty = _mm256_sub_pd(vy, _mm256_set1_pd(m[13]));
+		const __m256d tz = _mm256_sub_pd(vz, _mm256_set1_pd(m[14]));
+		_mm256_storeu_pd(x+i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(m[0]), tx), _mm256_mul_pd(_mm256_set1_pd(m[1]), ty)), _mm256_mul_pd(_mm256_set1_pd(m[2]), tz)));
+		_mm256_storeu_pd(y+i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(m[4]), tx), _mm256_mul_pd(_mm256_set1_pd(m[5]), ty)), _mm256_mul_pd(_mm256_set1_pd(m[6]), tz)));
+		_mm256_storeu_pd(z+i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(m[8]), tx), _mm256_mul_pd(_mm256_set1_pd(m[9]), ty)), _mm256_mul_pd(_mm256_set1_pd(m[10]), tz)));
+	}
+	return i;
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0]<7)
+		return false;
+	__cpuid(info, 1);
+	// The OS must save the AVX registers
+	const bool osxsave = (info[2] & (1<<27)) && (info[2] & (1<<28));
+	if (!osxsave || (_xgetbv(0) & 6)!=6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1<<5))!=0;
+#endif
+}
+
+#endif // PROJECTORKERNELS_X86
+
+bool isProjectionKernelSupported(StelProjectionKernel kernel)
+{
+	switch (kernel)
+	{
+		case StelProjectionKernelScalar:
+			return true;
+#ifdef PROJECTORKERNELS_X86
+		case StelProjectionKernelSSE2:
+#if defined(__GNUC__)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2");
+#else
+			return true;
+#endif
+		case StelProjectionKernelAVX2:
+			return cpuHasAVX2();
+#endif
+		default:
+			return false;
+	}
+}
+
+StelProjectionKernel getBestProjectionKernel()
+{
+	if (isProjectionKernelSupported(StelProjectionKernelAVX2))
+		return StelProjectionKernelAVX2;
+	if (isProjectionKernelSupported(StelProjectionKernelSSE2))
+		return StelProjectionKernelSSE2;
+	return StelProjectionKernelScalar;
+}
+
+void projectBatch(StelProjectionKernel kernel, const StelProjectionParams& params, int n,
+		  const double* x, const double* y, const double* z, float* wx, float* wy, float* wz)
+{
+	Q_ASSERT(params.type!=StelProjectionNone);
+	int done = 0;
+	switch (kernel)
+	{
+#ifdef PROJECTORKERNELS_X86
+		case StelProjectionKernelSSE2:
+			done = projectBatchSSE2(params, n, x, y, z, wx, wy, wz);
+			break;
+		case StelProjectionKernelAVX2:
+			done = projectBatchAVX2(params, n, x, y, z, wx, wy, wz);
+			break;
+#endif
+		default:
+			break;
+	}
+	// The last vectors, or all of them for the scalar kernel
+	projectBatchScalar(params, done, n, x, y, z, wx, wy, wz);
+}
+
+void unProjectBatch(StelProjectionKernel kernel, const StelProjectionParams& params, int n,
+		    const double* wx, const double* wy, double* x, double* y, double* z)
+{
+	Q_ASSERT(params.type!=StelProjectionNone);
+	int done = 0;
+	switch (kernel)
+	{
+#ifdef PROJECTORKERNELS_X86
+		case StelProjectionKernelSSE2:
+			done = unProjectBatchSSE2(params, n, wx, wy, x, y, z);
+			break;
+		case StelProjectionKernelAVX2:
+			done = unProjectBatchAVX2(params, n, wx, wy, x, y, z);
+			break;
+#endif
+		default:
+			break;
+	}
+	unProjectBatchScalar(params, done, n, wx, wy, x, y, z);
+}
@@ -0,0 +1,105 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELPROJECTORKERNELS_HPP_
+#define _STELPROJECTORKERNELS_HPP_
+
+//! Projections which can be computed by projectBatch() and unProjectBatch().
+//! The formulas are the ones of the forward() and backward() methods of the StelProjector classes.
+enum StelProjectionType
+{
+	StelProjectionNone,		//!< No batched implementation, the StelProjector methods must be used
+	StelProjectionPerspective,
+	StelProjectionEqualArea,
+	StelProjectionStereographic,
+	StelProjectionFisheye,
+	StelProjectionHammer,
+	StelProjectionCylinder,
+	StelProjectionMercator,
+	StelProjectionOrthographic,
+	StelProjectionSinusoidal,
+	StelProjectionMiller
+};
+
+//! Available implementations of projectBatch() and unProjectBatch().
+enum StelProjectionKernel
+{
+	StelProjectionKernelScalar,	//!< Portable implementation, one vector at a time
+	StelProjectionKernelSSE2,	//!< 4 vectors at a time (2 for unProjectBatch())
+	StelProjectionKernelAVX2	//!< 8 vectors at a time (4 for unProjectBatch())
+};
+
+//! @struct StelProjectionParams
+//! The state of a StelProjector used by the batched projections.
+struct StelProjectionParams
+{
+	StelProjectionType type;
+	//! The linear model view transformation, column major like Mat4d.
+	double modelView[16];
+	float widthStretch;
+	float viewportCenter[2];
+	float flipHorz, flipVert;
+	float pixelPerRad;
+	float zNear, oneOverZNearMinusZFar;
+};
+
+//! Get the fastest implementation supported by the CPU we are running on.
+StelProjectionKernel getBestProjectionKernel();
+
+//! Check whether an implementation can be used on this CPU (and was compiled in).
+bool isProjectionKernelSupported(StelProjectionKernel kernel);
+
+//! Project vectors from the current frame into the viewport frame, like StelProjector::project().
+//! Unlike the virtual method, the validity of the projected points is not returned.
+//! The Miller projection has no vector code, it is computed one vector at a time after a vectorized model view transformation.
+//! @param kernel the implementation to use, which must be supported
+//! @param params the projector state, params.type must not be StelProjectionNone
+//! @param n the number of vectors
+//! @param x,y,z the coordinates of the vectors
+//! @param wx,wy,wz receive the coordinates in the viewport frame
+void projectBatch(StelProjectionKernel kernel, const StelProjectionParams& params, int n,
+		  const double* x, const double* y, const double* z, float* wx, float* wy, float* wz);
+
+//! Same as above, using the fastest implementation.
+inline void projectBatch(const StelProjectionParams& params, int n, const double* x, const double* y, const double* z, float* wx, float* wy, float* wz)
+{
+	static const StelProjectionKernel kernel = getBestProjectionKernel();
+	projectBatch(kernel, params, n, x, y, z, wx, wy, wz);
+}
+
+//! Project points of the viewport back into the current frame, like StelProjector::unProject().
+//! The validity of the points is not returned.
+//! Only the perspective, equal area, stereographic and orthographic projections have vector code,
+//! the other ones are computed by the scalar implementation whatever the kernel.
+//! @param kernel the implementation to use, which must be supported
+//! @param params the projector state, params.type must not be StelProjectionNone
+//! @param n the number of points
+//! @param wx,wy the coordinates of the points in the viewport, in pixels
+//! @param x,y,z receive the coordinates of the vectors in the current frame
+void unProjectBatch(StelProjectionKernel kernel, const StelProjectionParams& params, int n,
+		    const double* wx, const double* wy, double* x, double* y, double* z);
+
+//! Same as above, using the fastest implementation.
+inline void unProjectBatch(const StelProjectionParams& params, int n, const double* wx, const double* wy, double* x, double* y, double* z)
+{
+	static const StelProjectionKernel kernel = getBestProjectionKernel();
+	unProjectBatch(kernel, params, n, wx, wy, x, y, z);
+}
+
+#endif // _STELPROJECTORKERNELS_HPP_
@@ -23,6 +23,9 @@
 #ifndef GL_VERTEX_PROGRAM_POINT_SIZE
  #define GL_VERTEX_PROGRAM_POINT_SIZE 0x8642
 #endif
+#ifndef GL_ALIASED_POINT_SIZE_RANGE
+ #define GL_ALIASED_POINT_SIZE_RANGE 0x846E
+#endif
 
 #include "StelSkyDrawer.hpp"
 #include "StelProjector.hpp"
@@ -60,8 +63,16 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	limitLuminance(0.f),
 	bortleScaleIndex(3),
 	inScale(1.f),
+	maxPointSourceRadius(0.f),
+	pointSourceBuffer(QOpenGLBuffer::VertexBuffer),
+	pointSourceBufferSize(0),
 	starShaderProgram(NULL),
 	starShaderVars(StarShaderVars()),
+	pointSpriteShaderProgram(NULL),
+	pointSpriteShaderVars(PointSpriteShaderVars()),
+	flagPointSprites(true),
+	maxPointSize(0.f),
+	nbPointSources(0),
 	maxLum(0.f),
 	oldLum(-1.f),
 	big3dModelHaloRadius(150.f)
@@ -74,6 +85,7 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	setTwinkleAmount(conf->value("stars/star_twinkle_amount",0.3).toFloat());
 	setFlagTwinkle(conf->value("stars/flag_star_twinkle",true).toBool());
 	setFlagForcedTwinkle(conf->value("stars/flag_forced_twinkle",false).toBool());
+	flagPointSprites = conf->value("stars/flag_point_sprites",true).toBool();
 	setMaxAdaptFov(conf->value("stars/mag_converter_max_fov",70.0).toFloat());
 	setMinAdaptFov(conf->value("stars/mag_converter_min_fov",0.1).toFloat());
 	setFlagLuminanceAdaptation(conf->value("viewing/use_luminance_adaptation",true).toBool());
@@ -117,31 +129,16 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	if (!ok)
 		setAtmospherePressure(1013.0);
 
-	// Initialize buffers for use by gl vertex array
-	nbPointSources = 0;
-	maxPointSources = 1000;
-	
-	
-	vertexArray = new StarVertex[maxPointSources*6];
-	
-	textureCoordArray = new unsigned char[maxPointSources*6*2];
-	for (unsigned int i=0;i<maxPointSources; ++i)
-	{
-		static const unsigned char texElems[] = {0, 0, 255, 0, 255, 255, 0, 0, 255, 255, 0, 255};
-		unsigned char* elem = &textureCoordArray[i*6*2];
-		memcpy(elem, texElems, 12);
-	}
+	// Initial size of the point source buffer, it grows when more sources are drawn at once
+	pointSources.resize(1000);
 }
 
 StelSkyDrawer::~StelSkyDrawer()
 {
-	delete[] vertexArray;
-	vertexArray = NULL;
-	delete[] textureCoordArray;
-	textureCoordArray = NULL;
-	
 	delete starShaderProgram;
 	starShaderProgram = NULL;
+	delete pointSpriteShaderProgram;
+	pointSpriteShaderProgram = NULL;
 }
 
 // Init parameters from config file
@@ -193,6 +190,59 @@ void StelSkyDrawer::init()
 	starShaderVars.color = starShaderProgram->attributeLocation("color");
 	starShaderVars.texture = starShaderProgram->uniformLocation("tex");
 
+	// Point sprite shader: one vertex per source, the twinkling is done here too.
+	// The random value is a hash of the position, changed at each frame by twinkleSeed.
+	QOpenGLShader spriteVShader(QOpenGLShader::Vertex);
+	const char *spriteVSrc =
+		"attribute highp vec2 pos;\n"
+		"attribute mediump float radius;\n"
+		"attribute mediump vec4 color;\n"
+		"uniform mediump mat4 projectionMatrix;\n"
+		"uniform highp float twinkleSeed;\n"
+		"varying mediump vec3 outColor;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_Position = projectionMatrix * vec4(pos.x, pos.y, 0, 1);\n"
+		"    gl_PointSize = 2.0*radius;\n"
+		"    highp float r = fract(sin(dot(pos, vec2(12.9898, 78.233)) + twinkleSeed)*43758.5453);\n"
+		"    outColor = color.rgb*(1.0-color.a*r);\n"
+		"}\n";
+	spriteVShader.compileSourceCode(spriteVSrc);
+	if (!spriteVShader.log().isEmpty()) { qWarning() << "StelSkyDrawer::init(): Warnings while compiling spriteVShader: " << spriteVShader.log(); }
+
+	QOpenGLShader spriteFShader(QOpenGLShader::Fragment);
+	const char *spriteFSrc =
+		"varying mediump vec3 outColor;\n"
+		"uniform sampler2D tex;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_FragColor = texture2D(tex, gl_PointCoord)*vec4(outColor, 1.);\n"
+		"}\n";
+	spriteFShader.compileSourceCode(spriteFSrc);
+	if (!spriteFShader.log().isEmpty()) { qWarning() << "StelSkyDrawer::init(): Warnings while compiling spriteFShader: " << spriteFShader.log(); }
+
+	pointSpriteShaderProgram = new QOpenGLShaderProgram(QOpenGLContext::currentContext());
+	pointSpriteShaderProgram->addShader(&spriteVShader);
+	pointSpriteShaderProgram->addShader(&spriteFShader);
+	if (StelPainter::linkProg(pointSpriteShaderProgram, "pointSpriteShader"))
+	{
+		pointSpriteShaderVars.projectionMatrix = pointSpriteShaderProgram->uniformLocation("projectionMatrix");
+		pointSpriteShaderVars.twinkleSeed = pointSpriteShaderProgram->uniformLocation("twinkleSeed");
+		pointSpriteShaderVars.pos = pointSpriteShaderProgram->attributeLocation("pos");
+		pointSpriteShaderVars.radius = pointSpriteShaderProgram->attributeLocation("radius");
+		pointSpriteShaderVars.color = pointSpriteShaderProgram->attributeLocation("color");
+		pointSpriteShaderVars.texture = pointSpriteShaderProgram->uniformLocation("tex");
+
+		GLfloat pointSizeRange[2] = {0.f, 0.f};
+		glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, pointSizeRange);
+		maxPointSize = pointSizeRange[1];
+		pointSourceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+		pointSourceBuffer.create();
+	}
+	else
+		flagPointSprites = false;
+	qDebug() << "Point sources drawn as" << (flagPointSprites ? "point sprites, maximum size" : "quads") << maxPointSize;
+
 	update(0);
 }
 
@@ -392,16 +442,109 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 
 	const Mat4f& m = sPainter->getProjector()->getProjectionMatrix();
 	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
-	
+
+	// The point size is limited by the GL implementation (sometimes to 1 pixel on OpenGL ES).
+	if (flagPointSprites && 2.f*maxPointSourceRadius<=maxPointSize)
+		drawPointSprites(qMat);
+	else
+		drawPointQuads(qMat);
+
+	nbPointSources = 0;
+	maxPointSourceRadius = 0.f;
+}
+
+void StelSkyDrawer::drawPointSprites(const QMatrix4x4& qMat)
+{
+	Q_ASSERT(sizeof(PointSource)==16);
+
+	const int size = nbPointSources*(int)sizeof(PointSource);
+	pointSourceBuffer.bind();
+	if (size>pointSourceBufferSize)
+	{
+		pointSourceBufferSize = pointSources.size()*(int)sizeof(PointSource);
+		pointSourceBuffer.allocate(pointSourceBufferSize);
+	}
+	pointSourceBuffer.write(0, pointSources.constData(), size);
+
+	const bool isGLES = QOpenGLContext::currentContext()->isOpenGLES();
+	if (!isGLES)
+	{
+		// Always enabled with OpenGL ES
+		glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+		glEnable(GL_POINT_SPRITE);
+	}
+
+	pointSpriteShaderProgram->bind();
+	pointSpriteShaderProgram->setAttributeBuffer(pointSpriteShaderVars.pos, GL_FLOAT, 0, 2, sizeof(PointSource));
+	pointSpriteShaderProgram->enableAttributeArray(pointSpriteShaderVars.pos);
+	pointSpriteShaderProgram->setAttributeBuffer(pointSpriteShaderVars.radius, GL_FLOAT, 8, 1, sizeof(PointSource));
+	pointSpriteShaderProgram->enableAttributeArray(pointSpriteShaderVars.radius);
+	pointSpriteShaderProgram->setAttributeBuffer(pointSpriteShaderVars.color, GL_UNSIGNED_BYTE, 12, 4, sizeof(PointSource));
+	pointSpriteShaderProgram->enableAttributeArray(pointSpriteShaderVars.color);
+	pointSpriteShaderProgram->setUniformValue(pointSpriteShaderVars.projectionMatrix, qMat);
+	pointSpriteShaderProgram->setUniformValue(pointSpriteShaderVars.twinkleSeed, (GLfloat)(qrand()%1000));
+	pointSourceBuffer.release();
+
+	glDrawArrays(GL_POINTS, 0, nbPointSources);
+
+	pointSpriteShaderProgram->disableAttributeArray(pointSpriteShaderVars.pos);
+	pointSpriteShaderProgram->disableAttributeArray(pointSpriteShaderVars.radius);
+	pointSpriteShaderProgram->disableAttributeArray(pointSpriteShaderVars.color);
+	pointSpriteShaderProgram->release();
+
+	if (!isGLES)
+	{
+		glDisable(GL_POINT_SPRITE);
+		glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+	}
+}
+
+void StelSkyDrawer::drawPointQuads(const QMatrix4x4& qMat)
+{
 	Q_ASSERT(sizeof(StarVertex)==12);
-	
+
+	if (vertexArray.size()<nbPointSources*6)
+	{
+		vertexArray.resize(pointSources.size()*6);
+		const int oldSize = textureCoordArray.size();
+		textureCoordArray.resize(pointSources.size()*6*2);
+		static const unsigned char texElems[] = {0, 0, 255, 0, 255, 255, 0, 0, 255, 255, 0, 255};
+		for (int i=oldSize; i<textureCoordArray.size(); i+=12)
+			memcpy(&textureCoordArray[i], texElems, 12);
+	}
+
+	// Expand each source into two triangles, with the twinkling done here
+	StarVertex* vx = vertexArray.data();
+	for (int i=0; i<nbPointSources; ++i)
+	{
+		const PointSource& source = pointSources.at(i);
+		const float radius = source.radius;
+		const Vec2f& win = source.pos;
+		unsigned char starColor[3];
+		if (source.color[3]==0)
+			memcpy(starColor, source.color, 3);
+		else
+		{
+			const float tw = 1.f-source.color[3]/255.f*qrand()/RAND_MAX;
+			starColor[0] = (unsigned char)(source.color[0]*tw+0.5f);
+			starColor[1] = (unsigned char)(source.color[1]*tw+0.5f);
+			starColor[2] = (unsigned char)(source.color[2]*tw+0.5f);
+		}
+		vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+	}
+
 	starShaderProgram->bind();
-	starShaderProgram->setAttributeArray(starShaderVars.pos, GL_FLOAT, (GLfloat*)vertexArray, 2, 12);
+	starShaderProgram->setAttributeArray(starShaderVars.pos, GL_FLOAT, (GLfloat*)vertexArray.constData(), 2, 12);
 	starShaderProgram->enableAttributeArray(starShaderVars.pos);
-	starShaderProgram->setAttributeArray(starShaderVars.color, GL_UNSIGNED_BYTE, (GLubyte*)&(vertexArray[0].color), 3, 12);
+	starShaderProgram->setAttributeArray(starShaderVars.color, GL_UNSIGNED_BYTE, (GLubyte*)&(vertexArray.constData()[0].color), 3, 12);
 	starShaderProgram->enableAttributeArray(starShaderVars.color);
 	starShaderProgram->setUniformValue(starShaderVars.projectionMatrix, qMat);
-	starShaderProgram->setAttributeArray(starShaderVars.texCoord, GL_UNSIGNED_BYTE, (GLubyte*)textureCoordArray, 2, 0);
+	starShaderProgram->setAttributeArray(starShaderVars.texCoord, GL_UNSIGNED_BYTE, (GLubyte*)textureCoordArray.constData(), 2, 0);
 	starShaderProgram->enableAttributeArray(starShaderVars.texCoord);
 	
 	glDrawArrays(GL_TRIANGLES, 0, nbPointSources*6);
@@ -410,8 +553,6 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 	starShaderProgram->disableAttributeArray(starShaderVars.color);
 	starShaderProgram->disableAttributeArray(starShaderVars.texCoord);
 	starShaderProgram->release();
-	
-	nbPointSources = 0;
 }
 
 // Draw a point source halo.
@@ -430,9 +571,18 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	if (!(checkInScreen ? sPainter->getProjector()->projectCheck(v, win) : sPainter->getProjector()->project(v, win)))
 		return false;
 
+	drawProjectedPointSource(sPainter, win, rcMag, color, twinkleFactor);
+	return true;
+}
+
+// Draw a point source halo whose screen position was already computed.
+void StelSkyDrawer::drawProjectedPointSource(StelPainter* sPainter, const Vec3f& win, const RCMag& rcMag, const Vec3f& color, float twinkleFactor)
+{
+	Q_ASSERT(sPainter);
+
 	const float radius = rcMag.radius;
-	// Random coef for star twinkling. twinkleFactor can introduce height-dependent twinkling.
-	const float tw = (flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle)) ? (1.f-twinkleFactor*twinkleAmount*qrand()/RAND_MAX)*rcMag.luminance : rcMag.luminance;
+	// Amount of star twinkling, the random coef is applied when drawing. twinkleFactor can introduce height-dependent twinkling.
+	const float tw = (flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle)) ? qBound(0.f, (float)(twinkleFactor*twinkleAmount), 1.f) : 0.f;
 
 	// If the rmag is big, draw a big halo
 	if (radius>MAX_LINEAR_RADIUS+5.f)
@@ -450,27 +600,19 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 		sPainter->drawSprite2dModeNoDeviceScale(win[0], win[1], rmag);
 	}
 
-	unsigned char starColor[3] = {0, 0, 0};
-	starColor[0] = (unsigned char)std::min((int)(color[0]*tw*255+0.5f), 255);
-	starColor[1] = (unsigned char)std::min((int)(color[1]*tw*255+0.5f), 255);
-	starColor[2] = (unsigned char)std::min((int)(color[2]*tw*255+0.5f), 255);
-	
-	// Store the drawing instructions in the vertex arrays
-	StarVertex* vx = &(vertexArray[nbPointSources*6]);
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-
+	if (nbPointSources>=pointSources.size())
+		pointSources.resize(pointSources.size()*2);
+
+	// Store the drawing instructions in the point source buffer
+	PointSource& source = pointSources[nbPointSources];
+	source.pos.set(win[0], win[1]);
+	source.radius = radius;
+	source.color[0] = (unsigned char)std::min((int)(color[0]*rcMag.luminance*255+0.5f), 255);
+	source.color[1] = (unsigned char)std::min((int)(color[1]*rcMag.luminance*255+0.5f), 255);
+	source.color[2] = (unsigned char)std::min((int)(color[2]*rcMag.luminance*255+0.5f), 255);
+	source.color[3] = (unsigned char)(tw*255+0.5f);
+	maxPointSourceRadius = qMax(maxPointSourceRadius, radius);
 	++nbPointSources;
-	if (nbPointSources>=maxPointSources)
-	{
-		// Flush the buffer (draw all buffered stars)
-		postDrawPointSource(sPainter);
-	}
-	return true;
 }
 
 // Draw's the Sun's corona during a solar eclipse on Earth.
@@ -26,10 +26,13 @@
 #include "VecMath.hpp"
 
 #include <QObject>
+#include <QOpenGLBuffer>
+#include <QVector>
 
 class StelToneReproducer;
 class StelCore;
 class StelPainter;
+class QMatrix4x4;
 
 //! Contains the 2 parameters necessary to draw a star on screen.
 //! the radius and luminance of the star halo texture.
@@ -104,6 +107,22 @@ public:
 
 	bool drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen=false, float twinkleFactor=1.0f);
 
+	//! Draw a point source halo at an already projected screen position.
+	//! This is the second half of drawPointSource(), used when the projection was done
+	//! beforehand, e.g. by worker threads. The caller is responsible for checking that
+	//! rcMag.radius is positive and that the projection succeeded.
+	//! @param sPainter the StelPainter to use for drawing.
+	//! @param win the position of the source in viewport coordinates
+	//! @param rcMag the radius and luminance of the source as computed by computeRCMag()
+	//! @param bV the source B-V index
+	//! @param twinkleFactor allows height-dependent twinkling. Allowed values [0..1]
+	void drawProjectedPointSource(StelPainter* sPainter, const Vec3f& win, const RCMag &rcMag, unsigned int bV, float twinkleFactor=1.0f)
+	{
+		drawProjectedPointSource(sPainter, win, rcMag, colorTable[bV], twinkleFactor);
+	}
+
+	void drawProjectedPointSource(StelPainter* sPainter, const Vec3f& win, const RCMag &rcMag, const Vec3f& bcolor, float twinkleFactor=1.0f);
+
 	void drawSunCorona(StelPainter* painter, const Vec3f& v, float radius, const Vec3f& color, const float alpha);
 
 	//! Terminate drawing of a 3D model, draw the halo
@@ -421,18 +440,36 @@ private:
 	float inScale;
 
 	// Variables used for GL optimization when displaying point sources
-	//! Vertex format for a point source.
+	//! One point source waiting to be drawn. The quad around it is made by the
+	//! point sprite shader, or by postDrawPointSource() when point sprites can't be used.
+	struct PointSource {
+		Vec2f pos;
+		float radius;
+		//! RGB color multiplied by the luminance, the last byte is the twinkle amount.
+		unsigned char color[4];
+	};
+
+	//! Vertex format for a point source drawn as a quad.
 	//! Texture pos is stored in another separately.
 	struct StarVertex {
 		Vec2f pos;
 		unsigned char color[4];
 	};
 	
-	//! Buffer for storing the vertex array data
-	StarVertex* vertexArray;
+	//! Point sources stored since the last postDrawPointSource(). The buffer only grows.
+	QVector<PointSource> pointSources;
+	//! Largest radius in pointSources
+	float maxPointSourceRadius;
 
-	//! Buffer for storing the texture coordinate array data.
-	unsigned char* textureCoordArray;
+	//! GPU copy of pointSources, kept between frames. Its size only grows.
+	QOpenGLBuffer pointSourceBuffer;
+	int pointSourceBufferSize;
+
+	//! Buffer for storing the vertex array data when drawing quads
+	QVector<StarVertex> vertexArray;
+
+	//! Buffer for storing the texture coordinate array data when drawing quads
+	QVector<unsigned char> textureCoordArray;
 	
 	class QOpenGLShaderProgram* starShaderProgram;
 	struct StarShaderVars {
@@ -443,11 +480,30 @@ private:
 		int texture;
 	};
 	StarShaderVars starShaderVars;
+
+	class QOpenGLShaderProgram* pointSpriteShaderProgram;
+	struct PointSpriteShaderVars {
+		int projectionMatrix;
+		int twinkleSeed;
+		int pos;
+		int radius;
+		int color;
+		int texture;
+	};
+	PointSpriteShaderVars pointSpriteShaderVars;
+
+	//! Whether point sources are drawn as point sprites, one vertex per source
+	bool flagPointSprites;
+	//! Largest point size supported by the GL implementation, in pixels
+	float maxPointSize;
 	
 	//! Current number of sources stored in the buffers (still to display)
-	unsigned int nbPointSources;
-	//! Maximum number of sources which can be stored in the buffers
-	unsigned int maxPointSources;
+	int nbPointSources;
+
+	//! Draw the stored point sources with the point sprite shader
+	void drawPointSprites(const QMatrix4x4& qMat);
+	//! Draw the stored point sources as two triangles each
+	void drawPointQuads(const QMatrix4x4& qMat);
 
 	//! The maximum transformed luminance to apply at the next update
 	float maxLum;
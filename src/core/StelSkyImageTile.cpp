@@ -202,6 +202,18 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 				return;
 			}
 		}
+		if (!tex->canBind())
+		{
+			// Load first the tiles covering the largest area of the screen, i.e. the lowest levels
+			double radius = M_PI;
+			if (!skyConvexPolygons.isEmpty())
+			{
+				radius = 0.;
+				foreach (const SphericalRegionP& poly, skyConvexPolygons)
+					radius = qMax(radius, std::acos(qBound(-1., poly->getBoundingCap().d, 1.)));
+			}
+			tex->setLoadPriority(2.*radius*core->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter());
+		}
 
 		// The tile is in screen and has a texture: every test passed :) The tile will be displayed
 		result.insert(minResolution, this);
@@ -37,15 +37,19 @@
 
 #include <cstdlib>
 
-StelTexture::StelTexture(StelTextureMgr *mgr) : textureMgr(mgr), networkReply(NULL), loader(NULL), errorOccured(false), alphaChannel(false), id(0), avgLuminance(-1.f), glSize(0)
+StelTexture::StelTexture(StelTextureMgr *mgr) : textureMgr(mgr), networkReply(NULL), loader(NULL), loadPriority(0.f), lastRequestFrame(0), lastBindFrame(0),
+	loadQueued(false), errorOccured(false), alphaChannel(false), id(0), avgLuminance(-1.f), glSize(0)
 {
 	width = -1;
 	height = -1;
+	textureMgr->addTexture(this);
 }
 
 StelTexture::~StelTexture()
 {
-	if (id != 0 && QOpenGLContext::currentContext())
+	if (textureMgr)
+		textureMgr->removeTexture(this);
+	if (textureMgr && id != 0 && QOpenGLContext::currentContext())
 	{
 		if (glIsTexture(id)==GL_FALSE)
 		{
@@ -123,6 +127,7 @@ bool StelTexture::bind(int slot)
 	if (id != 0)
 	{
 		// The texture is already fully loaded, just bind and return true;
+		lastBindFrame = textureMgr->frame;
 		glActiveTexture(GL_TEXTURE0 + slot);
 		glBindTexture(GL_TEXTURE_2D, id);
 		return true;
@@ -131,7 +136,7 @@ bool StelTexture::bind(int slot)
 		return false;
 
 	// If the file is remote, start a network connection.
-	if (loader == NULL && networkReply == NULL && fullPath.startsWith("http://")) {
+	if (loader == NULL && networkReply == NULL && downloadedData.isEmpty() && fullPath.startsWith("http://")) {
 		QNetworkRequest req = QNetworkRequest(QUrl(fullPath));
 		// Define that preference should be given to cached files (no etag checks)
 		req.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
@@ -143,19 +148,47 @@ bool StelTexture::bind(int slot)
 	// The network connection is still running.
 	if (networkReply != NULL)
 		return false;
-	// Not a remote file, start a loader from local file.
+	// The loader is started by the texture manager, in the order of the priorities.
 	if (loader == NULL)
 	{
-		loader = new QFuture<GLData>(QtConcurrent::run(loadFromPath, fullPath));
+		textureMgr->requestLoad(this);
 		return false;
 	}
-	// Wait until the loader finish.
-	if (!loader->isFinished())
+	// Wait until the loader finish, then load the data in the main thread.
+	if (!finishLoader() || id == 0)
 		return false;
-	// Finally load the data in the main thread.
-	glLoad(loader->result());
+	return bind(slot);
+}
+
+void StelTexture::startLoader()
+{
+	Q_ASSERT(loader == NULL);
+	// Remote files were downloaded first
+	const bool remote = !downloadedData.isEmpty();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+	if (remote)
+		loader = new QFuture<GLData>(QtConcurrent::run(&textureMgr->loaderPool, loadFromData, downloadedData));
+	else
+		loader = new QFuture<GLData>(QtConcurrent::run(&textureMgr->loaderPool, loadFromPath, fullPath));
+#else
+	if (remote)
+		loader = new QFuture<GLData>(QtConcurrent::run(loadFromData, downloadedData));
+	else
+		loader = new QFuture<GLData>(QtConcurrent::run(loadFromPath, fullPath));
+#endif
+	downloadedData.clear();
+	textureMgr->loadingTextures.insert(this);
+}
+
+bool StelTexture::finishLoader()
+{
+	if (loader == NULL || !loader->isFinished())
+		return false;
+	const GLData data = loader->result();
 	delete loader;
 	loader = NULL;
+	textureMgr->loadingTextures.remove(this);
+	glLoad(data);
 	return true;
 }
 
@@ -168,11 +201,11 @@ void StelTexture::onNetworkReply()
 	}
 	else
 	{
-		QByteArray data = networkReply->readAll();
-		if(data.isEmpty()) //prevent starting the loader when there is nothing to load
+		downloadedData = networkReply->readAll();
+		if(downloadedData.isEmpty()) //prevent starting the loader when there is nothing to load
 			reportError(QString("Empty result received for URL: %1").arg(networkReply->url().toString()));
 		else
-			loader = new QFuture<GLData>(QtConcurrent::run(loadFromData, data));
+			textureMgr->requestLoad(this);
 	}
 	networkReply->deleteLater();
 	networkReply = NULL;
@@ -325,6 +358,8 @@ bool StelTexture::glLoad(const GLData& data)
 	//for now, assume full sized 8 bit GL formats used internally
 	glSize = data.data.size();
 	textureMgr->glMemoryUsage += glSize;
+	textureMgr->loadedTextures.insert(this);
+	lastBindFrame = textureMgr->frame;
 
 	#ifndef NDEBUG
 	qDebug()<<"StelTexture"<<id<<"uploaded, total memory usage "<<textureMgr->glMemoryUsage / (1024.0 * 1024.0)<<"MB";
@@ -350,3 +385,14 @@ bool StelTexture::glLoad(const QImage& image)
 {
 	return glLoad(imageToGLData(image));
 }
+
+void StelTexture::glUnload()
+{
+	if (id == 0)
+		return;
+	glDeleteTextures(1, &id);
+	id = 0;
+	textureMgr->glMemoryUsage -= glSize;
+	glSize = 0;
+	textureMgr->loadedTextures.remove(this);
+}
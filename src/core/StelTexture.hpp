@@ -65,11 +65,15 @@ public:
 	virtual ~StelTexture();
 
 	//! Bind the texture so that it can be used for openGL drawing (calls glBindTexture).
-	//! If the texture is lazyly loaded, this starts the loading and return false immediately.
+	//! If the texture is lazyly loaded, this asks the StelTextureMgr to load it and return false immediately.
 	//! @return true if the binding successfully occured, false if the texture is not yet loaded.
 	
 	bool bind(int slot=0);
 
+	//! Set the priority of the loading of the texture, used when many textures are waiting to be loaded.
+	//! @param size the size of the textured object on screen in pixels, the largest objects are loaded first.
+	void setLoadPriority(float size) {loadPriority=size;}
+
 	//! Return whether the texture can be binded, i.e. it is fully loaded
 	bool canBind() const {return id!=0;}
 
@@ -89,7 +93,7 @@ public:
 	const QString& getFullPath() const {return fullPath;}
 
 	//! Return whether the image is currently being loaded
-	bool isLoading() const {return (loader || networkReply) && !canBind();}
+	bool isLoading() const {return (loader || networkReply || loadQueued) && !canBind();}
 
 signals:
 	//! Emitted when the texture is ready to be bind(), i.e. when downloaded, imageLoading and	glLoading is over
@@ -136,6 +140,14 @@ private:
 	bool glLoad(const QImage& image);
 	//! Same as glLoad(QImage), but with an image already in OpenGl format
 	bool glLoad(const GLData& data);
+	//! Delete the openGL texture. The texture is loaded again at the next bind().
+	void glUnload();
+
+	//! Start the loader thread, called by the StelTextureMgr.
+	void startLoader();
+	//! Load the texture in openGL memory if the loader thread is finished.
+	//! @return false if the loader is not finished.
+	bool finishLoader();
 
 	//! The parent texture manager
 	StelTextureMgr* textureMgr;
@@ -148,6 +160,18 @@ private:
 	//! The loader object
 	QFuture<GLData>* loader;
 
+	//! The data received for a remote texture, until the loader starts
+	QByteArray downloadedData;
+
+	//! Loading priority, see setLoadPriority()
+	float loadPriority;
+	//! Frame of the StelTextureMgr when the texture was last requested while not loaded
+	int lastRequestFrame;
+	//! Frame of the StelTextureMgr when the texture was last bound
+	int lastBindFrame;
+	//! True while the texture waits for a loader thread
+	bool loadQueued;
+
 
 	//! The URL where to download the file
 	QString fullPath;	
@@ -22,6 +22,7 @@
 #include "StelFileMgr.hpp"
 #include "StelUtils.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 
 #include <QFileInfo>
 #include <QFile>
@@ -29,17 +30,55 @@
 #include <QNetworkRequest>
 #include <QThread>
 #include <QSettings>
+#include <QVector>
 #include <cstdlib>
+#include <algorithm>
 #include <QOpenGLContext>
 
+// Textures bound during the last frames are never unloaded
+static const int minUnusedFrames = 60;
 
-StelTextureMgr::StelTextureMgr() : glMemoryUsage(0)
+StelTextureMgr::StelTextureMgr()
+	: glMemoryUsage(0)
+	, memoryBudget(0)
+	, frame(0)
+	, nbLoads(0)
+	, nbEvictions(0)
+	, nbShared(0)
 {
 
 }
 
+StelTextureMgr::~StelTextureMgr()
+{
+	// Static textures may be deleted after the manager
+	foreach (StelTexture* tex, textures)
+		tex->textureMgr = NULL;
+}
+
 void StelTextureMgr::init()
 {
+	QSettings* conf = StelApp::getInstance().getSettings();
+	Q_ASSERT(conf);
+	loaderPool.setMaxThreadCount(qMax(conf->value("video/texture_loader_threads", QThread::idealThreadCount()).toInt(), 1));
+	// in MB, 0 for no limit
+	setMemoryBudget(qBound(0, conf->value("video/texture_memory_budget", 0).toInt(), 2047) * 1024 * 1024);
+}
+
+QString StelTextureMgr::getCacheKey(const QString& path, const StelTexture::StelTextureParams& params)
+{
+	return QString("%1|%2|%3|%4|%5").arg(params.generateMipmaps).arg(params.filterMipmaps).arg(params.filtering).arg(params.wrapMode).arg(path);
+}
+
+StelTextureSP StelTextureMgr::findTexture(const QString& key)
+{
+	QHash<QString, QWeakPointer<StelTexture> >::iterator it = textureCache.find(key);
+	if (it==textureCache.end())
+		return StelTextureSP();
+	StelTextureSP tex = it.value().toStrongRef();
+	if (!tex)
+		textureCache.erase(it);
+	return tex;
 }
 
 StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const StelTexture::StelTextureParams& params)
@@ -47,7 +86,16 @@ StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const Stel
 	if (afilename.isEmpty())
 		return StelTextureSP();
 
-	StelTextureSP tex = StelTextureSP(new StelTexture(this));
+	// A texture still being loaded is not shared, this texture must be loaded at once
+	const QString key = getCacheKey(afilename, params);
+	StelTextureSP tex = findTexture(key);
+	if (tex && tex->canBind())
+	{
+		++nbShared;
+		return tex;
+	}
+
+	tex = StelTextureSP(new StelTexture(this));
 	tex->fullPath = afilename;
 
 	QImage image(tex->fullPath);
@@ -56,7 +104,10 @@ StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const Stel
 
 	tex->loadParams = params;
 	if (tex->glLoad(image))
+	{
+		textureCache.insert(key, tex);
 		return tex;
+	}
 	else
 	{
 		qWarning()<<tex->getErrorMessage();
@@ -70,12 +121,126 @@ StelTextureSP StelTextureMgr::createTextureThread(const QString& url, const Stel
 	if (url.isEmpty())
 		return StelTextureSP();
 
-	StelTextureSP tex = StelTextureSP(new StelTexture(this));
-	tex->loadParams = params;
-	tex->fullPath = url;	
+	const QString key = getCacheKey(url, params);
+	StelTextureSP tex = findTexture(key);
+	if (tex)
+		++nbShared;
+	else
+	{
+		tex = StelTextureSP(new StelTexture(this));
+		tex->loadParams = params;
+		tex->fullPath = url;
+		textureCache.insert(key, tex);
+	}
 	if (!lazyLoading)
 	{
 		tex->bind();
 	}
 	return tex;
 }
+
+int StelTextureMgr::getGLMemoryUsage()
+{
+	return glMemoryUsage;
+}
+
+StelTextureMgr::Statistics StelTextureMgr::getStatistics() const
+{
+	Statistics stats;
+	stats.nbTextures = textures.size();
+	stats.nbLoaded = loadedTextures.size();
+	stats.nbPending = pendingLoads.size();
+	stats.nbLoading = loadingTextures.size();
+	stats.glMemoryUsage = glMemoryUsage;
+	stats.memoryBudget = memoryBudget;
+	stats.nbLoads = nbLoads;
+	stats.nbEvictions = nbEvictions;
+	stats.nbShared = nbShared;
+	return stats;
+}
+
+void StelTextureMgr::requestLoad(StelTexture* tex)
+{
+	tex->lastRequestFrame = frame;
+	if (tex->loadQueued)
+		return;
+	tex->loadQueued = true;
+	pendingLoads.append(tex);
+}
+
+void StelTextureMgr::removeTexture(StelTexture* tex)
+{
+	textures.remove(tex);
+	if (tex->loadQueued)
+		pendingLoads.removeOne(tex);
+	loadingTextures.remove(tex);
+	loadedTextures.remove(tex);
+	// The weak pointer of the texture is already null, unless another texture has replaced it
+	const QString key = getCacheKey(tex->fullPath, tex->loadParams);
+	QHash<QString, QWeakPointer<StelTexture> >::iterator it = textureCache.find(key);
+	if (it!=textureCache.end() && it.value().isNull())
+		textureCache.erase(it);
+}
+
+bool StelTextureMgr::loadsBefore(const StelTexture* a, const StelTexture* b)
+{
+	// The textures bound at the last frame are on screen
+	if (a->lastRequestFrame!=b->lastRequestFrame)
+		return a->lastRequestFrame>b->lastRequestFrame;
+	return a->loadPriority>b->loadPriority;
+}
+
+void StelTextureMgr::update()
+{
+	// Upload the textures decoded by the loaders, even if they are not bound anymore, to free their threads
+	foreach (StelTexture* tex, loadingTextures.toList())
+		tex->finishLoader();
+
+	// Start the loads of the most wanted textures, without queuing more than the threads of the pool can decode
+	if (!pendingLoads.isEmpty() && loadingTextures.size()<loaderPool.maxThreadCount())
+	{
+		std::stable_sort(pendingLoads.begin(), pendingLoads.end(), loadsBefore);
+		while (!pendingLoads.isEmpty() && loadingTextures.size()<loaderPool.maxThreadCount())
+		{
+			StelTexture* tex = pendingLoads.takeFirst();
+			tex->loadQueued = false;
+			tex->startLoader();
+			++nbLoads;
+		}
+	}
+
+	if (memoryBudget>0 && glMemoryUsage>memoryBudget)
+	{
+		// Unload the least recently used textures
+		QVector<QPair<int, StelTexture*> > unused;
+		foreach (StelTexture* tex, loadedTextures)
+		{
+			if (frame-tex->lastBindFrame>=minUnusedFrames)
+				unused.append(qMakePair(tex->lastBindFrame, tex));
+		}
+		std::sort(unused.begin(), unused.end());
+		for (int i=0; i<unused.size() && glMemoryUsage>memoryBudget; ++i)
+		{
+			unused.at(i).second->glUnload();
+			++nbEvictions;
+		}
+	}
+
+	// Publish the statistics in the report and the overlay of the profiler
+	StelProfiler* profiler = StelProfiler::getInstance();
+	if (profiler && profiler->getFlagEnabled())
+	{
+		const Statistics stats = getStatistics();
+		profiler->setCounter("textures/alive", stats.nbTextures);
+		profiler->setCounter("textures/loaded", stats.nbLoaded);
+		profiler->setCounter("textures/pending", stats.nbPending);
+		profiler->setCounter("textures/loading", stats.nbLoading);
+		profiler->setCounter("textures/memoryUsage", stats.glMemoryUsage);
+		profiler->setCounter("textures/memoryBudget", stats.memoryBudget);
+		profiler->setCounter("textures/loads", stats.nbLoads);
+		profiler->setCounter("textures/evictions", stats.nbEvictions);
+		profiler->setCounter("textures/shared", stats.nbShared);
+	}
+
+	++frame;
+}
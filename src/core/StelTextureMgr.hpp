@@ -21,7 +21,12 @@
 #define _STELTEXTUREMGR_HPP_
 
 #include "StelTexture.hpp"
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QWeakPointer>
 
 class QNetworkReply;
 class QThread;
@@ -30,9 +35,32 @@ class QThread;
 //! @class StelTextureMgr
 //! Manage textures loading.
 //! It provides method for loading images in a separate thread.
+//! The images of the textures created by createTextureThread() are decoded by a dedicated pool of threads. The textures
+//! waiting for a thread are started at each frame, the ones bound during the last frame first, the largest on screen
+//! first (see StelTexture::setLoadPriority()). The textures which are not drawn anymore are loaded last.
+//! When a GPU memory budget is set, the textures which were not bound for some time are unloaded, the least recently
+//! used first, until the memory usage is within the budget. They are loaded again at the next bind().
+//! Textures created twice from the same path and parameters are shared.
 class StelTextureMgr : QObject
 {
 public:
+	//! Statistics of the texture loading.
+	struct Statistics
+	{
+		int nbTextures;		//!< Number of textures alive
+		int nbLoaded;		//!< Number of textures in GPU memory
+		int nbPending;		//!< Number of textures waiting for a loader thread
+		int nbLoading;		//!< Number of textures being decoded
+		int glMemoryUsage;	//!< Estimated GPU memory usage in bytes
+		int memoryBudget;	//!< GPU memory budget in bytes, 0 if unlimited
+		int nbLoads;		//!< Number of loader threads started
+		int nbEvictions;	//!< Number of textures unloaded to stay within the budget
+		int nbShared;		//!< Number of texture creations which returned an existing texture
+	};
+
+	//! Detach the textures still alive, which can't use the manager anymore.
+	~StelTextureMgr();
+
 	//! Load an image from a file and create a new texture from it
 	//! @param filename the texture file name, can be absolute path if starts with '/' otherwise
 	//!    the file will be looked for in Stellarium's standard textures directories.
@@ -49,6 +77,17 @@ public:
 	//! Returns the estimated memory usage of all textures currently loaded through StelTexture
 	int getGLMemoryUsage();
 
+	//! Get the statistics of the texture loading, for monitoring.
+	Statistics getStatistics() const;
+
+	//! Set the GPU memory budget in bytes. 0 means unlimited.
+	void setMemoryBudget(int bytes) {memoryBudget=qMax(bytes, 0);}
+	int getMemoryBudget() const {return memoryBudget;}
+
+	//! Start the pending loads and unload textures beyond the memory budget.
+	//! Called once per frame by StelApp, with the OpenGL context current.
+	void update();
+
 private:
 	friend class StelTexture;
 	friend class ImageLoader;
@@ -61,7 +100,35 @@ private:
 	//! Must be called after the creation of the GLContext.
 	void init();
 
+	//! Get the key of a texture in textureCache.
+	static QString getCacheKey(const QString& path, const StelTexture::StelTextureParams& params);
+	//! Get a live texture with this key, or a null pointer.
+	StelTextureSP findTexture(const QString& key);
+	//! Whether the load of a should be started before the load of b.
+	static bool loadsBefore(const StelTexture* a, const StelTexture* b);
+
+	//! Called by the constructor of StelTexture.
+	void addTexture(StelTexture* tex) {textures.insert(tex);}
+	//! Called by StelTexture::bind() when the texture needs to be loaded.
+	void requestLoad(StelTexture* tex);
+	//! Called by the destructor of StelTexture.
+	void removeTexture(StelTexture* tex);
+
 	int glMemoryUsage;
+	int memoryBudget;
+	//! Number of frames since the start, see update()
+	int frame;
+
+	QThreadPool loaderPool;
+	QSet<StelTexture*> textures;
+	QList<StelTexture*> pendingLoads;
+	QSet<StelTexture*> loadingTextures;
+	QSet<StelTexture*> loadedTextures;
+	QHash<QString, QWeakPointer<StelTexture> > textureCache;
+
+	int nbLoads;
+	int nbEvictions;
+	int nbShared;
 };
 
 
@@ -156,7 +156,12 @@ void ToastTile::drawTile(StelPainter* sPainter)
 		prepareDraw();
 
 	// Still not ready
-	if (texture.isNull() || !texture->bind())
+	if (texture.isNull())
+		return;
+	// The tiles of the lowest levels cover the largest areas of the screen, load them first
+	if (!texture->canBind())
+		texture->setLoadPriority(sPainter->getProjector()->getPixelPerRadAtCenter()*M_PI/(1<<level));
+	if (!texture->bind())
 		return;
 
 	if(!readyDraw)
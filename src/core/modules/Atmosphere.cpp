@@ -25,10 +25,18 @@
 #include "StelCore.hpp"
 #include "StelPainter.hpp"
 #include "StelFileMgr.hpp"
+#include "StelModuleMgr.hpp"
+#include "SolarSystem.hpp"
+#include "StelProfiler.hpp"
 
 #include <QDebug>
 #include <QSettings>
 #include <QOpenGLShaderProgram>
+#include <QFutureSynchronizer>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 inline bool myisnan(double value)
 {
@@ -48,6 +56,8 @@ Atmosphere::Atmosphere(void)
 	, overrideAverageLuminance(false)
 	, eclipseFactor(1.f)
 	, lightPollutionLuminance(0)
+	, flagParallel(true)
+	, gridParamsValid(false)
 {
 	setFadeDuration(1.5f);
 
@@ -113,9 +123,87 @@ Atmosphere::~Atmosphere(void)
 	atmoShaderProgram = NULL;
 }
 
+//! A range of points of the atmosphere grid, computed by one worker thread.
+struct AtmosphereLuminanceJob
+{
+	const StelProjector* prj;
+	const Skybright* skyb;
+	const Vec2f* posGrid;
+	Vec4f* colorGrid;
+	int begin;
+	int end;
+	Vec3f sunPos;
+	Vec3f moonPos;
+	bool planetsVisible;
+	float eclipseFactor;
+	float lightPollutionLuminance;
+};
+
+static void runAtmosphereLuminanceJob(AtmosphereLuminanceJob* job)
+{
+	// The points are given to Skybright by blocks, the arrays stay in the L1 cache
+	static const int blockSize = 64;
+	float cosDistMoon[blockSize];
+	float cosDistSun[blockSize];
+	float cosDistZenith[blockSize];
+	float lumi[blockSize];
+	Vec3d points[blockSize];
+	const Vec3f& sunPos = job->sunPos;
+	const Vec3f& moon_pos = job->moonPos;
+
+	for (int b=job->begin; b<job->end; b+=blockSize)
+	{
+		const int n = qMin(blockSize, job->end-b);
+		job->prj->unProject(n, job->posGrid+b, points);
+		for (int k=0; k<n; ++k)
+		{
+			Vec3d& point = points[k];
+
+			Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+
+			// Use mirroring for sun only
+			if (point[2]<=0)
+			{
+				point[2] = -point[2];
+				// The sky below the ground is the symmetric of the one above :
+				// it looks nice and gives proper values for brightness estimation
+				cosDistMoon[k] = moon_pos[0]*point[0]+moon_pos[1]*point[1]-moon_pos[2]*point[2];
+			}
+			else
+			{
+				cosDistMoon[k] = moon_pos[0]*point[0]+moon_pos[1]*point[1]+moon_pos[2]*point[2];
+			}
+			cosDistSun[k] = sunPos[0]*point[0]+sunPos[1]*point[1]+sunPos[2]*point[2];
+			cosDistZenith[k] = point[2];
+
+			// Store the back projected position, the luminance is added below.
+			// The xy part of the color component is computed in the openGL shader.
+			job->colorGrid[b+k].set(point[0], point[1], point[2], 0.f);
+		}
+
+		// Use the Skybright.cpp 's models for brightness which gives better results.
+		if (job->planetsVisible)
+			job->skyb->getLuminances(n, cosDistMoon, cosDistSun, cosDistZenith, lumi);
+		else
+			std::fill(lumi, lumi+n, 0.f);
+
+		for (int k=0; k<n; ++k)
+		{
+			float l = lumi[k]*job->eclipseFactor;
+			// Add star background luminance
+			l += 0.0001f;
+			// Add the light pollution luminance AFTER the scaling to avoid scaling it because it is the cause
+			// of the scaling itself
+			l += job->lightPollutionLuminance;
+			job->colorGrid[b+k][3] = l;
+		}
+	}
+}
+
 void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moonPhase,
 							   StelCore* core, float latitude, float altitude, float temperature, float relativeHumidity)
 {
+	StelProfileScope profileScope("Atmosphere::computeColor");
 	const StelProjectorP prj = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
 	if (viewport != prj->getViewport())
 	{
@@ -180,6 +268,7 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 		colorGridBuffer.bind();
 		colorGridBuffer.allocate(colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
 		colorGridBuffer.release();
+		gridParamsValid = false;
 	}
 
 	if (myisnan(_sunPos.length()))
@@ -227,9 +316,40 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	if (!fader.getInterstate())
 	{
 		averageLuminance = 0.001f + lightPollutionLuminance;
+		gridParamsValid = false;
 		return;
 	}
 
+	// Calculate the date from the julian day.
+	int year, month, day;
+	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
+
+	// Nothing to do if the sky and the view didn't change since the last frame,
+	// e.g. when the time is paused or runs slowly.
+	GridParams params;
+	params.sunPos = _sunPos;
+	params.moonPos = moonPos;
+	params.moonPhase = moonPhase;
+	params.year = year;
+	params.month = month;
+	params.latitude = latitude;
+	params.altitude = altitude;
+	params.temperature = temperature;
+	params.relativeHumidity = relativeHumidity;
+	params.eclipseFactor = eclipseFactor;
+	params.lightPollutionLuminance = lightPollutionLuminance;
+	params.planetsVisible = GETSTELMODULE(SolarSystem)->getFlagPlanets();
+	const Vec4i& vp = prj->getViewport();
+	prj->unProject(vp[0], vp[1], params.viewProbes[0]);
+	prj->unProject(vp[0]+vp[2], vp[1], params.viewProbes[1]);
+	prj->unProject(vp[0]+vp[2], vp[1]+vp[3], params.viewProbes[2]);
+	prj->unProject(vp[0], vp[1]+vp[3], params.viewProbes[3]);
+	prj->unProject(vp[0]+0.5*vp[2], vp[1]+0.5*vp[3], params.viewProbes[4]);
+	if (gridParamsValid && sameGridParams(gridParams, params))
+		return;
+	gridParams = params;
+	gridParamsValid = true;
+
 	// Calculate the atmosphere RGB for each point of the grid
 	float sunPos[3];
 	sunPos[0] = _sunPos[0];
@@ -245,63 +365,45 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 
 	skyb.setLocation(latitude * M_PI/180., altitude, temperature, relativeHumidity);
 	skyb.setSunMoon(moon_pos[2], sunPos[2]);
-
-	// Calculate the date from the julian day.
-	int year, month, day;
-	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
 	skyb.setDate(year, month, moonPhase);
 
-	// Variables used to compute the average sky luminance
-	float sum_lum = 0.f;
-
-	Vec3d point(1., 0., 0.);
-	float lumi;
-
-	// Compute the sky color for every point above the ground
-	for (int i=0; i<(1+skyResolutionX)*(1+skyResolutionY); ++i)
+	// Compute the sky color for every point above the ground.
+	// The rows of the grid are split between the threads of the global pool.
+	static const int minPointsPerJob = 512;
+	const int rowSize = 1+skyResolutionX;
+	const int nbRows = 1+skyResolutionY;
+	const int nbJobs = flagParallel ? qMax(1, qMin(rowSize*nbRows/minPointsPerJob, qMin(nbRows, 4*QThreadPool::globalInstance()->maxThreadCount()))) : 1;
+	QVector<AtmosphereLuminanceJob> jobs(nbJobs);
+	for (int j=0; j<nbJobs; ++j)
+	{
+		AtmosphereLuminanceJob& job = jobs[j];
+		job.prj = prj.data();
+		job.skyb = &skyb;
+		job.posGrid = posGrid;
+		job.colorGrid = colorGrid;
+		job.begin = rowSize*(nbRows*j/nbJobs);
+		job.end = rowSize*(nbRows*(j+1)/nbJobs);
+		job.sunPos.set(sunPos[0], sunPos[1], sunPos[2]);
+		job.moonPos.set(moon_pos[0], moon_pos[1], moon_pos[2]);
+		job.planetsVisible = params.planetsVisible;
+		job.eclipseFactor = eclipseFactor;
+		job.lightPollutionLuminance = lightPollutionLuminance;
+	}
+	if (nbJobs==1)
+		runAtmosphereLuminanceJob(&jobs[0]);
+	else
 	{
-		const Vec2f &v(posGrid[i]);
-		prj->unProject(v[0],v[1],point);
+		QFutureSynchronizer<void> synchronizer;
+		for (int j=0; j<nbJobs; ++j)
+			synchronizer.addFuture(QtConcurrent::run(runAtmosphereLuminanceJob, &jobs[j]));
+		synchronizer.waitForFinished();
+	}
 
-		Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+	// Average sky luminance, summed in the grid order so that it doesn't depend on the number of jobs
+	double sum_lum = 0.;
+	for (int i=0; i<rowSize*nbRows; ++i)
+		sum_lum += colorGrid[i][3];
 
-		// Use mirroring for sun only
-		if (point[2]<=0)
-		{
-			point[2] = -point[2];
-			// The sky below the ground is the symmetric of the one above :
-			// it looks nice and gives proper values for brightness estimation
-			// Use the Skybright.cpp 's models for brightness which gives better results.
-			lumi = skyb.getLuminance(moon_pos[0]*point[0]+moon_pos[1]*point[1]-
-					moon_pos[2]*point[2], sunPos[0]*point[0]+sunPos[1]*point[1]+
-					sunPos[2]*point[2], point[2]);
-		}
-		else
-		{
-			// Use the Skybright.cpp 's models for brightness which gives better results.
-			lumi = skyb.getLuminance(moon_pos[0]*point[0]+moon_pos[1]*point[1]+
-					moon_pos[2]*point[2], sunPos[0]*point[0]+sunPos[1]*point[1]+
-					sunPos[2]*point[2], point[2]);
-		}
-		lumi *= eclipseFactor;
-		// Add star background luminance
-		lumi += 0.0001f;
-		// Multiply by the input scale of the ToneConverter (is not done automatically by the xyYtoRGB method called later)
-		//lumi*=eye->getInputScale();
-
-		// Add the light pollution luminance AFTER the scaling to avoid scaling it because it is the cause
-		// of the scaling itself
-		lumi += lightPollutionLuminance;
-
-		// Store for later statistics
-		sum_lum+=lumi;
-
-		// Now need to compute the xy part of the color component
-		// This is done in the openGL shader
-		// Store the back projected position + luminance in the input color to the shader
-		colorGrid[i].set(point[0], point[1], point[2], lumi);
-	}
-	
 	colorGridBuffer.bind();
 	colorGridBuffer.write(0, colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
 	colorGridBuffer.release();
@@ -311,10 +413,36 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 		averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
 }
 
+bool Atmosphere::sameGridParams(const GridParams& a, const GridParams& b)
+{
+	// Changes of the Sun and Moon positions below ~2 arcseconds don't change the sky noticeably.
+	static const double posTolerance = 1e-5;
+	// The grid is fixed on the screen, any move of the view changes the color of its points.
+	static const double viewTolerance = 1e-9;
+
+	if ((a.sunPos-b.sunPos).lengthSquared() > posTolerance*posTolerance ||
+	    (a.moonPos-b.moonPos).lengthSquared() > posTolerance*posTolerance)
+		return false;
+	for (int i=0; i<5; ++i)
+	{
+		if ((a.viewProbes[i]-b.viewProbes[i]).lengthSquared() > viewTolerance*viewTolerance)
+			return false;
+	}
+	return std::fabs(a.moonPhase-b.moonPhase) <= 1e-4f
+		&& a.year==b.year && a.month==b.month
+		&& a.latitude==b.latitude && a.altitude==b.altitude
+		&& a.temperature==b.temperature && a.relativeHumidity==b.relativeHumidity
+		&& a.eclipseFactor==b.eclipseFactor
+		&& a.lightPollutionLuminance==b.lightPollutionLuminance
+		&& a.planetsVisible==b.planetsVisible;
+}
+
 // override computable luminance. This is for special operations only, e.g. for scripting of brightness-balanced image export.
 // To return to auto-computed values, set any negative value.
 void Atmosphere::setAverageLuminance(float overrideLum)
 {
+	// Compute the average luminance again at the next frame
+	gridParamsValid = false;
 	if (overrideLum<0.f)
 	{
 		overrideAverageLuminance=false;
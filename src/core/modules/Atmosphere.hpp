@@ -79,7 +79,29 @@ public:
 	//! Get the light pollution luminance in cd/m^2
 	float getLightPollutionLuminance() const { return lightPollutionLuminance; }
 
+	//! Define whether the luminance grid is computed in several threads
+	void setFlagParallel(bool b) { flagParallel = b; }
+	//! Get whether the luminance grid is computed in several threads
+	bool getFlagParallel() const { return flagParallel; }
+
 private:
+	//! The inputs of the luminance grid. When they didn't change since the last
+	//! call to computeColor(), the grid is kept.
+	struct GridParams
+	{
+		Vec3d sunPos;			// normalized
+		Vec3d moonPos;			// normalized
+		float moonPhase;
+		int year, month;
+		float latitude, altitude, temperature, relativeHumidity;
+		float eclipseFactor;
+		float lightPollutionLuminance;
+		bool planetsVisible;
+		Vec3d viewProbes[5];		// viewport corners and center, in the AltAz frame
+	};
+	//! Return true if the luminance grid computed with a is also valid for b.
+	static bool sameGridParams(const GridParams& a, const GridParams& b);
+
 	Vec4i viewport;
 	Skylight sky;
 	Skybright skyb;
@@ -97,6 +119,10 @@ private:
 	float eclipseFactor;
 	LinearFader fader;
 	float lightPollutionLuminance;
+	bool flagParallel;
+
+	GridParams gridParams;
+	bool gridParamsValid;
 
 	//! Vertex shader used for xyYToRGB computation
 	class QOpenGLShaderProgram* atmoShaderProgram;
@@ -42,13 +42,19 @@
 #define COMET_TAIL_SLICES 16 // segments around the perimeter
 #define COMET_TAIL_STACKS 16 // cuts along the rotational axis
 
-// These are to avoid having index arrays for each comet when all are equal.
-bool Comet::createTailIndices=true;
-bool Comet::createTailTextureCoords=true;
+// The tails of the comets smaller than this on screen [pixels] are not updated nor drawn.
+static const float minTailScreenSize = 2.f;
+
 StelTextureSP Comet::comaTexture;
 StelTextureSP Comet::tailTexture;
+// These are to avoid having vertex and index arrays for each comet when all are equal.
+QVector<double> Comet::comaVertexArr;
+QVector<float> Comet::comaTexCoordArr;
+QVector<Vec3d> Comet::tailUnitVertexArr;
 QVector<float> Comet::tailTexCoordArr; // computed only once for all Comets.
 QVector<unsigned short> Comet::tailIndices; // computed only once for all Comets.
+QList<Comet*> Comet::tailUpdateQueue;
+int Comet::tailUpdatesPerFrame = 10;
 
 Comet::Comet(const QString& englishName,
 	     int flagLighting,
@@ -94,7 +100,8 @@ Comet::Comet(const QString& englishName,
 	  lastJDEtail(0.0),
 	  dustTailWidthFactor(dustTailWidthFact),
 	  dustTailLengthFactor(dustTailLengthFact),
-	  dustTailBrightnessFactor(dustTailBrightnessFact)
+	  dustTailBrightnessFactor(dustTailBrightnessFact),
+	  tailUpdateQueued(false)
 {
 	eclipticPos=Vec3d(0.,0.,0.);
 	rotLocalToParent = Mat4d::identity();
@@ -102,15 +109,18 @@ Comet::Comet(const QString& englishName,
 
 	gastailVertexArr.clear();
 	dusttailVertexArr.clear();
-	comaVertexArr.clear();
 	gastailColorArr.clear();
 	dusttailColorArr.clear();
+	if (tailIndices.isEmpty())
+		computeUnitMeshes();
 
 	//TODO: Name processing?
 }
 
 Comet::~Comet()
 {
+	if (tailUpdateQueued)
+		tailUpdateQueue.removeAll(this);
 }
 
 void Comet::setAbsoluteMagnitudeAndSlope(const double magnitude, const double slope)
@@ -290,18 +300,19 @@ double Comet::getSiderealPeriod() const
 	return period;
 }
 
-float Comet::getVMagnitude(const StelCore* core) const
+float Comet::computeVMagnitude(const Vec3d& observerHelioPos, const Vec3d& planetHelioPos, double JDE,
+			       ApparentMagnitudeAlgorithm algorithm, bool onEarth, double shadowFactor) const
 {
 	//If the two parameter system is not used,
 	//use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(observerHelioPos, planetHelioPos, JDE, algorithm, onEarth, shadowFactor);
 	}
 
 	//Calculate distances
-	const Vec3d& observerHeliocentricPosition = core->getObserverHeliocentricEclipticPos();
-	const Vec3d& cometHeliocentricPosition = getHeliocentricEclipticPos();
+	const Vec3d& observerHeliocentricPosition = observerHelioPos;
+	const Vec3d& cometHeliocentricPosition = planetHelioPos;
 	const double cometSunDistance = cometHeliocentricPosition.length();
 	const double observerCometDistance = (observerHeliocentricPosition - cometHeliocentricPosition).length();
 
@@ -330,78 +341,37 @@ void Comet::update(int deltaTime)
 	if (!orbit->objectDateValid(dateJDE)) return; // don't do anything if out of useful date range. This allows having hundreds of comet elements.
 
 
+	// And also update magnitude and tail brightness/extinction here.
+	const StelProjectorP prj=core->getProjection(core->getAltAzModelViewTransform());
+	const float vMag=getVMagnitude(core);
+
+	// Don't spend time on the tails which are not drawn. Their geometry is updated when they become visible again.
+	if (!isTailDrawn(core, prj, vMag))
+	{
+		tailBright=false;
+		return;
+	}
+
 	//GZ: I think we can make deltaJDtail adaptive, depending on distance to sun! For some reason though, this leads to a crash!
 	//deltaJDtail=StelCore::JD_SECOND * qMax(1.0, qMin(eclipticPos.length(), 20.0));
 
-	if (fabs(lastJDEtail-dateJDE)>deltaJDEtail)
+	// The geometry is not rebuilt here, but by processTailUpdates() within the budget of the next frames.
+	if (!tailUpdateQueued && fabs(lastJDEtail-dateJDE)>deltaJDEtail && orbit->getUpdateTails())
 	{
-		lastJDEtail=dateJDE;
-
-		// The CometOrbit is in fact available in userDataPtr!
-		CometOrbit* orbit=(CometOrbit*)userDataPtr;
-		Q_ASSERT(orbit);
-		if (!orbit->objectDateValid(dateJDE)) return; // out of useful date range. This should allow having hundreds of comet elements.
-
-		if (orbit->getUpdateTails()){
-			// Compute lengths and orientations from orbit object, but only if required.
-			tailFactors=getComaDiameterAndTailLengthAU();
-
-			// Note that we use a diameter larger than what the formula returns. A scale factor of 1.2 is ad-hoc/empirical (GZ), but may look better.
-			computeComa(1.0f*tailFactors[0]); // TBD: APPARENTLY NO SCALING? REMOVE 1.0 and note above.
-
-			tailActive = (tailFactors[1] > tailFactors[0]); // Inhibit tails drawing if too short. Would be nice to include geometric projection angle, but this is too costly.
-
-			if (tailActive)
-			{
-				float gasTailEndRadius=qMax(tailFactors[0], 0.025f*tailFactors[1]) ; // This avoids too slim gas tails for bright comets like Hale-Bopp.
-				float gasparameter=gasTailEndRadius*gasTailEndRadius/(2.0f*tailFactors[1]); // parabola formula: z=r²/2p, so p=r²/2z
-				// The dust tail is thicker and usually shorter. The factors can be configured in the elements.
-				float dustparameter=gasTailEndRadius*gasTailEndRadius*dustTailWidthFactor*dustTailWidthFactor/(2.0f*dustTailLengthFactor*tailFactors[1]);
-
-				// Find valid parameters to create paraboloid vertex arrays: dustTail, gasTail.
-				computeParabola(gasparameter, gasTailEndRadius, -0.5f*gasparameter, gastailVertexArr,  tailTexCoordArr, tailIndices);
-				//gastailColorArr.fill(Vec3f(0.3,0.3,0.3), gastailVertexArr.length());
-				// Now we make a skewed parabola. Skew factor (xOffset, last arg) is rather ad-hoc/empirical. TBD later: Find physically correct solution.
-				computeParabola(dustparameter, dustTailWidthFactor*gasTailEndRadius, -0.5f*dustparameter, dusttailVertexArr, tailTexCoordArr, tailIndices, 25.0f*orbit->getVelocity().length());
-				//dusttailColorArr.fill(Vec3f(0.3,0.3,0.3), dusttailVertexArr.length());
-
-
-				// 2014-08 for 0.13.1 Moved from drawTail() to save lots of computation per frame (There *are* folks downloading all 730 MPC current comet elements...)
-				// Find rotation matrix from 0/0/1 to eclipticPosition: crossproduct for axis (normal vector), dotproduct for angle.
-				Vec3d eclposNrm=eclipticPos; eclposNrm.normalize();
-				gasTailRot=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^(eclposNrm), std::acos(Vec3d(0.0, 0.0, 1.0).dot(eclposNrm)) );
-
-				Vec3d velocity=orbit->getVelocity(); // [AU/d]
-				// This was a try to rotate a straight parabola somewhat away from the antisolar direction.
-				//Mat4d dustTailRot=Mat4d::rotation(eclposNrm^(-velocity), 0.15f*std::acos(eclposNrm.dot(-velocity))); // GZ: This scale factor of 0.15 is empirical from photos of Halley and Hale-Bopp.
-				// The curved tail is curved towards positive X. We first rotate around the Z axis into a direction opposite of the motion vector, then again the antisolar rotation applies.
-				// In addition, we let the dust tail already start with a light tilt.
-				dustTailRot=gasTailRot * Mat4d::zrotation(atan2(velocity[1], velocity[0]) + M_PI) * Mat4d::yrotation(5.0f*velocity.length());
-
-				// Rotate vertex arrays:
-				Vec3d* gasVertices=(Vec3d*) (gastailVertexArr.data());
-				Vec3d* dustVertices=(Vec3d*) (dusttailVertexArr.data());
-				for (int i=0; i<COMET_TAIL_SLICES*COMET_TAIL_STACKS+1; ++i)
-				{
-					gasVertices[i].transfo4d(gasTailRot);
-					dustVertices[i].transfo4d(dustTailRot);
-				}
-			}
-			orbit->setUpdateTails(false); // don't update until position has been recalculated elsewhere
-		}
+		tailUpdateQueued=true;
+		tailUpdateQueue.append(this);
 	}
 
-	// And also update magnitude and tail brightness/extinction here.
 	const bool withAtmosphere=(core->getSkyDrawer()->getFlagHasAtmosphere());
 
 	StelToneReproducer* eye = core->getToneReproducer();
-	float lum = core->getSkyDrawer()->surfacebrightnessToLuminance(getVMagnitude(core)+13.0f); // How to calibrate?
+	float lum = core->getSkyDrawer()->surfacebrightnessToLuminance(vMag+13.0f); // How to calibrate?
 	// Get the luminance scaled between 0 and 1
 	float aLum =eye->adaptLuminanceScaled(lum);
 
 
 	// To make comet more apparent in overviews, take field of view into account:
-	const float fov=core->getProjection(core->getAltAzModelViewTransform())->getFov();
+	const float fov=prj->getFov();
 	if (fov>20)
 		aLum*= (fov/20.0f);
 
@@ -414,6 +384,10 @@ void Comet::update(int deltaTime)
 	} else
 		tailBright=true;
 
+	// The colors are only needed by the tails
+	if (!tailActive)
+		return;
+
 	// Separate factors, but avoid overly bright tails. I limit to about 0.7 for overlapping both tails which should not exceed full-white.
 	float gasMagFactor=qMin(0.9f*aLum, 0.7f);
 	float dustMagFactor=qMin(dustTailBrightnessFactor*aLum, 0.7f);
@@ -467,6 +441,77 @@ void Comet::update(int deltaTime)
 }
 
 
+bool Comet::isTailDrawn(StelCore* core, const StelProjectorP& prj, float vMag)
+{
+	// Same tests as in draw()
+	if (hidden || getEnglishName() == core->getCurrentLocation().planetName)
+		return false;
+	const StelSkyDrawer* drawer=core->getSkyDrawer();
+	if (drawer->getFlagPlanetMagnitudeLimit() && vMag > drawer->getCustomPlanetMagnitudeLimit())
+		return false;
+	if ((vMag-3.0f) > drawer->getLimitMagnitude())
+		return false;
+
+	// The size is computed again because tailFactors is only updated with the geometry
+	const Vec2f factors=getComaDiameterAndTailLengthAU();
+	const double distance=getJ2000EquatorialPos(core).length();
+	return qMax(factors[0], factors[1])/distance*prj->getPixelPerRadAtCenter() >= minTailScreenSize;
+}
+
+void Comet::updateTailGeometry()
+{
+	StelCore* core=StelApp::getInstance().getCore();
+	const double dateJDE=core->getJDE();
+	lastJDEtail=dateJDE;
+
+	// The CometOrbit is in fact available in userDataPtr!
+	CometOrbit* orbit=(CometOrbit*)userDataPtr;
+	Q_ASSERT(orbit);
+	if (!orbit->objectDateValid(dateJDE)) return; // out of useful date range. This should allow having hundreds of comet elements.
+
+	// Compute lengths and orientations from orbit object, but only if required.
+	// The coma is scaled by tailFactors[0] when drawn.
+	tailFactors=getComaDiameterAndTailLengthAU();
+
+	tailActive = (tailFactors[1] > tailFactors[0]); // Inhibit tails drawing if too short. Would be nice to include geometric projection angle, but this is too costly.
+
+	if (tailActive)
+	{
+		float gasTailEndRadius=qMax(tailFactors[0], 0.025f*tailFactors[1]) ; // This avoids too slim gas tails for bright comets like Hale-Bopp.
+		float gasparameter=gasTailEndRadius*gasTailEndRadius/(2.0f*tailFactors[1]); // parabola formula: z=r²/2p, so p=r²/2z
+		// The dust tail is thicker and usually shorter. The factors can be configured in the elements.
+		float dustparameter=gasTailEndRadius*gasTailEndRadius*dustTailWidthFactor*dustTailWidthFactor/(2.0f*dustTailLengthFactor*tailFactors[1]);
+
+		// 2014-08 for 0.13.1 Moved from drawTail() to save lots of computation per frame (There *are* folks downloading all 730 MPC current comet elements...)
+		// Find rotation matrix from 0/0/1 to eclipticPosition: crossproduct for axis (normal vector), dotproduct for angle.
+		Vec3d eclposNrm=eclipticPos; eclposNrm.normalize();
+		gasTailRot=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^(eclposNrm), std::acos(Vec3d(0.0, 0.0, 1.0).dot(eclposNrm)) );
+
+		Vec3d velocity=orbit->getVelocity(); // [AU/d]
+		// This was a try to rotate a straight parabola somewhat away from the antisolar direction.
+		//Mat4d dustTailRot=Mat4d::rotation(eclposNrm^(-velocity), 0.15f*std::acos(eclposNrm.dot(-velocity))); // GZ: This scale factor of 0.15 is empirical from photos of Halley and Hale-Bopp.
+		// The curved tail is curved towards positive X. We first rotate around the Z axis into a direction opposite of the motion vector, then again the antisolar rotation applies.
+		// In addition, we let the dust tail already start with a light tilt.
+		dustTailRot=gasTailRot * Mat4d::zrotation(atan2(velocity[1], velocity[0]) + M_PI) * Mat4d::yrotation(5.0f*velocity.length());
+
+		// Find valid parameters to create paraboloid vertex arrays: dustTail, gasTail.
+		computeParabola(gasparameter, gasTailEndRadius, -0.5f*gasparameter, gasTailRot, gastailVertexArr);
+		// Now we make a skewed parabola. Skew factor (xOffset, last arg) is rather ad-hoc/empirical. TBD later: Find physically correct solution.
+		computeParabola(dustparameter, dustTailWidthFactor*gasTailEndRadius, -0.5f*dustparameter, dustTailRot, dusttailVertexArr, 25.0f*velocity.length());
+	}
+	orbit->setUpdateTails(false); // don't update until position has been recalculated elsewhere
+}
+
+void Comet::processTailUpdates()
+{
+	for (int i=0; i<tailUpdatesPerFrame && !tailUpdateQueue.isEmpty(); ++i)
+	{
+		Comet* comet=tailUpdateQueue.takeFirst();
+		comet->tailUpdateQueued=false;
+		comet->updateTailGeometry();
+	}
+}
+
 // Draw the Comet and all the related infos: name, circle etc... GZ: Taken from Planet.cpp 2013-11-05 and extended
 void Comet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont)
 {
@@ -573,11 +618,15 @@ void Comet::drawTail(StelCore* core, StelProjector::ModelViewTranformP transfo,
 
 void Comet::drawComa(StelCore* core, StelProjector::ModelViewTranformP transfo)
 {
+	if (tailFactors[0]<=0.0f)
+		return; // the size of the coma is not computed yet
+
 	// Find rotation matrix from 0/0/1 to viewdirection! crossproduct for axis (normal vector), dotproduct for angle.
 	Vec3d eclposNrm=eclipticPos - core->getObserverHeliocentricEclipticPos()  ; eclposNrm.normalize();
 	Mat4d comarot=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^(eclposNrm), std::acos(Vec3d(0.0, 0.0, 1.0).dot(eclposNrm)) );
 	StelProjector::ModelViewTranformP transfo2 = transfo->clone();
-	transfo2->combine(comarot);
+	// The unit disk is scaled to the coma radius
+	transfo2->combine(comarot * Mat4d::scaling(0.5*tailFactors[0]));
 	StelPainter* sPainter = new StelPainter(core->getProjection(transfo2));
 
 	glEnable(GL_BLEND);
@@ -613,28 +662,17 @@ Vec2f Comet::getComaDiameterAndTailLengthAU()
 	return Vec2f(D, L);
 }
 
-void Comet::computeComa(const float diameter)
+void Comet::computeUnitMeshes()
 {
-	StelPainter::computeFanDisk(0.5f*diameter, 3, 3, comaVertexArr, comaTexCoordArr);
-}
+	StelPainter::computeFanDisk(1.0f, 3, 3, comaVertexArr, comaTexCoordArr);
 
-//! create parabola shell to represent a tail. Designed for slices=16, stacks=16, but should work with other sizes as well.
-//! (Maybe slices must be an even number.)
-// Parabola equation: z=x²/2p.
-// xOffset for the dust tail, this may introduce a bend. Units are x per sqrt(z).
-void Comet::computeParabola(const float parameter, const float radius, const float zshift,
-			    QVector<Vec3d>& vertexArr, QVector<float>& texCoordArr, QVector<unsigned short> &indices, const float xOffset) {
-
-	// keep the array and replace contents. However, using replace() is only slightly faster.
-	if (vertexArr.length() < ((COMET_TAIL_SLICES*COMET_TAIL_STACKS+1)))
-		vertexArr.resize((COMET_TAIL_SLICES*COMET_TAIL_STACKS+1));
-	if (createTailIndices) indices.clear();
-	if (createTailTextureCoords) texCoordArr.clear();
+	tailUnitVertexArr.clear();
+	tailTexCoordArr.clear();
+	tailIndices.clear();
 	int i;
 	// The parabola has triangular faces with vertices on two circles that are rotated against each other. 
 	float xa[2*COMET_TAIL_SLICES];
 	float ya[2*COMET_TAIL_SLICES];
-	float x, y, z;
 	
 	// fill xa, ya with sin/cosines. TBD: make more efficient with index mirroring etc.
 	float da=M_PI/COMET_TAIL_SLICES; // full circle/2slices
@@ -643,50 +681,66 @@ void Comet::computeParabola(const float parameter, const float radius, const flo
 		ya[i]=cos(i*da);
 	}
 	
-	vertexArr.replace(0, Vec3d(0.0, 0.0, zshift));
-	int vertexArrIndex=1;
-	if (createTailTextureCoords) texCoordArr << 0.5f << 0.5f;
+	// The unit paraboloid is z=x²+y², with an opening of radius 1 at z=1.
+	tailUnitVertexArr << Vec3d(0.0, 0.0, 0.0);
+	tailTexCoordArr << 0.5f << 0.5f;
 	// define the indices lying on circles, starting at 1: odd rings have 1/slices+1/2slices, even-numbered rings straight 1/slices
 	// inner ring#1
 	int ring;
 	for (ring=1; ring<=COMET_TAIL_STACKS; ++ring){
-		z=ring*radius/COMET_TAIL_STACKS; z=z*z/(2*parameter) + zshift;
-		float xShift= xOffset*z*z;
+		const float r=(float)ring/COMET_TAIL_STACKS;
 		for (i=ring & 1; i<2*COMET_TAIL_SLICES; i+=2) { // i.e., ring1 has shifted vertices, ring2 has even ones.
-			x=xa[i]*radius*ring/COMET_TAIL_STACKS;
-			y=ya[i]*radius*ring/COMET_TAIL_STACKS;
-			vertexArr.replace(vertexArrIndex++, Vec3d(x+xShift, y, z));
-			if (createTailTextureCoords) texCoordArr << 0.5+ 0.5*x/radius << 0.5+0.5*y/radius;
+			const float x=xa[i]*r;
+			const float y=ya[i]*r;
+			tailUnitVertexArr << Vec3d(x, y, r*r);
+			tailTexCoordArr << 0.5+ 0.5*x << 0.5+0.5*y;
 		}
 	}
 	// now link the faces with indices.
-	if (createTailIndices)
-	{
-		for (i=1; i<COMET_TAIL_SLICES; ++i) indices << 0 << i << i+1;
-		indices << 0 << COMET_TAIL_SLICES << 1; // close inner fan.
-		// The other slices are a repeating pattern of 2 possibilities. Index @ring always is on the inner ring (slices-agon)
-		for (ring=1; ring<COMET_TAIL_STACKS; ring+=2) { // odd rings
-			const int first=(ring-1)*COMET_TAIL_SLICES+1;
-			for (i=0; i<COMET_TAIL_SLICES-1; ++i){
-				indices << first+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
-				indices << first+i << first+COMET_TAIL_SLICES+1+i << first+1+i;
-			}
-			// closing slice: mesh with other indices...
-			indices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
-			indices << ring*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1 << first;
+	for (i=1; i<COMET_TAIL_SLICES; ++i) tailIndices << 0 << i << i+1;
+	tailIndices << 0 << COMET_TAIL_SLICES << 1; // close inner fan.
+	// The other slices are a repeating pattern of 2 possibilities. Index @ring always is on the inner ring (slices-agon)
+	for (ring=1; ring<COMET_TAIL_STACKS; ring+=2) { // odd rings
+		const int first=(ring-1)*COMET_TAIL_SLICES+1;
+		for (i=0; i<COMET_TAIL_SLICES-1; ++i){
+			tailIndices << first+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
+			tailIndices << first+i << first+COMET_TAIL_SLICES+1+i << first+1+i;
 		}
+		// closing slice: mesh with other indices...
+		tailIndices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
+		tailIndices << ring*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1 << first;
+	}
 
-		for (ring=2; ring<COMET_TAIL_STACKS; ring+=2) { // even rings: different sequence.
-			const int first=(ring-1)*COMET_TAIL_SLICES+1;
-			for (i=0; i<COMET_TAIL_SLICES-1; ++i){
-				indices << first+i << first+COMET_TAIL_SLICES+i << first+1+i;
-				indices << first+1+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
-			}
-			// closing slice: mesh with other indices...
-			indices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << first;
-			indices << first << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
+	for (ring=2; ring<COMET_TAIL_STACKS; ring+=2) { // even rings: different sequence.
+		const int first=(ring-1)*COMET_TAIL_SLICES+1;
+		for (i=0; i<COMET_TAIL_SLICES-1; ++i){
+			tailIndices << first+i << first+COMET_TAIL_SLICES+i << first+1+i;
+			tailIndices << first+1+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
 		}
+		// closing slice: mesh with other indices...
+		tailIndices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << first;
+		tailIndices << first << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
+	}
+}
+
+//! create parabola shell to represent a tail. Designed for slices=16, stacks=16, but should work with other sizes as well.
+//! (Maybe slices must be an even number.)
+// Parabola equation: z=x²/2p.
+// xOffset for the dust tail, this may introduce a bend. Units are x per sqrt(z).
+void Comet::computeParabola(const float parameter, const float radius, const float zshift, const Mat4d& rotation,
+			    QVector<Vec3d>& vertexArr, const float xOffset) {
+
+	// keep the array and replace contents.
+	vertexArr.resize(tailUnitVertexArr.size());
+	const double zscale=radius*radius/(2*parameter);
+	vertexArr[0]=Vec3d(0.0, 0.0, zshift);
+	vertexArr[0].transfo4d(rotation);
+	for (int i=1; i<tailUnitVertexArr.size(); ++i)
+	{
+		const Vec3d& u=tailUnitVertexArr.at(i);
+		const double z=u[2]*zscale + zshift;
+		Vec3d& v=vertexArr[i];
+		v.set(u[0]*radius + xOffset*z*z, u[1]*radius, z);
+		v.transfo4d(rotation);
 	}
-	createTailIndices=false;
-	createTailTextureCoords=false;
 }
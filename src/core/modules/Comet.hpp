@@ -33,6 +33,8 @@
 	2014-01: GZ: Parabolic tails appropriately scaled/rotated. Much is currently empirical, leaving room for physics-based improvements.
 	2014-08: GZ: speedup in case hundreds of comets are loaded.
 	2014-11: GZ: tail extinction, better brightness balance.
+	2016: the tails are scaled from a unit paraboloid shared by all comets. Their geometry is only updated for the comets
+	      which are drawn, within a budget of rebuilds per frame.
   */
 class Comet : public Planet
 {
@@ -76,7 +78,8 @@ public:
 	//was not designed to handle different types of objects.
 	//virtual QString getType() const {return "Comet";}
 	//! \todo Find better sources for the g,k system
-	virtual float getVMagnitude(const StelCore* core) const;
+	virtual float computeVMagnitude(const Vec3d& observerHelioPos, const Vec3d& planetHelioPos, double JDE,
+					ApparentMagnitudeAlgorithm algorithm, bool onEarth, double shadowFactor=1.) const;
 	//! sets the nameI18 property with the appropriate translation.
 	//! Function overriden to handle the problem with name conflicts.
 	virtual void translateName(const StelTranslator& trans);
@@ -109,21 +112,29 @@ private:
 	void drawTail(StelCore* core, StelProjector::ModelViewTranformP transfo, bool gas);
 	void drawComa(StelCore* core, StelProjector::ModelViewTranformP transfo);
 
-	//! compute a coma, faked as simple disk to be tilted towards the observer.
-	//! @param diameter Diameter of Coma [AU]
-	void computeComa(const float diameter);
+	//! compute the meshes shared by all comets: the unit coma disk, and the unit paraboloid with its texture coordinates and indices.
+	static void computeUnitMeshes();
 
-	//! compute tail shape. This is a paraboloid shell with triangular mesh (indexed vertices).
+	//! compute tail shape, by scaling the unit paraboloid. This is a paraboloid shell with triangular mesh (indexed vertices).
 	//! Try to call not for every frame...
-	//! To be more efficient, the arrays are only computed if they are empty.
 	//! @param parameter the parameter p of the parabola. z=r²/2p (r²=x²+y²)
-	//! @param lengthfactor The parabola will be lengthened. This shifts the visible focus, so it must be here.
-	//! @param vertexArr vertex array, collects x0, y0, z0, x1, y1, z1, ...
-	//! @param texCoordArr texture coordinates u0, v0, u1, v1, ...
-	//! @param colorArr vertex colors (if not textured) r0, g0, b0, r1, g1, b1, ...
-	//! @param indices into the former arrays (zero-starting), triplets forming triangles: t0,0, t0,1, t0,2, t1,0, t1,1, t1,2, ...
+	//! @param topradius radius of the open end of the tail.
+	//! @param zshift shift of the apex along the axis. This shifts the visible focus, so it must be here.
+	//! @param rotation rotation applied to the tail after the scaling.
+	//! @param vertexArr vertex array, receives the transformed vertices of the unit paraboloid.
 	//! @param xOffset for the dust tail, this may introduce a bend. Units are x per sqrt(z).
-	void computeParabola(const float parameter, const float topradius, const float zshift, QVector<Vec3d>& vertexArr, QVector<float>& texCoordArr, QVector<unsigned short>& indices, const float xOffset=0.0f);
+	void computeParabola(const float parameter, const float topradius, const float zshift, const Mat4d& rotation, QVector<Vec3d>& vertexArr, const float xOffset=0.0f);
+
+	//! @return true if the tails are drawn: the comet is bright enough, and the coma or the tail is at least a few pixels long.
+	//! @param vMag the visual magnitude of the comet.
+	bool isTailDrawn(StelCore* core, const StelProjectorP& prj, float vMag);
+
+	//! Recompute the coma size and the tail geometry.
+	void updateTailGeometry();
+
+	//! Rebuild the tail geometry of the first comets of the queue, no more than tailUpdatesPerFrame.
+	//! Called by SolarSystem once per frame before the update of the planets.
+	static void processTailUpdates();
 
 	double absoluteMagnitude;
 	double slopeParameter;
@@ -142,19 +153,21 @@ private:
 	float dustTailWidthFactor;      //!< empirical individual broadening of the dust tail end, compared to the gas tail end. Actually, dust tail width=2*comaWidth*dustTailWidthFactor. Default 1.5
 	float dustTailLengthFactor;     //!< empirical individual length of dust tail relative to gas tail. Taken from ssystem.ini, typical value 0.3..0.5, default 0.4
 	float dustTailBrightnessFactor; //!< empirical individual brightness of dust tail relative to gas tail. Taken from ssystem.ini, default 1.5
-	QVector<double> comaVertexArr;
-	QVector<float> comaTexCoordArr; //  --> 2014-08: could also be declared static, but it is filled by StelPainter...
+	bool tailUpdateQueued;		//! true while the comet waits in tailUpdateQueue.
 
-	// These are to avoid having index arrays for each comet when all are equal.
-	static bool createTailIndices;
-	static bool createTailTextureCoords;
+	// The coma is a unit disk, which is scaled by the coma diameter when drawn.
+	static QVector<double> comaVertexArr;
+	static QVector<float> comaTexCoordArr;
 
 	QVector<Vec3d> gastailVertexArr;  // computed frequently, describes parabolic shape (along z axis) of gas tail.
 	QVector<Vec3d> dusttailVertexArr; // computed frequently, describes parabolic shape (along z axis) of dust tail.
 	QVector<Vec3f> gastailColorArr;    // NEW computed for every 5 mins, modulates gas tail brightness for extinction
 	QVector<Vec3f> dusttailColorArr;   // NEW computed for every 5 mins, modulates dust tail brightness for extinction
+	static QVector<Vec3d> tailUnitVertexArr; // unit paraboloid z=x²+y², computed only once for all comets!
 	static QVector<float> tailTexCoordArr; // computed only once for all comets!
 	static QVector<unsigned short> tailIndices; // computed only once for all comets!
+	static QList<Comet*> tailUpdateQueue;  // comets waiting for an update of their tail geometry
+	static int tailUpdatesPerFrame;        // maximum number of tail geometry updates per frame
 	static StelTextureSP comaTexture;
 	static StelTextureSP tailTexture;      // it seems not really necessary to have different textures. gas tail is just painted blue.
 };
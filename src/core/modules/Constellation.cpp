@@ -48,6 +48,7 @@ Constellation::Constellation()
 	, beginSeason(0)
 	, endSeason(0)
 	, asterism(NULL)
+	, artPolygonId(-1)
 {
 }
 
@@ -55,6 +56,8 @@ Constellation::~Constellation()
 {
 	delete[] asterism;
 	asterism = NULL;
+	if (artPolygonId>=0)
+		StelPainter::releaseRetainedArray(artPolygonId);
 }
 
 bool Constellation::read(const QString& record, StarMgr *starMgr)
@@ -171,7 +174,7 @@ void Constellation::drawArtOptim(StelPainter& sPainter, const SphericalRegion& r
 			if (artTexture->bind()==false)
 				return;
 
-			sPainter.drawStelVertexArray(artPolygon);
+			sPainter.drawRetainedArray(artPolygonId);
 		}
 	}
 }
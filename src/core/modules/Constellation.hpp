@@ -170,6 +170,8 @@ private:
 
 	StelTextureSP artTexture;
 	StelVertexArray artPolygon;
+	//! artPolygon registered with StelPainter::retainArray(), or -1
+	int artPolygonId;
 	SphericalCap boundingCap;
 
 	//! Define whether art, lines, names and boundary must be drawn
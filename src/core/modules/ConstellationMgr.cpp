@@ -564,6 +564,9 @@ void ConstellationMgr::loadLinesAndArt(const QString &fileName, const QString &a
 			cons->artPolygon.vertex=contour;
 			cons->artPolygon.texCoords=texCoords;
 			cons->artPolygon.primitiveType=StelVertexArray::Triangles;
+			if (cons->artPolygonId>=0)
+				StelPainter::releaseRetainedArray(cons->artPolygonId);
+			cons->artPolygonId = StelPainter::retainArray(cons->artPolygon);
 
 			Vec3d tmp(X * Vec3d(0.5*texSizeX, 0.5*texSizeY, 0.));
 			tmp.normalize();
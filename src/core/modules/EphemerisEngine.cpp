@@ -0,0 +1,215 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "EphemerisEngine.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelUtils.hpp"
+
+#include <QtConcurrent>
+
+#include <cmath>
+
+//! Dates of a request to compute in a worker thread
+struct EphemerisChunkJob
+{
+	const EphemerisEngine::Request* request;
+	EphemerisEngine::Entry* entries;	// the entries of the whole request
+	int from, to;
+	QAtomicInt* cancelled;
+	QObject* engine;			// notified when the job is done, or NULL
+	int generation;
+};
+
+static void runEphemerisChunkJob(EphemerisChunkJob job)
+{
+	for (int i=job.from; i<job.to; ++i)
+	{
+		if (job.cancelled->load())
+			return;
+		job.entries[i] = EphemerisEngine::computeEntry(*job.request, i);
+	}
+	if (job.engine)
+		QMetaObject::invokeMethod(job.engine, "chunkFinished", Qt::QueuedConnection, Q_ARG(int, job.generation), Q_ARG(int, job.to-job.from));
+}
+
+// Split the dates of a request into jobs for the global thread pool.
+static QList<QFuture<void> > startEphemerisJobs(const EphemerisEngine::Request* request, EphemerisEngine::Entry* entries,
+						 QAtomicInt* cancelled, QObject* engine, int generation)
+{
+	QList<QFuture<void> > jobs;
+	for (int from=0; from<request->count; from+=EphemerisEngine::ChunkSize)
+	{
+		EphemerisChunkJob job = {request, entries, from, qMin(from+EphemerisEngine::ChunkSize, request->count), cancelled, engine, generation};
+		jobs.append(QtConcurrent::run(runEphemerisChunkJob, job));
+	}
+	return jobs;
+}
+
+EphemerisEngine::Request::Request()
+	: rotationPeriod(0.)
+	, referenceJDE(0.)
+	, firstJD(0.)
+	, step(1.)
+	, count(0)
+	, lightTravelTime(false)
+	, algorithm(Planet::UndefinedAlgorithm)
+	, onEarth(false)
+{
+}
+
+EphemerisEngine::Request EphemerisEngine::prepare(const PlanetP& body, double firstJD, double step, int count)
+{
+	const StelCore* core = StelApp::getInstance().getCore();
+	Request r;
+	r.body = body;
+	r.home = core->getCurrentPlanet();
+	r.referenceJDE = core->getJDE();
+	r.observerOffset = core->getObserverHeliocentricEclipticPos() - r.home->getHeliocentricEclipticPos();
+	r.rotationAxis = r.home->getRotEquatorialToVsop87().multiplyWithoutTranslation(Vec3d(0., 0., 1.));
+	r.rotationAxis.normalize();
+	r.rotationPeriod = r.home->getSiderealDay();
+	r.firstJD = firstJD;
+	r.step = step;
+	r.count = qMax(count, 0);
+	r.lightTravelTime = GETSTELMODULE(SolarSystem)->getFlagLightTravelTime();
+	r.algorithm = r.home->getApparentMagnitudeAlgorithm();
+	r.onEarth = core->getCurrentLocation().planetName=="Earth";
+	return r;
+}
+
+EphemerisEngine::Entry EphemerisEngine::computeEntryAt(const Request& request, double JD)
+{
+	static const double lightTimePerAU = AU / (SPEED_OF_LIGHT * 86400);
+	Entry e;
+	e.JD = JD;
+	e.JDE = e.JD + StelApp::getInstance().getCore()->computeDeltaT(e.JD)/86400.;
+
+	// Turn the observer with its planet (Rodrigues' rotation formula)
+	Vec3d offset = request.observerOffset;
+	if (request.rotationPeriod!=0.)
+	{
+		const double angle = 2.*M_PI*(e.JDE-request.referenceJDE)/request.rotationPeriod;
+		const double c = std::cos(angle);
+		const double s = std::sin(angle);
+		const Vec3d& k = request.rotationAxis;
+		offset = offset*c + (k^offset)*s + k*(k.dot(offset)*(1.-c));
+	}
+	e.observerHelioPos = SolarSystem::computeHeliocentricEclipticPos(request.home.data(), e.JDE) + offset;
+
+	e.helioPos = SolarSystem::computeHeliocentricEclipticPos(request.body.data(), e.JDE);
+	if (request.lightTravelTime)
+		e.helioPos = SolarSystem::computeHeliocentricEclipticPos(request.body.data(), e.JDE - (e.helioPos-e.observerHelioPos).length()*lightTimePerAU);
+
+	const Vec3d observerToBody = e.helioPos - e.observerHelioPos;
+	e.j2000Pos = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(observerToBody);
+	e.distance = observerToBody.length();
+	const double observerRq = e.observerHelioPos.lengthSquared();
+	const double bodyRq = e.helioPos.lengthSquared();
+	const double distanceRq = e.distance*e.distance;
+	if (bodyRq>0. && observerRq>0.)
+	{
+		e.phaseAngle = std::acos(qBound(-1., (distanceRq + bodyRq - observerRq)/(2.0*std::sqrt(distanceRq*bodyRq)), 1.));
+		e.elongation = std::acos(qBound(-1., (distanceRq + observerRq - bodyRq)/(2.0*std::sqrt(distanceRq*observerRq)), 1.));
+	}
+	else
+	{
+		// The Sun, or an observer at its center
+		e.phaseAngle = 0.;
+		e.elongation = 0.;
+	}
+	e.magnitude = request.body->computeVMagnitude(e.observerHelioPos, e.helioPos, e.JDE, request.algorithm, request.onEarth);
+	return e;
+}
+
+QVector<EphemerisEngine::Entry> EphemerisEngine::compute(const Request& request)
+{
+	QVector<Entry> result;
+	if (!request.isValid())
+		return result;
+	result.resize(request.count);
+	QAtomicInt cancelled(0);
+	QList<QFuture<void> > jobs = startEphemerisJobs(&request, result.data(), &cancelled, NULL, 0);
+	for (int i=0; i<jobs.size(); ++i)
+		jobs[i].waitForFinished();
+	return result;
+}
+
+EphemerisEngine::EphemerisEngine(QObject* parent)
+	: QObject(parent)
+	, cancelled(0)
+	, generation(0)
+	, nbDone(0)
+	, running(false)
+{
+}
+
+EphemerisEngine::~EphemerisEngine()
+{
+	cancel();
+}
+
+bool EphemerisEngine::start(const Request& r)
+{
+	cancel();
+	if (!r.isValid())
+		return false;
+	request = r;
+	entries.resize(request.count);
+	cancelled.store(0);
+	nbDone = 0;
+	running = true;
+	jobs = startEphemerisJobs(&request, entries.data(), &cancelled, this, generation);
+	return true;
+}
+
+void EphemerisEngine::cancel()
+{
+	if (!running)
+		return;
+	cancelled.store(1);
+	waitForJobs();
+	// The notifications of the cancelled jobs may still be queued
+	++generation;
+	running = false;
+	entries.clear();
+}
+
+void EphemerisEngine::waitForJobs()
+{
+	while (!jobs.isEmpty())
+		jobs.takeFirst().waitForFinished();
+}
+
+void EphemerisEngine::chunkFinished(int gen, int size)
+{
+	if (gen!=generation || !running)
+		return;
+	nbDone += size;
+	emit progress(nbDone, request.count);
+	if (nbDone>=request.count)
+	{
+		waitForJobs();
+		++generation;
+		running = false;
+		emit finished();
+	}
+}
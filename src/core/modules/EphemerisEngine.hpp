@@ -0,0 +1,142 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _EPHEMERISENGINE_HPP_
+#define _EPHEMERISENGINE_HPP_
+
+#include "Planet.hpp"
+#include "VecMath.hpp"
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+//! @class EphemerisEngine
+//! Compute the positions of a solar system body over a range of dates.
+//! Unlike stepping the time of the StelCore, the state of the core and of the solar system is not changed:
+//! the positions of the body and of the observer's planet are computed for each date by the position functions
+//! of the bodies, on worker threads, in chunks of dates.
+//! A Request is first prepared in the main thread, from the current observer and settings. It can then be
+//! computed at once with compute() from any thread, or in the background with start(), which reports the
+//! progress and can be cancelled.
+//! The position of the observer on its planet is the current one, rotated around the axis of the planet
+//! with its sidereal period; the nutation, the aberration and the atmospheric extinction are ignored.
+class EphemerisEngine : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Number of dates computed by a job of the worker threads.
+	static const int ChunkSize = 64;
+
+	//! The position of the body at a date.
+	struct Entry
+	{
+		double JD;		//!< Julian Day (UT)
+		double JDE;		//!< Julian Ephemeris Day
+		Vec3d j2000Pos;		//!< Position in the J2000 equatorial frame, relative to the observer, in AU
+		Vec3d helioPos;		//!< Heliocentric ecliptic position of the body, in AU
+		Vec3d observerHelioPos;	//!< Heliocentric ecliptic position of the observer, in AU
+		double distance;	//!< Distance to the observer, in AU
+		double phaseAngle;	//!< Phase angle, in radians
+		double elongation;	//!< Elongation, in radians
+		float magnitude;	//!< Visual magnitude, without extinction
+	};
+
+	//! What to compute, with a copy of the settings needed by the computation.
+	struct Request
+	{
+		Request();
+		//! Whether the request has a body and at least one date.
+		bool isValid() const {return !body.isNull() && count>0;}
+
+		PlanetP body;
+		PlanetP home;			//!< The planet of the observer
+		Vec3d observerOffset;		//!< Position of the observer relative to the center of its planet at referenceJDE
+		Vec3d rotationAxis;		//!< Rotation axis of the observer's planet, in the heliocentric ecliptic frame
+		double rotationPeriod;		//!< Sidereal period of the observer's planet in days, 0 if unknown
+		double referenceJDE;
+		double firstJD;			//!< First date (UT)
+		double step;			//!< Interval between the dates, in days
+		int count;			//!< Number of dates
+		bool lightTravelTime;		//!< Whether the position is corrected for the light time
+		Planet::ApparentMagnitudeAlgorithm algorithm;
+		bool onEarth;
+	};
+
+	//! Prepare a request for the current observer and settings. Must be called from the main thread.
+	//! @param firstJD the first date (UT)
+	//! @param step the interval between the dates, in days
+	//! @param count the number of dates
+	static Request prepare(const PlanetP& body, double firstJD, double step, int count);
+
+	//! Compute the position of the body at the date i of the request. Can be called from any thread.
+	static Entry computeEntry(const Request& request, int i) {return computeEntryAt(request, request.firstJD + i*request.step);}
+	//! Compute the position of the body of the request at any date (UT). Can be called from any thread.
+	static Entry computeEntryAt(const Request& request, double JD);
+
+	//! Compute all the dates of the request with the global thread pool, and wait for the result.
+	//! Can be called from any thread.
+	static QVector<Entry> compute(const Request& request);
+
+	EphemerisEngine(QObject* parent=NULL);
+	//! Cancel the running computation, if any.
+	~EphemerisEngine();
+
+	//! Start computing a request in the background. The computation running before is cancelled.
+	//! The progress() and finished() signals are emitted in the thread of the engine.
+	//! @return false if the request is not valid.
+	bool start(const Request& request);
+	//! Stop the running computation. The entries already computed are lost, finished() is not emitted.
+	void cancel();
+	bool isRunning() const {return running;}
+
+	//! Get the entries of the last finished computation.
+	const QVector<Entry>& getEntries() const {return entries;}
+	//! Get the request of the last computation started.
+	const Request& getRequest() const {return request;}
+
+signals:
+	//! Emitted when a chunk of dates is computed.
+	void progress(int done, int total);
+	//! Emitted when all the dates of the request are computed.
+	void finished();
+
+private slots:
+	//! Called in the thread of the engine when a job is finished.
+	void chunkFinished(int generation, int size);
+
+private:
+	//! Wait for the jobs still running.
+	void waitForJobs();
+
+	Request request;
+	QVector<Entry> entries;
+	QList<QFuture<void> > jobs;
+	QAtomicInt cancelled;
+	int generation;		// number of computations started, to ignore the late notifications of cancelled ones
+	int nbDone;
+	bool running;
+};
+
+Q_DECLARE_METATYPE(EphemerisEngine::Request)
+
+#endif // _EPHEMERISENGINE_HPP_
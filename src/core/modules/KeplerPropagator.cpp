@@ -0,0 +1,271 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "KeplerPropagator.hpp"
+#include "Orbit.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Same as in Orbit.cpp
+#define GAUSS_GRAV_CONST (0.01720209895*0.01720209895)
+
+const double KeplerPropagator::Tolerance = 1e-9;
+
+// Number of orbits computed together. The temporary arrays of a block stay in the L1 cache.
+static const int BlockSize = 64;
+// The iterations of a block stop when all the corrections are below this, in radians
+static const double AnomalyEpsilon = 1e-12;
+// Same limits as EllipticalOrbit::eccentricAnomaly()
+static const int MaxEllipticIterations = 10;
+static const int MaxHyperbolicIterations = 30;
+
+void KeplerPropagator::Group::append(int index, double t0, double M0, double n, double q, double e, const Vec3d& P, const Vec3d& Q)
+{
+	indices.append(index);
+	this->t0.append(t0);
+	this->M0.append(M0);
+	this->n.append(n);
+	this->e.append(e);
+	if (e<1.0)
+	{
+		// r*cos(nu) = a*(cos(E)-e), r*sin(nu) = a*sqrt(1-e^2)*sin(E)
+		const double A = q/(1.0-e);
+		a.append(A);
+		b.append(A*std::sqrt(1.0-e*e));
+	}
+	else if (e>1.0)
+	{
+		// r*cos(nu) = a*(e-cosh(H)), r*sin(nu) = a*sqrt(e^2-1)*sinh(H)
+		const double A = q/(e-1.0);
+		a.append(A);
+		b.append(A*std::sqrt(e*e-1.0));
+	}
+	else
+	{
+		// r*cos(nu) = q*(1-tan(nu/2)^2), r*sin(nu) = 2*q*tan(nu/2)
+		a.append(q);
+		b.append(2.0*q);
+	}
+	vFactor.append(std::sqrt(GAUSS_GRAV_CONST/(q*(1.0+e))));
+	px.append(P[0]);
+	py.append(P[1]);
+	pz.append(P[2]);
+	qx.append(Q[0]);
+	qy.append(Q[1]);
+	qz.append(Q[2]);
+}
+
+KeplerPropagator::KeplerPropagator()
+	: nbOrbits(0)
+{
+}
+
+// Whether the rotation of an orbit to VSOP87 is the identity, i.e. it's the orbit of a body orbiting the Sun
+static bool isHeliocentric(const double* rotateToVsop87)
+{
+	static const double identity[9] = {1., 0., 0., 0., 1., 0., 0., 0., 1.};
+	for (int i=0; i<9; ++i)
+		if (fabs(rotateToVsop87[i]-identity[i])>1e-15)
+			return false;
+	return true;
+}
+
+int KeplerPropagator::add(const EllipticalOrbit* orbit)
+{
+	// EllipticalOrbit doesn't compute parabolic orbits
+	if (orbit->eccentricity==1.0 || !isHeliocentric(orbit->rotateToVsop87))
+		return -1;
+	return add(orbit->eccentricity<1.0 ? Elliptic : Hyperbolic, orbit->epoch, orbit->meanAnomalyAtEpoch, 2.0*M_PI/orbit->period,
+		   orbit->pericenterDistance, orbit->eccentricity, orbit->inclination, orbit->ascendingNode, orbit->argOfPeriapsis);
+}
+
+int KeplerPropagator::add(const CometOrbit* orbit)
+{
+	if (!isHeliocentric(orbit->rotateToVsop87))
+		return -1;
+	const OrbitType type = orbit->e<1.0 ? Elliptic : (orbit->e>1.0 ? Hyperbolic : Parabolic);
+	return add(type, orbit->t0, 0., orbit->n, orbit->q, orbit->e, orbit->i, orbit->Om, orbit->w);
+}
+
+int KeplerPropagator::add(OrbitType type, double t0, double M0, double n, double q, double e,
+			  double inclination, double ascendingNode, double argOfPericenter)
+{
+	// Same as Init3D() in Orbit.cpp
+	const double cw = cos(argOfPericenter);
+	const double sw = sin(argOfPericenter);
+	const double cOm = cos(ascendingNode);
+	const double sOm = sin(ascendingNode);
+	const double ci = cos(inclination);
+	const double si = sin(inclination);
+	const Vec3d P(-sw*sOm*ci+cw*cOm, sw*cOm*ci+cw*sOm, sw*si);
+	const Vec3d Q(-cw*sOm*ci-sw*cOm, cw*cOm*ci-sw*sOm, cw*si);
+
+	groups[type].append(nbOrbits, t0, M0, n, q, e, P, Q);
+	x.append(0.);
+	y.append(0.);
+	z.append(0.);
+	vx.append(0.);
+	vy.append(0.);
+	vz.append(0.);
+	return nbOrbits++;
+}
+
+void KeplerPropagator::clear()
+{
+	for (int t=0; t<NbOrbitTypes; ++t)
+		groups[t] = Group();
+	nbOrbits = 0;
+	x.clear();
+	y.clear();
+	z.clear();
+	vx.clear();
+	vy.clear();
+	vz.clear();
+}
+
+void KeplerPropagator::compute(double dateJDE, const double* lightTimes, int part, int nbParts)
+{
+	for (int t=0; t<NbOrbitTypes; ++t)
+	{
+		const int size = groups[t].indices.size();
+		computeGroup(OrbitType(t), size*part/nbParts, size*(part+1)/nbParts, dateJDE, lightTimes);
+	}
+}
+
+void KeplerPropagator::computeGroup(OrbitType type, int begin, int end, double dateJDE, const double* lightTimes)
+{
+	const Group& g = groups[type];
+	double* outX = x.data();
+	double* outY = y.data();
+	double* outZ = z.data();
+	double* outVX = vx.data();
+	double* outVY = vy.data();
+	double* outVZ = vz.data();
+	double M[BlockSize], E[BlockSize], rCosNu[BlockSize], rSinNu[BlockSize];
+
+	for (int block=begin; block<end; block+=BlockSize)
+	{
+		const int nb = std::min(BlockSize, end-block);
+		const int* indices = g.indices.constData()+block;
+		const double* t0 = g.t0.constData()+block;
+		const double* M0 = g.M0.constData()+block;
+		const double* n = g.n.constData()+block;
+		const double* e = g.e.constData()+block;
+		const double* a = g.a.constData()+block;
+		const double* b = g.b.constData()+block;
+
+		// Mean anomalies, or W for parabolic orbits
+		if (lightTimes)
+			for (int k=0; k<nb; ++k)
+				M[k] = M0[k] + n[k]*(dateJDE-lightTimes[indices[k]]-t0[k]);
+		else
+			for (int k=0; k<nb; ++k)
+				M[k] = M0[k] + n[k]*(dateJDE-t0[k]);
+
+		if (type==Elliptic)
+		{
+			// Laguerre-Conway iterations, see InitEll() in Orbit.cpp. 1-e*cos(E) is always positive.
+			for (int k=0; k<nb; ++k)
+			{
+				M[k] -= 2.0*M_PI*std::floor(M[k]*(0.5/M_PI)+0.5);
+				E[k] = M[k] + 0.85*e[k]*std::copysign(1.0, std::sin(M[k]));
+			}
+			for (int i=0; i<MaxEllipticIterations; ++i)
+			{
+				double maxCorrection = 0.;
+				for (int k=0; k<nb; ++k)
+				{
+					const double f2 = e[k]*std::sin(E[k]);
+					const double f = E[k]-f2-M[k];
+					const double f1 = 1.0-e[k]*std::cos(E[k]);
+					const double dE = (-5.0*f)/(f1+std::sqrt(std::fabs(16.0*f1*f1-20.0*f*f2)));
+					E[k] += dE;
+					maxCorrection = std::max(maxCorrection, std::fabs(dE));
+				}
+				if (maxCorrection<AnomalyEpsilon)
+					break;
+			}
+			for (int k=0; k<nb; ++k)
+			{
+				rCosNu[k] = a[k]*(std::cos(E[k])-e[k]);
+				rSinNu[k] = b[k]*std::sin(E[k]);
+			}
+		}
+		else if (type==Hyperbolic)
+		{
+			// Laguerre-Conway iterations, see InitHyp() in Orbit.cpp. e*cosh(H)-1 is always positive.
+			for (int k=0; k<nb; ++k)
+				E[k] = std::copysign(std::log(2.0*std::fabs(M[k])/e[k] + 1.85), M[k]);
+			for (int i=0; i<MaxHyperbolicIterations; ++i)
+			{
+				double maxCorrection = 0.;
+				for (int k=0; k<nb; ++k)
+				{
+					const double f2 = e[k]*std::sinh(E[k]);
+					const double f = f2-E[k]-M[k];
+					const double f1 = e[k]*std::cosh(E[k])-1.0;
+					const double dE = (-5.0*f)/(f1+std::sqrt(std::fabs(16.0*f1*f1-20.0*f*f2)));
+					E[k] += dE;
+					maxCorrection = std::max(maxCorrection, std::fabs(dE));
+				}
+				if (maxCorrection<AnomalyEpsilon)
+					break;
+			}
+			for (int k=0; k<nb; ++k)
+			{
+				rCosNu[k] = a[k]*(e[k]-std::cosh(E[k]));
+				rSinNu[k] = b[k]*std::sinh(E[k]);
+			}
+		}
+		else
+		{
+			// Direct solution, see InitPar() in Orbit.cpp
+			for (int k=0; k<nb; ++k)
+			{
+				const double Y = std::cbrt(M[k]+std::sqrt(M[k]*M[k]+1.0));
+				const double tanNu2 = Y-1.0/Y;
+				rCosNu[k] = a[k]*(1.0-tanNu2*tanNu2);
+				rSinNu[k] = b[k]*tanNu2;
+			}
+		}
+
+		// Positions and velocities, see Init3D() in Orbit.cpp
+		const double* px = g.px.constData()+block;
+		const double* py = g.py.constData()+block;
+		const double* pz = g.pz.constData()+block;
+		const double* qx = g.qx.constData()+block;
+		const double* qy = g.qy.constData()+block;
+		const double* qz = g.qz.constData()+block;
+		const double* vFactor = g.vFactor.constData()+block;
+		for (int k=0; k<nb; ++k)
+		{
+			const int i = indices[k];
+			outX[i] = px[k]*rCosNu[k]+qx[k]*rSinNu[k];
+			outY[i] = py[k]*rCosNu[k]+qy[k]*rSinNu[k];
+			outZ[i] = pz[k]*rCosNu[k]+qz[k]*rSinNu[k];
+			const double r = std::sqrt(rCosNu[k]*rCosNu[k]+rSinNu[k]*rSinNu[k]);
+			const double cosNu = rCosNu[k]/r;
+			const double sinNu = rSinNu[k]/r;
+			outVX[i] = vFactor[k]*((e[k]+cosNu)*qx[k]-sinNu*px[k]);
+			outVY[i] = vFactor[k]*((e[k]+cosNu)*qy[k]-sinNu*py[k]);
+			outVZ[i] = vFactor[k]*((e[k]+cosNu)*qz[k]-sinNu*pz[k]);
+		}
+	}
+}
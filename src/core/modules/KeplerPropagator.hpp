@@ -0,0 +1,108 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _KEPLERPROPAGATOR_HPP_
+#define _KEPLERPROPAGATOR_HPP_
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+class EllipticalOrbit;
+class CometOrbit;
+
+//! @class KeplerPropagator
+//! Compute the positions of many heliocentric Kepler orbits at once.
+//! The elements of the orbits are copied into arrays, one per element, grouped by type of orbit (elliptic,
+//! hyperbolic and parabolic), so that each group is computed by the same instructions without branches:
+//! Kepler's equation is solved for blocks of orbits, with a starting value computed without branches and
+//! Laguerre-Conway iterations run on the whole block until all of its orbits have converged. The loops only
+//! contain arithmetic on contiguous arrays, which the compiler can vectorize.
+//! The positions are the ones of EllipticalOrbit::positionAtTimevInVSOP87Coordinates() and
+//! CometOrbit::positionAtTimevInVSOP87Coordinates(), the velocities the ones of CometOrbit::getVelocity().
+//! Only the orbits of the bodies orbiting the Sun are supported, they are not rotated to the VSOP87 frame.
+//! The orbits must not be changed while they are in the propagator.
+class KeplerPropagator
+{
+public:
+	//! The maximum difference with the positions computed by the CometOrbit objects, in AU per AU of distance
+	//! to the Sun. EllipticalOrbit stops the iterations for eccentricities below 0.2 before they have converged,
+	//! the propagator computes these orbits more accurately than EllipticalOrbit.
+	static const double Tolerance;
+
+	KeplerPropagator();
+
+	//! Add an orbit.
+	//! @return its index, or -1 if it is not supported: parabolic EllipticalOrbit or not heliocentric.
+	int add(const EllipticalOrbit* orbit);
+	//! Add an orbit.
+	//! @return its index, or -1 if it is not heliocentric.
+	int add(const CometOrbit* orbit);
+	//! Remove all the orbits.
+	void clear();
+	//! Get the number of orbits.
+	int size() const {return nbOrbits;}
+
+	//! Compute the positions and velocities of the orbits.
+	//! The orbits can be distributed over several threads calling this with different parts.
+	//! @param dateJDE the date
+	//! @param lightTimes if not NULL, the light time correction in days to subtract from the date for each orbit
+	//! @param part, nbParts the part of the orbits to compute, from 0 to nbParts-1.
+	void compute(double dateJDE, const double* lightTimes=NULL, int part=0, int nbParts=1);
+
+	//! Get the position of an orbit last computed, in AU.
+	Vec3d getPosition(int i) const {return Vec3d(x[i], y[i], z[i]);}
+	//! Get the velocity of an orbit last computed, in AU/day.
+	Vec3d getVelocity(int i) const {return Vec3d(vx[i], vy[i], vz[i]);}
+
+private:
+	enum OrbitType
+	{
+		Elliptic,
+		Hyperbolic,
+		Parabolic,
+		NbOrbitTypes
+	};
+
+	//! The elements of the orbits of a type
+	struct Group
+	{
+		void append(int index, double t0, double M0, double n, double q, double e, const Vec3d& P, const Vec3d& Q);
+		QVector<int> indices;	// indices of the orbits
+		QVector<double> t0;	// time of the mean anomaly M0
+		QVector<double> M0;
+		QVector<double> n;	// mean motion, or W/dt for parabolic orbits
+		QVector<double> e;
+		QVector<double> a, b;	// factors of r*cos(nu) and r*sin(nu), see computeGroup()
+		QVector<double> vFactor;	// sqrt(GM/p) of the velocity
+		QVector<double> px, py, pz;	// unit vector towards the pericenter
+		QVector<double> qx, qy, qz;	// unit vector in the plane of the orbit, 90 degrees ahead
+	};
+
+	int add(OrbitType type, double t0, double M0, double n, double q, double e,
+		double inclination, double ascendingNode, double argOfPericenter);
+	void computeGroup(OrbitType type, int begin, int end, double dateJDE, const double* lightTimes);
+
+	Group groups[NbOrbitTypes];
+	int nbOrbits;
+	QVector<double> x, y, z;
+	QVector<double> vx, vy, vz;
+};
+
+#endif // _KEPLERPROPAGATOR_HPP_
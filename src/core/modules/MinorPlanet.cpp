@@ -316,20 +316,19 @@ double MinorPlanet::getSiderealPeriod() const
 	return period;
 }
 
-float MinorPlanet::getVMagnitude(const StelCore* core) const
+float MinorPlanet::computeVMagnitude(const Vec3d& observerHelioPos, const Vec3d& planetHelioPos, double JDE,
+				     ApparentMagnitudeAlgorithm algorithm, bool onEarth, double shadowFactor) const
 {
 	//If the H-G system is not used, use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(observerHelioPos, planetHelioPos, JDE, algorithm, onEarth, shadowFactor);
 	}
 
 	//Calculate phase angle
-	//(Code copied from Planet::getVMagnitude())
+	//(Code copied from Planet::computeVMagnitude())
 	//(this is actually vector subtraction + the cosine theorem :))
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
 	const float observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
 	const float planetRq = planetHelioPos.lengthSquared();
 	const float observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
 	const float cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
@@ -48,6 +48,11 @@
 #include <QStringList>
 #include <QRegExp>
 #include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+#include <cstring>
 
 void NebulaMgr::setLabelsColor(const Vec3f& c) {Nebula::labelColor = c; emit labelsColorChanged(c);}
 const Vec3f NebulaMgr::getLabelsColor(void) const {return Nebula::labelColor;}
@@ -124,6 +129,9 @@ NebulaMgr::NebulaMgr(void)
 	, labelsAmount(0)
 	, flagConverter(false)
 	, flagDecimalCoordinates(true)
+	, flagDSOCatalogCache(true)
+	, designationIndexValid(false)
+	, nameIndexValid(false)
 {
 	setObjectName("NebulaMgr");
 }
@@ -278,6 +286,8 @@ void NebulaMgr::init()
 	flagConverter = conf->value("devel/convert_dso_catalog", false).toBool();
 	flagDecimalCoordinates = conf->value("devel/convert_dso_decimal_coord", true).toBool();
 
+	flagDSOCatalogCache = conf->value("astro/flag_dso_catalog_cache", true).toBool();
+
 	setFlagUseTypeFilters(conf->value("astro/flag_use_type_filter", false).toBool());
 
 	Nebula::CatalogGroup catalogFilters = Nebula::CatalogGroup(0);
@@ -406,9 +416,7 @@ void NebulaMgr::setCatalogFilters(Nebula::CatalogGroup cflags)
 	{
 		Nebula::catalogFilters = cflags;
 
-		dsoArray.clear();
-		dsoIndex.clear();
-		nebGrid.clear();
+		clearDSO();
 		bool status = getFlagShow();
 
 		StelApp::getInstance().getStelObjectMgr().unSelect();
@@ -629,125 +637,88 @@ NebulaP NebulaMgr::searchDSO(unsigned int DSO)
 	return NebulaP();
 }
 
+NebulaP NebulaMgr::searchCatalogIndex(Nebula::CatalogGroupFlags catalog, unsigned int nb) const
+{
+	QHash<int, QHash<unsigned int, NebulaP> >::const_iterator it = catalogIndex.constFind(catalog);
+	if (it==catalogIndex.constEnd())
+		return NebulaP();
+	return it->value(nb);
+}
+
 
 NebulaP NebulaMgr::searchM(unsigned int M)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->M_nb == M)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatM, M);
 }
 
 NebulaP NebulaMgr::searchNGC(unsigned int NGC)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->NGC_nb == NGC)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatNGC, NGC);
 }
 
 NebulaP NebulaMgr::searchIC(unsigned int IC)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->IC_nb == IC)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatIC, IC);
 }
 
 NebulaP NebulaMgr::searchC(unsigned int C)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->C_nb == C)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatC, C);
 }
 
 NebulaP NebulaMgr::searchB(unsigned int B)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->B_nb == B)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatB, B);
 }
 
 NebulaP NebulaMgr::searchSh2(unsigned int Sh2)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->Sh2_nb == Sh2)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatSh2, Sh2);
 }
 
 NebulaP NebulaMgr::searchVdB(unsigned int VdB)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->VdB_nb == VdB)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatVdB, VdB);
 }
 
 NebulaP NebulaMgr::searchRCW(unsigned int RCW)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->RCW_nb == RCW)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatRCW, RCW);
 }
 
 NebulaP NebulaMgr::searchLDN(unsigned int LDN)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->LDN_nb == LDN)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatLDN, LDN);
 }
 
 NebulaP NebulaMgr::searchLBN(unsigned int LBN)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->LBN_nb == LBN)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatLBN, LBN);
 }
 
 NebulaP NebulaMgr::searchCr(unsigned int Cr)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->Cr_nb == Cr)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatCr, Cr);
 }
 
 NebulaP NebulaMgr::searchMel(unsigned int Mel)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->Mel_nb == Mel)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatMel, Mel);
 }
 
 NebulaP NebulaMgr::searchPGC(unsigned int PGC)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->PGC_nb == PGC)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatPGC, PGC);
 }
 
 NebulaP NebulaMgr::searchUGC(unsigned int UGC)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->UGC_nb == UGC)
-			return n;
-	return NebulaP();
+	return searchCatalogIndex(Nebula::CatUGC, UGC);
 }
 
 NebulaP NebulaMgr::searchCed(QString Ced)
 {
-	foreach (const NebulaP& n, dsoArray)
-		if (n->Ced_nb.trimmed().toUpper() == Ced.trimmed().toUpper())
-			return n;
-	return NebulaP();
+	return cedIndex.value(Ced.trimmed().toUpper());
 }
 
 QString NebulaMgr::getLatestSelectedDSODesignation()
@@ -1012,31 +983,319 @@ bool NebulaMgr::loadDSOCatalog(const QString &filename)
 	if (!in.open(QIODevice::ReadOnly))
 		return false;
 
-	// TODO: Let's begin use gzipped data
-	// QDataStream ins(StelUtils::uncompress(in.readAll()));
-	QDataStream ins(&in);
-	ins.setVersion(QDataStream::Qt_5_2);
+	// The cache is checked against the content of the catalog, so that it is
+	// rebuilt when the catalog is updated or converted again.
+	QString cachePath;
+	QByteArray catalogHash;
+	if (flagDSOCatalogCache)
+	{
+		QCryptographicHash hash(QCryptographicHash::Sha1);
+		hash.addData(&in);
+		catalogHash = hash.result();
+		in.seek(0);
+		cachePath = StelFileMgr::getCacheDir() + "/nebulae/" + QFileInfo(filename).dir().dirName() + ".cache";
+	}
 
-	int totalRecords=0;
-	while (!ins.atEnd())
+	QVector<NebulaP> records;
+	if (cachePath.isEmpty() || !loadDSOCatalogCache(cachePath, catalogHash, records))
 	{
-		// Create a new Nebula record
-		NebulaP e = NebulaP(new Nebula);
-		e->readDSO(ins);
+		// TODO: Let's begin use gzipped data
+		// QDataStream ins(StelUtils::uncompress(in.readAll()));
+		QDataStream ins(&in);
+		ins.setVersion(QDataStream::Qt_5_2);
+
+		while (!ins.atEnd())
+		{
+			// Create a new Nebula record
+			NebulaP e = NebulaP(new Nebula);
+			e->readDSO(ins);
+			records.append(e);
+		}
+
+		if (!cachePath.isEmpty())
+			saveDSOCatalogCache(cachePath, catalogHash, records);
+	}
+	in.close();
 
+	int totalRecords=0;
+	foreach (const NebulaP& e, records)
+	{
 		if (!objectInDisplayedCatalog(e)) continue;
 
-		dsoArray.append(e);
-		nebGrid.insert(qSharedPointerCast<StelRegionObject>(e));
-		if (e->DSO_nb!=0)
-			dsoIndex.insert(e->DSO_nb, e);
+		addDSO(e);
 		++totalRecords;
 	}
-	in.close();
 	qDebug() << "Loaded" << totalRecords << "DSO records";
 	return true;
 }
 
+void NebulaMgr::addDSO(const NebulaP& e)
+{
+	designationIndexValid = false;
+	nameIndexValid = false;
+	dsoArray.append(e);
+	nebGrid.insert(qSharedPointerCast<StelRegionObject>(e));
+	if (e->DSO_nb!=0)
+		dsoIndex.insert(e->DSO_nb, e);
+
+	// Keep the first object of the catalog having a given number, like a sequential search would do
+	const unsigned int numbers[] = {e->M_nb, e->NGC_nb, e->IC_nb, e->C_nb, e->B_nb, e->Sh2_nb, e->VdB_nb, e->RCW_nb,
+					e->LDN_nb, e->LBN_nb, e->Cr_nb, e->Mel_nb, e->PGC_nb, e->UGC_nb};
+	static const Nebula::CatalogGroupFlags catalogs[] = {Nebula::CatM, Nebula::CatNGC, Nebula::CatIC, Nebula::CatC,
+							      Nebula::CatB, Nebula::CatSh2, Nebula::CatVdB, Nebula::CatRCW,
+							      Nebula::CatLDN, Nebula::CatLBN, Nebula::CatCr, Nebula::CatMel,
+							      Nebula::CatPGC, Nebula::CatUGC};
+	for (unsigned int i=0; i<sizeof(catalogs)/sizeof(catalogs[0]); ++i)
+	{
+		if (numbers[i]==0)
+			continue;
+		QHash<unsigned int, NebulaP>& index = catalogIndex[catalogs[i]];
+		if (!index.contains(numbers[i]))
+			index.insert(numbers[i], e);
+	}
+	if (!e->Ced_nb.isEmpty())
+	{
+		const QString ced = e->Ced_nb.trimmed().toUpper();
+		if (!cedIndex.contains(ced))
+			cedIndex.insert(ced, e);
+	}
+}
+
+void NebulaMgr::clearDSO()
+{
+	dsoArray.clear();
+	dsoIndex.clear();
+	catalogIndex.clear();
+	cedIndex.clear();
+	nebGrid.clear();
+	designationIndexValid = false;
+	nameIndexValid = false;
+}
+
+void NebulaMgr::updateNameIndexes() const
+{
+	if (!designationIndexValid)
+	{
+		designationIndex.clear();
+		spacedDesignationIndex.clear();
+		static const char* prefixes[] = {"M", "NGC", "IC", "C", "B", "SH2-", "VDB", "RCW",
+						 "LDN", "LBN", "CR", "MEL", "PGC", "UGC"};
+		static const char* spacedPrefixes[] = {"M ", "NGC ", "IC ", "C ", "B ", "SH 2-", "VDB ", "RCW ",
+						       "LDN ", "LBN ", "CR ", "MEL ", "PGC ", "UGC "};
+		foreach (const NebulaP& n, dsoArray)
+		{
+			const unsigned int numbers[] = {n->M_nb, n->NGC_nb, n->IC_nb, n->C_nb, n->B_nb, n->Sh2_nb, n->VdB_nb, n->RCW_nb,
+							n->LDN_nb, n->LBN_nb, n->Cr_nb, n->Mel_nb, n->PGC_nb, n->UGC_nb};
+			for (unsigned int i=0; i<sizeof(numbers)/sizeof(numbers[0]); ++i)
+			{
+				if (numbers[i]==0)
+					continue;
+				designationIndex.insert(QString("%1%2").arg(prefixes[i]).arg(numbers[i]), true);
+				spacedDesignationIndex.insert(QString("%1%2").arg(spacedPrefixes[i]).arg(numbers[i]), true);
+			}
+			if (!n->Ced_nb.isEmpty())
+			{
+				designationIndex.insert(QString("Ced%1").arg(n->Ced_nb.trimmed()), true);
+				spacedDesignationIndex.insert(QString("Ced %1").arg(n->Ced_nb.trimmed()), true);
+			}
+		}
+		designationIndexValid = true;
+	}
+
+	if (!nameIndexValid)
+	{
+		englishNameIndex.clear();
+		i18nNameIndex.clear();
+		foreach (const NebulaP& n, dsoArray)
+		{
+			englishNameIndex.insert(n->englishName);
+			foreach (const QString& name, n->englishAliases)
+				englishNameIndex.insert(name);
+			i18nNameIndex.insert(n->nameI18);
+			foreach (const QString& name, n->nameI18Aliases)
+				i18nNameIndex.insert(name);
+		}
+		nameIndexValid = true;
+	}
+}
+
+// Layout of the binary cache of a catalog: a header, the records, and the
+// strings of all the records as UTF-16 characters. It is read with a memory
+// mapping, so it uses the byte order and the alignment of the machine.
+#define DSO_CACHE_VERSION 1
+static const char dsoCacheMagic[8] = {'S','T','E','L','D','S','O','\0'};
+
+struct DSOCacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrder;		// 0x01020304 written in the machine byte order
+	quint32 recordSize;		// sizeof(DSOCacheRecord), checks the alignment
+	quint32 nbRecords;
+	quint32 nbChars;		// size of the strings table
+	char hash[20];			// SHA-1 of the catalog
+};
+
+struct DSOCacheRecord
+{
+	double XYZ[3];
+	quint32 numbers[15];		// DSO, M, NGC, IC, C, B, Sh2, VdB, RCW, LDN, LBN, Cr, Mel, PGC, UGC
+	qint32 nType;
+	qint32 orientationAngle;
+	float bMag, vMag;
+	float majorAxisSize, minorAxisSize;
+	float oDistance, oDistanceErr;
+	float redshift, redshiftErr;
+	float parallax, parallaxErr;
+	quint32 mTypeOffset, mTypeLength;	// position in the strings table
+	quint32 cedOffset, cedLength;
+	quint32 reserved;
+};
+
+bool NebulaMgr::loadDSOCatalogCache(const QString& cacheFilename, const QByteArray& catalogHash, QVector<NebulaP>& records)
+{
+	QFile file(cacheFilename);
+	if (!file.open(QIODevice::ReadOnly) || file.size()<(qint64)sizeof(DSOCacheHeader))
+		return false;
+	uchar* data = file.map(0, file.size());
+	if (!data)
+		return false;
+
+	const DSOCacheHeader* header = reinterpret_cast<const DSOCacheHeader*>(data);
+	if (memcmp(header->magic, dsoCacheMagic, sizeof(dsoCacheMagic))!=0
+	    || header->version!=DSO_CACHE_VERSION
+	    || header->byteOrder!=0x01020304
+	    || header->recordSize!=sizeof(DSOCacheRecord)
+	    || catalogHash.size()!=(int)sizeof(header->hash)
+	    || memcmp(header->hash, catalogHash.constData(), sizeof(header->hash))!=0
+	    || file.size()!=(qint64)(sizeof(DSOCacheHeader) + header->nbRecords*sizeof(DSOCacheRecord) + header->nbChars*sizeof(QChar)))
+	{
+		qDebug() << "DSO cache" << QDir::toNativeSeparators(cacheFilename) << "is out of date";
+		file.unmap(data);
+		return false;
+	}
+
+	const DSOCacheRecord* rec = reinterpret_cast<const DSOCacheRecord*>(data + sizeof(DSOCacheHeader));
+	const QChar* chars = reinterpret_cast<const QChar*>(rec + header->nbRecords);
+	records.reserve(header->nbRecords);
+	for (unsigned int i=0; i<header->nbRecords; ++i, ++rec)
+	{
+		if (rec->mTypeOffset+rec->mTypeLength>header->nbChars || rec->cedOffset+rec->cedLength>header->nbChars)
+		{
+			qWarning() << "DSO cache" << QDir::toNativeSeparators(cacheFilename) << "is corrupted";
+			records.clear();
+			file.unmap(data);
+			return false;
+		}
+		NebulaP e = NebulaP(new Nebula);
+		e->XYZ.set(rec->XYZ[0], rec->XYZ[1], rec->XYZ[2]);
+		e->DSO_nb = rec->numbers[0];
+		e->M_nb = rec->numbers[1];
+		e->NGC_nb = rec->numbers[2];
+		e->IC_nb = rec->numbers[3];
+		e->C_nb = rec->numbers[4];
+		e->B_nb = rec->numbers[5];
+		e->Sh2_nb = rec->numbers[6];
+		e->VdB_nb = rec->numbers[7];
+		e->RCW_nb = rec->numbers[8];
+		e->LDN_nb = rec->numbers[9];
+		e->LBN_nb = rec->numbers[10];
+		e->Cr_nb = rec->numbers[11];
+		e->Mel_nb = rec->numbers[12];
+		e->PGC_nb = rec->numbers[13];
+		e->UGC_nb = rec->numbers[14];
+		e->nType = (Nebula::NebulaType)rec->nType;
+		e->orientationAngle = rec->orientationAngle;
+		e->bMag = rec->bMag;
+		e->vMag = rec->vMag;
+		e->majorAxisSize = rec->majorAxisSize;
+		e->minorAxisSize = rec->minorAxisSize;
+		e->oDistance = rec->oDistance;
+		e->oDistanceErr = rec->oDistanceErr;
+		e->redshift = rec->redshift;
+		e->redshiftErr = rec->redshiftErr;
+		e->parallax = rec->parallax;
+		e->parallaxErr = rec->parallaxErr;
+		e->mTypeString = QString(chars+rec->mTypeOffset, rec->mTypeLength);
+		e->Ced_nb = QString(chars+rec->cedOffset, rec->cedLength);
+		e->pointRegion = SphericalRegionP(new SphericalPoint(e->XYZ));
+		records.append(e);
+	}
+	file.unmap(data);
+	return true;
+}
+
+void NebulaMgr::saveDSOCatalogCache(const QString& cacheFilename, const QByteArray& catalogHash, const QVector<NebulaP>& records)
+{
+	QVector<DSOCacheRecord> recs(records.size());
+	QString chars;
+	for (int i=0; i<records.size(); ++i)
+	{
+		const Nebula& n = *records.at(i);
+		DSOCacheRecord& rec = recs[i];
+		memset(&rec, 0, sizeof(rec));
+		rec.XYZ[0] = n.XYZ[0];
+		rec.XYZ[1] = n.XYZ[1];
+		rec.XYZ[2] = n.XYZ[2];
+		rec.numbers[0] = n.DSO_nb;
+		rec.numbers[1] = n.M_nb;
+		rec.numbers[2] = n.NGC_nb;
+		rec.numbers[3] = n.IC_nb;
+		rec.numbers[4] = n.C_nb;
+		rec.numbers[5] = n.B_nb;
+		rec.numbers[6] = n.Sh2_nb;
+		rec.numbers[7] = n.VdB_nb;
+		rec.numbers[8] = n.RCW_nb;
+		rec.numbers[9] = n.LDN_nb;
+		rec.numbers[10] = n.LBN_nb;
+		rec.numbers[11] = n.Cr_nb;
+		rec.numbers[12] = n.Mel_nb;
+		rec.numbers[13] = n.PGC_nb;
+		rec.numbers[14] = n.UGC_nb;
+		rec.nType = n.nType;
+		rec.orientationAngle = n.orientationAngle;
+		rec.bMag = n.bMag;
+		rec.vMag = n.vMag;
+		rec.majorAxisSize = n.majorAxisSize;
+		rec.minorAxisSize = n.minorAxisSize;
+		rec.oDistance = n.oDistance;
+		rec.oDistanceErr = n.oDistanceErr;
+		rec.redshift = n.redshift;
+		rec.redshiftErr = n.redshiftErr;
+		rec.parallax = n.parallax;
+		rec.parallaxErr = n.parallaxErr;
+		rec.mTypeOffset = chars.size();
+		rec.mTypeLength = n.mTypeString.size();
+		chars += n.mTypeString;
+		rec.cedOffset = chars.size();
+		rec.cedLength = n.Ced_nb.size();
+		chars += n.Ced_nb;
+	}
+
+	DSOCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, dsoCacheMagic, sizeof(dsoCacheMagic));
+	header.version = DSO_CACHE_VERSION;
+	header.byteOrder = 0x01020304;
+	header.recordSize = sizeof(DSOCacheRecord);
+	header.nbRecords = recs.size();
+	header.nbChars = chars.size();
+	memcpy(header.hash, catalogHash.constData(), qMin((int)sizeof(header.hash), catalogHash.size()));
+
+	QDir().mkpath(QFileInfo(cacheFilename).absolutePath());
+	QSaveFile file(cacheFilename);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "Cannot write DSO cache" << QDir::toNativeSeparators(cacheFilename);
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(recs.constData()), recs.size()*sizeof(DSOCacheRecord));
+	file.write(reinterpret_cast<const char*>(chars.constData()), chars.size()*sizeof(QChar));
+	if (!file.commit())
+		qWarning() << "Cannot write DSO cache" << QDir::toNativeSeparators(cacheFilename);
+}
+
 bool NebulaMgr::objectInDisplayedCatalog(NebulaP n)
 {
 	bool r = false;
@@ -1082,6 +1341,7 @@ bool NebulaMgr::objectInDisplayedCatalog(NebulaP n)
 bool NebulaMgr::loadDSONames(const QString &filename)
 {
 	qDebug() << "Loading DSO name data ...";
+	nameIndexValid = false;
 	QFile dsoNameFile(filename);
 	if (!dsoNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
@@ -1199,6 +1459,7 @@ bool NebulaMgr::loadDSONames(const QString &filename)
 void NebulaMgr::updateSkyCulture(const QString& skyCultureDir)
 {
 	QString namesFile = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/dso_names.fab");
+	nameIndexValid = false;
 
 	foreach (const NebulaP& n, dsoArray)
 		n->removeAllNames();
@@ -1276,6 +1537,7 @@ void NebulaMgr::updateI18n()
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
 	foreach (NebulaP n, dsoArray)
 		n->translateName(trans);
+	nameIndexValid = false;
 }
 
 
@@ -1643,325 +1905,18 @@ QStringList NebulaMgr::listMatchingObjects(const QString& objPrefix, int maxNbIt
 		return result;
 	}
 
-	QString objw = objPrefix.toUpper();
+	updateNameIndexes();
 
-	// Search by Messier objects number (possible formats are "M31" or "M 31")
-	if (objw.size()>=1 && objw.left(1)=="M" && objw.left(3)!="MEL")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->M_nb==0) continue;
-			QString constw = QString("M%1").arg(n->M_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("M %1").arg(n->M_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Melotte objects number (possible formats are "Mel31" or "Mel 31")
-	if (objw.size()>=1 && objw.left(3)=="MEL")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->Mel_nb==0) continue;
-			QString constw = QString("MEL%1").arg(n->Mel_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("MEL %1").arg(n->Mel_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
+	// Search by catalog designations (possible formats are "M31" or "M 31")
+	const StelNameIndex& designations = objPrefix.contains(' ') ? spacedDesignationIndex : designationIndex;
+	result = designations.findPrefix(objPrefix, maxNbItem);
 
-	// Search by IC objects number (possible formats are "IC466" or "IC 466")
-	if (objw.size()>=1 && objw.left(2)=="IC")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->IC_nb==0) continue;
-			QString constw = QString("IC%1").arg(n->IC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("IC %1").arg(n->IC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by NGC numbers (possible formats are "NGC31" or "NGC 31")
-	foreach (const NebulaP& n, dsoArray)
-	{
-		if (n->NGC_nb==0) continue;
-		QString constw = QString("NGC%1").arg(n->NGC_nb);
-		QString constws = constw.mid(0, objw.size());
-		if (constws==objw)
-		{
-			result << constws;
-			continue;
-		}
-		constw = QString("NGC %1").arg(n->NGC_nb);
-		constws = constw.mid(0, objw.size());
-		if (constws==objw)
-			result << constw;
-	}
-
-	// Search by PGC object numbers (possible formats are "PGC31" or "PGC 31")
-	if (objw.size()>=1 && objw.left(3)=="PGC")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->PGC_nb==0) continue;
-			QString constw = QString("PGC%1").arg(n->PGC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;	// Prevent adding both forms for name
-				continue;
-			}
-			constw = QString("PGC %1").arg(n->PGC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by UGC object numbers (possible formats are "UGC31" or "UGC 31")
-	if (objw.size()>=1 && objw.left(3)=="UGC")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->UGC_nb==0) continue;
-			QString constw = QString("UGC%1").arg(n->UGC_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("UGC %1").arg(n->UGC_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Caldwell objects number (possible formats are "C31" or "C 31")
-	if (objw.size()>=1 && objw.left(1)=="C" && objw.left(2)!="CR" && objw.left(2)!="CE")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->C_nb==0) continue;
-			QString constw = QString("C%1").arg(n->C_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("C %1").arg(n->C_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Collinder objects number (possible formats are "Cr31" or "Cr 31")
-	if (objw.size()>=1 && objw.left(2)=="CR")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->Cr_nb==0) continue;
-			QString constw = QString("CR%1").arg(n->Cr_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("CR %1").arg(n->Cr_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Ced objects number (possible formats are "Ced31" or "Ced 31")
-	if (objw.size()>=1 && objw.left(3)=="CED")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->Ced_nb==0) continue;
-			QString constw = QString("Ced%1").arg(n->Ced_nb.trimmed());
-			QString constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw.toUpper())
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("Ced %1").arg(n->Ced_nb.trimmed());
-			constws = constw.mid(0, objw.size());
-			if (constws.toUpper()==objw.toUpper())
-				result << constw;
-		}
-	}
-
-	// Search by Barnard objects number (possible formats are "B31" or "B 31")
-	if (objw.size()>=1 && objw.left(1)=="B")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->B_nb==0) continue;
-			QString constw = QString("B%1").arg(n->B_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("B %1").arg(n->B_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Sharpless objects number (possible formats are "Sh2-31" or "Sh 2-31")
-	if (objw.size()>=1 && objw.left(2)=="SH")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->Sh2_nb==0) continue;
-			QString constw = QString("SH2-%1").arg(n->Sh2_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("SH 2-%1").arg(n->Sh2_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by Van den Bergh objects number (possible formats are "VdB31" or "VdB 31")
-	if (objw.size()>=1 && objw.left(3)=="VDB")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->VdB_nb==0) continue;
-			QString constw = QString("VDB%1").arg(n->VdB_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("VDB %1").arg(n->VdB_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by RCW objects number (possible formats are "RCW31" or "RCW 31")
-	if (objw.size()>=1 && objw.left(3)=="RCW")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->RCW_nb==0) continue;
-			QString constw = QString("RCW%1").arg(n->RCW_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("RCW %1").arg(n->RCW_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by LDN objects number (possible formats are "LDN31" or "LDN 31")
-	if (objw.size()>=1 && objw.left(3)=="LDN")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->LDN_nb==0) continue;
-			QString constw = QString("LDN%1").arg(n->LDN_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("LDN %1").arg(n->LDN_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by LBN objects number (possible formats are "LBN31" or "LBN 31")
-	if (objw.size()>=1 && objw.left(3)=="LBN")
-	{
-		foreach (const NebulaP& n, dsoArray)
-		{
-			if (n->LBN_nb==0) continue;
-			QString constw = QString("LBN%1").arg(n->LBN_nb);
-			QString constws = constw.mid(0, objw.size());
-			if (constws==objw)
-			{
-				result << constws;
-				continue;	// Prevent adding both forms for name
-			}
-			constw = QString("LBN %1").arg(n->LBN_nb);
-			constws = constw.mid(0, objw.size());
-			if (constws==objw)
-				result << constw;
-		}
-	}
-
-	// Search by common names
-	foreach (const NebulaP& n, dsoArray)
-	{
-		QString name = inEnglish ? n->englishName : n->nameI18;
-		if (matchObjectName(name, objPrefix, useStartOfWords))
-		{
-			result.append(name);
-		}
-	}
-
-	// Search by aliases of common names
-	foreach (const NebulaP& n, dsoArray)
-	{
-		QStringList nameList = inEnglish ? n->englishAliases : n->nameI18Aliases;
-		foreach(QString name, nameList)
-		{
-			if (matchObjectName(name, objPrefix, useStartOfWords))
-				result.append(name);
-		}
-	}
+	// Search by common names and their aliases
+	const StelNameIndex& names = inEnglish ? englishNameIndex : i18nNameIndex;
+	if (useStartOfWords)
+		result << names.findPrefix(objPrefix, maxNbItem);
+	else
+		result << names.findSubstring(objPrefix, maxNbItem);
 
 	result.sort();
 	if (result.size() > maxNbItem)
@@ -25,6 +25,7 @@
 #include "StelObjectType.hpp"
 #include "StelFader.hpp"
 #include "StelSphericalIndex.hpp"
+#include "StelNameIndex.hpp"
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Nebula.hpp"
@@ -791,14 +792,46 @@ private:
 	NebulaP searchUGC(unsigned int UGC);
 	NebulaP searchCed(QString Ced);	
 
+	//! Find a DSO by its number in one catalog.
+	//! @param catalog the catalog, one of the Nebula::CatalogGroupFlags values
+	NebulaP searchCatalogIndex(Nebula::CatalogGroupFlags catalog, unsigned int nb) const;
+
 	// Load catalog of DSO
 	bool loadDSOCatalog(const QString& filename);
 	void convertDSOCatalog(const QString& in, const QString& out, bool decimal);
 	// Load proper names for DSO
 	bool loadDSONames(const QString& filename);
 
+	//! Read all the records of a catalog from its binary cache.
+	//! @param cacheFilename the cache file, see loadDSOCatalog()
+	//! @param catalogHash the hash of the content of the catalog
+	//! @return false if the cache doesn't exist or was built from another catalog.
+	bool loadDSOCatalogCache(const QString& cacheFilename, const QByteArray& catalogHash, QVector<NebulaP>& records);
+	//! Write all the records of a catalog in its binary cache.
+	void saveDSOCatalogCache(const QString& cacheFilename, const QByteArray& catalogHash, const QVector<NebulaP>& records);
+
+	//! Add a DSO to the list, the grid and the catalog indexes.
+	void addDSO(const NebulaP& n);
+	//! Remove all the DSO.
+	void clearDSO();
+	//! Build the name indexes used by listMatchingObjects() if the DSO or their names changed.
+	void updateNameIndexes() const;
+
 	QVector<NebulaP> dsoArray;		// The DSO list
 	QHash<unsigned int, NebulaP> dsoIndex;
+	//! The DSO for each catalog number, the key is a Nebula::CatalogGroupFlags value.
+	QHash<int, QHash<unsigned int, NebulaP> > catalogIndex;
+	//! The DSO for each Cederblad designation, in upper case.
+	QHash<QString, NebulaP> cedIndex;
+
+	//! The catalog designations, as "M31", and with a space, as "M 31".
+	mutable StelNameIndex designationIndex;
+	mutable StelNameIndex spacedDesignationIndex;
+	//! The names and aliases in English and in the current language.
+	mutable StelNameIndex englishNameIndex;
+	mutable StelNameIndex i18nNameIndex;
+	mutable bool designationIndexValid;
+	mutable bool nameIndexValid;
 
 	LinearFader hintsFader;
 	LinearFader flagShow;
@@ -819,6 +852,9 @@ private:
 	// For DSO convertor
 	bool flagConverter;
 	bool flagDecimalCoordinates;
+
+	//! Whether the catalog is read from the binary cache
+	bool flagDSOCatalogCache;
 };
 
 #endif // _NEBULAMGR_HPP_
@@ -60,6 +60,8 @@ public:
 	virtual void sample(double, double, int, OrbitSampleProc&) const;
 
 private:
+	friend class KeplerPropagator;
+
 	//! returns eccentric anomaly E for Mean anomaly M
 	double eccentricAnomaly(const double M) const;
 	Vec3d positionAtE(const double E) const;
@@ -98,8 +100,12 @@ public:
 	void setUpdateTails(const bool update){ updateTails=update; }
 	//! return speed value [AU/d] last computed by positionAtTimevInVSOP87Coordinates(JDE, v, true)
 	Vec3d getVelocity() const { return rdot; }
+	//! set the velocity computed for the last position by another implementation, like KeplerPropagator.
+	void setVelocity(const Vec3d& velocity) { rdot=velocity; updateTails=true; }
 	bool objectDateValid(const double JDE) const { return (fabs(t0-JDE)<orbitGood); }
 private:
+	friend class KeplerPropagator;
+
 	const double q;  //! perihel distance
 	const double e;  //! eccentricity
 	const double i;  //! inclination
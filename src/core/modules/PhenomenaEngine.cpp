@@ -0,0 +1,464 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "PhenomenaEngine.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelSphericalIndex.hpp"
+
+#include <QStringList>
+#include <QtConcurrent>
+
+#include <cmath>
+
+// Precision of the dates of the events: one minute
+static const double searchPrecision = 1./1440.;
+
+//! The separation of a pair of objects at any date
+struct PairSeparation
+{
+	const EphemerisEngine::Request* body;
+	const EphemerisEngine::Request* target;	// NULL for a fixed target
+	Vec3d position;				// the fixed target
+	bool opposition;
+	double bodyDistance, targetDistance;	// at the last date computed
+
+	double operator()(double JD)
+	{
+		const EphemerisEngine::Entry b = EphemerisEngine::computeEntryAt(*body, JD);
+		bodyDistance = b.distance;
+		double angle;
+		if (target)
+		{
+			const EphemerisEngine::Entry t = EphemerisEngine::computeEntryAt(*target, JD);
+			targetDistance = t.distance;
+			angle = b.j2000Pos.angle(t.j2000Pos);
+		}
+		else
+		{
+			targetDistance = 0.;
+			angle = b.j2000Pos.angle(position);
+		}
+		return opposition ? M_PI - angle : angle;
+	}
+};
+
+// Find the local minima of the separation of a pair sampled at the given dates, and refine them
+// by a golden section search. The positions of a fixed target have a single element.
+static void searchPairMinima(const PhenomenaEngine::Request& r, int target, bool fixed, bool opposition, const QVector<double>& dates,
+			     const QVector<Vec3d>& bodyPos, const QVector<Vec3d>& targetPos, QVector<PhenomenaEngine::Event>& events)
+{
+	static const double invPhi = 0.5*(std::sqrt(5.)-1.);
+	if (dates.size()<2)
+		return;
+
+	// One more sample before the first date and after the last one, so that the minima
+	// at the first and last dates are bracketed too
+	const int n = dates.size()+2;
+	QVector<double> sampleDates(n);
+	QVector<Vec3d> sampleBodyPos(n), sampleTargetPos(n);
+	sampleDates[0] = 2.*dates.at(0) - dates.at(1);
+	sampleDates[n-1] = 2.*dates.last() - dates.at(n-4);
+	for (int i=1; i<n-1; ++i)
+	{
+		sampleDates[i] = dates.at(i-1);
+		sampleBodyPos[i] = bodyPos.at(i-1);
+		sampleTargetPos[i] = fixed ? targetPos.at(0) : targetPos.at(i-1);
+	}
+	for (int i=0; i<n; i+=n-1)
+	{
+		sampleBodyPos[i] = EphemerisEngine::computeEntryAt(r.body, sampleDates.at(i)).j2000Pos;
+		sampleTargetPos[i] = fixed ? targetPos.at(0) : EphemerisEngine::computeEntryAt(r.planets.at(target), sampleDates.at(i)).j2000Pos;
+	}
+
+	QVector<double> separations(n);
+	QVector<double> motions(n);	// relative angular motion from the previous date
+	for (int i=0; i<n; ++i)
+	{
+		const double angle = sampleBodyPos.at(i).angle(sampleTargetPos.at(i));
+		separations[i] = opposition ? M_PI - angle : angle;
+		motions[i] = i==0 ? 0. : sampleBodyPos.at(i).angle(sampleBodyPos.at(i-1)) + sampleTargetPos.at(i).angle(sampleTargetPos.at(i-1));
+	}
+
+	PairSeparation separation = {&r.body, fixed ? NULL : &r.planets.at(target), fixed ? targetPos.at(0) : Vec3d(0.), opposition, 0., 0.};
+	for (int k=1; k<n-1; ++k)
+	{
+		if (separations.at(k)>separations.at(k-1) || separations.at(k)>=separations.at(k+1))
+			continue;
+		// The separation can't be smaller than this between the neighbouring dates
+		if (separations.at(k) - qMax(motions.at(k), motions.at(k+1)) > r.maxSeparation)
+			continue;
+
+		double a = sampleDates.at(k-1);
+		double b = sampleDates.at(k+1);
+		double c = b - invPhi*(b-a);
+		double d = a + invPhi*(b-a);
+		double fc = separation(c);
+		double fd = separation(d);
+		while (b-a>searchPrecision)
+		{
+			if (fc<fd)
+			{
+				b = d;
+				d = c;
+				fd = fc;
+				c = b - invPhi*(b-a);
+				fc = separation(c);
+			}
+			else
+			{
+				a = c;
+				c = d;
+				fc = fd;
+				d = a + invPhi*(b-a);
+				fd = separation(d);
+			}
+		}
+
+		PhenomenaEngine::Event e;
+		e.target = target;
+		e.fixed = fixed;
+		e.opposition = opposition;
+		e.JD = 0.5*(a+b);
+		e.separation = separation(e.JD);
+		e.bodyDistance = separation.bodyDistance;
+		e.targetDistance = separation.targetDistance;
+		if (e.separation<r.maxSeparation && e.JD>=r.startJD && e.JD<=r.stopJD)
+			events.append(e);
+	}
+}
+
+//! Targets to search in a worker thread
+struct PhenomenaChunkJob
+{
+	const PhenomenaEngine::Request* request;
+	const QVector<EphemerisEngine::Entry>* track;	// the path of the body
+	const int* targets;				// indices of the fixed targets, or NULL for the solar system targets
+	int from, to;
+	QAtomicInt* cancelled;
+	QMutex* mutex;
+	QVector<PhenomenaEngine::Event>* pending;
+	QObject* engine;
+	int generation;
+};
+
+static void runPhenomenaChunkJob(PhenomenaChunkJob job)
+{
+	const PhenomenaEngine::Request& r = *job.request;
+	const QVector<EphemerisEngine::Entry>& track = *job.track;
+	QVector<PhenomenaEngine::Event> events;
+	QVector<double> dates;
+	QVector<Vec3d> bodyPos, targetPos;
+	for (int i=job.from; i<job.to; ++i)
+	{
+		if (job.cancelled->load())
+			return;
+		dates.clear();
+		bodyPos.clear();
+		targetPos.clear();
+		if (job.targets)
+		{
+			// Fixed target: use all the dates of the path
+			for (int j=0; j<track.size(); ++j)
+			{
+				dates.append(track.at(j).JD);
+				bodyPos.append(track.at(j).j2000Pos);
+			}
+			targetPos.append(r.positions.at(job.targets[i]));
+			searchPairMinima(r, job.targets[i], true, false, dates, bodyPos, targetPos, events);
+		}
+		else
+		{
+			// Solar system target: sample the path with the step of the pair
+			const int stride = qMax(1, (int)(r.planetSteps.at(i)/r.body.step + 1e-6));
+			for (int j=0; j<track.size(); j+=stride)
+			{
+				dates.append(track.at(j).JD);
+				bodyPos.append(track.at(j).j2000Pos);
+				targetPos.append(EphemerisEngine::computeEntryAt(r.planets.at(i), track.at(j).JD).j2000Pos);
+			}
+			searchPairMinima(r, i, false, false, dates, bodyPos, targetPos, events);
+			if (r.oppositions)
+				searchPairMinima(r, i, false, true, dates, bodyPos, targetPos, events);
+		}
+	}
+	if (!events.isEmpty())
+	{
+		QMutexLocker locker(job.mutex);
+		*job.pending += events;
+	}
+	QMetaObject::invokeMethod(job.engine, "chunkFinished", Qt::QueuedConnection, Q_ARG(int, job.generation), Q_ARG(int, job.to-job.from));
+}
+
+//! A fixed target in the spatial index
+class PhenomenaTarget : public StelRegionObject
+{
+public:
+	PhenomenaTarget(const Vec3d& p, int i) : region(new SphericalPoint(p)), pos(p), index(i) {}
+	virtual SphericalRegionP getRegion() const {return region;}
+	virtual Vec3d getPointInRegion() const {return pos;}
+	SphericalRegionP region;
+	Vec3d pos;
+	int index;
+};
+
+struct PhenomenaCandidateFunc
+{
+	PhenomenaCandidateFunc(QVector<bool>& f) : flags(f) {}
+	void operator()(const StelRegionObject* obj)
+	{
+		flags[static_cast<const PhenomenaTarget*>(obj)->index] = true;
+	}
+	QVector<bool>& flags;
+};
+
+PhenomenaEngine::Request::Request()
+	: startJD(0.)
+	, stopJD(0.)
+	, maxSeparation(0.)
+	, oppositions(false)
+	, positionStep(1.)
+{
+}
+
+void PhenomenaEngine::Request::addPlanet(const PlanetP& planet)
+{
+	if (planet.isNull() || planet==body.body || planet==body.home)
+		return;
+	planets.append(EphemerisEngine::prepare(planet, startJD, 1., 0));
+	planetSteps.append(getSearchStep(body.body, planet, startJD, stopJD));
+}
+
+void PhenomenaEngine::Request::addPosition(const Vec3d& j2000Pos)
+{
+	Vec3d pos = j2000Pos;
+	pos.normalize();
+	positions.append(pos);
+}
+
+PhenomenaEngine::Request PhenomenaEngine::prepare(const PlanetP& body, double startJD, double stopJD, double maxSeparation, bool oppositions)
+{
+	Request r;
+	r.body = EphemerisEngine::prepare(body, startJD, 1., 0);
+	r.startJD = startJD;
+	r.stopJD = stopJD;
+	r.maxSeparation = maxSeparation;
+	r.oppositions = oppositions;
+	r.positionStep = getSearchStep(body, PlanetP(), startJD, stopJD);
+	return r;
+}
+
+double PhenomenaEngine::getSearchStep(const PlanetP& body, const PlanetP& target, double startJD, double stopJD)
+{
+	QStringList names;
+	names << body->getEnglishName();
+	if (target)
+		names << target->getEnglishName();
+	// The fixed targets are sampled twice as often, their separation has sharper minima
+	const double scale = target ? 1. : 0.5;
+
+	double step = (stopJD - startJD)/(target ? 12. : 8.);
+	step = qMin(step, 24.8*365.25);
+	if (names.contains("Neptune") || names.contains("Uranus"))
+		step = qMin(step, 3652.5*scale);
+	if (names.contains("Jupiter") || names.contains("Saturn"))
+		step = qMin(step, 365.25*scale);
+	if (names.contains("Mars"))
+		step = qMin(step, 10.*scale);
+	if (names.contains("Venus") || names.contains("Mercury"))
+		step = qMin(step, 5.*scale);
+	if (names.contains("Moon"))
+		step = qMin(step, 0.25);
+	return qMax(step, searchPrecision);
+}
+
+PhenomenaEngine::PhenomenaEngine(QObject* parent)
+	: QObject(parent)
+	, trackEngine(new EphemerisEngine(this))
+	, cancelled(0)
+	, generation(0)
+	, nbDone(0)
+	, running(false)
+{
+	connect(trackEngine, SIGNAL(progress(int,int)), this, SLOT(trackProgress(int,int)));
+	connect(trackEngine, SIGNAL(finished()), this, SLOT(searchTargets()));
+}
+
+PhenomenaEngine::~PhenomenaEngine()
+{
+	cancel();
+}
+
+bool PhenomenaEngine::start(const Request& r)
+{
+	cancel();
+	if (!r.isValid())
+		return false;
+	request = r;
+
+	// The path of the body is sampled with the smallest step of all the pairs
+	double step = request.positions.isEmpty() ? request.stopJD - request.startJD : request.positionStep;
+	for (int i=0; i<request.planetSteps.size(); ++i)
+		step = qMin(step, request.planetSteps.at(i));
+	request.body.firstJD = request.startJD;
+	request.body.step = step;
+	request.body.count = (int)std::ceil((request.stopJD - request.startJD)/step) + 1;
+
+	events.clear();
+	pendingEvents.clear();
+	track.clear();
+	candidates.clear();
+	nbDone = 0;
+	cancelled.store(0);
+	running = true;
+	trackEngine->start(request.body);
+	return true;
+}
+
+void PhenomenaEngine::cancel()
+{
+	if (!running)
+		return;
+	cancelled.store(1);
+	trackEngine->cancel();
+	waitForJobs();
+	// The notifications of the cancelled jobs may still be queued
+	++generation;
+	running = false;
+	pendingEvents.clear();
+}
+
+void PhenomenaEngine::waitForJobs()
+{
+	while (!jobs.isEmpty())
+		jobs.takeFirst().waitForFinished();
+}
+
+void PhenomenaEngine::trackProgress(int done, int)
+{
+	if (running)
+		emit progress(done, getTotal());
+}
+
+QVector<int> PhenomenaEngine::findCandidatePositions() const
+{
+	static const int GroupSize = 16;
+	QVector<bool> flags(request.positions.size(), false);
+	StelSphericalIndex index;
+	for (int i=0; i<request.positions.size(); ++i)
+		index.insert(StelRegionObjectP(new PhenomenaTarget(request.positions.at(i), i)));
+
+	// Look for the targets close to each part of the path
+	PhenomenaCandidateFunc func(flags);
+	for (int first=0; first<track.size()-1; first+=GroupSize)
+	{
+		const int last = qMin(first+GroupSize, track.size()-1);
+		Vec3d center(0.);
+		for (int j=first; j<=last; ++j)
+		{
+			Vec3d v = track.at(j).j2000Pos;
+			v.normalize();
+			center += v;
+		}
+		double radius = M_PI;
+		if (center.lengthSquared()>1e-6)
+		{
+			center.normalize();
+			radius = 0.;
+			for (int j=first; j<=last; ++j)
+			{
+				double r = center.angle(track.at(j).j2000Pos);
+				// Between two dates the path may go away by half the motion between them
+				if (j>first)
+					r += 0.5*track.at(j).j2000Pos.angle(track.at(j-1).j2000Pos);
+				radius = qMax(radius, r);
+			}
+			radius += request.maxSeparation;
+		}
+		if (radius>=M_PI)
+		{
+			flags.fill(true);
+			break;
+		}
+		index.processBoundingCapIntersectingRegions(SphericalCap(center, std::cos(radius)), func);
+	}
+
+	QVector<int> result;
+	for (int i=0; i<flags.size(); ++i)
+	{
+		if (flags.at(i))
+			result.append(i);
+	}
+	return result;
+}
+
+void PhenomenaEngine::searchTargets()
+{
+	if (!running)
+		return;
+	track = trackEngine->getEntries();
+	nbDone = track.size();
+	candidates = findCandidatePositions();
+	nbDone += request.positions.size() - candidates.size();
+	emit progress(nbDone, getTotal());
+
+	for (int from=0; from<request.planets.size(); from+=PlanetChunkSize)
+	{
+		PhenomenaChunkJob job = {&request, &track, NULL, from, qMin(from+PlanetChunkSize, request.planets.size()),
+					 &cancelled, &pendingMutex, &pendingEvents, this, generation};
+		jobs.append(QtConcurrent::run(runPhenomenaChunkJob, job));
+	}
+	for (int from=0; from<candidates.size(); from+=FixedChunkSize)
+	{
+		PhenomenaChunkJob job = {&request, &track, candidates.constData(), from, qMin(from+FixedChunkSize, candidates.size()),
+					 &cancelled, &pendingMutex, &pendingEvents, this, generation};
+		jobs.append(QtConcurrent::run(runPhenomenaChunkJob, job));
+	}
+	if (jobs.isEmpty())
+	{
+		running = false;
+		emit finished();
+	}
+}
+
+void PhenomenaEngine::chunkFinished(int gen, int size)
+{
+	if (gen!=generation || !running)
+		return;
+	QVector<Event> found;
+	pendingMutex.lock();
+	found.swap(pendingEvents);
+	pendingMutex.unlock();
+	if (!found.isEmpty())
+	{
+		const int first = events.size();
+		events += found;
+		emit eventsFound(first, found.size());
+	}
+
+	nbDone += size;
+	emit progress(nbDone, getTotal());
+	if (nbDone>=getTotal())
+	{
+		waitForJobs();
+		++generation;
+		running = false;
+		emit finished();
+	}
+}
@@ -0,0 +1,150 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _PHENOMENAENGINE_HPP_
+#define _PHENOMENAENGINE_HPP_
+
+#include "EphemerisEngine.hpp"
+#include "VecMath.hpp"
+
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+//! @class PhenomenaEngine
+//! Search the conjunctions (closest approaches) of a solar system body with a list of targets, and its
+//! oppositions with solar system bodies.
+//! The targets are solar system bodies, or fixed positions like the stars and the deep-sky objects.
+//! The separation of each pair of objects is sampled with a step depending on their motion, then each
+//! local minimum is refined by a golden section search down to one minute.
+//! The positions are computed by the EphemerisEngine, so the state of the core is not changed.
+//! The path of the body is computed once and shared by all the pairs; the fixed targets which are never
+//! close to this path are skipped with a StelSphericalIndex. The pairs are then distributed in chunks over
+//! the global thread pool, and the events are reported as soon as a chunk is finished.
+class PhenomenaEngine : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Number of solar system targets searched by a job of the worker threads.
+	static const int PlanetChunkSize = 8;
+	//! Number of fixed targets searched by a job of the worker threads.
+	static const int FixedChunkSize = 256;
+
+	//! A closest approach found by the search.
+	struct Event
+	{
+		int target;		//!< Index of the target in Request::planets or Request::positions
+		bool fixed;		//!< Whether the target is a fixed position
+		bool opposition;
+		double JD;		//!< Date of the closest approach (UT)
+		double separation;	//!< Angular separation in radians, or for an opposition the difference to 180 degrees
+		double bodyDistance;	//!< Distance of the body to the observer, in AU
+		double targetDistance;	//!< Distance of the target to the observer in AU, 0 for a fixed target
+	};
+
+	//! What to search, with a copy of the settings needed by the computation.
+	struct Request
+	{
+		Request();
+		//! Whether the request has a body, a range of dates and at least one target.
+		bool isValid() const {return !body.body.isNull() && stopJD>startJD && (!planets.isEmpty() || !positions.isEmpty());}
+		//! Add a solar system target. Must be called from the main thread.
+		//! The body itself and the planet of the observer are ignored.
+		void addPlanet(const PlanetP& planet);
+		//! Add a fixed target.
+		//! @param j2000Pos the direction of the target in the J2000 equatorial frame
+		void addPosition(const Vec3d& j2000Pos);
+
+		EphemerisEngine::Request body;		//!< The body, its dates are set by the search
+		double startJD, stopJD;			//!< The range of dates (UT)
+		double maxSeparation;			//!< Largest separation of the events, in radians
+		bool oppositions;			//!< Whether the oppositions with the solar system targets are searched
+		QVector<EphemerisEngine::Request> planets;
+		QVector<double> planetSteps;		//!< The sampling step of each solar system target, in days
+		QVector<Vec3d> positions;		//!< The fixed targets, normalized
+		double positionStep;			//!< The sampling step of the fixed targets, in days
+	};
+
+	//! Prepare a request for the current observer and settings. Must be called from the main thread.
+	//! @param startJD, stopJD the range of dates (UT)
+	//! @param maxSeparation the largest separation of the events, in radians
+	static Request prepare(const PlanetP& body, double startJD, double stopJD, double maxSeparation, bool oppositions);
+
+	//! Get the sampling step of the separation of two objects, in days.
+	//! @param target a solar system target, or NULL for a fixed target
+	static double getSearchStep(const PlanetP& body, const PlanetP& target, double startJD, double stopJD);
+
+	PhenomenaEngine(QObject* parent=NULL);
+	//! Cancel the running search, if any.
+	~PhenomenaEngine();
+
+	//! Start a search in the background. The search running before is cancelled.
+	//! The signals are emitted in the thread of the engine.
+	//! @return false if the request is not valid.
+	bool start(const Request& request);
+	//! Stop the running search. finished() is not emitted.
+	void cancel();
+	bool isRunning() const {return running;}
+
+	//! Get the events found by the last search, in the order they were found.
+	const QVector<Event>& getEvents() const {return events;}
+	//! Get the request of the last search started.
+	const Request& getRequest() const {return request;}
+
+signals:
+	//! Emitted during the search. The total is the number of dates of the path of the body plus the number of targets.
+	void progress(int done, int total);
+	//! Emitted when new events were found.
+	//! @param first the index in getEvents() of the first new event
+	//! @param count the number of new events
+	void eventsFound(int first, int count);
+	//! Emitted when all the targets are searched.
+	void finished();
+
+private slots:
+	//! Called when the path of the body is computed, start the jobs of the targets.
+	void searchTargets();
+	void trackProgress(int done, int total);
+	//! Called in the thread of the engine when a job is finished.
+	void chunkFinished(int generation, int size);
+
+private:
+	//! Get the fixed targets close to the path of the body.
+	QVector<int> findCandidatePositions() const;
+	void waitForJobs();
+	int getTotal() const {return request.body.count + request.planets.size() + request.positions.size();}
+
+	Request request;
+	EphemerisEngine* trackEngine;	// computes the path of the body
+	QVector<EphemerisEngine::Entry> track;
+	QVector<int> candidates;	// the fixed targets to search
+	QVector<Event> events;
+	QVector<Event> pendingEvents;	// found by the workers, not yet reported
+	QMutex pendingMutex;
+	QList<QFuture<void> > jobs;
+	QAtomicInt cancelled;
+	int generation;
+	int nbDone;
+	bool running;
+};
+
+#endif // _PHENOMENAENGINE_HPP_
@@ -44,6 +44,7 @@
 #include <QString>
 #include <QDebug>
 #include <QVarLengthArray>
+#include <QOpenGLBuffer>
 #include <QOpenGLContext>
 #include <QOpenGLShader>
 
@@ -592,7 +593,9 @@ void Planet::computePosition(const double dateJDE)
 {
 	// Make sure the parent position is computed for the dateJDE, otherwise
 	// getHeliocentricPos() would return incorrect values.
-	if (parent)
+	// The Sun (the only body without parent) is always at the origin, and is not
+	// touched here so that its satellites can be computed in parallel threads.
+	if (parent && parent->parent)
 		parent->computePositionWithoutOrbits(dateJDE);
 
 	if (orbitFader.getInterstate()>0.000001 && deltaOrbitJDE > 0 && (fabs(lastOrbitJDE-dateJDE)>deltaOrbitJDE || !orbitCached))
@@ -952,36 +955,23 @@ double Planet::getElongation(const Vec3d& obsPos) const
 // Computation of the visual magnitude (V band) of the planet.
 float Planet::getVMagnitude(const StelCore* core) const
 {
+	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	double shadowFactor = 1.;
 	if (parent == 0)
 	{
-		// Sun, compute the apparent magnitude for the absolute mag (V: 4.83) and observer's distance
-		// Hint: Absolute Magnitude of the Sun in Several Bands: http://mips.as.arizona.edu/~cnaw/sun.html
-		const double distParsec = std::sqrt(core->getObserverHeliocentricEclipticPos().lengthSquared())*AU/PARSEC;
-
-		// check how much of it is visible
+		// check how much of the Sun is visible
 		const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
-		double shadowFactor = ssm->getEclipseFactor(core);
+		shadowFactor = ssm->getEclipseFactor(core);
 		// See: Hughes, D. W., Brightness during a solar eclipse // Journal of the British Astronomical Association, vol.110, no.4, p.203-205
 		// URL: http://adsabs.harvard.edu/abs/2000JBAA..110..203H
 		if(shadowFactor < 0.000128)
 			shadowFactor = 0.000128;
-
-		return 4.83 + 5.*(std::log10(distParsec)-1.) - 2.5*(std::log10(shadowFactor));
 	}
-
-	// Compute the angular phase
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
-	const double observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
-	const double planetRq = planetHelioPos.lengthSquared();
-	const double observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
-	const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
-	const double phase = std::acos(cos_chi);
-
-	double shadowFactor = 1.;
 	// Check if the satellite is inside the inner shadow of the parent planet:
-	if (parent->parent != 0)
+	else if (parent->parent != 0)
 	{
+		const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
+		const double planetRq = planetHelioPos.lengthSquared();
 		const Vec3d& parentHeliopos = parent->getHeliocentricEclipticPos();
 		const double parent_Rq = parentHeliopos.lengthSquared();
 		const double pos_times_parent_pos = planetHelioPos * parentHeliopos;
@@ -1017,9 +1007,30 @@ float Planet::getVMagnitude(const StelCore* core) const
 			}
 		}
 	}
+	return computeVMagnitude(observerHelioPos, getHeliocentricEclipticPos(), core->getJDE(),
+				 core->getCurrentPlanet()->getApparentMagnitudeAlgorithm(), core->getCurrentLocation().planetName=="Earth", shadowFactor);
+}
+
+float Planet::computeVMagnitude(const Vec3d& observerHelioPos, const Vec3d& planetHelioPos, double JDE,
+				ApparentMagnitudeAlgorithm algorithm, bool onEarth, double shadowFactor) const
+{
+	if (parent == 0)
+	{
+		// Sun, compute the apparent magnitude for the absolute mag (V: 4.83) and observer's distance
+		// Hint: Absolute Magnitude of the Sun in Several Bands: http://mips.as.arizona.edu/~cnaw/sun.html
+		const double distParsec = std::sqrt(observerHelioPos.lengthSquared())*AU/PARSEC;
+		return 4.83 + 5.*(std::log10(distParsec)-1.) - 2.5*(std::log10(shadowFactor));
+	}
+
+	// Compute the angular phase
+	const double observerRq = observerHelioPos.lengthSquared();
+	const double planetRq = planetHelioPos.lengthSquared();
+	const double observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
+	const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
+	const double phase = std::acos(cos_chi);
 
 	// Use empirical formulae for main planets when seen from earth
-	if (core->getCurrentLocation().planetName=="Earth")
+	if (onEarth)
 	{
 		const double phaseDeg=phase*180./M_PI;
 		const double d = 5. * log10(std::sqrt(observerPlanetRq*planetRq));
@@ -1032,7 +1043,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 		// I activate (1) for now, because we want to simulate the eye's impression. (Esp. Venus!)
 		// AW: (2) activated by default
 
-		switch (core->getCurrentPlanet()->getApparentMagnitudeAlgorithm())
+		switch (algorithm)
 		{
 			case Planesas:
 			{
@@ -1054,12 +1065,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - observerHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinx=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1093,12 +1103,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - observerHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1131,12 +1140,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - observerHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1280,6 +1288,7 @@ static StelPainterLight light;
 void Planet::PlanetShaderVars::initLocations(QOpenGLShaderProgram* p)
 {
 	GL(projectionMatrix = p->uniformLocation("projectionMatrix"));
+	GL(vertexScale = p->uniformLocation("vertexScale"));
 	GL(texCoord = p->attributeLocation("texCoord"));
 	GL(unprojectedVertex = p->attributeLocation("unprojectedVertex"));
 	GL(vertex = p->attributeLocation("vertex"));
@@ -1303,6 +1312,7 @@ void Planet::initShader()
 		"attribute highp vec3 unprojectedVertex;\n"
 		"attribute mediump vec2 texCoord;\n"
 		"uniform highp mat4 projectionMatrix;\n"
+		"uniform highp vec3 vertexScale;\n"
 		"uniform highp vec3 lightDirection;\n"
 		"uniform highp vec3 eyeDirection;\n"
 		"varying mediump vec2 texc;\n"
@@ -1319,7 +1329,8 @@ void Planet::initShader()
 		"{\n"
 		"    gl_Position = projectionMatrix * vec4(vertex, 1.);\n"
 		"    texc = texCoord;\n"
-		"    highp vec3 normal = normalize(unprojectedVertex);\n"
+		"    highp vec3 position = unprojectedVertex * vertexScale;\n"
+		"    highp vec3 normal = normalize(position);\n"
 		"#ifdef IS_MOON\n"
 		"    normalX = normalize(cross(vec3(0,0,1), normal));\n"
 		"    normalY = normalize(cross(normal, normalX));\n"
@@ -1329,7 +1340,7 @@ void Planet::initShader()
 		"    lum_ = clamp(c, 0.0, 1.0);\n"
 		"#endif\n"
 		"\n"
-		"    P = unprojectedVertex;\n"
+		"    P = position;\n"
 		"}\n"
 		"\n";
 	
@@ -1551,8 +1562,12 @@ void Planet::initShader()
 	GL(moonShaderProgram->release());
 }
 
+static void deleteMeshes();
+
 void Planet::deinitShader()
 {
+	// The meshes hold OpenGL buffers, which must be deleted with the context
+	deleteMeshes();
 	delete planetShaderProgram;
 	planetShaderProgram = NULL;
 	delete ringPlanetShaderProgram;
@@ -1784,6 +1799,92 @@ void sRing(Ring3DModel* model, const float rMin, const float rMax, int slices, c
 	}
 }
 
+// Numbers of facets of the cached spheres. The level of detail is chosen from the size of the planet on screen.
+static const int sphereFacets[] = {10, 14, 20, 28, 40, 56, 72, 100};
+static const int nbSphereLevels = sizeof(sphereFacets)/sizeof(sphereFacets[0]);
+
+//! A unit sphere shared by all the planets, which is stored in GPU buffers.
+//! The vertex shader scales it by the radius and the oblateness of each planet.
+struct SphereMesh
+{
+	SphereMesh()
+		: vertexBuffer(QOpenGLBuffer::VertexBuffer)
+		, texCoordBuffer(QOpenGLBuffer::VertexBuffer)
+		, indiceBuffer(QOpenGLBuffer::IndexBuffer)
+	{}
+	Planet3DModel model;	// kept for the projection of the vertices and StelPainter
+	QOpenGLBuffer vertexBuffer;
+	QOpenGLBuffer texCoordBuffer;
+	QOpenGLBuffer indiceBuffer;
+};
+
+static SphereMesh* sphereMeshes[nbSphereLevels] = {NULL};
+// Rings by inner and outer radius
+static QMap<QPair<float, float>, Ring3DModel> ringModels;
+// Projected vertices, reused by all the planets to avoid allocations at each frame
+static QVector<float> projectedVertexArr;
+
+static void createStaticBuffer(QOpenGLBuffer& buffer, const void* data, int size)
+{
+	buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	buffer.create();
+	buffer.bind();
+	buffer.allocate(data, size);
+	buffer.release();
+}
+
+// Get the cached sphere for a diameter on screen in pixels, creating it if needed.
+static const SphereMesh* getSphereMesh(float screenSz)
+{
+	// 40 facets for 1024 pixels diameter on screen
+	const int nbFacets = (int)(screenSz * 40.f/50.f);
+	int level = 0;
+	while (level<nbSphereLevels-1 && sphereFacets[level]<nbFacets)
+		++level;
+	SphereMesh*& mesh = sphereMeshes[level];
+	if (mesh==NULL)
+	{
+		mesh = new SphereMesh;
+		sSphere(&mesh->model, 1.f, 1.f, sphereFacets[level], sphereFacets[level]);
+		const Planet3DModel& m = mesh->model;
+		createStaticBuffer(mesh->vertexBuffer, m.vertexArr.constData(), m.vertexArr.size()*sizeof(float));
+		createStaticBuffer(mesh->texCoordBuffer, m.texCoordArr.constData(), m.texCoordArr.size()*sizeof(float));
+		createStaticBuffer(mesh->indiceBuffer, m.indiceArr.constData(), m.indiceArr.size()*sizeof(unsigned short));
+		if (projectedVertexArr.capacity()<m.vertexArr.size())
+			projectedVertexArr.reserve(m.vertexArr.size());
+	}
+	return mesh;
+}
+
+// Get the cached ring model, creating it if needed.
+static const Ring3DModel& getRingModel(float rMin, float rMax)
+{
+	const QPair<float, float> key(rMin, rMax);
+	QMap<QPair<float, float>, Ring3DModel>::iterator it = ringModels.find(key);
+	if (it==ringModels.end())
+	{
+		it = ringModels.insert(key, Ring3DModel());
+		sRing(&it.value(), rMin, rMax, 128, 32);
+	}
+	return it.value();
+}
+
+static void deleteMeshes()
+{
+	for (int i=0; i<nbSphereLevels; ++i)
+	{
+		if (sphereMeshes[i]==NULL)
+			continue;
+		sphereMeshes[i]->vertexBuffer.destroy();
+		sphereMeshes[i]->texCoordBuffer.destroy();
+		sphereMeshes[i]->indiceBuffer.destroy();
+		delete sphereMeshes[i];
+		sphereMeshes[i] = NULL;
+	}
+	ringModels.clear();
+	projectedVertexArr.clear();
+}
+
 void Planet::computeModelMatrix(Mat4d &result) const
 {
 	result = Mat4d::translation(eclipticPos) * rotLocalToParent * Mat4d::zrotation(M_PI/180*(axisRotation + 90.));
@@ -1799,7 +1900,8 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 {
 	if (texMap)
 	{
-		// For lazy loading, return if texture not yet loaded
+		// For lazy loading, return if texture not yet loaded. The largest planets on screen are loaded first.
+		texMap->setLoadPriority(screenSz);
 		if (!texMap->bind(0))
 		{
 			return;
@@ -1811,18 +1913,18 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 
 	// Draw the spheroid itself
 	// Adapt the number of facets according with the size of the sphere for optimization
-	int nb_facet = (int)(screenSz * 40.f/50.f);	// 40 facets for 1024 pixels diameter on screen
-	if (nb_facet<10) nb_facet = 10;
-	if (nb_facet>100) nb_facet = 100;
+	const SphereMesh* mesh = getSphereMesh(screenSz);
+	const Planet3DModel& model = mesh->model;
 
-	// Generates the vertice
-	Planet3DModel model;
-	sSphere(&model, radius*sphereScale, oneMinusOblateness, nb_facet, nb_facet);
-	
-	QVector<float> projectedVertexArr;
+	// The projection is not linear, the vertices scaled to the size of the planet are projected on the CPU
+	const float r = radius*sphereScale;
+	const Vec3f scale(r, r, r*oneMinusOblateness);
 	projectedVertexArr.resize(model.vertexArr.size());
-	for (int i=0;i<model.vertexArr.size()/3;++i)
-		painter->getProjector()->project(*((Vec3f*)(model.vertexArr.constData()+i*3)), *((Vec3f*)(projectedVertexArr.data()+i*3)));
+	for (int i=0;i<model.vertexArr.size();i+=3)
+	{
+		const Vec3f v(model.vertexArr[i]*scale[0], model.vertexArr[i+1]*scale[1], model.vertexArr[i+2]*scale[2]);
+		painter->getProjector()->project(v, *((Vec3f*)(projectedVertexArr.data()+i)));
+	}
 	
 	const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
 		
@@ -1900,6 +2002,7 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 
 
 	GL(shader->setUniformValue(shaderVars->projectionMatrix, qMat));
+	GL(shader->setUniformValue(shaderVars->vertexScale, scale[0], scale[1], scale[2]));
 	GL(shader->setUniformValue(shaderVars->lightDirection, lightPos3[0], lightPos3[1], lightPos3[2]));
 	GL(shader->setUniformValue(shaderVars->eyeDirection, eyePos[0], eyePos[1], eyePos[2]));
 	GL(shader->setUniformValue(shaderVars->diffuseLight, light.diffuse[0], light.diffuse[1], light.diffuse[2]));
@@ -1933,11 +2036,17 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		}
 	}
 
+	// The unit sphere and the texture coordinates are read from the GPU buffers, the buffers must be released
+	// before passing the projected vertices from the client memory
 	GL(shader->setAttributeArray(shaderVars->vertex, (const GLfloat*)projectedVertexArr.constData(), 3));
 	GL(shader->enableAttributeArray(shaderVars->vertex));
-	GL(shader->setAttributeArray(shaderVars->unprojectedVertex, (const GLfloat*)model.vertexArr.constData(), 3));
+	GL(mesh->vertexBuffer.bind());
+	GL(shader->setAttributeBuffer(shaderVars->unprojectedVertex, GL_FLOAT, 0, 3));
+	GL(mesh->vertexBuffer.release());
 	GL(shader->enableAttributeArray(shaderVars->unprojectedVertex));
-	GL(shader->setAttributeArray(shaderVars->texCoord, (const GLfloat*)model.texCoordArr.constData(), 2));
+	GL(mesh->texCoordBuffer.bind());
+	GL(shader->setAttributeBuffer(shaderVars->texCoord, GL_FLOAT, 0, 2));
+	GL(mesh->texCoordBuffer.release());
 	GL(shader->enableAttributeArray(shaderVars->texCoord));
 
 	if (rings)
@@ -1948,7 +2057,11 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 	}
 	
 	if (!drawOnlyRing)
-		GL(glDrawElements(GL_TRIANGLES, model.indiceArr.size(), GL_UNSIGNED_SHORT, model.indiceArr.constData()));
+	{
+		GL(mesh->indiceBuffer.bind());
+		GL(glDrawElements(GL_TRIANGLES, model.indiceArr.size(), GL_UNSIGNED_SHORT, 0));
+		GL(mesh->indiceBuffer.release());
+	}
 
 	if (rings)
 	{
@@ -1959,10 +2072,10 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glEnable(GL_BLEND);
 	
-		Ring3DModel ringModel;
-		sRing(&ringModel, rings->radiusMin, rings->radiusMax, 128, 32);
+		const Ring3DModel& ringModel = getRingModel(rings->radiusMin, rings->radiusMax);
 		
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.isRing, true));
+		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.vertexScale, 1.f, 1.f, 1.f));
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.texture, 2));
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.ringS, 1));
 		
@@ -1997,6 +2110,9 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		glDisable(GL_DEPTH_TEST);
 	}
 	
+	GL(shader->disableAttributeArray(shaderVars->vertex));
+	GL(shader->disableAttributeArray(shaderVars->unprojectedVertex));
+	GL(shader->disableAttributeArray(shaderVars->texCoord));
 	GL(shader->release());
 	
 	glDisable(GL_CULL_FACE);
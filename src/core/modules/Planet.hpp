@@ -156,6 +156,14 @@ public:
 	virtual double getSatellitesFov(const StelCore* core) const;
 	virtual double getParentSatellitesFov(const StelCore* core) const;
 	virtual float getVMagnitude(const StelCore* core) const;
+	//! Compute the visual magnitude for given heliocentric positions of the observer and of the planet.
+	//! Unlike getVMagnitude(), it doesn't use the current state of the planets, and can be called from any thread.
+	//! @param JDE the date, used for the rings of Saturn
+	//! @param algorithm the algorithm of the observer's planet
+	//! @param onEarth whether the observer is on the Earth, where the empirical formulae of the major planets are used
+	//! @param shadowFactor the fraction of light not blocked by the shadow of the parent planet, or for the Sun by an eclipse
+	virtual float computeVMagnitude(const Vec3d& observerHelioPos, const Vec3d& planetHelioPos, double JDE,
+					ApparentMagnitudeAlgorithm algorithm, bool onEarth, double shadowFactor=1.) const;
 	virtual float getSelectPriority(const StelCore* core) const;
 	virtual Vec3f getInfoColor(void) const;
 	virtual QString getType(void) const {return "Planet";}
@@ -451,6 +459,7 @@ protected:
 	// Shader-related variables
 	struct PlanetShaderVars {
 		int projectionMatrix;
+		int vertexScale;
 		int texCoord;
 		int unprojectedVertex;
 		int vertex;
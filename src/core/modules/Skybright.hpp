@@ -68,7 +68,20 @@ public:
 	//! @param cosDistZenith cos(angular distance between zenith and the position)
 	float getLuminance(float cosDistMoon, const float cosDistSun, const float cosDistZenith) const;
 
+	//! Compute the luminance at several positions.
+	//! Unlike getLuminance(), this doesn't check whether the Sun and Moon are displayed, the caller has to do it once.
+	//! Only the terms precomputed by the setter functions are read, so several threads can call it at the same time.
+	//! @param nb the number of positions
+	//! @param cosDistMoon array of nb cos(angular distance between moon and the position)
+	//! @param cosDistSun array of nb cos(angular distance between sun and the position)
+	//! @param cosDistZenith array of nb cos(angular distance between zenith and the position)
+	//! @param luminance array receiving the nb luminances, in cd/m^2
+	void getLuminances(const int nb, const float* cosDistMoon, const float* cosDistSun, const float* cosDistZenith, float* luminance) const;
+
 private:
+	//! Same as getLuminance(), without the check of the planets display.
+	inline float computeLuminance(float cosDistMoon, const float cosDistSun, const float cosDistZenith) const;
+
 	float airMassMoon;  // Air mass for the Moon
 	float airMassSun;   // Air mass for the Sun
 	float magMoon;      // Moon magnitude
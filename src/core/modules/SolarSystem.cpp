@@ -20,6 +20,7 @@
  */
 
 #include "SolarSystem.hpp"
+#include "SolarSystemCatalog.hpp"
 #include "StelTexture.hpp"
 #include "EphemWrapper.hpp"
 #include "Orbit.hpp"
@@ -33,7 +34,6 @@
 #include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
 #include "StelModuleMgr.hpp"
-#include "StelIniParser.hpp"
 #include "Planet.hpp"
 #include "MinorPlanet.hpp"
 #include "Comet.hpp"
@@ -43,6 +43,7 @@
 #include "StelPainter.hpp"
 #include "TrailGroup.hpp"
 #include "RefractionExtinction.hpp"
+#include "StelProfiler.hpp"
 
 #include "AstroCalcDialog.hpp"
 
@@ -59,14 +60,21 @@
 #include <QMapIterator>
 #include <QDebug>
 #include <QDir>
+#include <QFutureSynchronizer>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 SolarSystem::SolarSystem()
 	: shadowPlanetCount(0)
 	, flagMoonScale(false)
 	, moonScale(1.)
 	, labelsAmount(false)
+	, lightTimeJDE(-1e100)
 	, flagOrbits(false)
 	, flagLightTravelTime(true)
+	, flagParallelPositions(true)
+	, flagKeplerPropagator(false)
+	, flagSolarSystemCache(true)
 	, flagShow(false)
 	, flagPointer(false)
 	, flagNativeNames(false)
@@ -139,10 +147,14 @@ void SolarSystem::init()
 	Q_ASSERT(conf);
 
 	Planet::init();
+	flagSolarSystemCache = conf->value("astro/flag_solar_system_cache", true).toBool();
+	flagKeplerPropagator = conf->value("astro/flag_kepler_propagator", false).toBool();
+	Comet::tailUpdatesPerFrame = qMax(conf->value("astro/comet_tail_updates_per_frame", 10).toInt(), 1);
 	loadPlanets();	// Load planets data
 
 	// Compute position and matrix of sun and all the satellites (ie planets)
 	// for the first initialization Q_ASSERT that center is sun center (only impacts on light speed correction)	
+	setFlagParallelPositions(conf->value("astro/flag_parallel_positions", true).toBool());
 	computePositions(StelApp::getInstance().getCore()->getJDE());
 
 	setSelected("");	// Fix a bug on macosX! Thanks Fumio!
@@ -430,68 +442,113 @@ void SolarSystem::loadPlanets()
 	foreach (const PlanetP& planet, systemPlanets)
 		if(planet->parent != sun || !planet->satellites.isEmpty())
 			shadowPlanetCount++;
+
+	updatePositionGroups();
 }
 
-bool SolarSystem::loadPlanets(const QString& filePath)
+bool SolarSystem::loadSolarSystemFile(const QString& filePath)
 {
-	QSettings pd(filePath, StelIniFormat);
-	if (pd.status() != QSettings::NoError)
-	{
-		qWarning() << "ERROR while parsing" << QDir::toNativeSeparators(filePath);
+	flagSolarSystemCache = false;
+	if (!loadPlanets(filePath))
 		return false;
+	updatePositionGroups();
+	return true;
+}
+
+void SolarSystem::updatePositionGroups()
+{
+	serialPlanets.clear();
+	parallelPlanets.clear();
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		if (p->parent==sun && p->satellites.isEmpty() &&
+		    (p->coordFunc==&ellipticalOrbitPosFunc || p->coordFunc==&cometOrbitPosFunc))
+			parallelPlanets.append(p);
+		else
+			serialPlanets.append(p);
+	}
+	keplerPropagator.clear();
+	propagatedPlanets.clear();
+	if (flagKeplerPropagator)
+	{
+		QList<PlanetP> notPropagated;
+		foreach (const PlanetP& p, parallelPlanets)
+		{
+			const int i = p->coordFunc==&ellipticalOrbitPosFunc
+				      ? keplerPropagator.add(static_cast<const EllipticalOrbit*>(p->userDataPtr))
+				      : keplerPropagator.add(static_cast<const CometOrbit*>(p->userDataPtr));
+			if (i>=0)
+				propagatedPlanets.append(p);
+			else
+				notPropagated.append(p);
+		}
+		parallelPlanets = notPropagated;
 	}
+	// Force the computation of the light time corrections
+	serialLightTimes.clear();
+	parallelLightTimes.clear();
+	propagatedLightTimes.clear();
+	lightTimeJDE = -1e100;
+}
 
-	// QSettings does not allow us to say that the sections of the file
-	// will be listed in the same order  as in the file like the old
-	// InitParser used to so we can no longer assume that.
+bool SolarSystem::loadPlanets(const QString& filePath)
+{
+	// The minor bodies orbiting the Sun come as records from the catalog, and are created
+	// in bulk by createMinorBodies(). The other bodies are created from their sections.
+	SolarSystemCatalog catalog;
+	if (!catalog.load(filePath, flagSolarSystemCache))
+		return false;
+	const QVector<SolarSystemCatalog::Section>& sections = catalog.getSections();
+
+	// The sections are sorted by name like QSettings::childGroups(), they
+	// are not in the same order as in the file like the old InitParser used
+	// to return them, so we can no longer assume that.
 	//
 	// This means we must first decide what order to read the sections
 	// of the file in (each section contains one planet) to avoid setting
 	// the parent Planet* to one which has not yet been created.
 	//
-	// Stage 1: Make a map of body names back to the section names
+	// Stage 1: Make a map of body names back to the section indices
 	// which they come from. Also make a map of body name to parent body
 	// name. These two maps can be made in a single pass through the
 	// sections of the file.
 	//
-	// Stage 2: Make an ordered list of section names such that each
+	// Stage 2: Make an ordered list of section indices such that each
 	// item is only ever dependent on items which appear earlier in the
 	// list.
 	// 2a: Make a QMultiMap relating the number of levels of dependency
-	//     to the body name, i.e.
+	//     to the body section, i.e.
 	//     0 -> Sun
 	//     1 -> Mercury
 	//     1 -> Venus
 	//     1 -> Earth
 	//     2 -> Moon
 	//     etc.
-	// 2b: Populate an ordered list of section names by iterating over
+	// 2b: Populate an ordered list of section indices by iterating over
 	//     the QMultiMap.  This type of contains is always sorted on the
 	//     key, so it's easy.
 	//     i.e. [sol, earth, moon] is fine, but not [sol, moon, earth]
 	//
 	// Stage 3: iterate over the ordered sections decided in stage 2,
-	// creating the planet objects from the QSettings data.
+	// creating the planet objects from the section data.
 
 	// Stage 1 (as described above).
-	QMap<QString, QString> secNameMap;
+	QMap<QString, int> secNameMap;
 	QMap<QString, QString> parentMap;
-	QStringList sections = pd.childGroups();
 	for (int i=0; i<sections.size(); ++i)
 	{
-		const QString secname = sections.at(i);
-		const QString englishName = pd.value(secname+"/name").toString();
-		const QString strParent = pd.value(secname+"/parent").toString();
-		secNameMap[englishName] = secname;
+		const QString englishName = sections.at(i).value("name").toString();
+		const QString strParent = sections.at(i).value("parent").toString();
+		secNameMap[englishName] = i;
 		if (strParent!="none" && !strParent.isEmpty() && !englishName.isEmpty())
 			parentMap[englishName] = strParent;
 	}
 
 	// Stage 2a (as described above).
-	QMultiMap<int, QString> depLevelMap;
+	QMultiMap<int, int> depLevelMap;
 	for (int i=0; i<sections.size(); ++i)
 	{
-		const QString englishName = pd.value(sections.at(i)+"/name").toString();
+		const QString englishName = sections.at(i).value("name").toString();
 
 		// follow dependencies, incrementing level when we have one
 		// till we run out.
@@ -507,8 +564,8 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	}
 
 	// Stage 2b (as described above).
-	QStringList orderedSections;
-	QMapIterator<int, QString> levelMapIt(depLevelMap);
+	QVector<int> orderedSections;
+	QMapIterator<int, int> levelMapIt(depLevelMap);
 	while(levelMapIt.hasNext())
 	{
 		levelMapIt.next();
@@ -521,9 +578,10 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	for (int i = 0;i<orderedSections.size();++i)
 	{
 		totalPlanets++;
-		const QString secname = orderedSections.at(i);
-		const QString englishName = pd.value(secname+"/name").toString().simplified();
-		const QString strParent = pd.value(secname+"/parent").toString();
+		const SolarSystemCatalog::Section& sec = sections.at(orderedSections.at(i));
+		const QString& secname = sec.name;
+		const QString englishName = sec.value("name").toString().simplified();
+		const QString strParent = sec.value("parent").toString();
 		PlanetP parent;
 		if (strParent!="none")
 		{
@@ -544,219 +602,19 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 			}
 		}
 
-		const QString funcName = pd.value(secname+"/coord_func").toString();
+		const QString funcName = sec.value("coord_func").toString();
 		posFuncType posfunc=NULL;
 		void* userDataPtr=NULL;
 		OsculatingFunctType *osculatingFunc = 0;
-		bool closeOrbit = pd.value(secname+"/closeOrbit", true).toBool();
-
-		if (funcName=="ell_orbit")
-		{
-			// Read the orbital elements
-			const double epoch = pd.value(secname+"/orbit_Epoch",J2000).toDouble();
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity").toDouble();
-			if (eccentricity >= 1.0) closeOrbit = false;
-			double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
-			double semi_major_axis;
-			if (pericenterDistance <= 0.0) {
-				semi_major_axis = pd.value(secname+"/orbit_SemiMajorAxis",-1e100).toDouble();
-				if (semi_major_axis <= -1e100) {
-					qDebug() << "ERROR: " << englishName
-						<< ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
-					//abort();
-					continue;
-				} else {
-					semi_major_axis /= AU;
-					Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
-					pericenterDistance = semi_major_axis * (1.0-eccentricity);
-				}
-			} else {
-				pericenterDistance /= AU;
-				semi_major_axis = (eccentricity == 1.0)
-								? 0.0 // parabolic orbits have no semi_major_axis
-								: pericenterDistance / (1.0-eccentricity);
-			}
-			double meanMotion = pd.value(secname+"/orbit_MeanMotion",-1e100).toDouble();
-			double period;
-			if (meanMotion <= -1e100) {
-				period = pd.value(secname+"/orbit_Period",-1e100).toDouble();
-				if (period <= -1e100) {
-					meanMotion = (eccentricity == 1.0)
-								? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)
-								: (semi_major_axis > 0.0)
-								? 0.01720209895 / (semi_major_axis*std::sqrt(semi_major_axis))
-								: 0.01720209895 / (-semi_major_axis*std::sqrt(-semi_major_axis));
-					period = 2.0*M_PI/meanMotion;
-				} else {
-					meanMotion = 2.0*M_PI/period;
-				}
-			} else {
-				period = 2.0*M_PI/meanMotion;
-			}
-			const double inclination = pd.value(secname+"/orbit_Inclination").toDouble()*(M_PI/180.0);
-			const double ascending_node = pd.value(secname+"/orbit_AscendingNode").toDouble()*(M_PI/180.0);
-			double arg_of_pericenter = pd.value(secname+"/orbit_ArgOfPericenter",-1e100).toDouble();
-			double long_of_pericenter;
-			if (arg_of_pericenter <= -1e100) {
-				long_of_pericenter = pd.value(secname+"/orbit_LongOfPericenter").toDouble()*(M_PI/180.0);
-				arg_of_pericenter = long_of_pericenter - ascending_node;
-			} else {
-				arg_of_pericenter *= (M_PI/180.0);
-				long_of_pericenter = arg_of_pericenter + ascending_node;
-			}
-			double mean_anomaly = pd.value(secname+"/orbit_MeanAnomaly",-1e100).toDouble();
-			double mean_longitude;
-			if (mean_anomaly <= -1e100) {
-				mean_longitude = pd.value(secname+"/orbit_MeanLongitude").toDouble()*(M_PI/180.0);
-				mean_anomaly = mean_longitude - long_of_pericenter;
-			} else {
-				mean_anomaly *= (M_PI/180.0);
-				mean_longitude = mean_anomaly + long_of_pericenter;
-			}
+		bool closeOrbit = sec.value("closeOrbit", true).toBool();
 
-			// when the parent is the sun use ecliptic rather than sun equator:
-			const double parentRotObliquity = parent->getParent()
-											  ? parent->getRotObliquity(2451545.0)
-											  : 0.0;
-			const double parent_rot_asc_node = parent->getParent()
-											  ? parent->getRotAscendingnode()
-											  : 0.0;
-			double parent_rot_j2000_longitude = 0.0;
-			if (parent->getParent()) {
-				const double c_obl = cos(parentRotObliquity);
-				const double s_obl = sin(parentRotObliquity);
-				const double c_nod = cos(parent_rot_asc_node);
-				const double s_nod = sin(parent_rot_asc_node);
-				const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
-				const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
-				const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
-				const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
-				Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
-				J2000NodeOrigin.normalize();
-				parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
-			}
-
-			// Create an elliptical orbit
-			EllipticalOrbit *orb = new EllipticalOrbit(pericenterDistance,
-								   eccentricity,
-								   inclination,
-								   ascending_node,
-								   arg_of_pericenter,
-								   mean_anomaly,
-								   period,
-								   epoch,
-								   parentRotObliquity,
-								   parent_rot_asc_node,
-								   parent_rot_j2000_longitude);
-			orbits.push_back(orb);
-
-			userDataPtr = orb;
-			posfunc = &ellipticalOrbitPosFunc;
-		}
-		else if (funcName=="comet_orbit")
+		if (funcName=="ell_orbit" || funcName=="comet_orbit")
 		{
-			// Read the orbital elements
-			// orbit_PericenterDistance,orbit_SemiMajorAxis: given in AU
-			// orbit_MeanMotion: given in degrees/day
-			// orbit_Period: given in days
-			// orbit_TimeAtPericenter,orbit_Epoch: JD
-			// orbit_MeanAnomaly,orbit_Inclination,orbit_ArgOfPericenter,orbit_AscendingNode: given in degrees
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity",0.0).toDouble();
-			if (eccentricity >= 1.0) closeOrbit = false;
-			double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
-			double semi_major_axis;
-			if (pericenterDistance <= 0.0) {
-				semi_major_axis = pd.value(secname+"/orbit_SemiMajorAxis",-1e100).toDouble();
-				if (semi_major_axis <= -1e100) {
-					qWarning() << "ERROR: " << englishName
-						<< ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
-					//abort();
-					continue;
-				} else {
-					Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
-					pericenterDistance = semi_major_axis * (1.0-eccentricity);
-				}
-			} else {
-				semi_major_axis = (eccentricity == 1.0)
-								? 0.0 // parabolic orbits have no semi_major_axis
-								: pericenterDistance / (1.0-eccentricity);
-			}
-			double meanMotion = pd.value(secname+"/orbit_MeanMotion",-1e100).toDouble();
-			if (meanMotion <= -1e100) {
-				const double period = pd.value(secname+"/orbit_Period",-1e100).toDouble();
-				if (period <= -1e100) {
-					if (parent->getParent()) {
-						qWarning() << "ERROR: " << englishName
-							<< ": when the parent body is not the sun, you must provide "
-							<< "either orbit_MeanMotion or orbit_Period";
-					} else {
-						// in case of parent=sun: use Gaussian gravitational constant
-						// for calculating meanMotion:
-						//meanMotion = (eccentricity >= 0.9999 && eccentricity <= 1.0)
-						//			? 0.01720209895 * (1.5/pericenterDistance) * sqrt(0.5/pericenterDistance)
-						//			: (semi_major_axis > 0.0)
-						//			? 0.01720209895 / (semi_major_axis*sqrt(semi_major_axis))
-						//			: 0.01720209895 / (-semi_major_axis*sqrt(-semi_major_axis));
-						meanMotion = (eccentricity == 1.0)
-									? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)  // GZ: This is Heafner's W / dt
-									: 0.01720209895 / (fabs(semi_major_axis)*std::sqrt(fabs(semi_major_axis)));
-					}
-				} else {
-					meanMotion = 2.0*M_PI/period;
-				}
-			} else {
-				meanMotion *= (M_PI/180.0);
-			}
-			double time_at_pericenter = pd.value(secname+"/orbit_TimeAtPericenter",-1e100).toDouble();
-			if (time_at_pericenter <= -1e100) {
-				const double epoch = pd.value(secname+"/orbit_Epoch",-1e100).toDouble();
-				double mean_anomaly = pd.value(secname+"/orbit_MeanAnomaly",-1e100).toDouble();
-				if (epoch <= -1e100 || mean_anomaly <= -1e100) {
-					qWarning() << "ERROR: " << englishName
-						<< ": when you do not provide orbit_TimeAtPericenter, you must provide both "
-						<< "orbit_Epoch and orbit_MeanAnomaly";
-					//abort();
-					continue;
-				} else {
-					mean_anomaly *= (M_PI/180.0);
-					time_at_pericenter = epoch - mean_anomaly / meanMotion;
-				}
-			}
-			const double orbitGoodDays=pd.value(secname+"/orbit_good", 1000).toDouble();
-			const double inclination = pd.value(secname+"/orbit_Inclination").toDouble()*(M_PI/180.0);
-			const double arg_of_pericenter = pd.value(secname+"/orbit_ArgOfPericenter").toDouble()*(M_PI/180.0);
-			const double ascending_node = pd.value(secname+"/orbit_AscendingNode").toDouble()*(M_PI/180.0);
-			const double parentRotObliquity = parent->getParent() ? parent->getRotObliquity(2451545.0) : 0.0;
-			const double parent_rot_asc_node = parent->getParent() ? parent->getRotAscendingnode() : 0.0;
-			double parent_rot_j2000_longitude = 0.0;
-						if (parent->getParent()) {
-							const double c_obl = cos(parentRotObliquity);
-							const double s_obl = sin(parentRotObliquity);
-							const double c_nod = cos(parent_rot_asc_node);
-							const double s_nod = sin(parent_rot_asc_node);
-							const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
-							const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
-							const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
-							const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
-							Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
-							J2000NodeOrigin.normalize();
-							parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
-						}
-			//qDebug() << "Creating CometOrbit for" << englishName;
-			CometOrbit *orb = new CometOrbit(pericenterDistance,
-							 eccentricity,
-							 inclination,
-							 ascending_node,
-							 arg_of_pericenter,
-							 time_at_pericenter,
-							 orbitGoodDays,
-							 meanMotion,
-							 parentRotObliquity,
-							 parent_rot_asc_node,
-							 parent_rot_j2000_longitude);
-			orbits.push_back(orb);
-			userDataPtr = orb;
-			posfunc = &cometOrbitPosFunc;
+			SolarSystemCatalog::OrbitElements elements;
+			if (!SolarSystemCatalog::readOrbitElements(sec, englishName, parent.isNull() || parent->getParent().isNull(), elements))
+				continue;
+			if (elements.eccentricity >= 1.0) closeOrbit = false;
+			posfunc = createOrbit(elements, parent.data(), userDataPtr);
 		}
 
 		if (funcName=="sun_special")
@@ -873,7 +731,7 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		}
 
 		// Create the Solar System body and add it to the list
-		QString type = pd.value(secname+"/type").toString();		
+		QString type = sec.value("type").toString();		
 		PlanetP p;
 		// New class objects, named "plutino", "cubewano", "dwarf planet", "SDO", "OCO", has properties
 		// similar to asteroids and we should calculate their positions like for asteroids. Dwarf planets
@@ -881,38 +739,38 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		if ((type == "asteroid" || type == "dwarf planet" || type == "cubewano" || type == "plutino" || type == "scattered disc object" || type == "Oort cloud object") && !englishName.contains("Pluto"))
 		{
 			p = PlanetP(new MinorPlanet(englishName,
-						    pd.value(secname+"/lighting").toBool(),
-						    pd.value(secname+"/radius").toDouble()/AU,
-						    pd.value(secname+"/oblateness", 0.0).toDouble(),
-						    StelUtils::strToVec3f(pd.value(secname+"/color").toString()),
-						    pd.value(secname+"/albedo").toFloat(),
-						    pd.value(secname+"/tex_map").toString(),
+						    sec.value("lighting").toBool(),
+						    sec.value("radius").toDouble()/AU,
+						    sec.value("oblateness", 0.0).toDouble(),
+						    StelUtils::strToVec3f(sec.value("color").toString()),
+						    sec.value("albedo").toFloat(),
+						    sec.value("tex_map").toString(),
 						    posfunc,
 						    userDataPtr,
 						    osculatingFunc,
 						    closeOrbit,
-						    pd.value(secname+"/hidden", 0).toBool(),						    
+						    sec.value("hidden", 0).toBool(),						    
 						    type));
 
 			QSharedPointer<MinorPlanet> mp =  p.dynamicCast<MinorPlanet>();
 
 			//Number
-			int minorPlanetNumber = pd.value(secname+"/minor_planet_number", 0).toInt();
+			int minorPlanetNumber = sec.value("minor_planet_number", 0).toInt();
 			if (minorPlanetNumber)
 			{
 				mp->setMinorPlanetNumber(minorPlanetNumber);
 			}
 
 			//Provisional designation
-			QString provisionalDesignation = pd.value(secname+"/provisional_designation").toString();
+			QString provisionalDesignation = sec.value("provisional_designation").toString();
 			if (!provisionalDesignation.isEmpty())
 			{
 				mp->setProvisionalDesignation(provisionalDesignation);
 			}
 
 			//H-G magnitude system
-			double magnitude = pd.value(secname+"/absolute_magnitude", -99).toDouble();
-			double slope = pd.value(secname+"/slope_parameter", 0.15).toDouble();
+			double magnitude = sec.value("absolute_magnitude", -99).toDouble();
+			double slope = sec.value("slope_parameter", 0.15).toDouble();
 			if (magnitude > -99)
 			{
 				if (slope >= 0 && slope <= 1)
@@ -925,34 +783,34 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 				}
 			}
 
-			mp->setSemiMajorAxis(pd.value(secname+"/orbit_SemiMajorAxis", 0).toDouble());
+			mp->setSemiMajorAxis(sec.value("orbit_SemiMajorAxis", 0).toDouble());
 
 		}
 		else if (type == "comet")
 		{
 			p = PlanetP(new Comet(englishName,
-			               pd.value(secname+"/lighting").toBool(),
-			               pd.value(secname+"/radius").toDouble()/AU,
-			               pd.value(secname+"/oblateness", 0.0).toDouble(),
-			               StelUtils::strToVec3f(pd.value(secname+"/color").toString()),
-			               pd.value(secname+"/albedo").toFloat(),
-			               pd.value(secname+"/tex_map").toString(),
+			               sec.value("lighting").toBool(),
+			               sec.value("radius").toDouble()/AU,
+			               sec.value("oblateness", 0.0).toDouble(),
+			               StelUtils::strToVec3f(sec.value("color").toString()),
+			               sec.value("albedo").toFloat(),
+			               sec.value("tex_map").toString(),
 			               posfunc,
 			               userDataPtr,
 			               osculatingFunc,
 			               closeOrbit,
-						   pd.value(secname+"/hidden", 0).toBool(),
+						   sec.value("hidden", 0).toBool(),
 						   type,
-						   pd.value(secname+"/dust_widthfactor", 1.5f).toFloat(),
-						   pd.value(secname+"/dust_lengthfactor", 0.4f).toFloat(),
-						   pd.value(secname+"/dust_brightnessfactor", 1.5f).toFloat()
+						   sec.value("dust_widthfactor", 1.5f).toFloat(),
+						   sec.value("dust_lengthfactor", 0.4f).toFloat(),
+						   sec.value("dust_brightnessfactor", 1.5f).toFloat()
 						  ));
 
 			QSharedPointer<Comet> mp =  p.dynamicCast<Comet>();
 
 			//g,k magnitude system
-			double magnitude = pd.value(secname+"/absolute_magnitude", -99).toDouble();
-			double slope = pd.value(secname+"/slope_parameter", 4.0).toDouble();
+			double magnitude = sec.value("absolute_magnitude", -99).toDouble();
+			double slope = sec.value("slope_parameter", 4.0).toDouble();
 			if (magnitude > -99)
 			{
 				if (slope >= 0 && slope <= 20)
@@ -965,8 +823,8 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 				}
 			}
 
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity",0.0).toDouble();
-			const double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
+			const double eccentricity = sec.value("orbit_Eccentricity",0.0).toDouble();
+			const double pericenterDistance = sec.value("orbit_PericenterDistance",-1e100).toDouble();
 			if (eccentricity<1 && pericenterDistance>0)
 			{
 				mp->setSemiMajorAxis(pericenterDistance / (1.0-eccentricity));
@@ -979,20 +837,20 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 			// Details: https://bugs.launchpad.net/stellarium/+bug/1335609
 			QString normalMapName = englishName.toLower().append("_normals.png");
 			p = PlanetP(new Planet(englishName,
-					       pd.value(secname+"/lighting").toBool(),
-					       pd.value(secname+"/radius").toDouble()/AU,
-					       pd.value(secname+"/oblateness", 0.0).toDouble(),
-					       StelUtils::strToVec3f(pd.value(secname+"/color").toString()),
-					       pd.value(secname+"/albedo").toFloat(),
-					       pd.value(secname+"/tex_map").toString(),
-					       pd.value(secname+"/normals_map", normalMapName).toString(),
+					       sec.value("lighting").toBool(),
+					       sec.value("radius").toDouble()/AU,
+					       sec.value("oblateness", 0.0).toDouble(),
+					       StelUtils::strToVec3f(sec.value("color").toString()),
+					       sec.value("albedo").toFloat(),
+					       sec.value("tex_map").toString(),
+					       sec.value("normals_map", normalMapName).toString(),
 					       posfunc,
 					       userDataPtr,
 					       osculatingFunc,
 					       closeOrbit,
-					       pd.value(secname+"/hidden", 0).toBool(),
-					       pd.value(secname+"/atmosphere", false).toBool(),
-					       pd.value(secname+"/halo", 0).toBool(),
+					       sec.value("hidden", 0).toBool(),
+					       sec.value("atmosphere", false).toBool(),
+					       sec.value("halo", 0).toBool(),
 					       type));
 		}
 
@@ -1006,46 +864,14 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		if (secname=="sun") sun = p;
 		if (secname=="moon") moon = p;
 
-		double rotObliquity = pd.value(secname+"/rot_obliquity",0.).toDouble()*(M_PI/180.0);
-		double rotAscNode = pd.value(secname+"/rot_equator_ascending_node",0.).toDouble()*(M_PI/180.0);
-
-		// Use more common planet North pole data if available
-		// NB: N pole as defined by IAU (NOT right hand rotation rule)
-		// NB: J2000 epoch
-		double J2000NPoleRA = pd.value(secname+"/rot_pole_ra", 0.).toDouble()*M_PI/180.;
-		double J2000NPoleDE = pd.value(secname+"/rot_pole_de", 0.).toDouble()*M_PI/180.;
-
-		if(J2000NPoleRA || J2000NPoleDE)
-		{
-			Vec3d J2000NPole;
-			StelUtils::spheToRect(J2000NPoleRA,J2000NPoleDE,J2000NPole);
-
-			Vec3d vsop87Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(J2000NPole));
-
-			double ra, de;
-			StelUtils::rectToSphe(&ra, &de, vsop87Pole);
-
-			rotObliquity = (M_PI_2 - de);
-			rotAscNode = (ra + M_PI_2);
-
-			// qDebug() << "\tCalculated rotational obliquity: " << rotObliquity*180./M_PI << endl;
-			// qDebug() << "\tCalculated rotational ascending node: " << rotAscNode*180./M_PI << endl;
-		}
-
-		p->setRotationElements(
-			pd.value(secname+"/rot_periode", pd.value(secname+"/orbit_Period", 24.).toDouble()).toDouble()/24.,
-			pd.value(secname+"/rot_rotation_offset",0.).toDouble(),
-			pd.value(secname+"/rot_epoch", J2000).toDouble(),
-			rotObliquity,
-			rotAscNode,
-			pd.value(secname+"/rot_precession_rate",0.).toDouble()*M_PI/(180*36525),
-			pd.value(secname+"/orbit_visualization_period",0.).toDouble());
-
+		RotationElements re;
+		SolarSystemCatalog::readRotationElements(sec, re);
+		p->setRotationElements(re.period, re.offset, re.epoch, re.obliquity, re.ascendingNode, re.precessionRate, re.siderealPeriod);
 
-		if (pd.value(secname+"/rings", 0).toBool()) {
-			const double rMin = pd.value(secname+"/ring_inner_size").toDouble()/AU;
-			const double rMax = pd.value(secname+"/ring_outer_size").toDouble()/AU;
-			Ring *r = new Ring(rMin,rMax,pd.value(secname+"/tex_ring").toString());
+		if (sec.value("rings", 0).toBool()) {
+			const double rMin = sec.value("ring_inner_size").toDouble()/AU;
+			const double rMax = sec.value("ring_outer_size").toDouble()/AU;
+			Ring *r = new Ring(rMin,rMax,sec.value("tex_ring").toString());
 			p->setRings(r);
 		}
 
@@ -1053,6 +879,8 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		readOk++;
 	}
 
+	createMinorBodies(catalog);
+
 	if (systemPlanets.isEmpty())
 	{
 		qWarning() << "No Solar System objects loaded from" << QDir::toNativeSeparators(filePath);
@@ -1070,32 +898,318 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	return true;
 }
 
-// Compute the position for every elements of the solar system.
-// The order is not important since the position is computed relatively to the mother body
-void SolarSystem::computePositions(double dateJDE, const Vec3d& observerPos)
-{
-	if (flagLightTravelTime)
+posFuncType SolarSystem::createOrbit(const SolarSystemCatalog::OrbitElements& elements, const Planet* parent, void*& userDataPtr)
+{
+	// when the parent is the sun use ecliptic rather than sun equator:
+	const bool satellite = parent && parent->getParent();
+	const double parentRotObliquity = satellite ? parent->getRotObliquity(2451545.0) : 0.0;
+	const double parent_rot_asc_node = satellite ? parent->getRotAscendingnode() : 0.0;
+	double parent_rot_j2000_longitude = 0.0;
+	if (satellite) {
+		const double c_obl = cos(parentRotObliquity);
+		const double s_obl = sin(parentRotObliquity);
+		const double c_nod = cos(parent_rot_asc_node);
+		const double s_nod = sin(parent_rot_asc_node);
+		const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
+		const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
+		const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
+		const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
+		Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
+		J2000NodeOrigin.normalize();
+		parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
+	}
+
+	if (elements.comet)
+	{
+		CometOrbit *orb = new CometOrbit(elements.pericenterDistance,
+						 elements.eccentricity,
+						 elements.inclination,
+						 elements.ascendingNode,
+						 elements.argOfPericenter,
+						 elements.timeAtPericenter,
+						 elements.orbitGoodDays,
+						 elements.meanMotion,
+						 parentRotObliquity,
+						 parent_rot_asc_node,
+						 parent_rot_j2000_longitude);
+		orbits.push_back(orb);
+		userDataPtr = orb;
+		return &cometOrbitPosFunc;
+	}
+
+	// Create an elliptical orbit
+	EllipticalOrbit *orb = new EllipticalOrbit(elements.pericenterDistance,
+						   elements.eccentricity,
+						   elements.inclination,
+						   elements.ascendingNode,
+						   elements.argOfPericenter,
+						   elements.meanAnomaly,
+						   elements.period,
+						   elements.epoch,
+						   parentRotObliquity,
+						   parent_rot_asc_node,
+						   parent_rot_j2000_longitude);
+	orbits.push_back(orb);
+	userDataPtr = orb;
+	return &ellipticalOrbitPosFunc;
+}
+
+void SolarSystem::createMinorBodies(const SolarSystemCatalog& catalog)
+{
+	const QVector<SolarSystemCatalog::MinorBody>& bodies = catalog.getMinorBodies();
+	if (bodies.isEmpty())
+		return;
+	if (sun.isNull())
 	{
-		foreach (PlanetP p, systemPlanets)
+		qWarning() << "ERROR : can't find parent solar system body for" << bodies.size() << "minor bodies";
+		return;
+	}
+
+	sun->satellites.reserve(sun->satellites.size()+bodies.size());
+	systemPlanets.reserve(systemPlanets.size()+bodies.size());
+	orbits.reserve(orbits.size()+bodies.size());
+	for (int i=0; i<bodies.size(); ++i)
+	{
+		const SolarSystemCatalog::MinorBody& b = bodies.at(i);
+		const QString englishName = catalog.getString(b.nameOffset, b.nameLength);
+		const QString texMapName = catalog.getString(b.texMapOffset, b.texMapLength);
+		const QString type = catalog.getString(b.typeOffset, b.typeLength);
+		const Vec3f color(b.color[0], b.color[1], b.color[2]);
+		void* userDataPtr = NULL;
+		const posFuncType posfunc = createOrbit(b.orbit, NULL, userDataPtr);
+
+		PlanetP p;
+		if (b.flags & SolarSystemCatalog::MinorBodyComet)
 		{
-			p->computePositionWithoutOrbits(dateJDE);
+			QSharedPointer<Comet> comet(new Comet(englishName,
+							      b.flags & SolarSystemCatalog::MinorBodyLighting,
+							      b.radius,
+							      b.oblateness,
+							      color,
+							      b.albedo,
+							      texMapName,
+							      posfunc,
+							      userDataPtr,
+							      NULL,
+							      b.flags & SolarSystemCatalog::MinorBodyCloseOrbit,
+							      b.flags & SolarSystemCatalog::MinorBodyHidden,
+							      type,
+							      b.dustWidthFactor,
+							      b.dustLengthFactor,
+							      b.dustBrightnessFactor));
+			if (b.absoluteMagnitude > -99)
+				comet->setAbsoluteMagnitudeAndSlope(b.absoluteMagnitude, b.slope);
+			if (b.flags & SolarSystemCatalog::MinorBodySemiMajorAxis)
+				comet->setSemiMajorAxis(b.semiMajorAxis);
+			p = comet;
 		}
-		foreach (PlanetP p, systemPlanets)
+		else
 		{
-			const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
-			p->computePosition(dateJDE-light_speed_correction);
+			QSharedPointer<MinorPlanet> mp(new MinorPlanet(englishName,
+								       b.flags & SolarSystemCatalog::MinorBodyLighting,
+								       b.radius,
+								       b.oblateness,
+								       color,
+								       b.albedo,
+								       texMapName,
+								       posfunc,
+								       userDataPtr,
+								       NULL,
+								       b.flags & SolarSystemCatalog::MinorBodyCloseOrbit,
+								       b.flags & SolarSystemCatalog::MinorBodyHidden,
+								       type));
+			if (b.minorPlanetNumber)
+				mp->setMinorPlanetNumber(b.minorPlanetNumber);
+			if (b.designationLength)
+				mp->setProvisionalDesignation(catalog.getString(b.designationOffset, b.designationLength));
+			if (b.absoluteMagnitude > -99)
+				mp->setAbsoluteMagnitudeAndSlope(b.absoluteMagnitude, b.slope);
+			mp->setSemiMajorAxis(b.semiMajorAxis);
+			p = mp;
 		}
+
+		sun->satellites.append(p);
+		p->parent = sun;
+		const RotationElements& re = b.rotation;
+		p->setRotationElements(re.period, re.offset, re.epoch, re.obliquity, re.ascendingNode, re.precessionRate, re.siderealPeriod);
+		systemPlanets.push_back(p);
+	}
+}
+
+//! A contiguous range of SolarSystem::parallelPlanets, computed by one worker thread.
+struct PlanetPositionJob
+{
+	const QList<PlanetP>* planets;
+	const double* lightTimes;
+	int begin;
+	int end;
+	double dateJDE;
+	bool withOrbits;
+};
+
+static void runPlanetPositionJob(PlanetPositionJob* job)
+{
+	for (int i=job->begin;i<job->end;++i)
+	{
+		const PlanetP& p = job->planets->at(i);
+		const double dateJDE = job->lightTimes ? job->dateJDE-job->lightTimes[i] : job->dateJDE;
+		if (job->withOrbits)
+			p->computePosition(dateJDE);
+		else
+			p->computePositionWithoutOrbits(dateJDE);
 	}
+}
+
+void SolarSystem::computePlanetPositions(const QList<PlanetP>& planets, const double* lightTimes,
+					 double dateJDE, bool withOrbits, bool parallel)
+{
+	// Below this, the overhead of the threads is bigger than the gain
+	static const int minPlanetsPerJob = 64;
+	const int nbJobs = parallel ? qMin(planets.size()/minPlanetsPerJob, 4*QThreadPool::globalInstance()->maxThreadCount()) : 1;
+	if (nbJobs<=1)
+	{
+		PlanetPositionJob job = {&planets, lightTimes, 0, planets.size(), dateJDE, withOrbits};
+		runPlanetPositionJob(&job);
+		return;
+	}
+
+	QVector<PlanetPositionJob> jobs(nbJobs);
+	for (int j=0;j<nbJobs;++j)
+	{
+		PlanetPositionJob& job = jobs[j];
+		job.planets = &planets;
+		job.lightTimes = lightTimes;
+		job.begin = planets.size()*j/nbJobs;
+		job.end = planets.size()*(j+1)/nbJobs;
+		job.dateJDE = dateJDE;
+		job.withOrbits = withOrbits;
+	}
+	QFutureSynchronizer<void> synchronizer;
+	for (int j=0;j<nbJobs;++j)
+		synchronizer.addFuture(QtConcurrent::run(runPlanetPositionJob, &jobs[j]));
+	synchronizer.waitForFinished();
+}
+
+//! A part of the orbits of SolarSystem::keplerPropagator, computed by one worker thread.
+struct KeplerPropagationJob
+{
+	KeplerPropagator* propagator;
+	const double* lightTimes;
+	double dateJDE;
+	int part;
+	int nbParts;
+};
+
+static void runKeplerPropagationJob(KeplerPropagationJob* job)
+{
+	job->propagator->compute(job->dateJDE, job->lightTimes, job->part, job->nbParts);
+}
+
+void SolarSystem::propagatePlanetPositions(const double* lightTimes, double dateJDE, bool withOrbits, bool parallel)
+{
+	if (propagatedPlanets.isEmpty())
+		return;
+
+	// The orbits are much cheaper to compute than in computePlanetPositions()
+	static const int minOrbitsPerJob = 1024;
+	const int nbJobs = parallel ? qMin(propagatedPlanets.size()/minOrbitsPerJob, 4*QThreadPool::globalInstance()->maxThreadCount()) : 1;
+	if (nbJobs<=1)
+		keplerPropagator.compute(dateJDE, lightTimes);
 	else
 	{
-		foreach (PlanetP p, systemPlanets)
+		QVector<KeplerPropagationJob> jobs(nbJobs);
+		QFutureSynchronizer<void> synchronizer;
+		for (int j=0;j<nbJobs;++j)
 		{
-			p->computePosition(dateJDE);
+			KeplerPropagationJob& job = jobs[j];
+			job.propagator = &keplerPropagator;
+			job.lightTimes = lightTimes;
+			job.dateJDE = dateJDE;
+			job.part = j;
+			job.nbParts = nbJobs;
+			synchronizer.addFuture(QtConcurrent::run(runKeplerPropagationJob, &job));
+		}
+		synchronizer.waitForFinished();
+	}
+
+	// The bodies whose orbit is drawn must also update the points of their orbit
+	QList<PlanetP> orbitPlanets;
+	QVector<double> orbitLightTimes;
+	for (int i=0;i<propagatedPlanets.size();++i)
+	{
+		const PlanetP& p = propagatedPlanets.at(i);
+		if (withOrbits && p->orbitFader.getInterstate()>0.000001)
+		{
+			orbitPlanets.append(p);
+			if (lightTimes)
+				orbitLightTimes.append(lightTimes[i]);
+			continue;
 		}
+		p->eclipticPos = keplerPropagator.getPosition(i);
+		p->lastJDE = lightTimes ? dateJDE-lightTimes[i] : dateJDE;
+		if (p->coordFunc==&cometOrbitPosFunc)
+			static_cast<CometOrbit*>(p->userDataPtr)->setVelocity(keplerPropagator.getVelocity(i));
+	}
+	if (!orbitPlanets.isEmpty())
+		computePlanetPositions(orbitPlanets, lightTimes ? orbitLightTimes.constData() : NULL, dateJDE, true, parallel);
+}
+
+// Compute the position for every elements of the solar system.
+// The planets are computed before their satellites, see Planet::computePosition().
+// The minor bodies on Kepler orbits don't depend on any other body and are computed in worker threads.
+void SolarSystem::computePositions(double dateJDE, const Vec3d& observerPos)
+{
+	StelProfileScope profileScope("SolarSystem::computePositions");
+	const bool parallel = flagParallelPositions && QThreadPool::globalInstance()->maxThreadCount()>1;
+	if (flagLightTravelTime)
+	{
+		if (dateJDE!=lightTimeJDE || observerPos!=lightTimeObserverPos || serialLightTimes.isEmpty())
+		{
+			computePlanetPositions(serialPlanets, NULL, dateJDE, false, false);
+			computePlanetPositions(parallelPlanets, NULL, dateJDE, false, parallel);
+			propagatePlanetPositions(NULL, dateJDE, false, parallel);
+			static const double lightTimePerAU = AU / (SPEED_OF_LIGHT * 86400);
+			serialLightTimes.resize(serialPlanets.size());
+			for (int i=0;i<serialPlanets.size();++i)
+				serialLightTimes[i] = (serialPlanets.at(i)->getHeliocentricEclipticPos()-observerPos).length() * lightTimePerAU;
+			parallelLightTimes.resize(parallelPlanets.size());
+			for (int i=0;i<parallelPlanets.size();++i)
+				parallelLightTimes[i] = (parallelPlanets.at(i)->getHeliocentricEclipticPos()-observerPos).length() * lightTimePerAU;
+			propagatedLightTimes.resize(propagatedPlanets.size());
+			for (int i=0;i<propagatedPlanets.size();++i)
+				propagatedLightTimes[i] = (propagatedPlanets.at(i)->getHeliocentricEclipticPos()-observerPos).length() * lightTimePerAU;
+			lightTimeJDE = dateJDE;
+			lightTimeObserverPos = observerPos;
+		}
+		computePlanetPositions(serialPlanets, serialLightTimes.constData(), dateJDE, true, false);
+		computePlanetPositions(parallelPlanets, parallelLightTimes.constData(), dateJDE, true, parallel);
+		propagatePlanetPositions(propagatedLightTimes.constData(), dateJDE, true, parallel);
+	}
+	else
+	{
+		computePlanetPositions(serialPlanets, NULL, dateJDE, true, false);
+		computePlanetPositions(parallelPlanets, NULL, dateJDE, true, parallel);
+		propagatePlanetPositions(NULL, dateJDE, true, parallel);
 	}
 	computeTransMatrices(dateJDE, observerPos);
 }
 
+Vec3d SolarSystem::computeHeliocentricEclipticPos(const Planet* p, double dateJDE)
+{
+	Vec3d pos(0.);
+	for (;p && p->parent;p=p->parent.data())
+	{
+		Vec3d v;
+		// Don't let the comets update the velocity vector used by their tails
+		if (p->coordFunc==&cometOrbitPosFunc)
+			static_cast<CometOrbit*>(p->userDataPtr)->positionAtTimevInVSOP87Coordinates(dateJDE, v, false);
+		else
+			p->coordFunc(dateJDE, v, p->userDataPtr);
+		pos += v;
+	}
+	return pos;
+}
+
 // Compute the transformation matrix for every elements of the solar system.
 // The elements have to be ordered hierarchically, eg. it's important to compute earth before moon.
 void SolarSystem::computeTransMatrices(double dateJDE, const Vec3d& observerPos)
@@ -1492,6 +1606,8 @@ void SolarSystem::update(double deltaTime)
 		allTrails->update();
 	}
 
+	// The tails queued at the previous frame are rebuilt before the comets compute their colors
+	Comet::processTailUpdates();
 	foreach (PlanetP p, systemPlanets)
 	{
 		p->update((int)(deltaTime*1000));
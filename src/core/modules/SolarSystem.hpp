@@ -28,6 +28,8 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Planet.hpp"
+#include "KeplerPropagator.hpp"
+#include "SolarSystemCatalog.hpp"
 #include "StelGui.hpp"
 
 #include <QFont>
@@ -345,6 +347,18 @@ public slots:
 	//! calculation is used or not.
 	bool getFlagLightTravelTime(void) const {return flagLightTravelTime;}
 
+	//! Set whether the positions of the minor bodies are computed in worker threads.
+	//! The computed positions are the same in both modes.
+	void setFlagParallelPositions(bool b) {flagParallelPositions = b;}
+	//! Get whether the positions of the minor bodies are computed in worker threads.
+	bool getFlagParallelPositions(void) const {return flagParallelPositions;}
+
+	//! Set whether the positions of the minor bodies are computed all together by a KeplerPropagator,
+	//! instead of one by one by their orbit. The positions match within KeplerPropagator::Tolerance.
+	void setFlagKeplerPropagator(bool b) {flagKeplerPropagator = b; updatePositionGroups();}
+	//! Get whether the positions of the minor bodies are computed by a KeplerPropagator.
+	bool getFlagKeplerPropagator(void) const {return flagKeplerPropagator;}
+
 	//! Set planet names font size.
 	//! @return font size
 	void setFontSize(float newFontSize);
@@ -769,6 +783,11 @@ public:
 	//! Reload the planets
 	void reloadPlanets();
 
+	//! Load the bodies of the given Solar System file, without the cache. Unlike init(), which loads
+	//! data/ssystem.ini, it needs no other module, e.g. to test the computation of the positions.
+	//! @return false if the file could not be loaded.
+	bool loadSolarSystemFile(const QString& filePath);
+
 	//! Determines relative amount of sun visible from the observer's position.
 	double getEclipseFactor(const StelCore *core) const;
 
@@ -777,6 +796,11 @@ public:
 	//! @param dateJDE the Julian Day in JDE (Ephemeris Time or equivalent)	
 	void computePositions(double dateJDE, const Vec3d& observerPos = Vec3d(0.));
 
+	//! Compute the heliocentric ecliptic position of a body, adding the positions of its parents at the same date.
+	//! Unlike Planet::computePosition(), the state of the bodies is not changed, so it can be called from any thread.
+	//! @param dateJDE the Julian Day in JDE (Ephemeris Time or equivalent)
+	static Vec3d computeHeliocentricEclipticPos(const Planet* p, double dateJDE);
+
 	//! Get the list of all the bodies of the solar system.	
 	const QList<PlanetP>& getAllPlanets() const {return systemPlanets;}	
 
@@ -807,6 +831,22 @@ private:
 	//! observerPos is needed for light travel time computation.
 	void computeTransMatrices(double dateJDE, const Vec3d& observerPos = Vec3d(0.));
 
+	//! Split systemPlanets into serialPlanets, parallelPlanets and propagatedPlanets.
+	//! Must be called whenever systemPlanets is modified.
+	void updatePositionGroups();
+
+	//! Compute the positions of a list of planets.
+	//! @param planets the planets, parents before their satellites
+	//! @param lightTimes light time correction in days for each planet, or NULL
+	//! @param withOrbits whether to call Planet::computePosition() or Planet::computePositionWithoutOrbits()
+	//! @param parallel whether to distribute the planets over worker threads.
+	//! This is only allowed for planets which don't depend on each other.
+	static void computePlanetPositions(const QList<PlanetP>& planets, const double* lightTimes,
+					   double dateJDE, bool withOrbits, bool parallel);
+	//! Compute the positions of propagatedPlanets with the keplerPropagator, same parameters as computePlanetPositions().
+	//! The bodies whose orbit is drawn are computed one by one, to update their orbit.
+	void propagatePlanetPositions(const double* lightTimes, double dateJDE, bool withOrbits, bool parallel);
+
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(const StelCore* core);
 
@@ -819,6 +859,14 @@ private:
 	//! Load planet data from the given file
 	bool loadPlanets(const QString& filePath);
 
+	//! Create the orbit of a body with coord_func ell_orbit or comet_orbit, and add it to orbits.
+	//! @param parent the parent body, or NULL for the Sun
+	//! @param userDataPtr receives the orbit, to be passed to the returned position function
+	posFuncType createOrbit(const SolarSystemCatalog::OrbitElements& elements, const Planet* parent, void*& userDataPtr);
+
+	//! Create the minor bodies of a catalog as satellites of the Sun, which must be loaded.
+	void createMinorBodies(const SolarSystemCatalog& catalog);
+
 	void recreateTrails();
 
 	//! Set flag who enable display a permanent orbits for objects or not
@@ -852,9 +900,32 @@ private:
 	//! List of all the bodies of the solar system.
 	QList<PlanetP> systemPlanets;
 
+	//! The bodies of systemPlanets whose position is computed in the main thread, in the same order.
+	QList<PlanetP> serialPlanets;
+	//! The bodies of systemPlanets whose position can be computed in worker threads: minor
+	//! bodies orbiting the Sun on Kepler orbits, without satellites. The other position
+	//! functions (VSOP87, ELP82B, ...) cache their results in static variables.
+	QList<PlanetP> parallelPlanets;
+	//! When flagKeplerPropagator is set, the bodies which would be in parallelPlanets and whose
+	//! orbit is supported by the keplerPropagator, in the order of the orbits in the propagator.
+	QList<PlanetP> propagatedPlanets;
+	KeplerPropagator keplerPropagator;
+	//! Light time corrections of serialPlanets, parallelPlanets and propagatedPlanets in days, computed
+	//! for lightTimeJDE and lightTimeObserverPos. They are reused as long as neither
+	//! the date nor the observer changes, e.g. while the time is paused.
+	QVector<double> serialLightTimes;
+	QVector<double> parallelLightTimes;
+	QVector<double> propagatedLightTimes;
+	double lightTimeJDE;
+	Vec3d lightTimeObserverPos;
+
 	// Master settings
 	bool flagOrbits;
 	bool flagLightTravelTime;
+	bool flagParallelPositions;
+	bool flagKeplerPropagator;
+	//! Whether ssystem.ini is read from its binary cache
+	bool flagSolarSystemCache;
 
 	//! The selection pointer texture.
 	StelTextureSP texPointer;
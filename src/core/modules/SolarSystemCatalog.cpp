@@ -0,0 +1,663 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SolarSystemCatalog.hpp"
+#include "StelCore.hpp"
+#include "StelFileMgr.hpp"
+#include "StelUtils.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureSynchronizer>
+#include <QMap>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <cstring>
+
+//! A part of an ini file, parsed by one worker thread.
+//! The keys found before the first section header of the part belong to the current section of the
+//! previous part, they are put in a first section with a null name.
+struct IniChunkJob
+{
+	const char* data;
+	int size;
+	QVector<SolarSystemCatalog::Section> sections;
+};
+
+// Same rules as readStelIniFile(), without the regular expressions
+static void runIniChunkJob(IniChunkJob* job)
+{
+	const QString text = QString::fromUtf8(job->data, job->size);
+	const QChar* s = text.constData();
+	const int size = text.size();
+	int current = -1;
+	for (int begin=0; begin<size;)
+	{
+		int end = begin;
+		while (end<size && s[end]!='\n' && s[end]!='\r')
+			++end;
+		QString l = QString::fromRawData(s+begin, end-begin);
+		begin = end+1;
+
+		const int comment = l.indexOf('#');
+		if (comment>=0)
+			l.truncate(comment);
+		l = l.trimmed();
+		if (l.isEmpty())
+			continue;
+
+		if (l.size()>=3 && l.startsWith('[') && l.endsWith(']'))
+		{
+			SolarSystemCatalog::Section sec;
+			sec.name = l.mid(1, l.size()-2);
+			job->sections.append(sec);
+			current = job->sections.size()-1;
+			continue;
+		}
+
+		const int eq = l.indexOf('=');
+		if (eq<=0)
+			continue;
+		int valueBegin = eq+1;
+		while (valueBegin<l.size() && l.at(valueBegin).isSpace())
+			++valueBegin;
+		if (valueBegin==l.size())
+			continue;
+		int keyEnd = eq;
+		while (keyEnd>0 && l.at(keyEnd-1).isSpace())
+			--keyEnd;
+		if (current<0)
+		{
+			job->sections.append(SolarSystemCatalog::Section());
+			current = 0;
+		}
+		job->sections[current].values.insert(l.left(keyEnd), l.mid(valueBegin));
+	}
+}
+
+QVector<SolarSystemCatalog::Section> SolarSystemCatalog::parseIni(const QByteArray& data)
+{
+	// Below this, the overhead of the threads is bigger than the gain
+	static const int minChunkSize = 256*1024;
+	const int nbChunks = qMax(1, qMin(data.size()/minChunkSize, 4*QThreadPool::globalInstance()->maxThreadCount()));
+
+	// Cut the text before section headers, '\n' and '[' can't be in the middle of an UTF-8 sequence
+	QVector<IniChunkJob> jobs;
+	int begin = 0;
+	for (int j=1; j<=nbChunks && begin<data.size(); ++j)
+	{
+		int end = data.size();
+		if (j<nbChunks)
+		{
+			end = data.indexOf("\n[", qMax(begin, (int)((qint64)data.size()*j/nbChunks)));
+			end = end<0 ? data.size() : end+1;
+		}
+		IniChunkJob job;
+		job.data = data.constData()+begin;
+		job.size = end-begin;
+		jobs.append(job);
+		begin = end;
+	}
+	if (jobs.size()==1)
+		runIniChunkJob(&jobs[0]);
+	else
+	{
+		QFutureSynchronizer<void> synchronizer;
+		for (int j=0; j<jobs.size(); ++j)
+			synchronizer.addFuture(QtConcurrent::run(runIniChunkJob, &jobs[j]));
+		synchronizer.waitForFinished();
+	}
+
+	// Merge the sections appearing several times, the last value of a key wins like in QSettings
+	QVector<Section> merged;
+	QMap<QString, int> index;
+	int current = -1;
+	for (int j=0; j<jobs.size(); ++j)
+	{
+		const QVector<Section>& chunkSections = jobs.at(j).sections;
+		for (int i=0; i<chunkSections.size(); ++i)
+		{
+			const Section& sec = chunkSections.at(i);
+			if (!sec.name.isNull())
+			{
+				current = index.value(sec.name, -1);
+				if (current<0)
+				{
+					current = merged.size();
+					index.insert(sec.name, current);
+					merged.append(sec);
+					continue;
+				}
+			}
+			// Keys of the previous chunk's section, or of a section seen before. Keys outside of any section are ignored.
+			if (current<0)
+				continue;
+			for (QHash<QString, QString>::const_iterator it=sec.values.constBegin(); it!=sec.values.constEnd(); ++it)
+				merged[current].values.insert(it.key(), it.value());
+		}
+	}
+
+	QVector<Section> result;
+	result.reserve(merged.size());
+	for (QMap<QString, int>::const_iterator it=index.constBegin(); it!=index.constEnd(); ++it)
+		result.append(merged.at(it.value()));
+	return result;
+}
+
+bool SolarSystemCatalog::readOrbitElements(const Section& sec, const QString& englishName, bool heliocentric, OrbitElements& elements)
+{
+	memset(&elements, 0, sizeof(elements));
+	if (sec.value("coord_func").toString()=="ell_orbit")
+	{
+		// Read the orbital elements
+		const double epoch = sec.value("orbit_Epoch",J2000).toDouble();
+		const double eccentricity = sec.value("orbit_Eccentricity").toDouble();
+		double pericenterDistance = sec.value("orbit_PericenterDistance",-1e100).toDouble();
+		double semi_major_axis;
+		if (pericenterDistance <= 0.0) {
+			semi_major_axis = sec.value("orbit_SemiMajorAxis",-1e100).toDouble();
+			if (semi_major_axis <= -1e100) {
+				qDebug() << "ERROR: " << englishName
+					<< ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
+				return false;
+			} else {
+				semi_major_axis /= AU;
+				Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
+				pericenterDistance = semi_major_axis * (1.0-eccentricity);
+			}
+		} else {
+			pericenterDistance /= AU;
+			semi_major_axis = (eccentricity == 1.0)
+							? 0.0 // parabolic orbits have no semi_major_axis
+							: pericenterDistance / (1.0-eccentricity);
+		}
+		double meanMotion = sec.value("orbit_MeanMotion",-1e100).toDouble();
+		double period;
+		if (meanMotion <= -1e100) {
+			period = sec.value("orbit_Period",-1e100).toDouble();
+			if (period <= -1e100) {
+				meanMotion = (eccentricity == 1.0)
+							? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)
+							: (semi_major_axis > 0.0)
+							? 0.01720209895 / (semi_major_axis*std::sqrt(semi_major_axis))
+							: 0.01720209895 / (-semi_major_axis*std::sqrt(-semi_major_axis));
+				period = 2.0*M_PI/meanMotion;
+			} else {
+				meanMotion = 2.0*M_PI/period;
+			}
+		} else {
+			period = 2.0*M_PI/meanMotion;
+		}
+		const double inclination = sec.value("orbit_Inclination").toDouble()*(M_PI/180.0);
+		const double ascending_node = sec.value("orbit_AscendingNode").toDouble()*(M_PI/180.0);
+		double arg_of_pericenter = sec.value("orbit_ArgOfPericenter",-1e100).toDouble();
+		double long_of_pericenter;
+		if (arg_of_pericenter <= -1e100) {
+			long_of_pericenter = sec.value("orbit_LongOfPericenter").toDouble()*(M_PI/180.0);
+			arg_of_pericenter = long_of_pericenter - ascending_node;
+		} else {
+			arg_of_pericenter *= (M_PI/180.0);
+			long_of_pericenter = arg_of_pericenter + ascending_node;
+		}
+		double mean_anomaly = sec.value("orbit_MeanAnomaly",-1e100).toDouble();
+		double mean_longitude;
+		if (mean_anomaly <= -1e100) {
+			mean_longitude = sec.value("orbit_MeanLongitude").toDouble()*(M_PI/180.0);
+			mean_anomaly = mean_longitude - long_of_pericenter;
+		} else {
+			mean_anomaly *= (M_PI/180.0);
+			mean_longitude = mean_anomaly + long_of_pericenter;
+		}
+
+		elements.pericenterDistance = pericenterDistance;
+		elements.eccentricity = eccentricity;
+		elements.inclination = inclination;
+		elements.ascendingNode = ascending_node;
+		elements.argOfPericenter = arg_of_pericenter;
+		elements.meanAnomaly = mean_anomaly;
+		elements.period = period;
+		elements.epoch = epoch;
+		return true;
+	}
+
+	// comet_orbit
+	// orbit_PericenterDistance,orbit_SemiMajorAxis: given in AU
+	// orbit_MeanMotion: given in degrees/day
+	// orbit_Period: given in days
+	// orbit_TimeAtPericenter,orbit_Epoch: JD
+	// orbit_MeanAnomaly,orbit_Inclination,orbit_ArgOfPericenter,orbit_AscendingNode: given in degrees
+	const double eccentricity = sec.value("orbit_Eccentricity",0.0).toDouble();
+	double pericenterDistance = sec.value("orbit_PericenterDistance",-1e100).toDouble();
+	double semi_major_axis;
+	if (pericenterDistance <= 0.0) {
+		semi_major_axis = sec.value("orbit_SemiMajorAxis",-1e100).toDouble();
+		if (semi_major_axis <= -1e100) {
+			qWarning() << "ERROR: " << englishName
+				<< ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
+			return false;
+		} else {
+			Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
+			pericenterDistance = semi_major_axis * (1.0-eccentricity);
+		}
+	} else {
+		semi_major_axis = (eccentricity == 1.0)
+						? 0.0 // parabolic orbits have no semi_major_axis
+						: pericenterDistance / (1.0-eccentricity);
+	}
+	double meanMotion = sec.value("orbit_MeanMotion",-1e100).toDouble();
+	if (meanMotion <= -1e100) {
+		const double period = sec.value("orbit_Period",-1e100).toDouble();
+		if (period <= -1e100) {
+			if (!heliocentric) {
+				qWarning() << "ERROR: " << englishName
+					<< ": when the parent body is not the sun, you must provide "
+					<< "either orbit_MeanMotion or orbit_Period";
+			} else {
+				// in case of parent=sun: use Gaussian gravitational constant
+				// for calculating meanMotion:
+				meanMotion = (eccentricity == 1.0)
+							? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)  // GZ: This is Heafner's W / dt
+							: 0.01720209895 / (fabs(semi_major_axis)*std::sqrt(fabs(semi_major_axis)));
+			}
+		} else {
+			meanMotion = 2.0*M_PI/period;
+		}
+	} else {
+		meanMotion *= (M_PI/180.0);
+	}
+	double time_at_pericenter = sec.value("orbit_TimeAtPericenter",-1e100).toDouble();
+	if (time_at_pericenter <= -1e100) {
+		const double epoch = sec.value("orbit_Epoch",-1e100).toDouble();
+		double mean_anomaly = sec.value("orbit_MeanAnomaly",-1e100).toDouble();
+		if (epoch <= -1e100 || mean_anomaly <= -1e100) {
+			qWarning() << "ERROR: " << englishName
+				<< ": when you do not provide orbit_TimeAtPericenter, you must provide both "
+				<< "orbit_Epoch and orbit_MeanAnomaly";
+			return false;
+		} else {
+			mean_anomaly *= (M_PI/180.0);
+			time_at_pericenter = epoch - mean_anomaly / meanMotion;
+		}
+	}
+
+	elements.comet = 1;
+	elements.pericenterDistance = pericenterDistance;
+	elements.eccentricity = eccentricity;
+	elements.inclination = sec.value("orbit_Inclination").toDouble()*(M_PI/180.0);
+	elements.ascendingNode = sec.value("orbit_AscendingNode").toDouble()*(M_PI/180.0);
+	elements.argOfPericenter = sec.value("orbit_ArgOfPericenter").toDouble()*(M_PI/180.0);
+	elements.timeAtPericenter = time_at_pericenter;
+	elements.orbitGoodDays = sec.value("orbit_good", 1000).toDouble();
+	elements.meanMotion = meanMotion;
+	return true;
+}
+
+void SolarSystemCatalog::readRotationElements(const Section& sec, RotationElements& elements)
+{
+	double rotObliquity = sec.value("rot_obliquity",0.).toDouble()*(M_PI/180.0);
+	double rotAscNode = sec.value("rot_equator_ascending_node",0.).toDouble()*(M_PI/180.0);
+
+	// Use more common planet North pole data if available
+	// NB: N pole as defined by IAU (NOT right hand rotation rule)
+	// NB: J2000 epoch
+	double J2000NPoleRA = sec.value("rot_pole_ra", 0.).toDouble()*M_PI/180.;
+	double J2000NPoleDE = sec.value("rot_pole_de", 0.).toDouble()*M_PI/180.;
+
+	if(J2000NPoleRA || J2000NPoleDE)
+	{
+		Vec3d J2000NPole;
+		StelUtils::spheToRect(J2000NPoleRA,J2000NPoleDE,J2000NPole);
+
+		Vec3d vsop87Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(J2000NPole));
+
+		double ra, de;
+		StelUtils::rectToSphe(&ra, &de, vsop87Pole);
+
+		rotObliquity = (M_PI_2 - de);
+		rotAscNode = (ra + M_PI_2);
+	}
+
+	elements.period = sec.value("rot_periode", sec.value("orbit_Period", 24.).toDouble()).toDouble()/24.;
+	elements.offset = sec.value("rot_rotation_offset",0.).toDouble();
+	elements.epoch = sec.value("rot_epoch", J2000).toDouble();
+	elements.obliquity = rotObliquity;
+	elements.ascendingNode = rotAscNode;
+	elements.precessionRate = sec.value("rot_precession_rate",0.).toDouble()*M_PI/(180*36525);
+	elements.siderealPeriod = sec.value("orbit_visualization_period",0.).toDouble();
+}
+
+static void appendString(QString& chars, const QString& s, quint32& offset, quint32& length)
+{
+	offset = chars.size();
+	length = s.size();
+	chars += s;
+}
+
+enum MinorBodyConversion
+{
+	NotMinorBody,		// kept as a section
+	MinorBodyConverted,
+	MinorBodyInvalid	// skipped, like SolarSystem::loadPlanets() skips the bodies without valid orbit
+};
+
+// Convert a section into a MinorBody if it can be created by SolarSystem::createMinorBodies(),
+// with the same values as the generic code of SolarSystem::loadPlanets().
+static MinorBodyConversion convertMinorBody(const SolarSystemCatalog::Section& sec, const QSet<QString>& parents,
+					    SolarSystemCatalog::MinorBody& body, QString& chars)
+{
+	const QString englishName = sec.value("name").toString().simplified();
+	const QString funcName = sec.value("coord_func").toString();
+	const QString type = sec.value("type").toString();
+	const bool comet = type=="comet";
+	const bool minorPlanet = (type == "asteroid" || type == "dwarf planet" || type == "cubewano" || type == "plutino" || type == "scattered disc object" || type == "Oort cloud object") && !englishName.contains("Pluto");
+	if ((!comet && !minorPlanet) || (funcName!="ell_orbit" && funcName!="comet_orbit")
+	    || sec.value("parent").toString()!="Sun" || parents.contains(englishName) || sec.value("rings", 0).toBool())
+		return NotMinorBody;
+
+	memset(static_cast<void*>(&body), 0, sizeof(body));
+	if (!SolarSystemCatalog::readOrbitElements(sec, englishName, true, body.orbit))
+		return MinorBodyInvalid;
+	SolarSystemCatalog::readRotationElements(sec, body.rotation);
+
+	body.radius = sec.value("radius").toDouble()/AU;
+	body.oblateness = sec.value("oblateness", 0.0).toDouble();
+	const Vec3f color = StelUtils::strToVec3f(sec.value("color").toString());
+	body.color[0] = color[0];
+	body.color[1] = color[1];
+	body.color[2] = color[2];
+	body.albedo = sec.value("albedo").toFloat();
+	if (sec.value("lighting").toBool())
+		body.flags |= SolarSystemCatalog::MinorBodyLighting;
+	if (sec.value("hidden", 0).toBool())
+		body.flags |= SolarSystemCatalog::MinorBodyHidden;
+	if (sec.value("closeOrbit", true).toBool() && body.orbit.eccentricity<1.0)
+		body.flags |= SolarSystemCatalog::MinorBodyCloseOrbit;
+	appendString(chars, englishName, body.nameOffset, body.nameLength);
+	appendString(chars, sec.value("tex_map").toString(), body.texMapOffset, body.texMapLength);
+	appendString(chars, type, body.typeOffset, body.typeLength);
+
+	body.absoluteMagnitude = sec.value("absolute_magnitude", -99).toDouble();
+	if (comet)
+	{
+		body.flags |= SolarSystemCatalog::MinorBodyComet;
+		//g,k magnitude system
+		body.slope = sec.value("slope_parameter", 4.0).toDouble();
+		if (body.slope < 0 || body.slope > 20)
+			body.slope = 4.0;
+		body.dustWidthFactor = sec.value("dust_widthfactor", 1.5f).toFloat();
+		body.dustLengthFactor = sec.value("dust_lengthfactor", 0.4f).toFloat();
+		body.dustBrightnessFactor = sec.value("dust_brightnessfactor", 1.5f).toFloat();
+		const double eccentricity = sec.value("orbit_Eccentricity",0.0).toDouble();
+		const double pericenterDistance = sec.value("orbit_PericenterDistance",-1e100).toDouble();
+		if (eccentricity<1 && pericenterDistance>0)
+		{
+			body.semiMajorAxis = pericenterDistance / (1.0-eccentricity);
+			body.flags |= SolarSystemCatalog::MinorBodySemiMajorAxis;
+		}
+	}
+	else
+	{
+		//H-G magnitude system
+		body.slope = sec.value("slope_parameter", 0.15).toDouble();
+		if (body.slope < 0 || body.slope > 1)
+			body.slope = 0.15;
+		body.minorPlanetNumber = sec.value("minor_planet_number", 0).toInt();
+		appendString(chars, sec.value("provisional_designation").toString(), body.designationOffset, body.designationLength);
+		body.semiMajorAxis = sec.value("orbit_SemiMajorAxis", 0).toDouble();
+		body.flags |= SolarSystemCatalog::MinorBodySemiMajorAxis;
+	}
+	return MinorBodyConverted;
+}
+
+//! A contiguous range of sections, converted by one worker thread.
+struct MinorBodyConvertJob
+{
+	const QVector<SolarSystemCatalog::Section>* sections;
+	const QSet<QString>* parents;
+	int begin;
+	int end;
+	QVector<SolarSystemCatalog::MinorBody> minorBodies;
+	QString chars;			// strings of minorBodies, the offsets start at 0
+	QVector<int> otherSections;	// index of the sections which are not minor bodies
+};
+
+static void runMinorBodyConvertJob(MinorBodyConvertJob* job)
+{
+	SolarSystemCatalog::MinorBody body;
+	for (int i=job->begin; i<job->end; ++i)
+	{
+		switch (convertMinorBody(job->sections->at(i), *job->parents, body, job->chars))
+		{
+			case MinorBodyConverted:
+				job->minorBodies.append(body);
+				break;
+			case NotMinorBody:
+				job->otherSections.append(i);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void SolarSystemCatalog::convert(const QVector<Section>& allSections)
+{
+	// The bodies with satellites stay in the generic code
+	QSet<QString> parents;
+	for (int i=0; i<allSections.size(); ++i)
+		parents.insert(allSections.at(i).value("parent").toString());
+
+	// Below this, the overhead of the threads is bigger than the gain
+	static const int minSectionsPerJob = 256;
+	const int nbJobs = qMax(1, qMin(allSections.size()/minSectionsPerJob, 4*QThreadPool::globalInstance()->maxThreadCount()));
+	QVector<MinorBodyConvertJob> jobs(nbJobs);
+	for (int j=0; j<nbJobs; ++j)
+	{
+		MinorBodyConvertJob& job = jobs[j];
+		job.sections = &allSections;
+		job.parents = &parents;
+		job.begin = allSections.size()*j/nbJobs;
+		job.end = allSections.size()*(j+1)/nbJobs;
+	}
+	if (nbJobs==1)
+		runMinorBodyConvertJob(&jobs[0]);
+	else
+	{
+		QFutureSynchronizer<void> synchronizer;
+		for (int j=0; j<nbJobs; ++j)
+			synchronizer.addFuture(QtConcurrent::run(runMinorBodyConvertJob, &jobs[j]));
+		synchronizer.waitForFinished();
+	}
+
+	sections.clear();
+	minorBodies.clear();
+	chars.clear();
+	for (int j=0; j<nbJobs; ++j)
+	{
+		const MinorBodyConvertJob& job = jobs.at(j);
+		const quint32 offset = chars.size();
+		for (int i=0; i<job.minorBodies.size(); ++i)
+		{
+			MinorBody body = job.minorBodies.at(i);
+			body.nameOffset += offset;
+			body.texMapOffset += offset;
+			body.typeOffset += offset;
+			body.designationOffset += offset;
+			minorBodies.append(body);
+		}
+		chars += job.chars;
+		for (int i=0; i<job.otherSections.size(); ++i)
+			sections.append(allSections.at(job.otherSections.at(i)));
+	}
+}
+
+// Layout of the binary cache: a header, the minor bodies, their strings as
+// UTF-16 characters, and the other sections serialized with QDataStream. It is
+// read with a memory mapping, so it uses the byte order and the alignment of
+// the machine.
+#define SSYSTEM_CACHE_VERSION 1
+static const char ssystemCacheMagic[8] = {'S','T','E','L','S','S','Y','S'};
+
+struct SolarSystemCacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrder;		// 0x01020304 written in the machine byte order
+	quint32 recordSize;		// sizeof(SolarSystemCatalog::MinorBody), checks the alignment
+	quint32 nbRecords;
+	quint32 nbChars;		// size of the strings table
+	quint32 sectionsSize;		// size of the serialized sections in bytes
+	char hash[20];			// SHA-1 of the ini file
+	quint32 reserved;
+};
+
+bool SolarSystemCatalog::load(const QString& filePath, bool useCache)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "ERROR while parsing" << QDir::toNativeSeparators(filePath);
+		return false;
+	}
+	const QByteArray data = file.readAll();
+	file.close();
+
+	QString cacheFilename;
+	QByteArray fileHash;
+	if (useCache)
+	{
+		fileHash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+		// One cache per file, the user's ssystem.ini and the installed one may be read one after the other
+		const QByteArray pathHash = QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+		cacheFilename = StelFileMgr::getCacheDir() + "/ssystem/" + QString::fromLatin1(pathHash.toHex()) + ".cache";
+		if (loadCache(cacheFilename, fileHash))
+			return true;
+	}
+
+	convert(parseIni(data));
+	if (useCache)
+		saveCache(cacheFilename, fileHash);
+	return true;
+}
+
+bool SolarSystemCatalog::loadCache(const QString& cacheFilename, const QByteArray& fileHash)
+{
+	QFile file(cacheFilename);
+	if (!file.open(QIODevice::ReadOnly) || file.size()<(qint64)sizeof(SolarSystemCacheHeader))
+		return false;
+	uchar* data = file.map(0, file.size());
+	if (!data)
+		return false;
+
+	const SolarSystemCacheHeader* header = reinterpret_cast<const SolarSystemCacheHeader*>(data);
+	if (memcmp(header->magic, ssystemCacheMagic, sizeof(ssystemCacheMagic))!=0
+	    || header->version!=SSYSTEM_CACHE_VERSION
+	    || header->byteOrder!=0x01020304
+	    || header->recordSize!=sizeof(MinorBody)
+	    || fileHash.size()!=(int)sizeof(header->hash)
+	    || memcmp(header->hash, fileHash.constData(), sizeof(header->hash))!=0
+	    || file.size()!=(qint64)(sizeof(SolarSystemCacheHeader) + (qint64)header->nbRecords*sizeof(MinorBody)
+				     + (qint64)header->nbChars*sizeof(QChar) + header->sectionsSize))
+	{
+		qDebug() << "Solar System cache" << QDir::toNativeSeparators(cacheFilename) << "is out of date";
+		file.unmap(data);
+		return false;
+	}
+
+	const MinorBody* rec = reinterpret_cast<const MinorBody*>(data + sizeof(SolarSystemCacheHeader));
+	const QChar* recChars = reinterpret_cast<const QChar*>(rec + header->nbRecords);
+	const char* sectionsData = reinterpret_cast<const char*>(recChars + header->nbChars);
+	for (unsigned int i=0; i<header->nbRecords; ++i)
+	{
+		const MinorBody& b = rec[i];
+		if ((qint64)b.nameOffset+b.nameLength>header->nbChars || (qint64)b.texMapOffset+b.texMapLength>header->nbChars
+		    || (qint64)b.typeOffset+b.typeLength>header->nbChars || (qint64)b.designationOffset+b.designationLength>header->nbChars)
+		{
+			qWarning() << "Solar System cache" << QDir::toNativeSeparators(cacheFilename) << "is corrupted";
+			file.unmap(data);
+			return false;
+		}
+	}
+
+	// The records are copied at once, without any conversion
+	minorBodies.resize(header->nbRecords);
+	memcpy(minorBodies.data(), rec, header->nbRecords*sizeof(MinorBody));
+	chars = QString(recChars, header->nbChars);
+
+	QDataStream in(QByteArray::fromRawData(sectionsData, header->sectionsSize));
+	in.setVersion(QDataStream::Qt_5_0);
+	qint32 nbSections;
+	in >> nbSections;
+	sections.resize(qMax(nbSections, 0));
+	for (int i=0; i<sections.size(); ++i)
+		in >> sections[i].name >> sections[i].values;
+	file.unmap(data);
+	if (in.status()!=QDataStream::Ok)
+	{
+		qWarning() << "Solar System cache" << QDir::toNativeSeparators(cacheFilename) << "is corrupted";
+		sections.clear();
+		minorBodies.clear();
+		chars.clear();
+		return false;
+	}
+	return true;
+}
+
+void SolarSystemCatalog::saveCache(const QString& cacheFilename, const QByteArray& fileHash) const
+{
+	QByteArray sectionsData;
+	QDataStream out(&sectionsData, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << (qint32)sections.size();
+	for (int i=0; i<sections.size(); ++i)
+		out << sections.at(i).name << sections.at(i).values;
+
+	SolarSystemCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ssystemCacheMagic, sizeof(ssystemCacheMagic));
+	header.version = SSYSTEM_CACHE_VERSION;
+	header.byteOrder = 0x01020304;
+	header.recordSize = sizeof(MinorBody);
+	header.nbRecords = minorBodies.size();
+	header.nbChars = chars.size();
+	header.sectionsSize = sectionsData.size();
+	memcpy(header.hash, fileHash.constData(), qMin((int)sizeof(header.hash), fileHash.size()));
+
+	QDir().mkpath(QFileInfo(cacheFilename).absolutePath());
+	QSaveFile file(cacheFilename);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "Cannot write Solar System cache" << QDir::toNativeSeparators(cacheFilename);
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(minorBodies.constData()), minorBodies.size()*sizeof(MinorBody));
+	file.write(reinterpret_cast<const char*>(chars.constData()), chars.size()*sizeof(QChar));
+	file.write(sectionsData);
+	if (!file.commit())
+		qWarning() << "Cannot write Solar System cache" << QDir::toNativeSeparators(cacheFilename);
+}
@@ -0,0 +1,140 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _SOLARSYSTEMCATALOG_HPP_
+#define _SOLARSYSTEMCATALOG_HPP_
+
+#include "Planet.hpp"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+//! @class SolarSystemCatalog
+//! The contents of a Solar System configuration file (ssystem.ini), read without QSettings.
+//! The bodies orbiting the Sun on Kepler orbits (asteroids, comets and the other minor bodies, which are most of
+//! the file after an import of the MPC catalogs) are converted into MinorBody records: their orbital and rotation
+//! elements are derived once, and SolarSystem creates them in bulk without looking up any key.
+//! The other bodies are kept as sections of key/value pairs.
+//! The records are saved in a binary cache, which is mapped at the next start as long as the file is unchanged.
+//! When the cache is stale, the text is parsed and converted by worker threads.
+class SolarSystemCatalog
+{
+public:
+	//! A section of the file, the keys have the same values as with QSettings and StelIniFormat.
+	struct Section
+	{
+		QString name;
+		QHash<QString, QString> values;
+
+		//! Same as QSettings::value(name+"/"+key, defaultValue).
+		QVariant value(const QString& key, const QVariant& defaultValue=QVariant()) const
+		{
+			QHash<QString, QString>::const_iterator it = values.constFind(key);
+			return it==values.constEnd() ? defaultValue : QVariant(it.value());
+		}
+	};
+
+	//! The elements of an EllipticalOrbit or a CometOrbit, derived from the orbit_* keys.
+	//! Angles are in radians, distances in AU.
+	struct OrbitElements
+	{
+		double pericenterDistance;
+		double eccentricity;
+		double inclination;
+		double ascendingNode;
+		double argOfPericenter;
+		double meanAnomaly;		// elliptical orbits
+		double period;			// elliptical orbits
+		double epoch;			// elliptical orbits
+		double timeAtPericenter;	// comet orbits
+		double orbitGoodDays;		// comet orbits
+		double meanMotion;		// comet orbits
+		qint32 comet;			// whether it's a comet_orbit
+		qint32 reserved;
+	};
+
+	enum MinorBodyFlag
+	{
+		MinorBodyComet		= 0x01,	//!< Comet instead of MinorPlanet
+		MinorBodyLighting	= 0x02,
+		MinorBodyHidden		= 0x04,
+		MinorBodyCloseOrbit	= 0x08,
+		MinorBodySemiMajorAxis	= 0x10	//!< semiMajorAxis must be set
+	};
+
+	//! A minor body orbiting the Sun. The strings are in the strings table, see getString().
+	struct MinorBody
+	{
+		OrbitElements orbit;
+		RotationElements rotation;
+		double radius;			// AU
+		double oblateness;
+		double absoluteMagnitude;	// -99 if unknown
+		double slope;			// checked, the default of the magnitude system if out of range
+		double semiMajorAxis;
+		float color[3];
+		float albedo;
+		float dustWidthFactor, dustLengthFactor, dustBrightnessFactor;
+		qint32 minorPlanetNumber;
+		quint32 flags;			// MinorBodyFlag
+		quint32 nameOffset, nameLength;
+		quint32 texMapOffset, texMapLength;
+		quint32 typeOffset, typeLength;
+		quint32 designationOffset, designationLength;
+	};
+
+	//! Read a Solar System configuration file.
+	//! @param filePath the ini file
+	//! @param useCache whether to read the binary cache, and to write it when it's out of date
+	//! @return false if the file can't be read.
+	bool load(const QString& filePath, bool useCache=true);
+
+	//! Parse the text of an ini file like StelIniFormat, in parallel for big files.
+	//! Sections appearing several times are merged. The sections are sorted by name like QSettings::childGroups().
+	static QVector<Section> parseIni(const QByteArray& data);
+
+	//! Read the orbit of a body with coord_func ell_orbit or comet_orbit.
+	//! @param heliocentric whether the parent of the body is the Sun
+	//! @return false, with a warning, if the elements are incomplete.
+	static bool readOrbitElements(const Section& sec, const QString& englishName, bool heliocentric, OrbitElements& elements);
+	//! Read the rot_* keys of a body.
+	static void readRotationElements(const Section& sec, RotationElements& elements);
+
+	//! Get the sections of the bodies which are not minor bodies.
+	const QVector<Section>& getSections() const {return sections;}
+	//! Get the minor bodies.
+	const QVector<MinorBody>& getMinorBodies() const {return minorBodies;}
+	//! Get a string of the strings table.
+	QString getString(quint32 offset, quint32 length) const {return QString(chars.constData()+offset, length);}
+
+private:
+	//! Split the sections into minor bodies and other sections.
+	void convert(const QVector<Section>& allSections);
+	bool loadCache(const QString& cacheFilename, const QByteArray& fileHash);
+	void saveCache(const QString& cacheFilename, const QByteArray& fileHash) const;
+
+	QVector<Section> sections;
+	QVector<MinorBody> minorBodies;
+	QString chars;
+};
+
+#endif // _SOLARSYSTEMCATALOG_HPP_
@@ -260,6 +260,10 @@ public:
 		return d[5] >> 3;
 	}
 
+	//! Star3 has no proper motion.
+	inline int getDx0() const {return 0;}
+	inline int getDx1() const {return 0;}
+
 	enum {MaxPosVal=((1<<17)-1)};
 	StelObjectP createStelObject(const SpecialZoneArray<Star3> *a, const SpecialZoneData<Star3> *z) const;
 	void getJ2000Pos(const ZoneData *z,float, Vec3f& pos) const
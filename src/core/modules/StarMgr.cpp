@@ -46,6 +46,7 @@
 #include "RefractionExtinction.hpp"
 #include "StelModuleMgr.hpp"
 #include "ConstellationMgr.hpp"
+#include "StelProfiler.hpp"
 
 #include <QTextStream>
 #include <QFile>
@@ -56,6 +57,9 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCryptographicHash>
+#include <QFutureSynchronizer>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 #include <errno.h>
 
@@ -141,6 +145,10 @@ StarMgr::StarMgr(void)
 	: flagStarName(false)
 	, labelsAmount(0.)
 	, gravityLabel(false)
+	, flagParallelDraw(true)
+	, flagSoACulling(false)
+	, flagStreamCatalogs(false)
+	, streamingBudget(256)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
 {
 	setObjectName("StarMgr");
@@ -420,12 +428,18 @@ void StarMgr::init()
 		}
 	}
 
+	// Must be known before loading the catalogs
+	flagStreamCatalogs = conf->value("stars/flag_stream_catalogs", false).toBool();
+	streamingBudget = conf->value("stars/streaming_budget_mb", 256).toInt();
+
 	loadData(starSettings);
 	starFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
 
 	setFlagStars(conf->value("astro/flag_stars", true).toBool());
 	setFlagLabels(conf->value("astro/flag_star_name",true).toBool());
 	setLabelsAmount(conf->value("stars/labels_amount",3.f).toFloat());
+	setFlagParallelDraw(conf->value("stars/flag_parallel_draw", true).toBool());
+	setFlagSoACulling(conf->value("stars/flag_soa_culling", false).toBool());
 
 	// Load colors from config file
 	QString defaultColor = conf->value("color/default_color").toString();
@@ -539,7 +553,7 @@ bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
 		}
 	}
 
-	ZoneArray* z = ZoneArray::create(catalogFilePath, true);
+	ZoneArray* z = ZoneArray::create(catalogFilePath, true, flagStreamCatalogs);
 	if (z)
 	{
 		if (z->level<gridLevels.size())
@@ -551,6 +565,8 @@ bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
 		Q_ASSERT(z->level==maxGeodesicGridLevel+1);
 		Q_ASSERT(z->level==gridLevels.size());
 		++maxGeodesicGridLevel;
+		z->setFlagSoA(flagSoACulling);
+		z->setStreamingBudget((qint64)streamingBudget*1024*1024);
 		gridLevels.append(z);
 	}
 	return true;
@@ -1074,6 +1090,92 @@ int StarMgr::getMaxSearchLevel() const
 
 
 // Draw all the stars
+//! A contiguous range of the selected zones of a ZoneArray, culled by one worker thread.
+struct StarCullJob
+{
+	const ZoneArray* zoneArray;
+	const QVector<int>* zones;	// zone indices, in drawing order
+	int nbInsideZones;		// the first nbInsideZones zones are fully inside the viewport
+	int begin;
+	int end;
+	const RCMag* rcmag_table;
+	int limitMagIndex;
+	const StelCore* core;
+	StelProjectorP prj;
+	const QVector<SphericalCap>* viewportCaps;
+	QVector<StarPointSource> result;
+};
+
+static void runStarCullJob(StarCullJob* job)
+{
+	for (int i=job->begin;i<job->end;++i)
+		job->zoneArray->cullZone(job->zones->at(i), i<job->nbInsideZones, job->rcmag_table, job->limitMagIndex,
+					 job->core, job->prj, *job->viewportCaps, job->result);
+}
+
+void StarMgr::setFlagSoACulling(bool b)
+{
+	flagSoACulling = b;
+	foreach(ZoneArray* z, gridLevels)
+		z->setFlagSoA(b);
+}
+
+void StarMgr::setStreamingBudget(int megabytes)
+{
+	streamingBudget = megabytes;
+	foreach(ZoneArray* z, gridLevels)
+		z->setStreamingBudget((qint64)megabytes*1024*1024);
+}
+
+void StarMgr::drawZonesCulled(const ZoneArray* z, const GeodesicSearchResult* geodesic_search_result,
+			      StelPainter* sPainter, const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
+			      int maxMagStarName, float names_brightness, const QVector<SphericalCap>& viewportCaps,
+			      bool parallel)
+{
+	// Same zone order as in the serial path: first the inside zones, then the border zones
+	QVector<int> zones;
+	int zone;
+	for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
+		zones.append(zone);
+	const int nbInsideZones = zones.size();
+	for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
+		zones.append(zone);
+	if (zones.isEmpty())
+		return;
+
+	// Use a few more jobs than threads because the number of stars per zone varies a lot
+	const int nbJobs = parallel ? qMin(zones.size(), 4*QThreadPool::globalInstance()->maxThreadCount()) : 1;
+	QVector<StarCullJob> jobs(nbJobs);
+	for (int j=0;j<nbJobs;++j)
+	{
+		StarCullJob& job = jobs[j];
+		job.zoneArray = z;
+		job.zones = &zones;
+		job.nbInsideZones = nbInsideZones;
+		job.begin = j*zones.size()/nbJobs;
+		job.end = (j+1)*zones.size()/nbJobs;
+		job.rcmag_table = rcmag_table;
+		job.limitMagIndex = limitMagIndex;
+		job.core = core;
+		job.prj = sPainter->getProjector();
+		job.viewportCaps = &viewportCaps;
+	}
+
+	if (parallel)
+	{
+		QFutureSynchronizer<void> synchronizer;
+		for (int j=0;j<nbJobs;++j)
+			synchronizer.addFuture(QtConcurrent::run(runStarCullJob, &jobs[j]));
+		synchronizer.waitForFinished();
+	}
+	else
+		runStarCullJob(&jobs[0]);
+
+	// Merge the per thread batches in order, the actual drawing must happen in the main thread
+	foreach (const StarCullJob& job, jobs)
+		z->drawCulled(sPainter, job.result, rcmag_table, core, maxMagStarName, names_brightness);
+}
+
 void StarMgr::draw(StelCore* core)
 {
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
@@ -1100,7 +1202,7 @@ void StarMgr::draw(StelCore* core)
 	RCMag rcmag_table[RCMAG_TABLE_SIZE];
 	
 	// Draw all the stars of all the selected zones
-	foreach(const ZoneArray* z, gridLevels)
+	foreach(ZoneArray* z, gridLevels)
 	{
 		int limitMagIndex=RCMAG_TABLE_SIZE;
 		const float mag_min = 0.001f*z->mag_min;
@@ -1138,18 +1240,33 @@ void StarMgr::draw(StelCore* core)
 			if (x > 0)
 				maxMagStarName = x;
 		}
-		int zone;
-		
-		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps);
-		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps);
+		const bool parallel = flagParallelDraw && QThreadPool::globalInstance()->maxThreadCount()>1;
+		StelProfileScope zonesScope("StarMgr::drawZones");
+		if (parallel || z->getFlagSoA())
+		{
+			drawZonesCulled(z, geodesic_search_result, &sPainter, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps, parallel);
+		}
+		else
+		{
+			int zone;
+
+			for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
+				z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps);
+			for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
+				z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps);
+		}
+		if (z->isStreaming())
+			z->prefetchNeighbours(geodesic_search_result, core->getGeodesicGrid(maxSearchLevel));
 	}
 	exit_loop:
 
 	// Finish drawing many stars
 	skyDrawer->postDrawPointSource(&sPainter);
 
+	// Release the decoded and streamed zones which are not visible anymore, also in the levels not drawn
+	foreach(ZoneArray* z, gridLevels)
+		z->nextFrame();
+
 	if (objectMgr->getFlagSelectedObjectPointer())
 		drawPointer(sPainter, core);
 }
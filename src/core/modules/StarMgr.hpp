@@ -35,7 +35,10 @@ class StelPainter;
 class QSettings;
 
 class ZoneArray;
+class GeodesicSearchResult;
+class SphericalCap;
 struct HipIndexStruct;
+struct RCMag;
 
 static const int RCMAG_TABLE_SIZE = 4096;
 
@@ -189,6 +192,27 @@ public slots:
 	static void setFlagSciNames(bool f) {flagSciNames = f;}
 	static bool getFlagSciNames(void) {return flagSciNames;}
 
+	//! Set whether the culling and projection of the stars is distributed over
+	//! worker threads. The drawn result is the same in both modes.
+	void setFlagParallelDraw(bool b) {flagParallelDraw = b;}
+	//! Get whether the culling and projection of the stars is distributed over worker threads.
+	bool getFlagParallelDraw(void) const {return flagParallelDraw;}
+
+	//! Set whether the stars are culled with SIMD instructions from decoded copies
+	//! of the visible zones. This uses more memory than the packed catalogs.
+	void setFlagSoACulling(bool b);
+	//! Get whether the stars are culled from decoded copies of the visible zones.
+	bool getFlagSoACulling(void) const {return flagSoACulling;}
+
+	//! Get whether the catalogs are streamed, i.e. their zones are read from the files
+	//! only when they are visible. This is set by stars/flag_stream_catalogs at startup.
+	bool getFlagStreamCatalogs(void) const {return flagStreamCatalogs;}
+	//! Set the memory budget of each streamed catalog in megabytes.
+	//! When it is exceeded, the least recently visible zones are released.
+	void setStreamingBudget(int megabytes);
+	//! Get the memory budget of each streamed catalog in megabytes.
+	int getStreamingBudget(void) const {return streamingBudget;}
+
 public:
 	///////////////////////////////////////////////////////////////////////////
 	// Other methods
@@ -385,6 +409,14 @@ private:
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(StelPainter& sPainter, const StelCore* core);
 
+	//! Draw the selected zones of a ZoneArray, culling and projecting the stars
+	//! first (in worker threads if parallel is true) and drawing them afterwards.
+	//! The stars are drawn in the same order as by ZoneArray::draw.
+	void drawZonesCulled(const ZoneArray* z, const GeodesicSearchResult* geodesic_search_result,
+			     StelPainter* sPainter, const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
+			     int maxMagStarName, float names_brightness, const QVector<SphericalCap>& viewportCaps,
+			     bool parallel);
+
 	//! List of all Hipparcos stars.
 	QList<StelObjectP> hipparcosStars;
 
@@ -394,6 +426,10 @@ private:
 	bool flagStarName;
 	double labelsAmount;
 	bool gravityLabel;
+	bool flagParallelDraw;
+	bool flagSoACulling;
+	bool flagStreamCatalogs;
+	int streamingBudget;
 
 	int maxGeodesicGridLevel;
 	int lastMaxSearchLevel;
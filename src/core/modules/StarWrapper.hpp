@@ -72,7 +72,7 @@ template <class Star> class StarWrapper : public StarWrapperBase
 protected:
 	StarWrapper(const SpecialZoneArray<Star> *a,
 		const SpecialZoneData<Star> *z,
-		const Star *s) : a(a), z(z), s(s) {;}
+		const Star *s) : a(a), z(z), star(*s), s(&star) {;}
 	Vec3d getJ2000EquatorialPos(const StelCore* core) const
 	{
 		static const double d2000 = 2451545.0;
@@ -96,6 +96,9 @@ protected:
 protected:
 	const SpecialZoneArray<Star> *const a;
 	const SpecialZoneData<Star> *const z;
+	//! Copy of the star record: streamed catalogs release the stars of the
+	//! zones which are not visible, while the wrapper may still be selected.
+	const Star star;
 	const Star *const s;
 };
 
@@ -27,6 +27,10 @@
 #include <QDebug>
 #include <QFile>
 #include <QDir>
+#include <QVarLengthArray>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
 #ifdef Q_OS_WIN
 #include <io.h>
 #include <windows.h>
@@ -90,7 +94,7 @@ static inline int ReadInt(QFile& file, unsigned int &x)
 #endif
 #endif
 
-ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
+ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap, bool streaming)
 {
 	QString dbStr; // for debugging output.
 	QFile* file = new QFile(catalogFilePath);
@@ -201,7 +205,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star2) == 10);
 #endif
-				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, streaming);
 				if (rval == 0)
 				{
 					dbStr += "error - no memory ";
@@ -222,7 +226,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star3) == 6);
 #endif
-				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, streaming);
 				if (rval == 0)
 				{
 					dbStr += "error - no memory ";
@@ -236,6 +240,8 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 	if (rval && rval->isInitialized())
 	{
 		dbStr += QString("%1").arg(rval->getNrOfStars());
+		if (rval->isStreaming())
+			dbStr += " (streaming)";
 		qDebug() << dbStr;
 	}
 	else
@@ -255,11 +261,166 @@ ZoneArray::ZoneArray(const QString& fname, QFile* file, int level, int mag_min,
 			 int mag_range, int mag_steps)
 			: fname(fname), level(level), mag_min(mag_min),
 			  mag_range(mag_range), mag_steps(mag_steps),
-			  star_position_scale(0.0), nr_of_stars(0), zones(0), file(file)
+			  star_position_scale(0.0), nr_of_stars(0), zones(0), file(file),
+			  soaZones(NULL), frame(0), zoneOffsets(NULL), zoneLastUsed(NULL),
+			  streamedBytes(0), streamingBudget(256*1024*1024)
 {
 	nr_of_zones = StelGeodesicGrid::nrOfZones(level);	
 }
 
+void ZoneArray::setFlagSoA(bool b)
+{
+	if (b==getFlagSoA())
+		return;
+	if (b)
+	{
+		soaZones = new ZoneSoA*[nr_of_zones];
+		for (unsigned int i=0;i<nr_of_zones;++i)
+			soaZones[i] = NULL;
+	}
+	else
+	{
+		for (unsigned int i=0;i<nr_of_zones;++i)
+			delete soaZones[i];
+		delete[] soaZones;
+		soaZones = NULL;
+	}
+}
+
+void ZoneArray::nextFrame()
+{
+	// Number of frames a zone can stay invisible before its decoded copy or its stars are released
+	static const unsigned int maxAge = 600;
+
+	if (!isStreaming())
+		++frame;
+	else
+	{
+		// The prefetch thread reads the frame counter too
+		QMutexLocker locker(&streamMutex);
+		++frame;
+		if (streamedBytes>streamingBudget || frame%64==0)
+		{
+			// Evict the least recently used zones, but never the ones used during the last frame
+			QVector<QPair<unsigned int, int> > candidates;
+			candidates.reserve(loadedZones.size());
+			foreach (int index, loadedZones)
+				candidates.append(qMakePair(zoneLastUsed[index], index));
+			std::sort(candidates.begin(), candidates.end());
+			QVector<int> kept;
+			for (int i=0;i<candidates.size();++i)
+			{
+				const int index = candidates.at(i).second;
+				const unsigned int age = frame-candidates.at(i).first;
+				if (age>1 && (streamedBytes>streamingBudget || age>maxAge))
+				{
+					streamedBytes -= (qint64)zones[index].size*getStarSize();
+					freeZone(index);
+					if (soaZones)
+					{
+						delete soaZones[index];
+						soaZones[index] = NULL;
+					}
+				}
+				else
+					kept.append(index);
+			}
+			loadedZones = kept;
+		}
+	}
+
+	// There can be hundreds of thousands of zones, so don't look at them every frame
+	if (soaZones==NULL || frame%64!=0)
+		return;
+	for (unsigned int i=0;i<nr_of_zones;++i)
+	{
+		if (soaZones[i] && frame-soaZones[i]->lastUsed>maxAge)
+		{
+			delete soaZones[i];
+			soaZones[i] = NULL;
+		}
+	}
+}
+
+qint64 ZoneArray::getStreamedBytes() const
+{
+	QMutexLocker locker(&streamMutex);
+	return streamedBytes;
+}
+
+bool ZoneArray::requireZone(int index) const
+{
+	if (!isStreaming())
+		return true;
+	QMutexLocker locker(&streamMutex);
+	zoneLastUsed[index] = frame;
+	if (zones[index].stars || zones[index].size==0)
+		return true;
+	if (!readZone(index))
+		return false;
+	loadedZones.append(index);
+	streamedBytes += (qint64)zones[index].size*getStarSize();
+	return true;
+}
+
+static void prefetchZones(const ZoneArray* zoneArray, QVector<int> indices)
+{
+	foreach (int index, indices)
+		zoneArray->requireZone(index);
+}
+
+void ZoneArray::prefetchNeighbours(const GeodesicSearchResult* searchResult, const StelGeodesicGrid* grid)
+{
+	if (!isStreaming() || prefetchFuture.isRunning())
+		return;
+
+	QVector<int> border;
+	int zone;
+	for (GeodesicSearchBorderIterator it(*searchResult, level);(zone = it.next()) >= 0;)
+		border.append(zone);
+	if (border==lastPrefetchBorder)
+		return;
+
+	// The neighbours are found by looking up points slightly outside
+	// the corners and the middle of the edges of the border zones.
+	QVector<int> neighbours;
+	Vec3f c[3];
+	for (int i=0;i<border.size();++i)
+	{
+		grid->getTriangleCorners(level, border.at(i), c[0], c[1], c[2]);
+		const Vec3f center = c[0]+c[1]+c[2];
+		for (int j=0;j<3;++j)
+		{
+			Vec3f v = c[j]*1.5f - center*(0.5f/3.f);
+			v.normalize();
+			neighbours.append(grid->getZoneNumberForPoint(v, level));
+			v = (c[j]+c[(j+1)%3])*0.75f - center*(0.5f/3.f);
+			v.normalize();
+			neighbours.append(grid->getZoneNumberForPoint(v, level));
+		}
+	}
+	std::sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+	lastPrefetchBorder = border;
+	prefetchFuture = QtConcurrent::run(prefetchZones, this, neighbours);
+}
+
+void ZoneArray::clearStreaming()
+{
+	if (!isStreaming())
+		return;
+	prefetchFuture.waitForFinished();
+	foreach (int index, loadedZones)
+		freeZone(index);
+	loadedZones.clear();
+	streamedBytes = 0;
+	delete[] zoneOffsets;
+	zoneOffsets = NULL;
+	delete[] zoneLastUsed;
+	zoneLastUsed = NULL;
+}
+
 bool ZoneArray::readFile(QFile& file, void *data, qint64 size)
 {
 	int parts = 256;
@@ -317,7 +478,7 @@ void SpecialZoneArray<Star>::scaleAxis()
 
 template<class Star>
 SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mmap,
-					 int level, int mag_min, int mag_range, int mag_steps)
+					 int level, int mag_min, int mag_range, int mag_steps, bool streaming)
 		: ZoneArray(file->fileName(), file, level, mag_min, mag_range, mag_steps),
 		  stars(0), mmap_start(0)
 {
@@ -367,6 +528,34 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 			zones = 0;
 			nr_of_zones = 0;
 		}
+		else if (streaming)
+		{
+			// Only remember where the stars of each zone are, they are read by readZone()
+			zoneOffsets = new qint64[nr_of_zones];
+			zoneLastUsed = new unsigned int[nr_of_zones];
+			qint64 offset = file->pos();
+			for (unsigned int z=0;z<nr_of_zones;z++)
+			{
+				zoneOffsets[z] = offset;
+				zoneLastUsed[z] = 0;
+				getZones()[z].stars = 0;
+				offset += sizeof(Star)*getZones()[z].size;
+			}
+			if (offset>file->size())
+			{
+				qDebug() << "Error reading zones from catalog:"
+					 << file->fileName() << "is truncated";
+				clearStreaming();
+				// Without stars the destructor doesn't delete the file
+				file->close();
+				delete file;
+				ZoneArray::file = 0;
+				nr_of_stars = 0;
+				delete[] getZones();
+				zones = 0;
+				nr_of_zones = 0;
+			}
+		}
 		else
 		{
 			if (use_mmap)
@@ -436,6 +625,12 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 template<class Star>
 SpecialZoneArray<Star>::~SpecialZoneArray(void)
 {
+	setFlagSoA(false);
+	if (isStreaming())
+	{
+		clearStreaming();
+		delete file;
+	}
 	if (stars)
 	{
 		if (mmap_start != 0)
@@ -459,88 +654,241 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 }
 
 template<class Star>
-void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
-				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness,
-				  const QVector<SphericalCap> &boundingCaps) const
+bool SpecialZoneArray<Star>::readZone(int index) const
 {
-	StelSkyDrawer* drawer = core->getSkyDrawer();
-	Vec3f vf;
+	SpecialZoneData<Star>* z = getZones() + index;
+	Star* s = new Star[z->size];
+	const qint64 size = sizeof(Star)*z->size;
+	if (!file->seek(zoneOffsets[index]) || file->read((char*)s, size)!=size)
+	{
+		qWarning() << "Error reading zone" << index << "from catalog:" << file->fileName() << file->errorString();
+		delete[] s;
+		return false;
+	}
+	z->stars = s;
+	return true;
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::freeZone(int index) const
+{
+	SpecialZoneData<Star>* z = getZones() + index;
+	delete[] z->getStars();
+	z->stars = 0;
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::initCullParams(const StelCore* core, int limitMagIndex, CullParams& params) const
+{
+	const StelSkyDrawer* drawer = core->getSkyDrawer();
 	static const double d2000 = 2451545.0;
-	const float movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
+	params.movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
 
 	// GZ, added for extinction
-	const Extinction& extinction=core->getSkyDrawer()->getExtinction();
-	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
-	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
-	
+	const Extinction& extinction=drawer->getExtinction();
+	params.withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
+	params.k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
+
 	// Allow artificial cutoff:
 	// find the (integer) mag at which is just bright enough to be drawn.
-	int cutoffMagStep=limitMagIndex;
+	params.cutoffMagStep=limitMagIndex;
 	if (drawer->getFlagStarMagnitudeLimit())
 	{
-		cutoffMagStep = ((int)(drawer->getCustomStarMagnitudeLimit()*1000.f) - mag_min)*mag_steps/mag_range;
-		if (cutoffMagStep>limitMagIndex)
-			cutoffMagStep = limitMagIndex;
+		params.cutoffMagStep = ((int)(drawer->getCustomStarMagnitudeLimit()*1000.f) - mag_min)*mag_steps/mag_range;
+		if (params.cutoffMagStep>limitMagIndex)
+			params.cutoffMagStep = limitMagIndex;
 	}
-	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
-    
+	Q_ASSERT(params.cutoffMagStep<RCMAG_TABLE_SIZE);
+}
+
+template<class Star>
+bool SpecialZoneArray<Star>::cullStar(const Star* s, const SpecialZoneData<Star>* zone, bool isInsideViewport,
+				      const CullParams& params, const StelCore* core, const QVector<SphericalCap>& boundingCaps,
+				      Vec3f& vf, int& extinctedMagIndex, float& twinkleFactor) const
+{
+	// Get the star position from the array
+	s->getJ2000Pos(zone, params.movementFactor, vf);
+
+	// If the star zone is not strictly contained inside the viewport, eliminate from the
+	// beginning the stars actually outside viewport.
+	if (!isInsideViewport)
+	{
+		vf.normalize();
+		foreach (const SphericalCap& cap, boundingCaps)
+		{
+			if (!cap.contains(vf))
+				return false;
+		}
+	}
+
+	extinctedMagIndex = s->getMag();
+	twinkleFactor=1.0f; // allow height-dependent twinkle.
+	if (params.withExtinction)
+	{
+		Vec3f altAz(vf);
+		altAz.normalize();
+		core->j2000ToAltAzInPlaceNoRefraction(&altAz);
+		float extMagShift=0.0f;
+		core->getSkyDrawer()->getExtinction().forward(altAz, &extMagShift);
+		extinctedMagIndex = s->getMag() + (int)(extMagShift/params.k);
+		if (extinctedMagIndex >= params.cutoffMagStep) // i.e., if extincted it is dimmer than cutoff, so remove
+			return false;
+		twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
+	}
+	return true;
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
+				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness,
+				  const QVector<SphericalCap> &boundingCaps) const
+{
+	if (!requireZone(index))
+		return;
+	StelSkyDrawer* drawer = core->getSkyDrawer();
+	CullParams params;
+	initCullParams(core, limitMagIndex, params);
+	Vec3f vf;
+	int extinctedMagIndex;
+	float twinkleFactor;
+
 	// Go through all stars, which are sorted by magnitude (bright stars first)
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
 	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
 	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
 	{
 		// Artifical cutoff per magnitude
-		if (s->getMag() > cutoffMagStep)
+		if (s->getMag() > params.cutoffMagStep)
 			break;
-    
+
 		// Because of the test above, the star should always be visible from this point.
-		
+		if (!cullStar(s, zoneToDraw, isInsideViewport, params, core, boundingCaps, vf, extinctedMagIndex, twinkleFactor))
+			continue;
+
 		// Array of 2 numbers containing radius and magnitude
-		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
-		
-		// Get the star position from the array
-		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
-		
-		// If the star zone is not strictly contained inside the viewport, eliminate from the 
-		// beginning the stars actually outside viewport.
-		if (!isInsideViewport)
+		const RCMag* tmpRcmag = &rcmag_table[extinctedMagIndex];
+		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
 		{
-			vf.normalize();
-			bool isVisible = true;
-			foreach (const SphericalCap& cap, boundingCaps)
-			{
-				if (!cap.contains(vf))
-				{
-					isVisible = false;
-					continue;
-				}
-			}
-			if (!isVisible)
-				continue;
+			const float offset = tmpRcmag->radius*0.7f;
+			const Vec3f colorr = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
+			sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
+			sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), s->getNameI18n(), 0, offset, offset, false);
 		}
+	}
+}
 
-		int extinctedMagIndex = s->getMag();
-		float twinkleFactor=1.0f; // allow height-dependent twinkle.
-		if (withExtinction)
-		{
-			Vec3f altAz(vf);
-			altAz.normalize();
-			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
-			float extMagShift=0.0f;
-			extinction.forward(altAz, &extMagShift);
-			extinctedMagIndex = s->getMag() + (int)(extMagShift/k);
-			if (extinctedMagIndex >= cutoffMagStep) // i.e., if extincted it is dimmer than cutoff, so remove
-				continue;
-			tmpRcmag = &rcmag_table[extinctedMagIndex];
-			twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
-		}
-	
-		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
+template<class Star>
+void SpecialZoneArray<Star>::cullZone(int index, bool isInsideViewport, const RCMag* rcmag_table, int limitMagIndex,
+				      const StelCore* core, const StelProjectorP& prj,
+				      const QVector<SphericalCap>& boundingCaps, QVector<StarPointSource>& result) const
+{
+	if (!requireZone(index))
+		return;
+	CullParams params;
+	initCullParams(core, limitMagIndex, params);
+	if (soaZones)
+	{
+		cullDecodedZone(index, isInsideViewport, rcmag_table, params, core, prj, boundingCaps, result);
+		return;
+	}
+	StarPointSource source;
+
+	const SpecialZoneData<Star>* zoneToCull = getZones() + index;
+	const Star* lastStar = zoneToCull->getStars() + zoneToCull->size;
+	for (const Star* s=zoneToCull->getStars();s<lastStar;++s)
+	{
+		if (s->getMag() > params.cutoffMagStep)
+			break;
+		if (!cullStar(s, zoneToCull, isInsideViewport, params, core, boundingCaps, source.pos, source.extinctedMagIndex, source.twinkleFactor))
+			continue;
+		// Same rejections as in StelSkyDrawer::drawPointSource
+		if (rcmag_table[source.extinctedMagIndex].radius<=0.f)
+			continue;
+		if (!(isInsideViewport ? prj->project(source.pos, source.win) : prj->projectCheck(source.pos, source.win)))
+			continue;
+		source.star = s;
+		result.append(source);
+	}
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::cullDecodedZone(int index, bool isInsideViewport, const RCMag* rcmag_table, const CullParams& params,
+					     const StelCore* core, const StelProjectorP& prj,
+					     const QVector<SphericalCap>& boundingCaps, QVector<StarPointSource>& result) const
+{
+	const SpecialZoneData<Star>* zoneToCull = getZones() + index;
+	ZoneSoA*& soa = soaZones[index];
+	if (soa==NULL)
+	{
+		soa = new ZoneSoA;
+		buildZoneSoA(zoneToCull, *soa);
+	}
+	soa->lastUsed = frame;
+
+	ZoneSoACullParams p;
+	p.center = zoneToCull->center;
+	p.axis0 = zoneToCull->axis0;
+	p.axis1 = zoneToCull->axis1;
+	p.movementFactor = params.movementFactor;
+	p.cutoffMagStep = params.cutoffMagStep;
+	p.checkCaps = !isInsideViewport;
+	QVarLengthArray<double, 32> caps;
+	foreach (const SphericalCap& cap, boundingCaps)
+	{
+		caps.append(cap.n[0]);
+		caps.append(cap.n[1]);
+		caps.append(cap.n[2]);
+		caps.append(cap.d);
+	}
+	p.nbCaps = boundingCaps.size();
+	p.caps = caps.constData();
+	p.withExtinction = params.withExtinction;
+	const Mat4d& m = core->getJ2000ToAltAzMatrix();
+	p.altAzRow[0] = m[2];
+	p.altAzRow[1] = m[6];
+	p.altAzRow[2] = m[10];
+	p.altAzRow[3] = m[14];
+	const Extinction& extinction = core->getSkyDrawer()->getExtinction();
+	p.extinctionCoefficient = extinction.getExtinctionCoefficient();
+	p.undergroundExtinctionMode = extinction.getUndergroundExtinctionMode();
+	p.k = params.k;
+
+	ZoneSoACullResult r;
+	r.resize(soa->size);
+	const int nb = cullZoneSoA(*soa, p, r);
+
+	StarPointSource source;
+	for (int i=0;i<nb;++i)
+	{
+		if (rcmag_table[r.magIndex[i]].radius<=0.f)
+			continue;
+		source.pos.set(r.x[i], r.y[i], r.z[i]);
+		if (!(isInsideViewport ? prj->project(source.pos, source.win) : prj->projectCheck(source.pos, source.win)))
+			continue;
+		source.star = zoneToCull->getStars() + r.index[i];
+		source.twinkleFactor = r.twinkleFactor[i];
+		source.extinctedMagIndex = r.magIndex[i];
+		result.append(source);
+	}
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::drawCulled(StelPainter* sPainter, const QVector<StarPointSource>& sources,
+					const RCMag* rcmag_table, StelCore* core,
+					int maxMagStarName, float names_brightness) const
+{
+	StelSkyDrawer* drawer = core->getSkyDrawer();
+	foreach (const StarPointSource& source, sources)
+	{
+		const Star* s = static_cast<const Star*>(source.star);
+		const RCMag* tmpRcmag = &rcmag_table[source.extinctedMagIndex];
+		drawer->drawProjectedPointSource(sPainter, source.win, *tmpRcmag, s->getBVIndex(), source.twinkleFactor);
+		if (s->hasName() && source.extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
 		{
 			const float offset = tmpRcmag->radius*0.7f;
 			const Vec3f colorr = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
 			sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
-			sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), s->getNameI18n(), 0, offset, offset, false);
+			sPainter->drawText(Vec3d(source.pos[0], source.pos[1], source.pos[2]), s->getNameI18n(), 0, offset, offset, false);
 		}
 	}
 }
@@ -549,6 +897,8 @@ template<class Star>
 void SpecialZoneArray<Star>::searchAround(const StelCore* core, int index, const Vec3d &v, double cosLimFov,
 					  QList<StelObjectP > &result)
 {
+	if (!requireZone(index))
+		return;
 	static const double d2000 = 2451545.0;
 	const double movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25)/ star_position_scale;
 	const SpecialZoneData<Star> *const z = getZones()+index;
@@ -24,6 +24,7 @@
 #define _ZONEARRAY_HPP_
 
 #include "ZoneData.hpp"
+#include "ZoneSoA.hpp"
 #include "Star.hpp"
 
 #include "StelCore.hpp"
@@ -33,12 +34,15 @@
 #include <QString>
 #include <QFile>
 #include <QDebug>
+#include <QMutex>
+#include <QFuture>
 
 #ifdef __OpenBSD__
 #include <unistd.h>
 #endif
 
 class StelPainter;
+class StelGeodesicGrid;
 
 // Patch by Rainer Canavan for compilation on irix with mipspro compiler part 1
 #ifndef MAP_NORESERVE
@@ -68,6 +72,19 @@ struct HipIndexStruct
 	const Star1 *s;
 };
 
+//! @struct StarPointSource
+//! A star which passed the culling stage of SpecialZoneArray::cullZone and is
+//! ready to be handed over to StelSkyDrawer. Culling and projection are done
+//! by worker threads, the (OpenGL bound) drawing is done in the main thread.
+struct StarPointSource
+{
+	Vec3f pos;		// J2000 position, as it would be passed to StelSkyDrawer::drawPointSource
+	Vec3f win;		// Position in viewport coordinates
+	const void *star;	// The Star1, Star2 or Star3 record this source comes from
+	float twinkleFactor;
+	int extinctedMagIndex;	// Index in the RCMag table, extinction taken into account
+};
+
 //! @class ZoneArray
 //! Manages all ZoneData structures of a given StelGeodesicGrid level. An
 //! instance of this class is never created directly; the named constructor
@@ -81,10 +98,13 @@ public:
 	//! loading.
 	//! @param extended_file_name path of the star catalog to load from
 	//! @param use_mmap whether or not to mmap the star catalog
+	//! @param streaming whether the zones are read from the file only when they are
+	//! needed, see isStreaming(). Ignored for the Hipparcos catalog.
 	//! @return an instance of SpecialZoneArray or HipZoneArray
-	static ZoneArray *create(const QString &extended_file_name, bool use_mmap);
+	static ZoneArray *create(const QString &extended_file_name, bool use_mmap, bool streaming=false);
 	virtual ~ZoneArray()
 	{
+		setFlagSoA(false);
 		nr_of_zones = 0;
 	}
 
@@ -104,6 +124,16 @@ public:
 					  int maxMagStarName, float names_brightness,
 					  const QVector<SphericalCap>& boundingCaps) const = 0;
 
+	//! Pure virtual method. See subclass implementation.
+	virtual void cullZone(int index, bool is_inside, const RCMag* rcmag_table, int limitMagIndex,
+			      const StelCore* core, const StelProjectorP& prj,
+			      const QVector<SphericalCap>& boundingCaps, QVector<StarPointSource>& result) const = 0;
+
+	//! Pure virtual method. See subclass implementation.
+	virtual void drawCulled(StelPainter* sPainter, const QVector<StarPointSource>& sources,
+				const RCMag* rcmag_table, StelCore* core,
+				int maxMagStarName, float names_brightness) const = 0;
+
 	//! Get whether or not the catalog was successfully loaded.
 	//! @return @c true if at least one zone was loaded, otherwise @c false
 	bool isInitialized(void) const { return (nr_of_zones>0); }
@@ -113,6 +143,35 @@ public:
 	
 	virtual void scaleAxis() = 0;
 
+	//! Set whether the stars are culled from decoded copies of the zones (see ZoneSoA)
+	//! instead of the packed records. A copy is built the first time a zone is culled.
+	void setFlagSoA(bool b);
+	//! Get whether the stars are culled from decoded copies of the zones.
+	bool getFlagSoA() const {return soaZones!=NULL;}
+	//! To be called once per drawn frame, whether this catalog was drawn or not.
+	//! Decoded copies and streamed zones which were not used during the last
+	//! frames are released, and streamed zones are evicted in least recently used
+	//! order until the memory budget is respected.
+	void nextFrame();
+
+	//! Get whether the zones are read from the catalog file only when they are
+	//! culled, searched or prefetched, instead of loading the whole catalog.
+	bool isStreaming() const {return zoneOffsets!=NULL;}
+	//! Set the amount of memory the streamed zones may use, in bytes.
+	void setStreamingBudget(qint64 bytes) {streamingBudget = bytes;}
+	//! Get the amount of memory the streamed zones may use, in bytes.
+	qint64 getStreamingBudget() const {return streamingBudget;}
+	//! Get the amount of memory currently used by the streamed zones, in bytes.
+	qint64 getStreamedBytes() const;
+	//! Load in a worker thread the zones which are adjacent to the border zones of a
+	//! search result, so that they are ready when the view moves. Does nothing if
+	//! the border did not change since the last call or a prefetch is still running.
+	void prefetchNeighbours(const GeodesicSearchResult* searchResult, const StelGeodesicGrid* grid);
+	//! Make sure the stars of a zone are in memory, reading them from the file in streaming mode.
+	//! Can be called from several threads at once.
+	//! @return false if the zone could not be read
+	bool requireZone(int index) const;
+
 	//! File path of the catalog.
 	const QString fname;
 
@@ -137,10 +196,39 @@ protected:
 
 	//! Protected constructor. Initializes fields and does not load anything.
 	ZoneArray(const QString& fname, QFile* file, int level, int mag_min, int mag_range, int mag_steps);
+
+	//! Read the stars of a zone from the file. Called with streamMutex locked.
+	virtual bool readZone(int index) const = 0;
+	//! Free the stars of a zone read by readZone(). Called with streamMutex locked.
+	virtual void freeZone(int index) const = 0;
+	//! Free all streamed zones and stop streaming.
+	void clearStreaming();
+	//! Size of one star record.
+	virtual int getStarSize() const = 0;
 	unsigned int nr_of_zones;
 	unsigned int nr_of_stars;
 	ZoneData *zones;
 	QFile* file;
+
+	//! Decoded copies of the zones, or NULL if not used. The entry of a zone
+	//! is NULL until the zone is culled for the first time. Each zone is culled
+	//! by a single thread at a time, so the entries can be built without locking.
+	mutable ZoneSoA **soaZones;
+	//! Frame counter for releasing the decoded copies of zones which are not visible anymore.
+	unsigned int frame;
+
+	//! Offset in the file of the stars of each zone in streaming mode, NULL otherwise.
+	qint64 *zoneOffsets;
+	//! Frame counter value of the last use of each zone in streaming mode.
+	mutable unsigned int *zoneLastUsed;
+	//! Zones currently in memory in streaming mode.
+	mutable QVector<int> loadedZones;
+	mutable qint64 streamedBytes;
+	qint64 streamingBudget;
+	//! Protects the file, the stars pointers of the zones and the fields above.
+	mutable QMutex streamMutex;
+	QFuture<void> prefetchFuture;
+	QVector<int> lastPrefetchBorder;
 };
 
 //! @class SpecialZoneArray
@@ -160,8 +248,9 @@ public:
 	//! @param mag_min lower bound of magnitudes
 	//! @param mag_range range of magnitudes
 	//! @param mag_steps number of steps used to describe values in range
+	//! @param streaming whether to read the zones only when they are needed
 	SpecialZoneArray(QFile* file,bool byte_swap,bool use_mmap,int level,int mag_min,
-			 int mag_range,int mag_steps);
+			 int mag_range,int mag_steps,bool streaming=false);
 	~SpecialZoneArray(void);
 protected:
 	//! Get an array of all SpecialZoneData objects in this catalog.
@@ -184,12 +273,60 @@ protected:
 			  int maxMagStarName, float names_brightness,
 			  const QVector<SphericalCap>& boundingCaps) const;
 
+	//! Collect the visible stars of a zone without drawing them. This does
+	//! the same culling and projection as draw() and is safe to call from
+	//! worker threads concurrently for different zones.
+	//! @param index zone index to cull
+	//! @param isInsideViewport whether the zone is inside the current viewport
+	//! @param rcmag_table table of magnitudes
+	//! @param limitMagIndex index from rcmag_table at which stars are not visible anymore
+	//! @param core core to use for the coordinate transformations
+	//! @param prj projector used for computing the viewport positions
+	//! @param boundingCaps caps bounding the viewport
+	//! @param result the visible stars are appended to this list, in drawing order
+	virtual void cullZone(int index, bool isInsideViewport, const RCMag* rcmag_table, int limitMagIndex,
+			      const StelCore* core, const StelProjectorP& prj,
+			      const QVector<SphericalCap>& boundingCaps, QVector<StarPointSource>& result) const;
+
+	//! Draw stars previously collected by cullZone() and their names.
+	//! Must be called from the main thread. Calling cullZone() then drawCulled()
+	//! gives exactly the same result as calling draw().
+	virtual void drawCulled(StelPainter* sPainter, const QVector<StarPointSource>& sources,
+				const RCMag* rcmag_table, StelCore* core,
+				int maxMagStarName, float names_brightness) const;
+
 	virtual void scaleAxis();
+	virtual bool readZone(int index) const;
+	virtual void freeZone(int index) const;
+	virtual int getStarSize() const {return sizeof(Star);}
 	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
 					  QList<StelObjectP > &result);
 
 	Star *stars;
 private:
+	//! Per call values shared by all stars of a zone during culling.
+	struct CullParams
+	{
+		float movementFactor;
+		bool withExtinction;
+		float k;
+		int cutoffMagStep;
+	};
+
+	//! Compute the culling parameters, see draw() for the meaning of the arguments.
+	void initCullParams(const StelCore* core, int limitMagIndex, CullParams& params) const;
+
+	//! Implementation of cullZone() using the decoded copy of the zone.
+	void cullDecodedZone(int index, bool isInsideViewport, const RCMag* rcmag_table, const CullParams& params,
+			     const StelCore* core, const StelProjectorP& prj,
+			     const QVector<SphericalCap>& boundingCaps, QVector<StarPointSource>& result) const;
+
+	//! Compute the position and extincted magnitude of a star and check its visibility.
+	//! @return false if the star must not be drawn
+	bool cullStar(const Star* s, const SpecialZoneData<Star>* zone, bool isInsideViewport,
+		      const CullParams& params, const StelCore* core, const QVector<SphericalCap>& boundingCaps,
+		      Vec3f& vf, int& extinctedMagIndex, float& twinkleFactor) const;
+
 	uchar *mmap_start;
 };
 
@@ -0,0 +1,474 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "ZoneSoA.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// The SIMD kernels are compiled with function attributes, so that the rest of
+// the program does not need to be compiled with -mavx2. The CPU is checked at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define ZONESOA_X86
+# define ZONESOA_TARGET_SSE2 __attribute__((target("sse2")))
+# define ZONESOA_TARGET_AVX2 __attribute__((target("avx2")))
+# include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# define ZONESOA_X86
+# define ZONESOA_TARGET_SSE2
+# define ZONESOA_TARGET_AVX2
+# include <immintrin.h>
+# include <intrin.h>
+#endif
+
+// Same values as Extinction::UndergroundExtinctionMode
+static const int UndergroundExtinctionZero = 0;
+static const int UndergroundExtinctionMax = 1;
+
+// Padding of the arrays, in number of stars
+static const int SoAPadding = 8;
+
+void ZoneSoA::allocate(int n)
+{
+	clear();
+	size = n;
+	const int padded = (n + SoAPadding-1) / SoAPadding * SoAPadding;
+	if (padded==0)
+		return;
+	// 4 float arrays followed by the 2 byte arrays, all starting on 32 bytes boundaries
+	data = qMallocAligned(padded*(4*sizeof(float)+2), 32);
+	Q_ASSERT(data);
+	memset(data, 0, padded*(4*sizeof(float)+2));
+	x0 = static_cast<float*>(data);
+	x1 = x0 + padded;
+	dx0 = x1 + padded;
+	dx1 = dx0 + padded;
+	mag = reinterpret_cast<quint8*>(dx1 + padded);
+	bV = mag + padded;
+}
+
+void ZoneSoA::clear()
+{
+	if (data)
+		qFreeAligned(data);
+	data = NULL;
+	x0 = x1 = dx0 = dx1 = NULL;
+	mag = bV = NULL;
+	size = 0;
+	built = false;
+}
+
+void ZoneSoACullResult::resize(int n)
+{
+	if ((int)index.size()>=n)
+		return;
+	index.resize(n);
+	x.resize(n);
+	y.resize(n);
+	z.resize(n);
+	magIndex.resize(n);
+	twinkleFactor.resize(n);
+}
+
+// Number of stars to process: the stars are sorted by magnitude, and like
+// in SpecialZoneArray::draw we stop at the first one fainter than the cutoff.
+static int nbStarsBrighterThanCutoff(const ZoneSoA& soa, int cutoffMagStep)
+{
+	int n = 0;
+	while (n<soa.size && soa.mag[n]<=cutoffMagStep)
+		++n;
+	return n;
+}
+
+// Same as Extinction::airmass(cosZ, false)
+static inline float geometricAirmass(float cosZ, int undergroundExtinctionMode)
+{
+	if (cosZ<-0.035f)
+	{
+		if (undergroundExtinctionMode==UndergroundExtinctionZero)
+			return 0.f;
+		if (undergroundExtinctionMode==UndergroundExtinctionMax)
+			return 42.f;
+		cosZ = std::min(1.f, -0.035f - (cosZ+0.035f));
+	}
+	const float nom=(1.002432f*cosZ+0.148386f)*cosZ+0.0096467f;
+	const float denum=((cosZ+0.149864f)*cosZ+0.0102963f)*cosZ+0.000303978f;
+	return nom/denum;
+}
+
+/*************************************************************************
+ Portable implementation, this is the reference for the SIMD versions.
+*************************************************************************/
+static int cullZoneSoAScalar(const ZoneSoA& soa, const ZoneSoACullParams& p, ZoneSoACullResult& r)
+{
+	const int n = nbStarsBrighterThanCutoff(soa, p.cutoffMagStep);
+	int nb = 0;
+	for (int i=0;i<n;++i)
+	{
+		Vec3f vf = p.axis0;
+		vf *= soa.x0[i]+p.movementFactor*soa.dx0[i];
+		vf += (soa.x1[i]+p.movementFactor*soa.dx1[i])*p.axis1;
+		vf += p.center;
+
+		if (p.checkCaps)
+		{
+			vf.normalize();
+			bool isVisible = true;
+			for (int c=0;c<p.nbCaps && isVisible;++c)
+			{
+				const double* cap = p.caps+4*c;
+				isVisible = vf[0]*cap[0]+vf[1]*cap[1]+vf[2]*cap[2]>=cap[3];
+			}
+			if (!isVisible)
+				continue;
+		}
+
+		int magIndex = soa.mag[i];
+		float twinkleFactor = 1.f;
+		if (p.withExtinction)
+		{
+			Vec3f altAz(vf);
+			altAz.normalize();
+			const float cosZ = p.altAzRow[0]*altAz[0] + p.altAzRow[1]*altAz[1] + p.altAzRow[2]*altAz[2] + p.altAzRow[3];
+			const float extMagShift = 0.f + geometricAirmass(cosZ, p.undergroundExtinctionMode)*p.extinctionCoefficient;
+			magIndex = soa.mag[i] + (int)(extMagShift/p.k);
+			if (magIndex >= p.cutoffMagStep)
+				continue;
+			twinkleFactor = qMin(1.0f, 1.0f-0.9f*cosZ);
+		}
+
+		r.index[nb] = i;
+		r.x[nb] = vf[0];
+		r.y[nb] = vf[1];
+		r.z[nb] = vf[2];
+		r.magIndex[nb] = magIndex;
+		r.twinkleFactor[nb] = twinkleFactor;
+		++nb;
+	}
+	return nb;
+}
+
+#ifdef ZONESOA_X86
+
+/*************************************************************************
+ SSE2 implementation, 4 stars at a time.
+ The double precision parts (caps and AltAz) match the scalar code, which
+ promotes the float coordinates to double there.
+*************************************************************************/
+ZONESOA_TARGET_SSE2
+static inline int sse2CapsMask(__m128 x, __m128 y, __m128 z, const ZoneSoACullParams& p)
+{
+	const __m128d xl = _mm_cvtps_pd(x), xh = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+	const __m128d yl = _mm_cvtps_pd(y), yh = _mm_cvtps_pd(_mm_movehl_ps(y, y));
+	const __m128d zl = _mm_cvtps_pd(z), zh = _mm_cvtps_pd(_mm_movehl_ps(z, z));
+	int bits = 0xF;
+	for (int c=0;c<p.nbCaps && bits;++c)
+	{
+		const double* cap = p.caps+4*c;
+		const __m128d n0 = _mm_set1_pd(cap[0]), n1 = _mm_set1_pd(cap[1]), n2 = _mm_set1_pd(cap[2]), d = _mm_set1_pd(cap[3]);
+		const __m128d dl = _mm_add_pd(_mm_add_pd(_mm_mul_pd(xl, n0), _mm_mul_pd(yl, n1)), _mm_mul_pd(zl, n2));
+		const __m128d dh = _mm_add_pd(_mm_add_pd(_mm_mul_pd(xh, n0), _mm_mul_pd(yh, n1)), _mm_mul_pd(zh, n2));
+		bits &= _mm_movemask_pd(_mm_cmpge_pd(dl, d)) | (_mm_movemask_pd(_mm_cmpge_pd(dh, d))<<2);
+	}
+	return bits;
+}
+
+ZONESOA_TARGET_SSE2
+static inline void sse2Normalize(__m128& x, __m128& y, __m128& z)
+{
+	const __m128 s = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+	x = _mm_mul_ps(x, s);
+	y = _mm_mul_ps(y, s);
+	z = _mm_mul_ps(z, s);
+}
+
+ZONESOA_TARGET_SSE2
+static int cullZoneSoASSE2(const ZoneSoA& soa, const ZoneSoACullParams& p, ZoneSoACullResult& r)
+{
+	const int n = nbStarsBrighterThanCutoff(soa, p.cutoffMagStep);
+	const __m128 mf = _mm_set1_ps(p.movementFactor);
+	const __m128 a0x = _mm_set1_ps(p.axis0[0]), a0y = _mm_set1_ps(p.axis0[1]), a0z = _mm_set1_ps(p.axis0[2]);
+	const __m128 a1x = _mm_set1_ps(p.axis1[0]), a1y = _mm_set1_ps(p.axis1[1]), a1z = _mm_set1_ps(p.axis1[2]);
+	const __m128 cx = _mm_set1_ps(p.center[0]), cy = _mm_set1_ps(p.center[1]), cz = _mm_set1_ps(p.center[2]);
+	const __m128i cutoff = _mm_set1_epi32(p.cutoffMagStep);
+	const __m128i zero = _mm_setzero_si128();
+
+	float ox[4], oy[4], oz[4], ot[4];
+	int om[4];
+	int nb = 0;
+	for (int i=0;i<n;i+=4)
+	{
+		int bits = n-i>=4 ? 0xF : (1<<(n-i))-1;
+
+		const __m128 f0 = _mm_add_ps(_mm_load_ps(soa.x0+i), _mm_mul_ps(mf, _mm_load_ps(soa.dx0+i)));
+		const __m128 f1 = _mm_add_ps(_mm_load_ps(soa.x1+i), _mm_mul_ps(mf, _mm_load_ps(soa.dx1+i)));
+		__m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0x, f0), _mm_mul_ps(f1, a1x)), cx);
+		__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0y, f0), _mm_mul_ps(f1, a1y)), cy);
+		__m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0z, f0), _mm_mul_ps(f1, a1z)), cz);
+
+		if (p.checkCaps)
+		{
+			sse2Normalize(x, y, z);
+			bits &= sse2CapsMask(x, y, z, p);
+			if (!bits)
+				continue;
+		}
+
+		int mags;
+		memcpy(&mags, soa.mag+i, 4);
+		__m128i magIndex = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(mags), zero), zero);
+		__m128 twinkle = _mm_set1_ps(1.f);
+		if (p.withExtinction)
+		{
+			__m128 ax = x, ay = y, az = z;
+			sse2Normalize(ax, ay, az);
+			const __m128d r0 = _mm_set1_pd(p.altAzRow[0]), r1 = _mm_set1_pd(p.altAzRow[1]), r2 = _mm_set1_pd(p.altAzRow[2]), r3 = _mm_set1_pd(p.altAzRow[3]);
+			const __m128d zl = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(r0, _mm_cvtps_pd(ax)), _mm_mul_pd(r1, _mm_cvtps_pd(ay))), _mm_mul_pd(r2, _mm_cvtps_pd(az))), r3);
+			const __m128d zh = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(r0, _mm_cvtps_pd(_mm_movehl_ps(ax, ax))), _mm_mul_pd(r1, _mm_cvtps_pd(_mm_movehl_ps(ay, ay)))), _mm_mul_pd(r2, _mm_cvtps_pd(_mm_movehl_ps(az, az)))), r3);
+			const __m128 cosZ = _mm_movelh_ps(_mm_cvtpd_ps(zl), _mm_cvtpd_ps(zh));
+
+			// Extinction::airmass(cosZ, false), branch free
+			const __m128 below = _mm_cmplt_ps(cosZ, _mm_set1_ps(-0.035f));
+			__m128 c = cosZ;
+			if (p.undergroundExtinctionMode!=UndergroundExtinctionZero && p.undergroundExtinctionMode!=UndergroundExtinctionMax)
+			{
+				const __m128 mirrored = _mm_min_ps(_mm_set1_ps(1.f), _mm_sub_ps(_mm_set1_ps(-0.035f), _mm_add_ps(cosZ, _mm_set1_ps(0.035f))));
+				c = _mm_or_ps(_mm_and_ps(below, mirrored), _mm_andnot_ps(below, cosZ));
+			}
+			const __m128 nom = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.002432f), c), _mm_set1_ps(0.148386f)), c), _mm_set1_ps(0.0096467f));
+			const __m128 denum = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(c, _mm_set1_ps(0.149864f)), c), _mm_set1_ps(0.0102963f)), c), _mm_set1_ps(0.000303978f));
+			__m128 airmass = _mm_div_ps(nom, denum);
+			if (p.undergroundExtinctionMode==UndergroundExtinctionZero)
+				airmass = _mm_andnot_ps(below, airmass);
+			else if (p.undergroundExtinctionMode==UndergroundExtinctionMax)
+				airmass = _mm_or_ps(_mm_and_ps(below, _mm_set1_ps(42.f)), _mm_andnot_ps(below, airmass));
+
+			const __m128 extMagShift = _mm_mul_ps(airmass, _mm_set1_ps(p.extinctionCoefficient));
+			magIndex = _mm_add_epi32(magIndex, _mm_cvttps_epi32(_mm_div_ps(extMagShift, _mm_set1_ps(p.k))));
+			bits &= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(magIndex, cutoff)));
+			if (!bits)
+				continue;
+			twinkle = _mm_min_ps(_mm_set1_ps(1.f), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(_mm_set1_ps(0.9f), cosZ)));
+		}
+
+		_mm_storeu_ps(ox, x);
+		_mm_storeu_ps(oy, y);
+		_mm_storeu_ps(oz, z);
+		_mm_storeu_ps(ot, twinkle);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(om), magIndex);
+		for (int l=0;l<4;++l)
+		{
+			if (!(bits & (1<<l)))
+				continue;
+			r.index[nb] = i+l;
+			r.x[nb] = ox[l];
+			r.y[nb] = oy[l];
+			r.z[nb] = oz[l];
+			r.magIndex[nb] = om[l];
+			r.twinkleFactor[nb] = ot[l];
+			++nb;
+		}
+	}
+	return nb;
+}
+
+/*************************************************************************
+ AVX2 implementation, 8 stars at a time.
+*************************************************************************/
+ZONESOA_TARGET_AVX2
+static inline __m256d avx2Dot(__m128 x, __m128 y, __m128 z, __m256d n0, __m256d n1, __m256d n2)
+{
+	return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(x), n0), _mm256_mul_pd(_mm256_cvtps_pd(y), n1)), _mm256_mul_pd(_mm256_cvtps_pd(z), n2));
+}
+
+ZONESOA_TARGET_AVX2
+static inline void avx2Normalize(__m256& x, __m256& y, __m256& z)
+{
+	const __m256 s = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z))));
+	x = _mm256_mul_ps(x, s);
+	y = _mm256_mul_ps(y, s);
+	z = _mm256_mul_ps(z, s);
+}
+
+ZONESOA_TARGET_AVX2
+static int cullZoneSoAAVX2(const ZoneSoA& soa, const ZoneSoACullParams& p, ZoneSoACullResult& r)
+{
+	const int n = nbStarsBrighterThanCutoff(soa, p.cutoffMagStep);
+	const __m256 mf = _mm256_set1_ps(p.movementFactor);
+	const __m256 a0x = _mm256_set1_ps(p.axis0[0]), a0y = _mm256_set1_ps(p.axis0[1]), a0z = _mm256_set1_ps(p.axis0[2]);
+	const __m256 a1x = _mm256_set1_ps(p.axis1[0]), a1y = _mm256_set1_ps(p.axis1[1]), a1z = _mm256_set1_ps(p.axis1[2]);
+	const __m256 cx = _mm256_set1_ps(p.center[0]), cy = _mm256_set1_ps(p.center[1]), cz = _mm256_set1_ps(p.center[2]);
+	const __m256i cutoff = _mm256_set1_epi32(p.cutoffMagStep);
+
+	float ox[8], oy[8], oz[8], ot[8];
+	int om[8];
+	int nb = 0;
+	for (int i=0;i<n;i+=8)
+	{
+		int bits = n-i>=8 ? 0xFF : (1<<(n-i))-1;
+
+		const __m256 f0 = _mm256_add_ps(_mm256_load_ps(soa.x0+i), _mm256_mul_ps(mf, _mm256_load_ps(soa.dx0+i)));
+		const __m256 f1 = _mm256_add_ps(_mm256_load_ps(soa.x1+i), _mm256_mul_ps(mf, _mm256_load_ps(soa.dx1+i)));
+		__m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0x, f0), _mm256_mul_ps(f1, a1x)), cx);
+		__m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0y, f0), _mm256_mul_ps(f1, a1y)), cy);
+		__m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0z, f0), _mm256_mul_ps(f1, a1z)), cz);
+
+		if (p.checkCaps)
+		{
+			avx2Normalize(x, y, z);
+			const __m128 xl = _mm256_castps256_ps128(x), xh = _mm256_extractf128_ps(x, 1);
+			const __m128 yl = _mm256_castps256_ps128(y), yh = _mm256_extractf128_ps(y, 1);
+			const __m128 zl = _mm256_castps256_ps128(z), zh = _mm256_extractf128_ps(z, 1);
+			for (int c=0;c<p.nbCaps && bits;++c)
+			{
+				const double* cap = p.caps+4*c;
+				const __m256d n0 = _mm256_set1_pd(cap[0]), n1 = _mm256_set1_pd(cap[1]), n2 = _mm256_set1_pd(cap[2]), d = _mm256_set1_pd(cap[3]);
+				bits &= _mm256_movemask_pd(_mm256_cmp_pd(avx2Dot(xl, yl, zl, n0, n1, n2), d, _CMP_GE_OQ))
+				      | (_mm256_movemask_pd(_mm256_cmp_pd(avx2Dot(xh, yh, zh, n0, n1, n2), d, _CMP_GE_OQ))<<4);
+			}
+			if (!bits)
+				continue;
+		}
+
+		__m256i magIndex = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(soa.mag+i)));
+		__m256 twinkle = _mm256_set1_ps(1.f);
+		if (p.withExtinction)
+		{
+			__m256 ax = x, ay = y, az = z;
+			avx2Normalize(ax, ay, az);
+			const __m256d r0 = _mm256_set1_pd(p.altAzRow[0]), r1 = _mm256_set1_pd(p.altAzRow[1]), r2 = _mm256_set1_pd(p.altAzRow[2]), r3 = _mm256_set1_pd(p.altAzRow[3]);
+			const __m256d zl = _mm256_add_pd(avx2Dot(_mm256_castps256_ps128(ax), _mm256_castps256_ps128(ay), _mm256_castps256_ps128(az), r0, r1, r2), r3);
+			const __m256d zh = _mm256_add_pd(avx2Dot(_mm256_extractf128_ps(ax, 1), _mm256_extractf128_ps(ay, 1), _mm256_extractf128_ps(az, 1), r0, r1, r2), r3);
+			const __m256 cosZ = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(zl)), _mm256_cvtpd_ps(zh), 1);
+
+			// Extinction::airmass(cosZ, false), branch free
+			const __m256 below = _mm256_cmp_ps(cosZ, _mm256_set1_ps(-0.035f), _CMP_LT_OQ);
+			__m256 c = cosZ;
+			if (p.undergroundExtinctionMode!=UndergroundExtinctionZero && p.undergroundExtinctionMode!=UndergroundExtinctionMax)
+			{
+				const __m256 mirrored = _mm256_min_ps(_mm256_set1_ps(1.f), _mm256_sub_ps(_mm256_set1_ps(-0.035f), _mm256_add_ps(cosZ, _mm256_set1_ps(0.035f))));
+				c = _mm256_blendv_ps(cosZ, mirrored, below);
+			}
+			const __m256 nom = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.002432f), c), _mm256_set1_ps(0.148386f)), c), _mm256_set1_ps(0.0096467f));
+			const __m256 denum = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(c, _mm256_set1_ps(0.149864f)), c), _mm256_set1_ps(0.0102963f)), c), _mm256_set1_ps(0.000303978f));
+			__m256 airmass = _mm256_div_ps(nom, denum);
+			if (p.undergroundExtinctionMode==UndergroundExtinctionZero)
+				airmass = _mm256_andnot_ps(below, airmass);
+			else if (p.undergroundExtinctionMode==UndergroundExtinctionMax)
+				airmass = _mm256_blendv_ps(airmass, _mm256_set1_ps(42.f), below);
+
+			const __m256 extMagShift = _mm256_mul_ps(airmass, _mm256_set1_ps(p.extinctionCoefficient));
+			magIndex = _mm256_add_epi32(magIndex, _mm256_cvttps_epi32(_mm256_div_ps(extMagShift, _mm256_set1_ps(p.k))));
+			bits &= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cutoff, magIndex)));
+			if (!bits)
+				continue;
+			twinkle = _mm256_min_ps(_mm256_set1_ps(1.f), _mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_mul_ps(_mm256_set1_ps(0.9f), cosZ)));
+		}
+
+		_mm256_storeu_ps(ox, x);
+		_mm256_storeu_ps(oy, y);
+		_mm256_storeu_ps(oz, z);
+		_mm256_storeu_ps(ot, twinkle);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(om), magIndex);
+		for (int l=0;l<8;++l)
+		{
+			if (!(bits & (1<<l)))
+				continue;
+			r.index[nb] = i+l;
+			r.x[nb] = ox[l];
+			r.y[nb] = oy[l];
+			r.z[nb] = oz[l];
+			r.magIndex[nb] = om[l];
+			r.twinkleFactor[nb] = ot[l];
+			++nb;
+		}
+	}
+	return nb;
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0]<7)
+		return false;
+	__cpuid(info, 1);
+	// The OS must save the AVX registers
+	const bool osxsave = (info[2] & (1<<27)) && (info[2] & (1<<28));
+	if (!osxsave || (_xgetbv(0) & 6)!=6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1<<5))!=0;
+#endif
+}
+
+#endif // ZONESOA_X86
+
+bool isZoneSoAKernelSupported(ZoneSoAKernel kernel)
+{
+	switch (kernel)
+	{
+		case ZoneSoAKernelScalar:
+			return true;
+#ifdef ZONESOA_X86
+		case ZoneSoAKernelSSE2:
+#if defined(__GNUC__)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2");
+#else
+			return true;
+#endif
+		case ZoneSoAKernelAVX2:
+			return cpuHasAVX2();
+#endif
+		default:
+			return false;
+	}
+}
+
+ZoneSoAKernel getBestZoneSoAKernel()
+{
+	if (isZoneSoAKernelSupported(ZoneSoAKernelAVX2))
+		return ZoneSoAKernelAVX2;
+	if (isZoneSoAKernelSupported(ZoneSoAKernelSSE2))
+		return ZoneSoAKernelSSE2;
+	return ZoneSoAKernelScalar;
+}
+
+int cullZoneSoA(ZoneSoAKernel kernel, const ZoneSoA& soa, const ZoneSoACullParams& params, ZoneSoACullResult& result)
+{
+	Q_ASSERT(soa.built);
+	Q_ASSERT((int)result.index.size()>=soa.size);
+	switch (kernel)
+	{
+#ifdef ZONESOA_X86
+		case ZoneSoAKernelSSE2:
+			return cullZoneSoASSE2(soa, params, result);
+		case ZoneSoAKernelAVX2:
+			return cullZoneSoAAVX2(soa, params, result);
+#endif
+		default:
+			return cullZoneSoAScalar(soa, params, result);
+	}
+}
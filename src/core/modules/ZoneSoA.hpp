@@ -0,0 +1,163 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _ZONESOA_HPP_
+#define _ZONESOA_HPP_
+
+#include "ZoneData.hpp"
+
+#include <QtGlobal>
+#include <vector>
+
+//! @struct ZoneSoA
+//! Decoded copy of the stars of one zone, stored as a structure of arrays.
+//! The packed Star1/Star2/Star3 records are kept for disk and for zones which
+//! are not visible; the decoded arrays are built the first time a zone
+//! is culled, so that the culling can be done for several stars at once
+//! with SIMD instructions (see cullZoneSoA()).
+//! All arrays are 32 bytes aligned and padded to a multiple of 8 stars.
+struct ZoneSoA
+{
+	ZoneSoA() : size(0), built(false), lastUsed(0), x0(NULL), x1(NULL), dx0(NULL), dx1(NULL), mag(NULL), bV(NULL), data(NULL) {}
+	~ZoneSoA() {clear();}
+
+	//! Allocate the arrays for n stars. Previous content is lost.
+	void allocate(int n);
+	//! Free the arrays and mark the zone as not built.
+	void clear();
+
+	//! Number of stars.
+	int size;
+	//! Whether the arrays contain the decoded stars.
+	bool built;
+	//! Frame counter value of the last culling, used for releasing cold zones.
+	unsigned int lastUsed;
+
+	//! Star positions relative to the zone axes, in units of the packed format
+	float *x0, *x1;
+	//! Proper motions, in units of the packed format (0 for Star3)
+	float *dx0, *dx1;
+	//! Magnitude index, as returned by Star::getMag()
+	quint8 *mag;
+	//! B-V index, as returned by Star::getBVIndex()
+	quint8 *bV;
+
+private:
+	void *data;
+	ZoneSoA(const ZoneSoA&);
+	ZoneSoA& operator=(const ZoneSoA&);
+};
+
+//! Decode the stars of a packed zone into a ZoneSoA.
+//! @tparam Star either Star1, Star2 or Star3
+template <class Star>
+void buildZoneSoA(const SpecialZoneData<Star>* zone, ZoneSoA& soa)
+{
+	soa.allocate(zone->size);
+	const Star* s = zone->getStars();
+	for (int i=0;i<zone->size;++i,++s)
+	{
+		soa.x0[i] = (float)s->getX0();
+		soa.x1[i] = (float)s->getX1();
+		soa.dx0[i] = (float)s->getDx0();
+		soa.dx1[i] = (float)s->getDx1();
+		soa.mag[i] = (quint8)s->getMag();
+		soa.bV[i] = (quint8)s->getBVIndex();
+	}
+	soa.built = true;
+}
+
+//! @struct ZoneSoACullParams
+//! Values used by cullZoneSoA() which are the same for all stars of a zone.
+//! These reproduce the computations of SpecialZoneArray::draw().
+struct ZoneSoACullParams
+{
+	//! Zone center and (scaled) axes, see ZoneData.
+	Vec3f center, axis0, axis1;
+	//! Proper motion factor for the current date.
+	float movementFactor;
+	//! Stars with a magnitude index above this value are not drawn.
+	int cutoffMagStep;
+	//! Set to true for zones which are not fully inside the viewport: the
+	//! positions are then normalized and tested against the caps.
+	bool checkCaps;
+	//! Number of caps bounding the viewport.
+	int nbCaps;
+	//! The caps bounding the viewport, 4 values per cap: n[0], n[1], n[2], d.
+	const double* caps;
+	//! Whether the atmospheric extinction must be applied.
+	bool withExtinction;
+	//! Third row of the J2000 to AltAz matrix, i.e. the elements 2, 6, 10 and 14 of the Mat4d.
+	double altAzRow[4];
+	//! Extinction coefficient in mag/airmass.
+	float extinctionCoefficient;
+	//! The Extinction::UndergroundExtinctionMode in use.
+	int undergroundExtinctionMode;
+	//! Size of a magnitude index step in magnitudes.
+	float k;
+};
+
+//! @struct ZoneSoACullResult
+//! Output of cullZoneSoA(). There is one entry per visible star, in the order of the zone.
+struct ZoneSoACullResult
+{
+	//! Reserve enough space for n visible stars.
+	void resize(int n);
+
+	//! Index of the star in the zone.
+	std::vector<int> index;
+	//! J2000 position, normalized if ZoneSoACullParams::checkCaps is set.
+	std::vector<float> x, y, z;
+	//! Magnitude index with extinction applied.
+	std::vector<int> magIndex;
+	//! Height dependent twinkle factor.
+	std::vector<float> twinkleFactor;
+};
+
+//! Available implementations of cullZoneSoA().
+enum ZoneSoAKernel
+{
+	ZoneSoAKernelScalar,	//!< Portable implementation, one star at a time
+	ZoneSoAKernelSSE2,	//!< 4 stars at a time
+	ZoneSoAKernelAVX2	//!< 8 stars at a time
+};
+
+//! Get the fastest implementation supported by the CPU we are running on.
+ZoneSoAKernel getBestZoneSoAKernel();
+
+//! Check whether an implementation can be used on this CPU (and was compiled in).
+bool isZoneSoAKernelSupported(ZoneSoAKernel kernel);
+
+//! Apply proper motion, normalization, viewport caps containment and extinction shifted magnitude
+//! cutoff to the stars of a decoded zone.
+//! @param kernel the implementation to use, which must be supported
+//! @param soa the decoded zone
+//! @param params the culling parameters
+//! @param result receives the visible stars, must have been resized to at least soa.size
+//! @return the number of visible stars
+int cullZoneSoA(ZoneSoAKernel kernel, const ZoneSoA& soa, const ZoneSoACullParams& params, ZoneSoACullResult& result);
+
+//! Same as above, using the fastest implementation.
+inline int cullZoneSoA(const ZoneSoA& soa, const ZoneSoACullParams& params, ZoneSoACullResult& result)
+{
+	static const ZoneSoAKernel kernel = getBestZoneSoAKernel();
+	return cullZoneSoA(kernel, soa, params, result);
+}
+
+#endif // _ZONESOA_HPP_
@@ -0,0 +1,336 @@
+/*
+Copyright (C) 2016 Stellarium Developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Library General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+*/
+
+#include "EphemCache.hpp"
+#include "vsop87.h"
+#include "elp82b.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Degree of the polynomials
+#define EPHEM_CACHE_DEGREE 13
+#define EPHEM_CACHE_NODES (EPHEM_CACHE_DEGREE+1)
+// Number of segments kept per group
+#define EPHEM_CACHE_SEGMENTS 512
+// Number of dates answered by the series inside a segment before it is fitted
+#define EPHEM_CACHE_FIT_AFTER 4
+// Segments are never made shorter than this, in days
+#define EPHEM_CACHE_MIN_DURATION (1./64.)
+// Smallest accuracy bound accepted, in AU
+#define EPHEM_CACHE_MIN_ACCURACY 1e-10
+
+namespace
+{
+	// The VSOP87 planets are fitted together, the Moon separately.
+	enum Group
+	{
+		GroupVsop87,
+		GroupMoon,
+		NbGroups
+	};
+
+	// Number of bodies in each group
+	const int groupSizes[NbGroups] = {8, 1};
+
+	// Initial segment lengths in days. They are halved automatically when
+	// a fit does not reach the requested accuracy.
+	const double defaultDurations[NbGroups] = {32., 4.};
+
+	struct Segment
+	{
+		explicit Segment(int nbBodies) : c(nbBodies*3*EPHEM_CACHE_NODES) {}
+		// Coefficients of body b, coordinate i start at (b*3+i)*EPHEM_CACHE_NODES
+		QVector<double> c;
+	};
+
+	struct GroupCache
+	{
+		GroupCache() : duration(0.), lastMiss(0), lastMissJDE(0.), nbMisses(0), failedKey(0), hasFailed(false), segments(EPHEM_CACHE_SEGMENTS) {}
+		double duration;
+		qint64 lastMiss;
+		double lastMissJDE;
+		int nbMisses;
+		// Last segment which could not be fitted at the shortest duration, answered by the series
+		qint64 failedKey;
+		bool hasFailed;
+		QCache<qint64, Segment> segments;
+	};
+
+	double accuracy = 1e-9;
+	int fitCount = 0;
+	bool initialized = false;
+	GroupCache groups[NbGroups];
+	QMutex mutex;
+
+	inline Group groupOf(int body)
+	{
+		return body==EphemCache::Moon ? GroupMoon : GroupVsop87;
+	}
+
+	// Series value used when a date is not covered by a fitted segment
+	void evalSeries(double jde, int body, double xyz[3])
+	{
+		if (body==EphemCache::Moon)
+			GetElp82bCoor(jde, xyz);
+		else
+			GetVsop87Coor(jde, body, xyz);
+	}
+
+	// Sample the full series for all bodies of a group, xyz receives 3 values per body
+	void sampleGroup(Group group, double jde, double* xyz)
+	{
+		if (group==GroupMoon)
+			GetElp82bCoor(jde, xyz);
+		else
+			GetVsop87CoorAll(jde, xyz);
+	}
+
+	// Sum of c[k]*T_k(x) with the Clenshaw recurrence
+	double evalChebyshev(const double* c, double x)
+	{
+		double b1 = 0., b2 = 0.;
+		for (int k=EPHEM_CACHE_DEGREE; k>=1; --k)
+		{
+			const double b0 = c[k] + 2.*x*b1 - b2;
+			b2 = b1;
+			b1 = b0;
+		}
+		return c[0] + x*b1 - b2;
+	}
+
+	void resetGroups()
+	{
+		for (int g=0; g<NbGroups; ++g)
+		{
+			groups[g].duration = defaultDurations[g];
+			groups[g].nbMisses = 0;
+			groups[g].hasFailed = false;
+			groups[g].segments.clear();
+		}
+		fitCount = 0;
+		initialized = true;
+	}
+
+	// Fit the segment starting at jde0. Return false if the estimated error is above the accuracy bound.
+	bool fitSegment(Group group, double jde0, double duration, Segment* seg)
+	{
+		const int n = groupSizes[group]*3;
+		const double half = 0.5*duration;
+		const double mid = jde0 + half;
+		QVector<double> f(n*EPHEM_CACHE_NODES);
+		double xyz[8*3];
+		for (int j=0; j<EPHEM_CACHE_NODES; ++j)
+		{
+			sampleGroup(group, mid + half*std::cos(M_PI*(j+0.5)/EPHEM_CACHE_NODES), xyz);
+			for (int i=0; i<n; ++i)
+				f[i*EPHEM_CACHE_NODES+j] = xyz[i];
+		}
+
+		bool ok = true;
+		for (int i=0; i<n; ++i)
+		{
+			const double* fi = f.constData() + i*EPHEM_CACHE_NODES;
+			double* ci = seg->c.data() + i*EPHEM_CACHE_NODES;
+			for (int k=0; k<EPHEM_CACHE_NODES; ++k)
+			{
+				double sum = 0.;
+				for (int j=0; j<EPHEM_CACHE_NODES; ++j)
+					sum += fi[j]*std::cos(M_PI*k*(j+0.5)/EPHEM_CACHE_NODES);
+				ci[k] = (k==0 ? 1. : 2.)*sum/EPHEM_CACHE_NODES;
+			}
+			// The coefficients decrease geometrically, the last two bound the truncation error.
+			if (std::fabs(ci[EPHEM_CACHE_DEGREE-1]) + std::fabs(ci[EPHEM_CACHE_DEGREE]) > accuracy)
+				ok = false;
+		}
+		return ok;
+	}
+
+	// Get the fitted segment containing jde, fitting it if needed. Must be called with the mutex locked.
+	// Returns NULL when even the shortest segments do not reach the accuracy bound.
+	Segment* getSegment(Group group, double jde, qint64& key)
+	{
+		GroupCache& cache = groups[group];
+		key = (qint64)std::floor((jde-2451545.0)/cache.duration);
+		Segment* seg = cache.segments.object(key);
+		if (seg)
+			return seg;
+
+		seg = new Segment(groupSizes[group]);
+		while (!fitSegment(group, 2451545.0 + key*cache.duration, cache.duration, seg))
+		{
+			if (cache.duration<=EPHEM_CACHE_MIN_DURATION)
+			{
+				delete seg;
+				cache.nbMisses = 0;
+				cache.failedKey = key;
+				cache.hasFailed = true;
+				return NULL;
+			}
+			cache.duration *= 0.5;
+			cache.segments.clear();
+			key = (qint64)std::floor((jde-2451545.0)/cache.duration);
+		}
+		++fitCount;
+		cache.nbMisses = 0;
+		cache.segments.insert(key, seg);
+		return seg;
+	}
+}
+
+void EphemCache::getCoor(double jde, int body, double xyz[3])
+{
+	Q_ASSERT(body>=0 && body<NbBodies);
+	QMutexLocker lock(&mutex);
+	if (accuracy<=0.)
+	{
+		evalSeries(jde, body, xyz);
+		return;
+	}
+	if (!initialized)
+		resetGroups();
+
+	const Group group = groupOf(body);
+	GroupCache& cache = groups[group];
+	qint64 key = (qint64)std::floor((jde-2451545.0)/cache.duration);
+	Segment* seg = cache.segments.object(key);
+	if (!seg)
+	{
+		// Segments used for a few dates only (e.g. after a jump in time, or when the
+		// time runs very fast) are cheaper with the series.
+		if (cache.nbMisses==0 || cache.lastMiss!=key)
+		{
+			cache.lastMiss = key;
+			cache.nbMisses = 0;
+		}
+		if (cache.nbMisses==0 || cache.lastMissJDE!=jde)
+		{
+			cache.lastMissJDE = jde;
+			++cache.nbMisses;
+		}
+		if (cache.nbMisses<=EPHEM_CACHE_FIT_AFTER || (cache.hasFailed && cache.failedKey==key))
+		{
+			evalSeries(jde, body, xyz);
+			return;
+		}
+		seg = getSegment(group, jde, key);
+		if (!seg)
+		{
+			evalSeries(jde, body, xyz);
+			return;
+		}
+	}
+
+	const double x = 2.*((jde-2451545.0)/cache.duration - key) - 1.;
+	const int b = group==GroupMoon ? 0 : body;
+	const double* c = seg->c.constData() + b*3*EPHEM_CACHE_NODES;
+	xyz[0] = evalChebyshev(c, x);
+	xyz[1] = evalChebyshev(c + EPHEM_CACHE_NODES, x);
+	xyz[2] = evalChebyshev(c + 2*EPHEM_CACHE_NODES, x);
+}
+
+void EphemCache::getOsculatingCoor(double jde0, double jde, int body, double xyz[3])
+{
+	Q_ASSERT(body>=0 && body<Moon);
+	QMutexLocker lock(&mutex);
+	GetVsop87OsculatingCoor(jde0, jde, body, xyz);
+}
+
+void EphemCache::precompute(double jde0, double jde1)
+{
+	QMutexLocker lock(&mutex);
+	if (accuracy<=0.)
+		return;
+	if (!initialized)
+		resetGroups();
+
+	for (int g=0; g<NbGroups; ++g)
+	{
+		int nb = 0;
+		double jde = jde0;
+		while (jde<=jde1 && nb<EPHEM_CACHE_SEGMENTS)
+		{
+			const double duration = groups[g].duration;
+			qint64 key;
+			getSegment((Group)g, jde, key);
+			if (groups[g].duration!=duration)
+			{
+				// The segments were shortened, the previous ones were dropped
+				jde = jde0;
+				nb = 0;
+				continue;
+			}
+			jde = 2451545.0 + (key+1)*duration;
+			++nb;
+		}
+	}
+}
+
+void EphemCache::setAccuracy(double au)
+{
+	QMutexLocker lock(&mutex);
+	// Below this the rounding errors of the series make the fits fail.
+	accuracy = au>0. ? qMax(au, EPHEM_CACHE_MIN_ACCURACY) : 0.;
+	resetGroups();
+}
+
+double EphemCache::getAccuracy()
+{
+	QMutexLocker lock(&mutex);
+	return accuracy;
+}
+
+bool EphemCache::isEnabled()
+{
+	QMutexLocker lock(&mutex);
+	return accuracy>0.;
+}
+
+void EphemCache::clear()
+{
+	QMutexLocker lock(&mutex);
+	for (int g=0; g<NbGroups; ++g)
+	{
+		groups[g].nbMisses = 0;
+		groups[g].hasFailed = false;
+		groups[g].segments.clear();
+	}
+	fitCount = 0;
+}
+
+double EphemCache::getSegmentDuration(int body)
+{
+	Q_ASSERT(body>=0 && body<NbBodies);
+	QMutexLocker lock(&mutex);
+	if (!initialized)
+		resetGroups();
+	return groups[groupOf(body)].duration;
+}
+
+int EphemCache::getFitCount()
+{
+	QMutexLocker lock(&mutex);
+	return fitCount;
+}
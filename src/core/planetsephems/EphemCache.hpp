@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2016 Stellarium Developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Library General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+*/
+
+/*
+ * Cache of Chebyshev approximations of the VSOP87 and ELP82B series.
+ *
+ * Evaluating the full series costs a few thousand terms per call, which is
+ * noticeable when the time runs fast or when many dates are computed (orbits,
+ * light time correction, ephemeris tables). The time axis is split into
+ * segments aligned on J2000.0; when dates are requested repeatedly inside a
+ * segment, the series is sampled at Chebyshev nodes and later calls inside
+ * that segment are answered by evaluating the polynomials.
+ * The error of each fit is estimated from its last coefficients. When it is
+ * larger than the accuracy bound, the segments are halved and the fit is done
+ * again. The eight VSOP87 bodies share their segments, since the series gives
+ * all of them at once.
+ *
+ * All functions are thread safe. GetVsop87Coor() and GetElp82bCoor() keep their
+ * state in static variables, so they must only be called through this class
+ * once worker threads compute positions.
+ */
+
+#ifndef _EPHEMCACHE_HPP_
+#define _EPHEMCACHE_HPP_
+
+class EphemCache
+{
+public:
+	//! The cached bodies. The planets use the body numbers of GetVsop87Coor().
+	enum Body
+	{
+		Mercury = 0,
+		Venus,
+		EarthMoonBarycenter,
+		Mars,
+		Jupiter,
+		Saturn,
+		Uranus,
+		Neptune,
+		Moon,		//!< geocentric position from GetElp82bCoor()
+		NbBodies
+	};
+
+	//! Get the position of a body at the given JDE.
+	//! The result is the same as GetVsop87Coor() (or GetElp82bCoor() for the Moon) within the accuracy bound.
+	//! When the cache is disabled, the series are always evaluated.
+	static void getCoor(double jde, int body, double xyz[3]);
+
+	//! Get the osculating position of a VSOP87 body for the elements of JDE0, evaluated at JDE,
+	//! i.e. GetVsop87OsculatingCoor(), serialized with the series evaluations of getCoor().
+	static void getOsculatingCoor(double jde0, double jde, int body, double xyz[3]);
+
+	//! Set the maximum difference with the full series, in AU. A value <= 0 disables the cache.
+	//! Values below 1e-10 AU are raised to 1e-10 AU.
+	//! Changing the accuracy drops all fitted segments.
+	static void setAccuracy(double au);
+	static double getAccuracy();
+	static bool isEnabled();
+
+	//! Fit in advance all the segments covering a range of dates (at most the number of segments kept in the cache),
+	//! e.g. before computing an ephemeris table.
+	static void precompute(double jde0, double jde1);
+
+	//! Drop all fitted segments.
+	static void clear();
+
+	//! Get the length of the segments currently used for a body, in days.
+	static double getSegmentDuration(int body);
+	//! Get the number of segments fitted since the last call to clear() or setAccuracy().
+	static int getFitCount();
+};
+
+#endif // _EPHEMCACHE_HPP_
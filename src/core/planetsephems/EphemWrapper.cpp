@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 */
 
 #include "EphemWrapper.hpp"
+#include "EphemCache.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
 #include "vsop87.h"
@@ -31,6 +32,8 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "de430.hpp"
 #include "pluto.h"
 
+#include <QMutex>
+
 #define EPHEM_MERCURY_ID  0
 #define EPHEM_VENUS_ID    1
 #define EPHEM_EMB_ID    2
@@ -58,6 +61,22 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 **            7 = uranus 
 **/
 
+// DE430/431 and the theories of the planetary satellites keep their state in static variables.
+// Their calls are serialized, so that positions can also be computed by worker threads (see EphemerisEngine).
+static QMutex theoryMutex;
+
+static bool lockedDe430Coor(const double jde, const int planet_id, double* xyz, const int centralBody_id=CENTRAL_PLANET_ID)
+{
+	QMutexLocker locker(&theoryMutex);
+	return GetDe430Coor(jde, planet_id, xyz, centralBody_id);
+}
+
+static bool lockedDe431Coor(const double jde, const int planet_id, double* xyz, const int centralBody_id=CENTRAL_PLANET_ID)
+{
+	QMutexLocker locker(&theoryMutex);
+	return GetDe431Coor(jde, planet_id, xyz, centralBody_id);
+}
+
 void EphemWrapper::init_de430(const char* filepath)
 {
 	InitDE430(filepath);
@@ -106,15 +125,15 @@ void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_i
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, planet_id + 1, xyz);
+		deOk=lockedDe430Coor(jd, planet_id + 1, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, planet_id + 1, xyz);
+		deOk=lockedDe431Coor(jd, planet_id + 1, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87Coor(jd, planet_id, xyz);
+		EphemCache::getCoor(jd, planet_id, xyz);
 	}
 }
 
@@ -131,15 +150,16 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], i
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, planet_id + 1, xyz);
+		deOk=lockedDe430Coor(jd, planet_id + 1, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, planet_id + 1, xyz);
+		deOk=lockedDe431Coor(jd, planet_id + 1, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87OsculatingCoor(jd0, jd, planet_id, xyz);
+		// Shares the static elements of VSOP87 with the series evaluated by the cache
+		EphemCache::getOsculatingCoor(jd0, jd, planet_id, xyz);
 	}
 }
 
@@ -160,11 +180,11 @@ void get_pluto_helio_coordsv(double jd,double xyz[3], void* unused)
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
+		deOk=lockedDe430Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
+		deOk=lockedDe431Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
 	}
 	if (!deOk) // fallback to previous solution
 	{
@@ -203,17 +223,17 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused)
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
+		deOk=lockedDe430Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
+		deOk=lockedDe431Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
 		double moon[3];
-		GetVsop87Coor(jd,EPHEM_EMB_ID,xyz);
-		GetElp82bCoor(jd,moon);
+		EphemCache::getCoor(jd,EphemCache::EarthMoonBarycenter,xyz);
+		EphemCache::getCoor(jd,EphemCache::Moon,moon);
 		/* Earth != EMB:
 	0.0121505677733761 = mu_m/(1+mu_m),
 	mu_m = mass(moon)/mass(earth) = 0.01230002 */
@@ -305,124 +325,143 @@ void get_lunar_parent_coordsv(double jde,double xyz[3], void* unused)
 	Q_UNUSED(unused);
 	bool deOk=false;
 	if(use_de430(jde))
-		deOk=GetDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
+		deOk=lockedDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	else if(use_de431(jde))
-		deOk=GetDe431Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
+		deOk=lockedDe431Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	if (!deOk) // fallback...
-		GetElp82bCoor(jde,xyz);
+		EphemCache::getCoor(jde,EphemCache::Moon,xyz);
 }
 
 void get_phobos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetMarsSatCoor(jd,MARS_SAT_PHOBOS,xyz);
 }
 
 void get_deimos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetMarsSatCoor(jd,MARS_SAT_DEIMOS,xyz);
 }
 
 void get_io_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetL1Coor(jd,L1_IO,xyz);
 }
 
 void get_europa_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetL1Coor(jd,L1_EUROPA,xyz);
 }
 
 void get_ganymede_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetL1Coor(jd,L1_GANYMEDE,xyz);
 }
 
 void get_callisto_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetL1Coor(jd,L1_CALLISTO,xyz);
 }
 
 void get_mimas_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_MIMAS,xyz);
 }
 
 void get_enceladus_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_ENCELADUS,xyz);
 }
 
 void get_tethys_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_TETHYS,xyz);
 }
 
 void get_dione_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_DIONE,xyz);
 }
 
 void get_rhea_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_RHEA,xyz);
 }
 
 void get_titan_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_TITAN,xyz);
 }
 
 void get_hyperion_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_HYPERION,xyz);
 }
 
 void get_iapetus_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetTass17Coor(jd,TASS17_IAPETUS,xyz);
 }
 
 void get_miranda_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetGust86Coor(jd,GUST86_MIRANDA,xyz);
 }
 
 void get_ariel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetGust86Coor(jd,GUST86_ARIEL,xyz);
 }
 
 void get_umbriel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetGust86Coor(jd,GUST86_UMBRIEL,xyz);
 }
 
 void get_titania_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetGust86Coor(jd,GUST86_TITANIA,xyz);
 }
 
 void get_oberon_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&theoryMutex);
 	GetGust86Coor(jd,GUST86_OBERON,xyz);
 }
 
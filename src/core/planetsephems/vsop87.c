@@ -137349,3 +137349,12 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd,
   }
   EllipticToRectangularA(vsop87_mu[body],vsop87_elem+(body*6),jd-jd0,xyz);
 }
+
+void GetVsop87CoorAll(const double jd,double xyz[8*3]) {
+  double elem[VSOP87_DIM];
+  int body;
+  CalcVsop87Elem((jd - 2451545.0) / 365250.0,elem);
+  for (body=0;body<8;body++) {
+	EllipticToRectangularA(vsop87_mu[body],elem+(body*6),0.0,xyz+(body*3));
+  }
+}
@@ -63,6 +63,14 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd, const int body,do
   /* The oculating orbit of epoch jd0, evaluated at jd, is returned.
   */
 
+void GetVsop87CoorAll(const double jd,double xyz[8*3]);
+  /* Return the rectangular coordinates of all 8 bodies (body*3+i),
+     summing the series at jd instead of interpolating the elements
+     between cached dates like GetVsop87Coor() does.
+     This is slower for a single call, but exact and without side effects
+     on the cache of GetVsop87Coor().
+  */
+
 #ifdef __cplusplus
 }
 #endif
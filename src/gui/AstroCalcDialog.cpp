@@ -29,6 +29,8 @@
 
 #include "SolarSystem.hpp"
 #include "Planet.hpp"
+#include "EphemerisEngine.hpp"
+#include "PhenomenaEngine.hpp"
 #include "NebulaMgr.hpp"
 #include "Nebula.hpp"
 
@@ -58,6 +60,8 @@ AstroCalcDialog::AstroCalcDialog(QObject *parent)
 	solarSystem = GETSTELMODULE(SolarSystem);
 	dsoMgr = GETSTELMODULE(NebulaMgr);
 	objectMgr = GETSTELMODULE(StelObjectMgr);
+	ephemerisEngine = new EphemerisEngine(this);
+	phenomenaEngine = new PhenomenaEngine(this);
 	starMgr = GETSTELMODULE(StarMgr);
 	ephemerisHeader.clear();
 	phenomenaHeader.clear();
@@ -147,12 +151,17 @@ void AstroCalcDialog::createDialogContent()
 	connect(ui->planetaryPositionsUpdateButton, SIGNAL(clicked()), this, SLOT(currentPlanetaryPositions()));
 
 	connect(ui->ephemerisPushButton, SIGNAL(clicked()), this, SLOT(generateEphemeris()));
+	connect(ephemerisEngine, SIGNAL(progress(int,int)), this, SLOT(showEphemerisProgress(int,int)));
+	connect(ephemerisEngine, SIGNAL(finished()), this, SLOT(fillEphemeris()));
 	connect(ui->ephemerisCleanupButton, SIGNAL(clicked()), this, SLOT(cleanupEphemeris()));
 	connect(ui->ephemerisSaveButton, SIGNAL(clicked()), this, SLOT(saveEphemeris()));
 	connect(ui->ephemerisTreeWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(selectCurrentEphemeride(QModelIndex)));
 	connect(ui->ephemerisTreeWidget, SIGNAL(clicked(QModelIndex)), this, SLOT(onChangedEphemerisPosition(QModelIndex)));
 
 	connect(ui->phenomenaPushButton, SIGNAL(clicked()), this, SLOT(calculatePhenomena()));
+	connect(phenomenaEngine, SIGNAL(progress(int,int)), this, SLOT(showPhenomenaProgress(int,int)));
+	connect(phenomenaEngine, SIGNAL(eventsFound(int,int)), this, SLOT(fillPhenomenaTable(int,int)));
+	connect(phenomenaEngine, SIGNAL(finished()), this, SLOT(finishPhenomena()));
 	connect(ui->phenomenaTreeWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(selectCurrentPhenomen(QModelIndex)));
 	connect(ui->phenomenaSaveButton, SIGNAL(clicked()), this, SLOT(savePhenomena()));
 
@@ -329,7 +338,7 @@ void AstroCalcDialog::initListEphemeris()
 
 void AstroCalcDialog::generateEphemeris()
 {
-	float currentStep, ra, dec;
+	float currentStep;
 	QString currentPlanet = ui->celestialBodyComboBox->currentData().toString();
 
 	initListEphemeris();
@@ -364,39 +373,53 @@ void AstroCalcDialog::generateEphemeris()
 			break;
 	}
 
-	StelObjectP obj = solarSystem->searchByName(currentPlanet);
+	PlanetP obj = solarSystem->searchByEnglishName(currentPlanet);
 	if (obj)
 	{
-		double currentJD = core->getJD(); // save current JD
 		double firstJD = StelUtils::qDateTimeToJd(ui->dateFromDateTimeEdit->dateTime());
 		firstJD = firstJD - core->getUTCOffset(firstJD)/24;
 		int elements = (int)((StelUtils::qDateTimeToJd(ui->dateToDateTimeEdit->dateTime()) - firstJD)/currentStep);
-		EphemerisListJ2000.clear();
-		EphemerisListJ2000.reserve(elements);
-		EphemerisListDates.clear();
-		EphemerisListDates.reserve(elements);
-		for (int i=0; i<elements; i++)
+		// The positions are computed in worker threads, without changing the time of the core
+		if (ephemerisEngine->start(EphemerisEngine::prepare(obj, firstJD, currentStep, elements)))
 		{
-			double JD = firstJD + i*currentStep;
-			core->setJD(JD);
-			core->update(0); // force update to get new coordinates			
-			Vec3d pos = obj->getJ2000EquatorialPos(core);
-			EphemerisListJ2000.append(pos);
-			EphemerisListDates.append(StelUtils::jdToQDateTime(JD + core->getUTCOffset(JD)/24).toString("yyyy-MM-dd"));
-			StelUtils::rectToSphe(&ra,&dec,pos);
-			ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->ephemerisTreeWidget);
-			// local date and time
-			treeItem->setText(EphemerisDate, StelUtils::jdToQDateTime(JD + core->getUTCOffset(JD)/24).toString("yyyy-MM-dd hh:mm:ss"));
-			treeItem->setText(EphemerisJD, QString::number(JD, 'f', 5));
-			treeItem->setText(EphemerisRA, StelUtils::radToHmsStr(ra));
-			treeItem->setTextAlignment(EphemerisRA, Qt::AlignRight);
-			treeItem->setText(EphemerisDec, StelUtils::radToDmsStr(dec, true));
-			treeItem->setTextAlignment(EphemerisDec, Qt::AlignRight);
-			treeItem->setText(EphemerisMagnitude, QString::number(obj->getVMagnitudeWithExtinction(core), 'f', 2));
-			treeItem->setTextAlignment(EphemerisMagnitude, Qt::AlignRight);
+			ui->ephemerisPushButton->setEnabled(false);
+			ui->ephemerisSaveButton->setEnabled(false);
 		}
-		core->setJD(currentJD); // restore time
 	}
+}
+
+void AstroCalcDialog::showEphemerisProgress(int done, int total)
+{
+	ui->ephemerisPushButton->setText(QString(q_("Calculating... %1%")).arg(100*done/qMax(total, 1)));
+}
+
+void AstroCalcDialog::fillEphemeris()
+{
+	float ra, dec;
+	const QVector<EphemerisEngine::Entry>& entries = ephemerisEngine->getEntries();
+	EphemerisListJ2000.clear();
+	EphemerisListJ2000.reserve(entries.size());
+	EphemerisListDates.clear();
+	EphemerisListDates.reserve(entries.size());
+	for (int i=0; i<entries.size(); i++)
+	{
+		const EphemerisEngine::Entry& e = entries.at(i);
+		const QDateTime localDate = StelUtils::jdToQDateTime(e.JD + core->getUTCOffset(e.JD)/24);
+		EphemerisListJ2000.append(e.j2000Pos);
+		EphemerisListDates.append(localDate.toString("yyyy-MM-dd"));
+		StelUtils::rectToSphe(&ra,&dec,e.j2000Pos);
+		ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->ephemerisTreeWidget);
+		// local date and time
+		treeItem->setText(EphemerisDate, localDate.toString("yyyy-MM-dd hh:mm:ss"));
+		treeItem->setText(EphemerisJD, QString::number(e.JD, 'f', 5));
+		treeItem->setText(EphemerisRA, StelUtils::radToHmsStr(ra));
+		treeItem->setTextAlignment(EphemerisRA, Qt::AlignRight);
+		treeItem->setText(EphemerisDec, StelUtils::radToDmsStr(dec, true));
+		treeItem->setTextAlignment(EphemerisDec, Qt::AlignRight);
+		treeItem->setText(EphemerisMagnitude, QString::number(e.magnitude, 'f', 2));
+		treeItem->setTextAlignment(EphemerisMagnitude, Qt::AlignRight);
+	}
+	resetEphemerisButtons();
 
 	// adjust the column width
 	for(int i = 0; i < EphemerisCount; ++i)
@@ -408,6 +431,13 @@ void AstroCalcDialog::generateEphemeris()
 	ui->ephemerisTreeWidget->sortItems(EphemerisDate, Qt::AscendingOrder);
 }
 
+void AstroCalcDialog::resetEphemerisButtons()
+{
+	ui->ephemerisPushButton->setText(q_("Calculate ephemeris"));
+	ui->ephemerisPushButton->setEnabled(true);
+	ui->ephemerisSaveButton->setEnabled(true);
+}
+
 void AstroCalcDialog::saveEphemeris()
 {
 	QString filter = q_("CSV (Comma delimited)");
@@ -445,6 +475,11 @@ void AstroCalcDialog::saveEphemeris()
 
 void AstroCalcDialog::cleanupEphemeris()
 {
+	if (ephemerisEngine->isRunning())
+	{
+		ephemerisEngine->cancel();
+		resetEphemerisButtons();
+	}
 	EphemerisListJ2000.clear();
 	ui->ephemerisTreeWidget->clear();
 }
@@ -914,293 +949,110 @@ void AstroCalcDialog::calculatePhenomena()
 	PlanetP planet = solarSystem->searchByEnglishName(currentPlanet);
 	if (planet)
 	{
-		double currentJD = core->getJD(); // save current JD		
 		double startJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenFromDateEdit->date()));
 		double stopJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenToDateEdit->date().addDays(1)));
 		startJD = startJD - core->getUTCOffset(startJD)/24;
 		stopJD = stopJD - core->getUTCOffset(stopJD)/24;
 
+		// The search runs in worker threads, without changing the time of the core
+		PhenomenaEngine::Request request = PhenomenaEngine::prepare(planet, startJD, stopJD, separation*M_PI/180., true);
+		phenomenaTargetNames.clear();
+		phenomenaTargetSizes.clear();
 		if (obj2Type<9)
 		{
-			// Solar system objects
-			foreach (PlanetP obj, objects)
-			{
-				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, false), planet, obj, false);
-				// opposition
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, true), planet, obj, true);
-			}
+			// Solar system objects: conjunctions and oppositions
+			foreach (const PlanetP& obj, objects)
+				request.addPlanet(obj);
 		}
 		else if (obj2Type==9)
 		{
 			// Stars
-			foreach (StelObjectP obj, star)
+			foreach (const StelObjectP& obj, star)
 			{
-				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation), planet, obj);
+				request.addPosition(obj->getJ2000EquatorialPos(core));
+				phenomenaTargetNames.append(obj->getNameI18n());
+				phenomenaTargetSizes.append(obj->getAngularSize(core));
 			}
 		}
 		else
 		{
 			// Deep-sky objects
-			foreach (NebulaP obj, dso)
+			foreach (const NebulaP& obj, dso)
 			{
-				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation), planet, obj);
+				request.addPosition(obj->getJ2000EquatorialPos(core));
+				phenomenaTargetNames.append(obj->getNameI18n().isEmpty() ? obj->getDSODesignation() : obj->getNameI18n());
+				phenomenaTargetSizes.append(obj->getAngularSize(core));
 			}
 		}
 
-
-		core->setJD(currentJD); // restore time
-		core->update(0);
-	}
-
-	// adjust the column width
-	for(int i = 0; i < PhenomenaCount; ++i)
-	{
-	    ui->phenomenaTreeWidget->resizeColumnToContents(i);
-	}
-
-	// sort-by-date
-	ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);
-}
-
-void AstroCalcDialog::savePhenomena()
-{
-	QString filter = q_("CSV (Comma delimited)");
-	filter.append(" (*.csv)");
-	QString filePath = QFileDialog::getSaveFileName(0, q_("Save calculated phenomena as..."), QDir::homePath() + "/phenomena.csv", filter);
-	QFile phenomena(filePath);
-	if (!phenomena.open(QFile::WriteOnly | QFile::Truncate))
-	{
-		qWarning() << "AstroCalc: Unable to open file"
-			   << QDir::toNativeSeparators(filePath);
-		return;
-	}
-
-	QTextStream phenomenaList(&phenomena);
-	phenomenaList.setCodec("UTF-8");
-
-	int count = ui->phenomenaTreeWidget->topLevelItemCount();
-
-	phenomenaList << phenomenaHeader.join(delimiter) << acEndl;
-	for (int i = 0; i < count; i++)
-	{
-		int columns = phenomenaHeader.size();
-		for (int j=0; j<columns; j++)
+		if (phenomenaEngine->start(request))
 		{
-			phenomenaList << ui->phenomenaTreeWidget->topLevelItem(i)->text(j);
-			if (j<columns-1)
-				phenomenaList << delimiter;
-			else
-				phenomenaList << acEndl;
+			ui->phenomenaPushButton->setEnabled(false);
+			ui->phenomenaSaveButton->setEnabled(false);
 		}
 	}
+}
 
-	phenomena.close();
+void AstroCalcDialog::showPhenomenaProgress(int done, int total)
+{
+	ui->phenomenaPushButton->setText(QString(q_("Calculating... %1%")).arg(100*done/qMax(total, 1)));
 }
 
-void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const PlanetP object2, bool opposition)
+void AstroCalcDialog::fillPhenomenaTable(int first, int count)
 {
-	QMap<double, double>::ConstIterator it;
-	for (it=list.constBegin(); it!=list.constEnd(); ++it)
+	const PhenomenaEngine::Request& request = phenomenaEngine->getRequest();
+	const QVector<PhenomenaEngine::Event>& events = phenomenaEngine->getEvents();
+	const PlanetP& object1 = request.body.body;
+	for (int i=first; i<first+count; ++i)
 	{
-		core->setJD(it.key());
-		core->update(0);
-
+		const PhenomenaEngine::Event& e = events.at(i);
 		QString phenomenType = q_("Conjunction");
-		double separation = it.value();
+		double separation = e.separation;
 		bool occultation = false;
-		double s1 = object1->getSpheroidAngularSize(core);
-		double s2 = object2->getSpheroidAngularSize(core);
-		if (opposition)
+		double s1 = std::atan2(object1->getRadius()*object1->getSphereScale(), e.bodyDistance) * 180./M_PI;
+		QString object2Name;
+		if (e.fixed)
 		{
-			phenomenType = q_("Opposition");
-			separation += M_PI;
-		}
-		else if (separation<(s2*M_PI/180.) || separation<(s1*M_PI/180.))
-		{
-			double d1 = object1->getJ2000EquatorialPos(core).length();
-			double d2 = object2->getJ2000EquatorialPos(core).length();
-			if ((d1<d2 && s1<=s2) || (d1>d2 && s1>s2))
-				phenomenType = q_("Transit");
-			else
+			object2Name = phenomenaTargetNames.at(e.target);
+			if (separation<(phenomenaTargetSizes.at(e.target)*M_PI/180.) || separation<(s1*M_PI/180.))
+			{
 				phenomenType = q_("Occultation");
-
-			// Added a special case - eclipse
-			if (qAbs(s1-s2)<=0.05 && (object1->getEnglishName()=="Sun" || object2->getEnglishName()=="Sun")) // 5% error of difference of sizes
-				phenomenType = q_("Eclipse");
-
-			occultation = true;
+				occultation = true;
+			}
 		}
-
-		ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->phenomenaTreeWidget);
-		treeItem->setText(PhenomenaType, phenomenType);
-		// local date and time
-		treeItem->setText(PhenomenaDate, StelUtils::jdToQDateTime(it.key() + core->getUTCOffset(it.key())/24).toString("yyyy-MM-dd hh:mm:ss"));
-		treeItem->setText(PhenomenaObject1, object1->getNameI18n());
-		treeItem->setText(PhenomenaObject2, object2->getNameI18n());
-		if (occultation)
-			treeItem->setText(PhenomenaSeparation, QChar(0x2014));
 		else
-			treeItem->setText(PhenomenaSeparation, StelUtils::radToDmsStr(separation));
-	}
-}
-
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, PlanetP &object2, double startJD, double stopJD, double maxSeparation, bool opposition)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/12.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object2->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus" || object2->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object2->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn" || object2->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars" || object2->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object2->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury" || object2->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon" || object2->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2, opposition);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2, opposition);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
 		{
-			if (step > step0)
+			const PlanetP& object2 = request.planets.at(e.target).body;
+			object2Name = object2->getNameI18n();
+			double s2 = std::atan2(object2->getRadius()*object2->getSphereScale(), e.targetDistance) * 180./M_PI;
+			if (e.opposition)
 			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2, opposition);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
+				phenomenType = q_("Opposition");
+				separation += M_PI;
 			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn, opposition))
+			else if (separation<(s2*M_PI/180.) || separation<(s1*M_PI/180.))
 			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, PlanetP object2, double JD, double step, int prevSign, bool opposition)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==NULL)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2, opposition);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2, opposition);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2, opposition);
-			if (out->second < findDistance(JD - 5.0, object1, object2, opposition))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, PlanetP object2, bool opposition)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	double angle = obj1.angle(obj2);
-	if (opposition)
-		angle = M_PI - angle;
-	return angle;
-}
+				double d1 = e.bodyDistance;
+				double d2 = e.targetDistance;
+				if ((d1<d2 && s1<=s2) || (d1>d2 && s1>s2))
+					phenomenType = q_("Transit");
+				else
+					phenomenType = q_("Occultation");
 
-void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const NebulaP object2)
-{
-	QMap<double, double>::ConstIterator it;
-	for (it=list.constBegin(); it!=list.constEnd(); ++it)
-	{
-		core->setJD(it.key());
-		core->update(0);
+				// Added a special case - eclipse
+				if (qAbs(s1-s2)<=0.05 && (object1->getEnglishName()=="Sun" || object2->getEnglishName()=="Sun")) // 5% error of difference of sizes
+					phenomenType = q_("Eclipse");
 
-		QString phenomenType = q_("Conjunction");
-		double separation = it.value();
-		bool occultation = false;
-		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSize(core)*M_PI/180.))
-		{
-			phenomenType = q_("Occultation");
-			occultation = true;
+				occultation = true;
+			}
 		}
 
 		ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->phenomenaTreeWidget);
 		treeItem->setText(PhenomenaType, phenomenType);
 		// local date and time
-		treeItem->setText(PhenomenaDate, StelUtils::jdToQDateTime(it.key() + core->getUTCOffset(it.key())/24).toString("yyyy-MM-dd hh:mm:ss"));
+		treeItem->setText(PhenomenaDate, StelUtils::jdToQDateTime(e.JD + core->getUTCOffset(e.JD)/24).toString("yyyy-MM-dd hh:mm:ss"));
 		treeItem->setText(PhenomenaObject1, object1->getNameI18n());
-		if (!object2->getNameI18n().isEmpty())
-			treeItem->setText(PhenomenaObject2, object2->getNameI18n());
-		else
-			treeItem->setText(PhenomenaObject2, object2->getDSODesignation());
+		treeItem->setText(PhenomenaObject2, object2Name);
 		if (occultation)
 			treeItem->setText(PhenomenaSeparation, QChar(0x2014));
 		else
@@ -1208,284 +1060,55 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, NebulaP &object2, double startJD, double stopJD, double maxSeparation)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/8.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, NebulaP object2, double JD, double step, int prevSign)
+void AstroCalcDialog::finishPhenomena()
 {
-	int sgn;
-	double dist, prevDist;
+	ui->phenomenaPushButton->setText(q_("Calculate phenomena"));
+	ui->phenomenaPushButton->setEnabled(true);
+	ui->phenomenaSaveButton->setEnabled(true);
 
-	if (out==NULL)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
+	// adjust the column width
+	for(int i = 0; i < PhenomenaCount; ++i)
 	{
-		JD += step;
-		dist = findDistance(JD, object1, object2);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2);
-			if (out->second < findDistance(JD - 5.0, object1, object2))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
+	    ui->phenomenaTreeWidget->resizeColumnToContents(i);
 	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, NebulaP object2)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	return obj1.angle(obj2);
-}
-
-void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const StelObjectP object2)
-{
-	QMap<double, double>::ConstIterator it;
-	for (it=list.constBegin(); it!=list.constEnd(); ++it)
-	{
-		core->setJD(it.key());
-		core->update(0);
-
-		QString phenomenType = q_("Conjunction");
-		double separation = it.value();
-		bool occultation = false;
-		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSize(core)*M_PI/180.))
-		{
-			phenomenType = q_("Occultation");
-			occultation = true;
-		}
 
-		ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->phenomenaTreeWidget);
-		treeItem->setText(PhenomenaType, phenomenType);
-		// local date and time
-		treeItem->setText(PhenomenaDate, StelUtils::jdToQDateTime(it.key() + core->getUTCOffset(it.key())/24).toString("yyyy-MM-dd hh:mm:ss"));
-		treeItem->setText(PhenomenaObject1, object1->getNameI18n());
-		treeItem->setText(PhenomenaObject2, object2->getNameI18n());
-		if (occultation)
-			treeItem->setText(PhenomenaSeparation, QChar(0x2014));
-		else
-			treeItem->setText(PhenomenaSeparation, StelUtils::radToDmsStr(separation));
-	}
+	// sort-by-date
+	ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, StelObjectP &object2, double startJD, double stopJD, double maxSeparation)
+void AstroCalcDialog::savePhenomena()
 {
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/8.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus")
-		if (step0 > 1811.25)
-			step0 = 1811.25;
-	if (object1->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn")
-		if (step0 > 181.125)
-			step0 = 181.125;
-	if (object1->getEnglishName()=="Mars")
-		if (step0 > 5.f)
-			step0 = 5.0;
-	if (object1->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury")
-		if (step0 > 2.5f)
-			step0 = 2.5;
-	if (object1->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2);
-	jd += step;
-	while(jd <= stopJD)
+	QString filter = q_("CSV (Comma delimited)");
+	filter.append(" (*.csv)");
+	QString filePath = QFileDialog::getSaveFileName(0, q_("Save calculated phenomena as..."), QDir::homePath() + "/phenomena.csv", filter);
+	QFile phenomena(filePath);
+	if (!phenomena.open(QFile::WriteOnly | QFile::Truncate))
 	{
-		dist = findDistance(jd, object1, object2);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
+		qWarning() << "AstroCalc: Unable to open file"
+			   << QDir::toNativeSeparators(filePath);
+		return;
 	}
 
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==NULL)
-		return false;
+	QTextStream phenomenaList(&phenomena);
+	phenomenaList.setCodec("UTF-8");
 
-	prevDist = findDistance(JD, object1, object2);
-	step = -step/2.f;
-	prevSign = -prevSign;
+	int count = ui->phenomenaTreeWidget->topLevelItemCount();
 
-	while(true)
+	phenomenaList << phenomenaHeader.join(delimiter) << acEndl;
+	for (int i = 0; i < count; i++)
 	{
-		JD += step;
-		dist = findDistance(JD, object1, object2);
-
-		if (qAbs(step)< 1.f/1440.f)
+		int columns = phenomenaHeader.size();
+		for (int j=0; j<columns; j++)
 		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2);
-			if (out->second < findDistance(JD - 5.0, object1, object2))
-				return true;
+			phenomenaList << ui->phenomenaTreeWidget->topLevelItem(i)->text(j);
+			if (j<columns-1)
+				phenomenaList << delimiter;
 			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
+				phenomenaList << acEndl;
 		}
-		prevDist = dist;
-		prevSign = sgn;
 	}
-}
 
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, StelObjectP object2)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	return obj1.angle(obj2);
+	phenomena.close();
 }
 
 void AstroCalcDialog::changePage(QListWidgetItem *current, QListWidgetItem *previous)
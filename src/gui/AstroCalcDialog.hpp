@@ -103,12 +103,22 @@ private slots:
 
 	//! Calculate ephemeris for selected celestial body and fill the list.
 	void generateEphemeris();
+	//! Show the progress of the ephemeris calculation on its button.
+	void showEphemerisProgress(int done, int total);
+	//! Fill the list with the calculated ephemeris.
+	void fillEphemeris();
 	void cleanupEphemeris();
 	void selectCurrentEphemeride(const QModelIndex &modelIndex);
 	void saveEphemeris();
 
 	//! Calculate phenomena for selected celestial body and fill the list.
 	void calculatePhenomena();
+	//! Show the progress of the phenomena search on its button.
+	void showPhenomenaProgress(int done, int total);
+	//! Add the phenomena found by the search to the list.
+	void fillPhenomenaTable(int first, int count);
+	//! Restore the phenomena buttons and sort the list at the end of the search.
+	void finishPhenomena();
 	void selectCurrentPhenomen(const QModelIndex &modelIndex);
 	void savePhenomena();
 
@@ -124,6 +134,11 @@ private:
 	class NebulaMgr* dsoMgr;
 	class StarMgr* starMgr;
 	class StelObjectMgr* objectMgr;
+	class EphemerisEngine* ephemerisEngine;
+	class PhenomenaEngine* phenomenaEngine;
+	//! Names and angular sizes in degrees of the fixed targets of the phenomena search
+	QStringList phenomenaTargetNames;
+	QVector<double> phenomenaTargetSizes;
 	QTimer *currentTimeLine;
 
 	//! Update header names for planetary positions table
@@ -137,6 +152,8 @@ private:
 	void initListPlanetaryPositions();
 	//! Init header and list of ephemeris
 	void initListEphemeris();
+	//! Restore the ephemeris buttons after a calculation.
+	void resetEphemerisButtons();
 	//! Init header and list of phenomena
 	void initListPhenomena();
 
@@ -154,25 +171,6 @@ private:
 	//! Prepare graph settings
 	void prepareAxesAndGraph();
 
-	//! Calculation conjunctions and oppositions.
-	//! @note Ported from KStars, should be improved, because this feature calculate
-	//! angular separation ("conjunction" defined as equality of right ascension
-	//! of two body) and current solution is not accurate and slow.
-	QMap<double, double> findClosestApproach(PlanetP& object1, PlanetP& object2, double startJD, double stopJD, double maxSeparation, bool opposition);
-	double findDistance(double JD, PlanetP object1, PlanetP object2, bool opposition);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, PlanetP object2, double JD, double step, int prevSign, bool opposition);
-	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const PlanetP object2, bool opposition);
-
-	QMap<double, double> findClosestApproach(PlanetP& object1, NebulaP& object2, double startJD, double stopJD, double maxSeparation);
-	double findDistance(double JD, PlanetP object1, NebulaP object2);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, NebulaP object2, double JD, double step, int prevSign);
-	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const NebulaP object2);
-
-	QMap<double, double> findClosestApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD, double maxSeparation);
-	double findDistance(double JD, PlanetP object1, StelObjectP object2);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign);
-	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const StelObjectP object2);
-
 	QString delimiter, acEndl;
 	QStringList ephemerisHeader, phenomenaHeader, planetaryPositionsHeader;
 	static float brightLimit;
@@ -163,12 +163,6 @@ int main(int argc, char **argv)
 	// Init the file manager
 	StelFileMgr::init();
 
-	QPixmap pixmap(StelFileMgr::findFile("data/splash.png"));
-	QSplashScreen splash(pixmap);
-	splash.show();
-	splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
-	app.processEvents();
-
 	// Log command line arguments.
 	QString argStr;
 	QStringList argList;
@@ -184,6 +178,17 @@ int main(int argc, char **argv)
 		argList+= envStelOpts.split(" ");
 		argStr += " " + envStelOpts;
 	}
+
+	QPixmap pixmap(StelFileMgr::findFile("data/splash.png"));
+	QSplashScreen splash(pixmap);
+	// Nothing is shown when rendering headless frames
+	if (!CLIProcessor::argsGetOption(argList, "", "--headless"))
+	{
+		splash.show();
+		splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
+		app.processEvents();
+	}
+
 	// Parse for first set of CLI arguments - stuff we want to process before other
 	// output, such as --help and --version
 	CLIProcessor::parseCLIArgsPreConfig(argList);
@@ -28,6 +28,7 @@
 #include "LandscapeMgr.hpp"
 #include "SporadicMeteorMgr.hpp"
 #include "NebulaMgr.hpp"
+#include "EphemerisEngine.hpp"
 #include "Planet.hpp"
 #include "SolarSystem.hpp"
 #include "StarMgr.hpp"
@@ -64,6 +65,7 @@
 #include <QTemporaryFile>
 #include <QTimer>
 #include <QEventLoop>
+#include <QCoreApplication>
 
 #include <cmath>
 
@@ -795,7 +797,21 @@ double StelMainScriptAPI::jdFromDateString(const QString& dt, const QString& spe
 	return StelUtils::getJDFromSystem();
 }
 
+// Wait for t seconds of the program clock when it has a fixed time step (headless rendering).
+// The clock only advances when a frame is rendered, and the frames are rendered by the events.
+static void waitFixedClock(double t)
+{
+	const double end = StelApp::getTotalRunTime()+t;
+	while (StelApp::getFixedTimeStep()>0. && StelApp::getTotalRunTime()<end)
+		QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+}
+
 void StelMainScriptAPI::wait(double t) {
+	if (StelApp::getFixedTimeStep()>0.)
+	{
+		waitFixedClock(t);
+		return;
+	}
 	QEventLoop loop;
 	QTimer timer;
 	timer.setInterval(1000*t);
@@ -809,6 +825,11 @@ void StelMainScriptAPI::waitFor(const QString& dt, const QString& spec)
 	double deltaJD = jdFromDateString(dt, spec) - getJDay();
 	double timeSpeed = getTimeRate();
 	if (timeSpeed == 0.) { qDebug() << "waitFor() called with no time passing - would be infinite. not waiting!"; return;}
+	if (StelApp::getFixedTimeStep()>0.)
+	{
+		waitFixedClock(deltaJD*86400/timeSpeed);
+		return;
+	}
 	QEventLoop loop;
 	QTimer timer;
 	int interval=1000*deltaJD*86400/timeSpeed;
@@ -1110,6 +1131,43 @@ QVariantMap StelMainScriptAPI::getSelectedObjectInfo()
 	return map;
 }
 
+QVariantList StelMainScriptAPI::getEphemeris(const QString& name, const QString& dateFrom, const QString& dateTo, double step, const QString& spec)
+{
+	QVariantList list;
+	PlanetP obj = GETSTELMODULE(SolarSystem)->searchByEnglishName(name);
+	if (!obj)
+	{
+		debug("getEphemeris WARNING - solar system object not found: " + name);
+		return list;
+	}
+	if (step<=0.)
+	{
+		debug("getEphemeris WARNING - the step must be positive");
+		return list;
+	}
+
+	const double firstJD = jdFromDateString(dateFrom, spec);
+	const int count = (int)((jdFromDateString(dateTo, spec) - firstJD)/step) + 1;
+	const QVector<EphemerisEngine::Entry> entries = EphemerisEngine::compute(EphemerisEngine::prepare(obj, firstJD, step, count));
+	list.reserve(entries.size());
+	double ra, dec;
+	foreach (const EphemerisEngine::Entry& e, entries)
+	{
+		QVariantMap map;
+		map.insert("jd", e.JD);
+		map.insert("jde", e.JDE);
+		StelUtils::rectToSphe(&ra, &dec, e.j2000Pos);
+		map.insert("raJ2000", ra*180./M_PI);
+		map.insert("decJ2000", dec*180./M_PI);
+		map.insert("distance", e.distance);
+		map.insert("phase-angle", e.phaseAngle);
+		map.insert("elongation", e.elongation);
+		map.insert("vmag", e.magnitude);
+		list.append(map);
+	}
+	return list;
+}
+
 
 void StelMainScriptAPI::clear(const QString& state)
 {
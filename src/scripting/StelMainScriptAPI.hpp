@@ -231,6 +231,23 @@ public slots:
 	//! - ptype : object type (for Solar system objects only!)
 	QVariantMap getSelectedObjectInfo();
 
+	//! Compute the positions of a solar system body over a range of dates, for the current observer.
+	//! The time of the simulation is not changed, the positions are computed in worker threads.
+	//! @param name the english name of the body
+	//! @param dateFrom, dateTo the range of dates, in the formats of setDate()
+	//! @param step the interval between the dates, in days
+	//! @param spec "local" or "utc" - only has an effect when the ISO date type is used. Defaults to "utc".
+	//! @return a list of maps, one per date, or an empty list if the body is not found.  Keys:
+	//! - jd : Julian Day (UT)
+	//! - jde : Julian Ephemeris Day
+	//! - raJ2000 : right ascension angle (J2000 frame) in decimal degrees
+	//! - decJ2000 : declination angle (J2000 frame) in decimal degrees
+	//! - distance : distance to the body in AU
+	//! - phase-angle : phase angle in radians
+	//! - elongation : elongation in radians
+	//! - vmag : visual magnitude, without extinction
+	QVariantList getEphemeris(const QString& name, const QString& dateFrom, const QString& dateTo, double step, const QString& spec="utc");
+
 	//! Clear the display options, setting a "standard" view.
 	//! Preset states:
 	//! - natural : azimuthal mount, atmosphere, landscape,
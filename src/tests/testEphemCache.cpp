@@ -0,0 +1,172 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testEphemCache.hpp"
+
+#include <QtGlobal>
+#include <cmath>
+
+#include "EphemCache.hpp"
+#include "vsop87.h"
+#include "elp82b.h"
+
+QTEST_GUILESS_MAIN(TestEphemCache)
+
+// Full series, without the interpolation done by GetVsop87Coor()
+static void getSeriesCoor(double jde, int body, double xyz[3])
+{
+	if (body==EphemCache::Moon)
+	{
+		GetElp82bCoor(jde, xyz);
+		return;
+	}
+	double all[8*3];
+	GetVsop87CoorAll(jde, all);
+	xyz[0] = all[body*3];
+	xyz[1] = all[body*3+1];
+	xyz[2] = all[body*3+2];
+}
+
+void TestEphemCache::cleanup()
+{
+	EphemCache::setAccuracy(1e-9);
+}
+
+double TestEphemCache::maxError(int body, double jde0, double jde1, int nb)
+{
+	double err = 0.;
+	for (int i=0; i<nb; ++i)
+	{
+		const double jde = jde0 + (jde1-jde0)*i/(nb-1);
+		double cached[3], series[3];
+		EphemCache::getCoor(jde, body, cached);
+		getSeriesCoor(jde, body, series);
+		for (int k=0; k<3; ++k)
+			err = qMax(err, std::fabs(cached[k]-series[k]));
+	}
+	return err;
+}
+
+void TestEphemCache::testAgainstSeries_data()
+{
+	QTest::addColumn<double>("accuracy");
+	QTest::addColumn<double>("jde");
+
+	QTest::newRow("1e-9 AU, J2000") << 1e-9 << 2451545.0;
+	QTest::newRow("1e-9 AU, 1066") << 1e-9 << 2110701.5;
+	QTest::newRow("1e-9 AU, 3000") << 1e-9 << 2816787.5;
+	QTest::newRow("1e-7 AU, -2000") << 1e-7 << 990557.5;
+	QTest::newRow("1e-10 AU, 2017") << 1e-10 << 2457754.5;
+	QTest::newRow("1e-10 AU, -2000") << 1e-10 << 990557.5;
+}
+
+void TestEphemCache::testAgainstSeries()
+{
+	QFETCH(double, accuracy);
+	QFETCH(double, jde);
+
+	EphemCache::setAccuracy(accuracy);
+	EphemCache::precompute(jde, jde+200.);
+	const int fits = EphemCache::getFitCount();
+	QVERIFY(fits>0);
+
+	for (int body=0; body<EphemCache::NbBodies; ++body)
+	{
+		const double err = maxError(body, jde, jde+200., 2000);
+		QVERIFY2(err<=accuracy, qPrintable(QString("body %1: error %2 AU is above %3 AU").arg(body).arg(err).arg(accuracy)));
+	}
+	// Everything was answered from the precomputed segments
+	QCOMPARE(EphemCache::getFitCount(), fits);
+}
+
+void TestEphemCache::testOnDemand()
+{
+	EphemCache::setAccuracy(1e-9);
+	const double jde = 2457754.5;
+	double xyz[3];
+
+	// An isolated date is answered by the series
+	EphemCache::getCoor(jde, EphemCache::Jupiter, xyz);
+	QCOMPARE(EphemCache::getFitCount(), 0);
+
+	// Repeated calls at the same date don't trigger a fit
+	for (int i=0; i<10; ++i)
+		EphemCache::getCoor(jde, EphemCache::Mars, xyz);
+	QCOMPARE(EphemCache::getFitCount(), 0);
+
+	// Several dates inside a segment do, and the planets share their segments
+	const double step = EphemCache::getSegmentDuration(EphemCache::Jupiter)/100.;
+	for (int i=1; i<10; ++i)
+		EphemCache::getCoor(jde + i*step, EphemCache::Jupiter, xyz);
+	QCOMPARE(EphemCache::getFitCount(), 1);
+	for (int i=1; i<10; ++i)
+		EphemCache::getCoor(jde + i*step, EphemCache::Neptune, xyz);
+	QCOMPARE(EphemCache::getFitCount(), 1);
+
+	double series[3];
+	getSeriesCoor(jde + 5*step, EphemCache::Neptune, series);
+	EphemCache::getCoor(jde + 5*step, EphemCache::Neptune, xyz);
+	for (int k=0; k<3; ++k)
+		QVERIFY(std::fabs(xyz[k]-series[k])<=1e-9);
+
+	EphemCache::clear();
+	QCOMPARE(EphemCache::getFitCount(), 0);
+}
+
+void TestEphemCache::testDisabled()
+{
+	EphemCache::setAccuracy(0.);
+	QVERIFY(!EphemCache::isEnabled());
+	for (int i=0; i<100; ++i)
+	{
+		const double jde = 2451545.0 + i*0.25;
+		double cached[3], series[3];
+		EphemCache::getCoor(jde, EphemCache::Moon, cached);
+		GetElp82bCoor(jde, series);
+		QCOMPARE(cached[0], series[0]);
+		QCOMPARE(cached[1], series[1]);
+		QCOMPARE(cached[2], series[2]);
+		EphemCache::getCoor(jde, EphemCache::Mercury, cached);
+		GetVsop87Coor(jde, EphemCache::Mercury, series);
+		QCOMPARE(cached[0], series[0]);
+		QCOMPARE(cached[1], series[1]);
+		QCOMPARE(cached[2], series[2]);
+	}
+	QCOMPARE(EphemCache::getFitCount(), 0);
+}
+
+void TestEphemCache::benchmarkMoon_data()
+{
+	QTest::addColumn<bool>("cached");
+	QTest::newRow("series") << false;
+	QTest::newRow("cache") << true;
+}
+
+void TestEphemCache::benchmarkMoon()
+{
+	QFETCH(bool, cached);
+	EphemCache::setAccuracy(cached ? 1e-9 : 0.);
+	// One year of positions every 30 minutes, like a fast time lapse
+	double xyz[3];
+	QBENCHMARK
+	{
+		for (int i=0; i<365*48; ++i)
+			EphemCache::getCoor(2457754.5 + i/48., EphemCache::Moon, xyz);
+	}
+}
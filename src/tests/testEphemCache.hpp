@@ -0,0 +1,43 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTEPHEMCACHE_HPP_
+#define _TESTEPHEMCACHE_HPP_
+
+#include <QObject>
+#include <QTest>
+
+//! Chebyshev cache of the VSOP87 and ELP82B series.
+class TestEphemCache : public QObject
+{
+Q_OBJECT
+private slots:
+	void cleanup();
+	void testAgainstSeries_data();
+	void testAgainstSeries();
+	void testOnDemand();
+	void testDisabled();
+	void benchmarkMoon_data();
+	void benchmarkMoon();
+private:
+	//! Largest difference between the cache and the full series for one body over [jde0;jde1].
+	double maxError(int body, double jde0, double jde1, int nb);
+};
+
+#endif // _TESTEPHEMCACHE_HPP_
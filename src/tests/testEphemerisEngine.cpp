@@ -0,0 +1,115 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QObject>
+#include <QtDebug>
+#include <QtTest>
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+
+#include "tests/testEphemerisEngine.hpp"
+#include "EphemerisEngine.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelObserver.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestEphemerisEngine)
+
+void TestEphemerisEngine::initTestCase()
+{
+	// The Sun, the Earth and Mars, with the elements of ssystem.ini
+	QVERIFY(tempDir.isValid());
+	const QString filePath = tempDir.path()+"/ssystem.ini";
+	QFile file(filePath);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream out(&file);
+	out << "[sun]\ncoord_func=sun_special\nname=Sun\nparent=none\nradius=696000.\ntype=star\n\n"
+	    << "[earth]\nalbedo=0.3\ncoord_func=earth_special\nname=Earth\noblateness=0.00335364\n"
+	    << "orbit_visualization_period=365.256363004\nparent=Sun\nradius=6378.14\nrot_epoch=2451545.0\n"
+	    << "rot_obliquity=-23.4392803055555555556\nrot_periode=23.9344694\nrot_precession_rate=1.39639\n"
+	    << "rot_rotation_offset=280.5\ntype=planet\n\n"
+	    << "[mars]\nalbedo=0.150\ncoord_func=mars_special\nname=Mars\noblateness=0.0064763\n"
+	    << "orbit_visualization_period=686.971\nparent=Sun\nradius=3397\nrot_equator_ascending_node=82.91\n"
+	    << "rot_obliquity=26.72\nrot_periode=24.622962\nrot_pole_de=52.88212\nrot_pole_ra=317.6725\n"
+	    << "rot_rotation_offset=136.005\ntype=planet\n\n";
+	file.close();
+
+	// The observer and the engine need the core and the SolarSystem module, without the main window
+	app = new StelApp();
+	app->initCore(new QSettings(tempDir.path()+"/config.ini", QSettings::IniFormat, app));
+	ssystem = new SolarSystem();
+	QVERIFY(ssystem->loadSolarSystemFile(filePath));
+	app->getModuleMgr().registerModule(ssystem);
+	ssystem->setFlagLightTravelTime(false);
+
+	location.planetName = "Earth";
+	location.latitude = 48.85f;
+	location.longitude = 2.35f;
+	location.altitude = 35;
+}
+
+void TestEphemerisEngine::cleanupTestCase()
+{
+	// The SolarSystem is deleted with the module manager
+	delete app;
+	app = NULL;
+}
+
+void TestEphemerisEngine::setDate(double JD)
+{
+	StelCore* core = app->getCore();
+	core->setJD(JD);
+	ssystem->computePositions(core->getJDE());
+	core->setObserver(new StelObserver(location));
+}
+
+void TestEphemerisEngine::testTopocentricPositions()
+{
+	const PlanetP mars = ssystem->searchByEnglishName("Mars");
+	const PlanetP earth = ssystem->getEarth();
+	QVERIFY(!mars.isNull() && !earth.isNull());
+
+	// Three days with a step of three hours, while the observer turns with the Earth
+	const double firstJD = 2457700.5;
+	setDate(firstJD);
+	const EphemerisEngine::Request request = EphemerisEngine::prepare(mars, firstJD, 0.125, 24);
+	QVERIFY(request.isValid());
+	QVERIFY(request.home==earth);
+	const QVector<EphemerisEngine::Entry> entries = EphemerisEngine::compute(request);
+	QCOMPARE(entries.size(), 24);
+
+	const StelCore* core = app->getCore();
+	for (int i=0; i<entries.size(); ++i)
+	{
+		const EphemerisEngine::Entry& e = entries.at(i);
+		setDate(e.JD);
+		QVERIFY(std::fabs(e.JDE-core->getJDE())<1e-9);
+		const Vec3d expected = mars->getJ2000EquatorialPos(core);
+		// The observer is at about one Earth radius (4.3e-5 AU) from the center, the positions must agree within 15 km
+		const Vec3d geocentric = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(mars->getHeliocentricEclipticPos()-earth->getHeliocentricEclipticPos());
+		QVERIFY((expected-geocentric).length()>1e-5);
+		QVERIFY2((e.j2000Pos-expected).length()<1e-7, qPrintable(QString("JD %1: %2 AU").arg(e.JD, 0, 'f', 4).arg((e.j2000Pos-expected).length())));
+		QVERIFY(std::fabs(e.distance-expected.length())<1e-7);
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTEPHEMERISENGINE_HPP_
+#define _TESTEPHEMERISENGINE_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "StelLocation.hpp"
+
+class SolarSystem;
+class StelApp;
+
+//! Positions of the EphemerisEngine, compared with the ones of the planets updated by the
+//! SolarSystem for a topocentric observer of the StelCore.
+class TestEphemerisEngine : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testTopocentricPositions();
+private:
+	//! Set the date of the core, update the planets and the observer at this date.
+	void setDate(double JD);
+
+	QTemporaryDir tempDir;
+	StelApp* app;
+	SolarSystem* ssystem;
+	StelLocation location;
+};
+
+#endif // _TESTEPHEMERISENGINE_HPP_
@@ -0,0 +1,295 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QObject>
+#include <QtDebug>
+#include <QtTest>
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+
+#include "tests/testMinorBodyPositions.hpp"
+#include "KeplerPropagator.hpp"
+#include "Orbit.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelUtils.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestMinorBodyPositions)
+
+#define NB_BODIES 100000
+
+static double randomDouble(double min, double max)
+{
+	return min + (max-min)*qrand()/RAND_MAX;
+}
+
+void TestMinorBodyPositions::initTestCase()
+{
+	qsrand(42);
+	// Main belt like orbits, with the elements given the same way as in ssystem.ini
+	elements.resize(NB_BODIES);
+	for (int i=0;i<NB_BODIES;++i)
+	{
+		MinorBodyElements& el = elements[i];
+		el.eccentricity = randomDouble(0., 0.35);
+		const double a = randomDouble(2.1, 3.5);
+		el.pericenterDistance = a*(1.-el.eccentricity);
+		el.meanMotion = 0.01720209895/(a*std::sqrt(a))*(180./M_PI);
+		el.inclination = randomDouble(0., 30.);
+		el.ascendingNode = randomDouble(0., 360.);
+		el.argOfPericenter = randomDouble(0., 360.);
+		el.timeAtPericenter = 2451545.0+randomDouble(-1000., 1000.);
+		orbits.append(new CometOrbit(el.pericenterDistance, el.eccentricity, el.inclination*(M_PI/180.),
+					     el.ascendingNode*(M_PI/180.), el.argOfPericenter*(M_PI/180.),
+					     el.timeAtPericenter, 1e10, el.meanMotion*(M_PI/180.), 0., 0., 0.));
+	}
+
+	// The positions only need the settings, the core and the texture manager of the application
+	QVERIFY(tempDir.isValid());
+	app = new StelApp();
+	app->initCore(new QSettings(tempDir.path()+"/config.ini", QSettings::IniFormat, app));
+}
+
+void TestMinorBodyPositions::cleanupTestCase()
+{
+	qDeleteAll(orbits);
+	orbits.clear();
+	delete app;
+	app = NULL;
+}
+
+bool TestMinorBodyPositions::writeSolarSystemFile(const QString& filePath, int nb) const
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	QTextStream out(&file);
+	out << "[sun]\ncoord_func=sun_special\nname=Sun\nparent=none\nradius=696000.\ntype=star\n\n";
+	for (int i=0;i<nb;++i)
+	{
+		const MinorBodyElements& el = elements.at(i);
+		out << QString("[body%1]\n").arg(i)
+		    << "coord_func=comet_orbit\n"
+		    << QString("name=Body %1\n").arg(i)
+		    << QString("orbit_ArgOfPericenter=%1\n").arg(el.argOfPericenter, 0, 'g', 17)
+		    << QString("orbit_AscendingNode=%1\n").arg(el.ascendingNode, 0, 'g', 17)
+		    << QString("orbit_Eccentricity=%1\n").arg(el.eccentricity, 0, 'g', 17)
+		    << "orbit_good=10000000000\n"
+		    << QString("orbit_Inclination=%1\n").arg(el.inclination, 0, 'g', 17)
+		    << QString("orbit_MeanMotion=%1\n").arg(el.meanMotion, 0, 'g', 17)
+		    << QString("orbit_PericenterDistance=%1\n").arg(el.pericenterDistance, 0, 'g', 17)
+		    << QString("orbit_TimeAtPericenter=%1\n").arg(el.timeAtPericenter, 0, 'g', 17)
+		    << QString("orbit_visualization_period=%1\n").arg(360./el.meanMotion, 0, 'g', 17)
+		    << "parent=Sun\nradius=10\ntype=asteroid\n\n";
+	}
+	return out.status()==QTextStream::Ok;
+}
+
+SolarSystem* TestMinorBodyPositions::createSolarSystem(int nb)
+{
+	const QString filePath = QString("%1/ssystem_%2.ini").arg(tempDir.path()).arg(nb);
+	if (!QFile::exists(filePath) && !writeSolarSystemFile(filePath, nb))
+		return NULL;
+	SolarSystem* ssystem = new SolarSystem();
+	if (!ssystem->loadSolarSystemFile(filePath))
+	{
+		delete ssystem;
+		return NULL;
+	}
+	return ssystem;
+}
+
+void TestMinorBodyPositions::testParallelUpdate()
+{
+	SolarSystem* serial = createSolarSystem(10000);
+	SolarSystem* parallel = createSolarSystem(10000);
+	QVERIFY(serial && parallel);
+	QCOMPARE(parallel->getAllPlanets().size(), 10001);
+	// The bodies must be computed by the workers, not by the Kepler propagator
+	serial->setFlagKeplerPropagator(false);
+	parallel->setFlagKeplerPropagator(false);
+	serial->setFlagParallelPositions(false);
+	parallel->setFlagParallelPositions(true);
+	// With the orbits shown, the workers also compute the orbit points and their Delta-T
+	serial->setFlagOrbits(true);
+	parallel->setFlagOrbits(true);
+	for (int i=0;i<serial->getAllPlanets().size();++i)
+	{
+		serial->getAllPlanets().at(i)->update(10000);
+		parallel->getAllPlanets().at(i)->update(10000);
+	}
+
+	// The observer is on the Earth, which is at about 1 AU
+	const Vec3d observerPos(1., 0., 0.);
+	// The second date updates the orbits incrementally
+	const double dates[] = {2457000.5, 2457030.5};
+	for (int d=0;d<2;++d)
+	{
+		serial->computePositions(dates[d], observerPos);
+		parallel->computePositions(dates[d], observerPos);
+		QCOMPARE(parallel->getAllPlanets().size(), serial->getAllPlanets().size());
+		for (int i=0;i<serial->getAllPlanets().size();++i)
+		{
+			const PlanetP& p = serial->getAllPlanets().at(i);
+			const Vec3d pos = p->getHeliocentricEclipticPos();
+			// The bodies are independent, the results must be exactly the same
+			QVERIFY2(parallel->getAllPlanets().at(i)->getHeliocentricEclipticPos()==pos, qPrintable(p->getEnglishName()));
+			// Sanity check of the orbits
+			if (p!=serial->getSun())
+				QVERIFY(pos.length()>1.3 && pos.length()<4.8);
+		}
+	}
+	delete serial;
+	delete parallel;
+}
+
+void TestMinorBodyPositions::testKeplerPropagator()
+{
+	// Elliptic up to e=0.999, hyperbolic and parabolic orbits, with perihelion passages over +-50 years
+	QVector<CometOrbit*> cometOrbits;
+	KeplerPropagator propagator;
+	for (int i=0;i<3000;++i)
+	{
+		const double e = i%3==0 ? randomDouble(0., 0.999) : (i%3==1 ? randomDouble(1.0001, 3.) : 1.);
+		const double q = randomDouble(0.1, 5.);
+		const double n = e==1. ? 0.01720209895*(1.5/q)*std::sqrt(0.5/q) : 0.01720209895/std::pow(fabs(q/(1.-e)), 1.5);
+		cometOrbits.append(new CometOrbit(q, e, randomDouble(0., M_PI), randomDouble(0., 2*M_PI), randomDouble(0., 2*M_PI),
+						  2451545.0+randomDouble(-20000., 20000.), 1e10, n, 0., 0., 0.));
+		QCOMPARE(propagator.add(cometOrbits.last()), i);
+	}
+	// Orbits rotated to the frame of a planet are not supported
+	CometOrbit moonOrbit(0.01, 0.1, 0., 0., 0., 2451545.0, 1e10, 0.1, 0.4, 0.1, 0.);
+	QCOMPARE(propagator.add(&moonOrbit), -1);
+
+	for (double dateJDE=2440000.5; dateJDE<2470000.; dateJDE+=777.7)
+	{
+		propagator.compute(dateJDE);
+		for (int i=0;i<cometOrbits.size();++i)
+		{
+			double xyz[3];
+			cometOrbits.at(i)->positionAtTimevInVSOP87Coordinates(dateJDE, xyz, true);
+			const Vec3d pos(xyz[0], xyz[1], xyz[2]);
+			const double error = (propagator.getPosition(i)-pos).length()/qMax(1., pos.length());
+			QVERIFY2(error<KeplerPropagator::Tolerance, qPrintable(QString("body %1 error %2").arg(i).arg(error)));
+			const Vec3d velocity = cometOrbits.at(i)->getVelocity();
+			QVERIFY((propagator.getVelocity(i)-velocity).length()<KeplerPropagator::Tolerance*qMax(1e-3, velocity.length()));
+		}
+	}
+
+	// The ell_orbit bodies of ssystem.ini: circular, elliptic up to e=0.97 and hyperbolic orbits.
+	// EllipticalOrbit stops its iterations before they have converged for 0<e<0.2, except for
+	// nearly circular orbits.
+	static const double ellipticalEccentricities[] = {0., 0.01, 0.3, 0.6, 0.9, 0.97, 1.5};
+	QVector<EllipticalOrbit*> ellipticalOrbits;
+	KeplerPropagator ellipticalPropagator;
+	for (int i=0;i<7;++i)
+	{
+		const double e = ellipticalEccentricities[i];
+		const double q = randomDouble(0.3, 5.);
+		const double a = q/std::fabs(1.-e);
+		const double period = 2.*M_PI*a*std::sqrt(a)/0.01720209895;
+		ellipticalOrbits.append(new EllipticalOrbit(q, e, randomDouble(0., M_PI), randomDouble(0., 2*M_PI), randomDouble(0., 2*M_PI),
+							    randomDouble(0., 2*M_PI), period, 2451545.0+randomDouble(-2000., 2000.), 0., 0., 0.));
+		QCOMPARE(ellipticalPropagator.add(ellipticalOrbits.last()), i);
+	}
+	// EllipticalOrbit doesn't compute parabolic orbits
+	EllipticalOrbit parabolicOrbit(1., 1., 0.1, 0.2, 0.3, 0., 365.25, 2451545.0, 0., 0., 0.);
+	QCOMPARE(ellipticalPropagator.add(&parabolicOrbit), -1);
+
+	for (double dateJDE=2440000.5; dateJDE<2470000.; dateJDE+=777.7)
+	{
+		ellipticalPropagator.compute(dateJDE);
+		for (int i=0;i<ellipticalOrbits.size();++i)
+		{
+			double xyz[3];
+			ellipticalOrbits.at(i)->positionAtTimevInVSOP87Coordinates(dateJDE, xyz);
+			const Vec3d pos(xyz[0], xyz[1], xyz[2]);
+			const double error = (ellipticalPropagator.getPosition(i)-pos).length()/qMax(1., pos.length());
+			QVERIFY2(error<KeplerPropagator::Tolerance, qPrintable(QString("elliptical orbit e=%1 error %2").arg(ellipticalEccentricities[i]).arg(error)));
+		}
+	}
+	qDeleteAll(ellipticalOrbits);
+
+	// Light time corrections, and computation in several parts
+	QVector<double> lightTimes(cometOrbits.size());
+	for (int i=0;i<lightTimes.size();++i)
+		lightTimes[i] = randomDouble(0., 0.1);
+	for (int part=0;part<7;++part)
+		propagator.compute(2457000.5, lightTimes.constData(), part, 7);
+	for (int i=0;i<cometOrbits.size();++i)
+	{
+		double xyz[3];
+		cometOrbits.at(i)->positionAtTimevInVSOP87Coordinates(2457000.5-lightTimes.at(i), xyz, false);
+		const Vec3d pos(xyz[0], xyz[1], xyz[2]);
+		QVERIFY((propagator.getPosition(i)-pos).length()<KeplerPropagator::Tolerance*qMax(1., pos.length()));
+	}
+	qDeleteAll(cometOrbits);
+}
+
+void TestMinorBodyPositions::benchmarkUpdate_data()
+{
+	QTest::addColumn<int>("nb");
+	QTest::addColumn<bool>("parallel");
+	QTest::newRow("1k serial") << 1000 << false;
+	QTest::newRow("1k parallel") << 1000 << true;
+	QTest::newRow("10k serial") << 10000 << false;
+	QTest::newRow("10k parallel") << 10000 << true;
+	QTest::newRow("100k serial") << 100000 << false;
+	QTest::newRow("100k parallel") << 100000 << true;
+}
+
+void TestMinorBodyPositions::benchmarkUpdate()
+{
+	QFETCH(int, nb);
+	QFETCH(bool, parallel);
+	SolarSystem* ssystem = createSolarSystem(nb);
+	QVERIFY(ssystem);
+	ssystem->setFlagParallelPositions(parallel);
+	const Vec3d observerPos(1., 0., 0.);
+	double dateJDE = 2457000.5;
+	QBENCHMARK
+	{
+		// Advance the time like in a running simulation
+		ssystem->computePositions(dateJDE, observerPos);
+		dateJDE += 1./24.;
+	}
+	delete ssystem;
+}
+
+void TestMinorBodyPositions::benchmarkKeplerPropagator()
+{
+	// The orbits of the "100k" rows of benchmarkUpdate, without the Planet objects
+	KeplerPropagator propagator;
+	foreach (const CometOrbit* orbit, orbits)
+		propagator.add(orbit);
+	QVector<double> lightTimes(orbits.size());
+	static const Vec3d observerPos(1., 0., 0.);
+	double dateJDE = 2457000.5;
+	QBENCHMARK
+	{
+		propagator.compute(dateJDE);
+		for (int i=0;i<lightTimes.size();++i)
+			lightTimes[i] = (propagator.getPosition(i)-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+		propagator.compute(dateJDE, lightTimes.constData());
+		dateJDE += 1./24.;
+	}
+}
@@ -0,0 +1,69 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTMINORBODYPOSITIONS_HPP_
+#define _TESTMINORBODYPOSITIONS_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+class CometOrbit;
+class SolarSystem;
+class StelApp;
+
+//! Update of the positions of many minor bodies by SolarSystem::computePositions(): first without,
+//! then with light time correction, in the main thread or in worker threads.
+class TestMinorBodyPositions : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testParallelUpdate();
+	void testKeplerPropagator();
+	void benchmarkUpdate_data();
+	void benchmarkUpdate();
+	void benchmarkKeplerPropagator();
+private:
+	//! The orbital elements of a minor body, in the units of ssystem.ini.
+	struct MinorBodyElements
+	{
+		double pericenterDistance;	// AU
+		double eccentricity;
+		double inclination;		// degrees
+		double ascendingNode;		// degrees
+		double argOfPericenter;		// degrees
+		double timeAtPericenter;	// JDE
+		double meanMotion;		// degrees/day
+	};
+
+	//! Write a Solar System file with the Sun and the first nb bodies.
+	bool writeSolarSystemFile(const QString& filePath, int nb) const;
+	//! Load the Sun and the first nb bodies into a new SolarSystem, or return NULL.
+	SolarSystem* createSolarSystem(int nb);
+
+	QVector<MinorBodyElements> elements;
+	QVector<CometOrbit*> orbits;
+	QTemporaryDir tempDir;
+	StelApp* app;
+};
+
+#endif // _TESTMINORBODYPOSITIONS_HPP_
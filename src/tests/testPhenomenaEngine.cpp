@@ -0,0 +1,117 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QObject>
+#include <QtDebug>
+#include <QtTest>
+#include <QFile>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTextStream>
+
+#include "tests/testPhenomenaEngine.hpp"
+#include "PhenomenaEngine.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelLocation.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelObserver.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestPhenomenaEngine)
+
+void TestPhenomenaEngine::initTestCase()
+{
+	// The Sun, the Earth, Jupiter and Saturn, with the elements of ssystem.ini
+	QVERIFY(tempDir.isValid());
+	const QString filePath = tempDir.path()+"/ssystem.ini";
+	QFile file(filePath);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream out(&file);
+	out << "[sun]\ncoord_func=sun_special\nname=Sun\nparent=none\nradius=696000.\ntype=star\n\n"
+	    << "[earth]\nalbedo=0.3\ncoord_func=earth_special\nname=Earth\noblateness=0.00335364\n"
+	    << "orbit_visualization_period=365.256363004\nparent=Sun\nradius=6378.14\nrot_epoch=2451545.0\n"
+	    << "rot_obliquity=-23.4392803055555555556\nrot_periode=23.9344694\nrot_precession_rate=1.39639\n"
+	    << "rot_rotation_offset=280.5\ntype=planet\n\n"
+	    << "[jupiter]\nalbedo=0.51\ncoord_func=jupiter_special\nname=Jupiter\noblateness=0.064874\n"
+	    << "orbit_visualization_period=4331.87\nparent=Sun\nradius=71492\nrot_equator_ascending_node=-22.203\n"
+	    << "rot_obliquity=2.222461\nrot_periode=9.92491\nrot_pole_de=64.49\nrot_pole_ra=268.05\n"
+	    << "rot_rotation_offset=0\ntype=planet\n\n"
+	    << "[saturn]\nalbedo=0.50\ncoord_func=saturn_special\nname=Saturn\noblateness=0.097962\n"
+	    << "orbit_visualization_period=10760\nparent=Sun\nradius=60268\nrot_equator_ascending_node=169.5291\n"
+	    << "rot_obliquity=28.049\nrot_periode=10.65622\nrot_pole_de=83.537\nrot_pole_ra=40.5908\n"
+	    << "rot_rotation_offset=358.922\ntype=planet\n\n";
+	file.close();
+
+	// The observer and the engine need the core and the SolarSystem module, without the main window
+	app = new StelApp();
+	app->initCore(new QSettings(tempDir.path()+"/config.ini", QSettings::IniFormat, app));
+	ssystem = new SolarSystem();
+	QVERIFY(ssystem->loadSolarSystemFile(filePath));
+	app->getModuleMgr().registerModule(ssystem);
+	ssystem->setFlagLightTravelTime(true);
+
+	StelLocation location;
+	location.planetName = "Earth";
+	location.latitude = 48.85f;
+	location.longitude = 2.35f;
+	location.altitude = 35;
+	StelCore* core = app->getCore();
+	core->setJD(2459184.5);
+	ssystem->computePositions(core->getJDE());
+	core->setObserver(new StelObserver(location));
+}
+
+void TestPhenomenaEngine::cleanupTestCase()
+{
+	// The SolarSystem is deleted with the module manager
+	delete app;
+	app = NULL;
+}
+
+void TestPhenomenaEngine::testGreatConjunction()
+{
+	const PlanetP jupiter = ssystem->searchByEnglishName("Jupiter");
+	const PlanetP saturn = ssystem->searchByEnglishName("Saturn");
+	QVERIFY(!jupiter.isNull() && !saturn.isNull());
+
+	// The great conjunction of 2020 December 21, at about 18h UT with a separation of 6.1'
+	PhenomenaEngine::Request request = PhenomenaEngine::prepare(jupiter, 2459184.5, 2459225.5, M_PI/180., false);
+	request.addPlanet(saturn);
+	QVERIFY(request.isValid());
+
+	PhenomenaEngine engine;
+	QSignalSpy finished(&engine, SIGNAL(finished()));
+	QVERIFY(engine.start(request));
+	QVERIFY(finished.wait(60000));
+	QVERIFY(!engine.isRunning());
+
+	const QVector<PhenomenaEngine::Event>& events = engine.getEvents();
+	QCOMPARE(events.size(), 1);
+	const PhenomenaEngine::Event& e = events.first();
+	QCOMPARE(e.target, 0);
+	QVERIFY(!e.fixed);
+	QVERIFY(!e.opposition);
+	QVERIFY2(std::fabs(e.JD-2459205.26)<0.1, qPrintable(QString("JD %1").arg(e.JD, 0, 'f', 4)));
+	QVERIFY2(std::fabs(e.separation*180./M_PI*60.-6.1)<0.3, qPrintable(QString("separation %1'").arg(e.separation*180./M_PI*60.)));
+	QVERIFY(e.bodyDistance>5.5 && e.bodyDistance<6.);
+	QVERIFY(e.targetDistance>10.5 && e.targetDistance<11.);
+}
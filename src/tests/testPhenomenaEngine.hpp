@@ -0,0 +1,44 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTPHENOMENAENGINE_HPP_
+#define _TESTPHENOMENAENGINE_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+class SolarSystem;
+class StelApp;
+
+//! Search of known conjunctions by the PhenomenaEngine, for an observer on the Earth.
+class TestPhenomenaEngine : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testGreatConjunction();
+private:
+	QTemporaryDir tempDir;
+	StelApp* app;
+	SolarSystem* ssystem;
+};
+
+#endif // _TESTPHENOMENAENGINE_HPP_
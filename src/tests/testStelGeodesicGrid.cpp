@@ -0,0 +1,110 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelGeodesicGrid.hpp"
+#include "StelGeodesicGrid.hpp"
+
+#include <QtAlgorithms>
+
+QTEST_GUILESS_MAIN(TestStelGeodesicGrid)
+
+static const int gridLevel = 7;
+
+// Get the inside and border zones of the last level of a search result
+static QVector<int> getZones(const GeodesicSearchResult* r, int level)
+{
+	QVector<int> zones;
+	GeodesicSearchInsideIterator it1(*r, level);
+	for (int z=it1.next(); z>=0; z=it1.next())
+		zones.append(z);
+	zones.append(-1);
+	GeodesicSearchBorderIterator it2(*r, level);
+	for (int z=it2.next(); z>=0; z=it2.next())
+		zones.append(z);
+	qSort(zones);
+	return zones;
+}
+
+// A region like the viewport: 4 caps through the center of the sphere, around a direction
+static QVector<SphericalCap> getViewportCaps(double ra, double dec, double fov)
+{
+	const Vec3d dir(std::cos(dec)*std::cos(ra), std::cos(dec)*std::sin(ra), std::sin(dec));
+	const Vec3d east(-std::sin(ra), std::cos(ra), 0.);
+	const Vec3d north = dir^east;
+	const double s = std::sin(fov/2.), c = std::cos(fov/2.);
+	QVector<SphericalCap> caps;
+	caps << SphericalCap(dir*s+east*c, 0.) << SphericalCap(dir*s-east*c, 0.)
+	     << SphericalCap(dir*s+north*c, 0.) << SphericalCap(dir*s-north*c, 0.);
+	for (int i=0; i<caps.size(); ++i)
+		caps[i].n.normalize();
+	return caps;
+}
+
+void TestStelGeodesicGrid::testSearchCache()
+{
+	StelGeodesicGrid grid(gridLevel);
+	const QVector<SphericalCap> caps1 = getViewportCaps(0.3, 0.2, 0.5);
+	const QVector<SphericalCap> caps2 = getViewportCaps(2., -0.7, 0.2);
+
+	const GeodesicSearchResult* r1 = grid.search(caps1, gridLevel);
+	const GeodesicSearchResult* r2 = grid.search(caps2, gridLevel);
+	QVERIFY(r1!=r2);
+	// Alternating searches don't evict each other
+	QVERIFY(grid.search(caps1, gridLevel)==r1);
+	QVERIFY(grid.search(caps2, gridLevel)==r2);
+	QCOMPARE(grid.getSearchStatistics().misses, 2);
+	QCOMPARE(grid.getSearchStatistics().exactHits, 2);
+	// A different level is a different search
+	grid.search(caps1, gridLevel-1);
+	QCOMPARE(grid.getSearchStatistics().misses, 3);
+
+	// The least recently used result is replaced
+	for (int i=0; i<StelGeodesicGrid::SearchCacheSize; ++i)
+		grid.search(getViewportCaps(i, 1., 0.1), gridLevel);
+	grid.resetSearchStatistics();
+	grid.search(caps1, gridLevel);
+	QCOMPARE(grid.getSearchStatistics().misses, 1);
+	QCOMPARE(grid.getSearchStatistics().exactHits, 0);
+}
+
+void TestStelGeodesicGrid::testNearSearch()
+{
+	StelGeodesicGrid grid(gridLevel);
+	int nearHits = 0;
+	// Pan the view by small steps: the cached result must be exactly the result of a new search
+	for (int i=0; i<200; ++i)
+	{
+		const QVector<SphericalCap> caps = getViewportCaps(1.+i*1e-6, 0.5, 0.4);
+		const int before = grid.getSearchStatistics().nearHits;
+		const GeodesicSearchResult* r = grid.search(caps, gridLevel);
+		if (grid.getSearchStatistics().nearHits>before)
+		{
+			++nearHits;
+			StelGeodesicGrid freshGrid(gridLevel);
+			QCOMPARE(getZones(r, gridLevel), getZones(freshGrid.search(caps, gridLevel), gridLevel));
+		}
+	}
+	QVERIFY(nearHits>0);
+	QCOMPARE(grid.getSearchStatistics().nearHits+grid.getSearchStatistics().misses, 200);
+
+	// A large move needs a new search
+	grid.resetSearchStatistics();
+	grid.search(getViewportCaps(1.1, 0.5, 0.4), gridLevel);
+	QCOMPARE(grid.getSearchStatistics().misses, 1);
+}
@@ -0,0 +1,149 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelNameIndex.hpp"
+
+#include "StelNameIndex.hpp"
+
+QTEST_GUILESS_MAIN(TestStelNameIndex)
+
+void TestStelNameIndex::testFindPrefix()
+{
+	StelNameIndex index;
+	index.insert("Orion Nebula");
+	index.insert("Andromeda Galaxy");
+	index.insert("Omega Nebula");
+	index.insert("Owl Nebula");
+	index.insert("Crab Nebula");
+
+	QCOMPARE(index.findPrefix("o", 10), QStringList() << "Omega Nebula" << "Orion Nebula" << "Owl Nebula");
+	QCOMPARE(index.findPrefix("ORI", 10), QStringList() << "Orion Nebula");
+	QCOMPARE(index.findPrefix("Nebula", 10), QStringList());
+	QCOMPARE(index.findPrefix("x", 10), QStringList());
+	QCOMPARE(index.size(), 5);
+}
+
+void TestStelNameIndex::testFindSubstring()
+{
+	StelNameIndex index;
+	index.insert("Orion Nebula");
+	index.insert("Andromeda Galaxy");
+	index.insert("Crab Nebula");
+	index.insert("Pinwheel Galaxy");
+
+	QCOMPARE(index.findSubstring("nebula", 10), QStringList() << "Crab Nebula" << "Orion Nebula");
+	QCOMPARE(index.findSubstring("AX", 10), QStringList() << "Andromeda Galaxy" << "Pinwheel Galaxy");
+	QCOMPARE(index.findSubstring("a", 10), QStringList() << "Andromeda Galaxy" << "Crab Nebula" << "Orion Nebula" << "Pinwheel Galaxy");
+	QCOMPARE(index.findSubstring("zz", 10), QStringList());
+	// The empty text matches all names
+	QCOMPARE(index.findSubstring("", 10).size(), 4);
+}
+
+void TestStelNameIndex::testPrefixOnly()
+{
+	StelNameIndex index;
+	index.insert("NGC 1976", true);
+	index.insert("NGC 224", true);
+	index.insert("M 42", true);
+
+	QCOMPARE(index.findPrefix("ngc 1", 10), QStringList() << "NGC 1976");
+	QCOMPARE(index.findSubstring("NGC", 10), QStringList() << "NGC 1976" << "NGC 224");
+	// Designations are not found by their middle
+	QCOMPARE(index.findSubstring("42", 10), QStringList());
+	QCOMPARE(index.findSubstring("1976", 10), QStringList());
+}
+
+void TestStelNameIndex::testInsertAfterQuery()
+{
+	StelNameIndex index;
+	index.insert("Ring Nebula");
+	QCOMPARE(index.findSubstring("NEB", 10), QStringList() << "Ring Nebula");
+
+	// New names are merged with the ones already sorted
+	index.insert("Eagle Nebula");
+	index.insert("Rosette Nebula");
+	QCOMPARE(index.findSubstring("NEB", 10), QStringList() << "Eagle Nebula" << "Ring Nebula" << "Rosette Nebula");
+	QCOMPARE(index.findPrefix("R", 10), QStringList() << "Ring Nebula" << "Rosette Nebula");
+}
+
+void TestStelNameIndex::testDuplicates()
+{
+	StelNameIndex index;
+	index.insert("Pleiades");
+	index.insert("Pleiades");
+	index.insert("Seven Sisters");
+	index.insert("");
+
+	QCOMPARE(index.size(), 3);
+	// Names containing the text several times are only returned once
+	QCOMPARE(index.findSubstring("E", 10), QStringList() << "Pleiades" << "Seven Sisters");
+	QCOMPARE(index.findPrefix("P", 10), QStringList() << "Pleiades");
+}
+
+void TestStelNameIndex::testMaxNbItem()
+{
+	StelNameIndex index;
+	for (int i=1; i<=100; ++i)
+		index.insert(QString("M%1").arg(i), true);
+
+	QCOMPARE(index.findPrefix("M", 3), QStringList() << "M1" << "M10" << "M100");
+	QCOMPARE(index.findPrefix("M4", 2), QStringList() << "M4" << "M40");
+	QCOMPARE(index.findSubstring("M9", 20).size(), 11);
+	QCOMPARE(index.findPrefix("M", 0), QStringList());
+	QCOMPARE(index.findSubstring("M", -1), QStringList());
+
+	// Only the first distinct names are returned, whatever the order of the matched suffixes
+	StelNameIndex nebulae;
+	nebulae.insert("Zeta Nebula");
+	nebulae.insert("Nebula Alpha");
+	nebulae.insert("Mu Nebula");
+	nebulae.insert("Nebula Alpha");
+	QCOMPARE(nebulae.findSubstring("NEB", 2), QStringList() << "Mu Nebula" << "Nebula Alpha");
+	QCOMPARE(nebulae.findSubstring("A", 1), QStringList() << "Mu Nebula");
+}
+
+void TestStelNameIndex::testClear()
+{
+	StelNameIndex index;
+	index.insert("Beehive Cluster");
+	QCOMPARE(index.findPrefix("B", 10).size(), 1);
+	index.clear();
+	QCOMPARE(index.size(), 0);
+	QCOMPARE(index.findPrefix("B", 10), QStringList());
+	QCOMPARE(index.findSubstring("CLUSTER", 10), QStringList());
+	index.insert("Wild Duck Cluster");
+	QCOMPARE(index.findSubstring("CLUSTER", 10), QStringList() << "Wild Duck Cluster");
+}
+
+void TestStelNameIndex::benchmarkFindSubstring()
+{
+	// About the size of the DSO catalog, with names made of a few words
+	static const char* words[] = {"Nebula", "Cluster", "Galaxy", "Cloud", "Dark", "Eagle", "Horse", "Veil", "Ring", "Star"};
+	StelNameIndex index;
+	for (int i=0; i<100000; ++i)
+		index.insert(QString("%1 %2 %3").arg(words[i%10]).arg(words[(i/10)%10]).arg(i));
+	index.findPrefix("", 1);
+
+	QBENCHMARK
+	{
+		index.findSubstring("horse clo", 5);
+		index.findSubstring("99", 5);
+		index.findPrefix("veil", 5);
+	}
+}
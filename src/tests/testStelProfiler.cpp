@@ -0,0 +1,172 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelProfiler.hpp"
+
+#include "StelProfiler.hpp"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+QTEST_GUILESS_MAIN(TestStelProfiler)
+
+// Run a frame with some nested scopes
+static void runFrame(StelProfiler& profiler, int nbInnerCalls)
+{
+	profiler.beginFrame();
+	{
+		StelProfileScope update("update");
+		for (int i=0; i<nbInnerCalls; ++i)
+		{
+			StelProfileScope inner("inner");
+			QThread::usleep(100);
+		}
+	}
+	{
+		StelProfileScope draw("draw");
+	}
+}
+
+void TestStelProfiler::testDisabled()
+{
+	StelProfiler profiler;
+	QVERIFY(StelProfiler::getInstance()==&profiler);
+	QVERIFY(!profiler.getFlagEnabled());
+	runFrame(profiler, 1);
+	runFrame(profiler, 1);
+	StelProfiler::Statistics stats;
+	QVERIFY(!profiler.getStatistics("update", stats));
+	QVERIFY(profiler.getStatistics("", stats));
+	QCOMPARE(stats.count, 0);
+}
+
+void TestStelProfiler::testTree()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	for (int i=0; i<3; ++i)
+		runFrame(profiler, 2);
+	profiler.beginFrame();
+
+	StelProfiler::Statistics stats;
+	QVERIFY(profiler.getStatistics("", stats));
+	QCOMPARE(stats.count, 3);
+	QVERIFY(profiler.getStatistics("update", stats));
+	QCOMPARE(stats.count, 3);
+	QVERIFY(profiler.getStatistics("update/inner", stats));
+	QCOMPARE(stats.count, 3);
+	QVERIFY(profiler.getStatistics("draw", stats));
+	QVERIFY(!profiler.getStatistics("draw/inner", stats));
+	QVERIFY(!profiler.getStatistics("inner", stats));
+
+	const QStringList lines = profiler.getOverlayLines();
+	QCOMPARE(lines.size(), 4);
+	QVERIFY(lines.at(0).startsWith("frame"));
+	QVERIFY(lines.at(1).startsWith("  update"));
+	QVERIFY(lines.at(2).startsWith("    inner"));
+	QVERIFY(lines.at(3).startsWith("  draw"));
+
+	// Disabling clears the scopes
+	profiler.setFlagEnabled(false);
+	QVERIFY(!profiler.getStatistics("update", stats));
+}
+
+void TestStelProfiler::testStatistics()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	for (int i=0; i<StelProfiler::HistorySize+10; ++i)
+		runFrame(profiler, 2);
+	profiler.beginFrame();
+
+	StelProfiler::Statistics update, inner;
+	QVERIFY(profiler.getStatistics("update", update));
+	QVERIFY(profiler.getStatistics("update/inner", inner));
+	// Only the last frames are kept
+	QCOMPARE(update.count, (int)StelProfiler::HistorySize);
+	// Two calls of at least 0.1 ms each frame are summed
+	QVERIFY(inner.min>=0.2f);
+	QVERIFY(update.min>=inner.min);
+	QVERIFY(inner.min<=inner.median && inner.median<=inner.p95 && inner.p95<=inner.max);
+	QVERIFY(inner.mean>=inner.min && inner.mean<=inner.max);
+	int total = 0;
+	for (int i=0; i<StelProfiler::NbHistogramBins; ++i)
+		total += inner.histogram[i];
+	QCOMPARE(total, inner.count);
+	// Nothing under the upper limit of the 0.1 ms bin
+	QCOMPARE(inner.histogram[0]+inner.histogram[1], 0);
+}
+
+void TestStelProfiler::testUnclosedScope()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	profiler.beginFrame();
+	QVERIFY(profiler.enterScope("open"));
+	profiler.beginFrame();
+	runFrame(profiler, 1);
+	profiler.beginFrame();
+
+	StelProfiler::Statistics stats;
+	QVERIFY(profiler.getStatistics("open", stats));
+	QCOMPARE(stats.count, 1);
+	// The scopes of the next frames are not nested in the unclosed one
+	QVERIFY(profiler.getStatistics("update", stats));
+	QVERIFY(!profiler.getStatistics("open/update", stats));
+}
+
+void TestStelProfiler::testReport()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	for (int i=0; i<5; ++i)
+		runFrame(profiler, 1);
+	profiler.beginFrame();
+
+	QJsonParseError error;
+	const QJsonDocument doc = QJsonDocument::fromJson(profiler.getReport().toUtf8(), &error);
+	QCOMPARE(error.error, QJsonParseError::NoError);
+	const QJsonObject report = doc.object();
+	QCOMPARE(report.value("frames").toInt(), 5);
+	QCOMPARE(report.value("histogramLimits").toArray().size(), (int)StelProfiler::NbHistogramBins-1);
+	const QJsonObject frame = report.value("frame").toObject();
+	QCOMPARE(frame.value("name").toString(), QString("frame"));
+	QCOMPARE(frame.value("cpu").toObject().value("count").toInt(), 5);
+	QCOMPARE(frame.value("cpu").toObject().value("histogram").toArray().size(), (int)StelProfiler::NbHistogramBins);
+	const QJsonArray children = frame.value("children").toArray();
+	QCOMPARE(children.size(), 2);
+	QCOMPARE(children.at(0).toObject().value("name").toString(), QString("update"));
+	QCOMPARE(children.at(0).toObject().value("children").toArray().at(0).toObject().value("name").toString(), QString("inner"));
+	// No GPU timing without OpenGL
+	QVERIFY(!frame.contains("gpu"));
+	QVERIFY(!report.value("gpuTimer").toBool());
+
+	profiler.setCounter("textures/loading", 3);
+	QCOMPARE(profiler.getCounter("textures/loading"), (qint64)3);
+	const QJsonObject counters = QJsonDocument::fromJson(profiler.getReport().toUtf8()).object().value("counters").toObject();
+	QCOMPARE(counters.value("textures/loading").toInt(), 3);
+	QVERIFY(profiler.getOverlayLines().last().startsWith("textures/loading"));
+	// The counters are cleared with the scopes
+	profiler.setFlagEnabled(false);
+	QCOMPARE(profiler.getCounter("textures/loading"), (qint64)-1);
+	profiler.setCounter("textures/loading", 3);
+	QCOMPARE(profiler.getCounter("textures/loading"), (qint64)-1);
+}
@@ -0,0 +1,273 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QObject>
+#include <QtDebug>
+#include <QtTest>
+
+#include "tests/testStelProjectorKernels.hpp"
+#include "StelProjectorClasses.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelProjectorKernels)
+
+#define NB_VECTORS 100003
+
+static const char* projectionNames[] = {"none", "perspective", "equal area", "stereographic", "fisheye",
+	"hammer", "cylinder", "mercator", "orthographic", "sinusoidal", "miller"};
+static const char* kernelNames[] = {"scalar", "SSE2", "AVX2"};
+
+static double randomDouble()
+{
+	return (double)qrand()/RAND_MAX;
+}
+
+static StelProjector* createProjector(int type, StelProjector::ModelViewTranformP modelView)
+{
+	switch (type)
+	{
+		case StelProjectionPerspective:
+			return new StelProjectorPerspective(modelView);
+		case StelProjectionEqualArea:
+			return new StelProjectorEqualArea(modelView);
+		case StelProjectionStereographic:
+			return new StelProjectorStereographic(modelView);
+		case StelProjectionFisheye:
+			return new StelProjectorFisheye(modelView);
+		case StelProjectionHammer:
+			return new StelProjectorHammer(modelView);
+		case StelProjectionCylinder:
+			return new StelProjectorCylinder(modelView);
+		case StelProjectionMercator:
+			return new StelProjectorMercator(modelView);
+		case StelProjectionOrthographic:
+			return new StelProjectorOrthographic(modelView);
+		case StelProjectionSinusoidal:
+			return new StelProjectorSinusoidal(modelView);
+		case StelProjectionMiller:
+			return new StelProjectorMiller(modelView);
+	}
+	return NULL;
+}
+
+void TestStelProjectorKernels::initTestCase()
+{
+	qsrand(42);
+	// An orthogonal model view matrix, like the ones of StelCore
+	const double a = 0.3, b = 1.1;
+	const double m[16] = { std::cos(a), std::sin(a)*std::cos(b), std::sin(a)*std::sin(b), 0.,
+			      -std::sin(a), std::cos(a)*std::cos(b), std::cos(a)*std::sin(b), 0.,
+			       0., -std::sin(b), std::cos(b), 0.,
+			       0., 0., 0., 1.};
+	for (int i=0;i<16;++i)
+		params.modelView[i] = m[i];
+	params.widthStretch = 1.2f;
+	params.viewportCenter[0] = 512.f;
+	params.viewportCenter[1] = 384.f;
+	params.flipHorz = 1.f;
+	params.flipVert = -1.f;
+	params.pixelPerRad = 400.f;
+	params.zNear = 0.01f;
+	params.oneOverZNearMinusZFar = 1.f/(0.01f-500.f);
+
+	// Random directions of random lengths, away from the poles of the eye frame where
+	// the cylindrical projections are ill-conditioned
+	x.resize(NB_VECTORS);
+	y.resize(NB_VECTORS);
+	z.resize(NB_VECTORS);
+	for (int i=0;i<NB_VECTORS;++i)
+	{
+		const double u = 0.99*(2.*randomDouble()-1.);
+		const double t = 2.*M_PI*randomDouble();
+		const double r = 1.+3.*randomDouble();
+		const double s = std::sqrt(1.-u*u);
+		const double ex = r*s*std::cos(t);
+		const double ey = r*u;
+		const double ez = r*s*std::sin(t);
+		// Back to the current frame, the matrix is orthogonal
+		x[i] = m[0]*ex + m[1]*ey + m[2]*ez;
+		y[i] = m[4]*ex + m[5]*ey + m[6]*ez;
+		z[i] = m[8]*ex + m[9]*ey + m[10]*ez;
+	}
+}
+
+void TestStelProjectorKernels::testKernels_data()
+{
+	QTest::addColumn<int>("type");
+	QTest::addColumn<int>("kernel");
+	for (int type=StelProjectionPerspective; type<=StelProjectionMiller; ++type)
+	{
+		for (int kernel=StelProjectionKernelSSE2; kernel<=StelProjectionKernelAVX2; ++kernel)
+			QTest::newRow(qPrintable(QString("%1 %2").arg(projectionNames[type]).arg(kernelNames[kernel]))) << type << kernel;
+	}
+}
+
+void TestStelProjectorKernels::testKernels()
+{
+	QFETCH(int, type);
+	QFETCH(int, kernel);
+	if (!isProjectionKernelSupported((StelProjectionKernel)kernel))
+		QSKIP("Not supported by this CPU");
+
+	params.type = (StelProjectionType)type;
+	QVector<float> ex(NB_VECTORS), ey(NB_VECTORS), ez(NB_VECTORS);
+	QVector<float> wx(NB_VECTORS), wy(NB_VECTORS), wz(NB_VECTORS);
+	projectBatch(StelProjectionKernelScalar, params, NB_VECTORS, x.constData(), y.constData(), z.constData(), ex.data(), ey.data(), ez.data());
+	projectBatch((StelProjectionKernel)kernel, params, NB_VECTORS, x.constData(), y.constData(), z.constData(), wx.data(), wy.data(), wz.data());
+	for (int i=0;i<NB_VECTORS;++i)
+	{
+		// Relative to the distance to the center of the viewport, the vectorized atan2() and log() are not exact
+		const float tolX = 1e-4f*(1.f+std::fabs(ex[i]-params.viewportCenter[0]));
+		const float tolY = 1e-4f*(1.f+std::fabs(ey[i]-params.viewportCenter[1]));
+		QVERIFY2(std::fabs(wx[i]-ex[i])<=tolX, qPrintable(QString("x %1: %2 instead of %3").arg(i).arg(wx[i]).arg(ex[i])));
+		QVERIFY2(std::fabs(wy[i]-ey[i])<=tolY, qPrintable(QString("y %1: %2 instead of %3").arg(i).arg(wy[i]).arg(ey[i])));
+		QVERIFY2(std::fabs(wz[i]-ez[i])<=1e-5f*(1e-3f+std::fabs(ez[i])), qPrintable(QString("z %1: %2 instead of %3").arg(i).arg(wz[i]).arg(ez[i])));
+	}
+}
+
+void TestStelProjectorKernels::testRoundTrip_data()
+{
+	QTest::addColumn<int>("type");
+	QTest::addColumn<int>("kernel");
+	for (int type=StelProjectionPerspective; type<=StelProjectionMiller; ++type)
+	{
+		for (int kernel=StelProjectionKernelScalar; kernel<=StelProjectionKernelAVX2; ++kernel)
+			QTest::newRow(qPrintable(QString("%1 %2").arg(projectionNames[type]).arg(kernelNames[kernel]))) << type << kernel;
+	}
+}
+
+void TestStelProjectorKernels::testRoundTrip()
+{
+	QFETCH(int, type);
+	QFETCH(int, kernel);
+	if (!isProjectionKernelSupported((StelProjectionKernel)kernel))
+		QSKIP("Not supported by this CPU");
+
+	params.type = (StelProjectionType)type;
+	QVector<float> wx(NB_VECTORS), wy(NB_VECTORS), wz(NB_VECTORS);
+	projectBatch((StelProjectionKernel)kernel, params, NB_VECTORS, x.constData(), y.constData(), z.constData(), wx.data(), wy.data(), wz.data());
+	QVector<double> dx(NB_VECTORS), dy(NB_VECTORS), ux(NB_VECTORS), uy(NB_VECTORS), uz(NB_VECTORS);
+	for (int i=0;i<NB_VECTORS;++i)
+	{
+		dx[i] = wx[i];
+		dy[i] = wy[i];
+	}
+	unProjectBatch((StelProjectionKernel)kernel, params, NB_VECTORS, dx.constData(), dy.constData(), ux.data(), uy.data(), uz.data());
+
+	int nbChecked = 0;
+	for (int i=0;i<NB_VECTORS;++i)
+	{
+		// The perspective and orthographic projections only map one hemisphere
+		const double ez = params.modelView[2]*x[i] + params.modelView[6]*y[i] + params.modelView[10]*z[i];
+		if ((type==StelProjectionPerspective || type==StelProjectionOrthographic) && ez>=0.)
+			continue;
+		// The projection of the antipode of the view direction is singular
+		const double r = std::sqrt(x[i]*x[i] + y[i]*y[i] + z[i]*z[i]);
+		if ((type==StelProjectionStereographic || type==StelProjectionEqualArea || type==StelProjectionFisheye) && ez/r>0.99)
+			continue;
+		++nbChecked;
+		const double err = std::fabs(ux[i]-x[i]/r) + std::fabs(uy[i]-y[i]/r) + std::fabs(uz[i]-z[i]/r);
+		QVERIFY2(err<1e-3, qPrintable(QString("vector %1: error %2").arg(i).arg(err)));
+	}
+	QVERIFY(nbChecked>NB_VECTORS/3);
+}
+
+void TestStelProjectorKernels::testProjector_data()
+{
+	QTest::addColumn<int>("type");
+	for (int type=StelProjectionPerspective; type<=StelProjectionMiller; ++type)
+		QTest::newRow(projectionNames[type]) << type;
+}
+
+void TestStelProjectorKernels::testProjector()
+{
+	QFETCH(int, type);
+
+	StelProjector::StelProjectorParams projectorParams;
+	projectorParams.viewportXywh.set(0, 0, 1024, 768);
+	projectorParams.fov = 100.f;
+	projectorParams.zNear = 0.01f;
+	projectorParams.zFar = 500.f;
+	projectorParams.viewportCenter.set(512.f, 384.f);
+	projectorParams.viewportFovDiameter = 768.f;
+	projectorParams.flipVert = true;
+	projectorParams.widthStretch = 1.2f;
+	StelProjector::ModelViewTranformP modelView(new StelProjector::Mat4dTransform(Mat4d(params.modelView)));
+	QScopedPointer<StelProjector> prj(createProjector(type, modelView));
+	QVERIFY(prj);
+	prj->init(projectorParams);
+
+	// Check that the batched path is taken
+	StelProjectionParams prjParams;
+	QVERIFY(prj->getProjectionParams(prjParams));
+	QCOMPARE((int)prjParams.type, type);
+
+	QVector<Vec3d> in(NB_VECTORS);
+	for (int i=0;i<NB_VECTORS;++i)
+		in[i].set(x[i], y[i], z[i]);
+	QVector<Vec3f> out(NB_VECTORS);
+	prj->project(NB_VECTORS, in.constData(), out.data());
+
+	// Compare with the forward() of the projector, one vector at a time
+	Vec3d win;
+	for (int i=0;i<NB_VECTORS;++i)
+	{
+		prj->project(in[i], win);
+		const double tolX = 1e-4*(1.+std::fabs(win[0]-projectorParams.viewportCenter[0]));
+		const double tolY = 1e-4*(1.+std::fabs(win[1]-projectorParams.viewportCenter[1]));
+		QVERIFY2(std::fabs(out[i][0]-win[0])<=tolX, qPrintable(QString("x %1: %2 instead of %3").arg(i).arg(out[i][0]).arg(win[0])));
+		QVERIFY2(std::fabs(out[i][1]-win[1])<=tolY, qPrintable(QString("y %1: %2 instead of %3").arg(i).arg(out[i][1]).arg(win[1])));
+		QVERIFY2(std::fabs(out[i][2]-win[2])<=1e-5*(1e-3+std::fabs(win[2])), qPrintable(QString("z %1: %2 instead of %3").arg(i).arg(out[i][2]).arg(win[2])));
+	}
+}
+
+void TestStelProjectorKernels::benchmark_data()
+{
+	QTest::addColumn<int>("type");
+	QTest::addColumn<int>("kernel");
+	QTest::addColumn<int>("count");
+	static const int types[] = {StelProjectionStereographic, StelProjectionHammer};
+	for (int t=0;t<2;++t)
+	{
+		for (int kernel=StelProjectionKernelScalar; kernel<=StelProjectionKernelAVX2; ++kernel)
+		{
+			for (int count=1000; count<=10000000; count*=100)
+				QTest::newRow(qPrintable(QString("%1 %2 %3").arg(projectionNames[types[t]]).arg(kernelNames[kernel]).arg(count))) << types[t] << kernel << count;
+		}
+	}
+}
+
+void TestStelProjectorKernels::benchmark()
+{
+	QFETCH(int, type);
+	QFETCH(int, kernel);
+	QFETCH(int, count);
+	if (!isProjectionKernelSupported((StelProjectionKernel)kernel))
+		QSKIP("Not supported by this CPU");
+
+	params.type = (StelProjectionType)type;
+	// Large counts reuse the same buffers, like the successive draw calls of a frame
+	const int n = qMin(count, NB_VECTORS);
+	QVector<float> wx(n), wy(n), wz(n);
+	QBENCHMARK {
+		for (int done=0; done<count; done+=n)
+			projectBatch((StelProjectionKernel)kernel, params, n, x.constData(), y.constData(), z.constData(), wx.data(), wy.data(), wz.data());
+	}
+}
@@ -0,0 +1,47 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTSTELPROJECTORKERNELS_HPP_
+#define _TESTSTELPROJECTORKERNELS_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+#include "StelProjectorKernels.hpp"
+
+class TestStelProjectorKernels : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testKernels_data();
+	void testKernels();
+	void testRoundTrip_data();
+	void testRoundTrip();
+	void testProjector_data();
+	void testProjector();
+	void benchmark_data();
+	void benchmark();
+private:
+	StelProjectionParams params;
+	QVector<double> x, y, z;
+};
+
+#endif // _TESTSTELPROJECTORKERNELS_HPP_
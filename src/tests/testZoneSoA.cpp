@@ -0,0 +1,259 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QObject>
+#include <QtDebug>
+#include <QtTest>
+
+#include "tests/testZoneSoA.hpp"
+
+#include <cstring>
+
+QTEST_GUILESS_MAIN(TestZoneSoA)
+
+#define NB_STARS 20000
+
+// Pack a star in the Star2 binary format, see the layout in Star.hpp
+static Star2 makeStar2(int x0, int x1, int dx0, int dx1, int bV, int mag)
+{
+	quint8 d[10];
+	d[0] = x0 & 0xFF;
+	d[1] = (x0>>8) & 0xFF;
+	d[2] = ((x0>>16) & 0xF) | ((x1 & 0xF)<<4);
+	d[3] = (x1>>4) & 0xFF;
+	d[4] = (x1>>12) & 0xFF;
+	d[5] = dx0 & 0xFF;
+	d[6] = ((dx0>>8) & 0x3F) | ((dx1 & 0x3)<<6);
+	d[7] = (dx1>>2) & 0xFF;
+	d[8] = ((dx1>>10) & 0xF) | ((bV & 0xF)<<4);
+	d[9] = ((bV>>4) & 0x7) | ((mag & 0x1F)<<3);
+	Star2 s;
+	memcpy(&s, d, sizeof(d));
+	return s;
+}
+
+static int randomInt(int range)
+{
+	return qrand()%(2*range+1)-range;
+}
+
+void TestZoneSoA::initTestCase()
+{
+	qsrand(42);
+	// Stars are sorted by magnitude in the catalogs
+	for (int i=0;i<NB_STARS;++i)
+		stars.append(makeStar2(randomInt(Star2::MaxPosVal), randomInt(Star2::MaxPosVal), randomInt(8000), randomInt(8000), qrand()%128, i*32/NB_STARS));
+
+	// A zone of about 35 degrees, with axes scaled like in ZoneArray::scaleAxis()
+	const float scale = 0.3f/Star2::MaxPosVal;
+	zone.center.set(0.6f, 0.f, 0.8f);
+	zone.axis0.set(0.f, scale, 0.f);
+	zone.axis1.set(-0.8f*scale, 0.f, 0.6f*scale);
+	zone.size = stars.size();
+	zone.stars = stars.data();
+
+	buildZoneSoA(&zone, soa);
+
+	// Two caps cutting through the zone
+	caps << 0. << 1. << 0. << -0.05;
+	caps << 1. << 0. << 0. << 0.55;
+
+	params.center = zone.center;
+	params.axis0 = zone.axis0;
+	params.axis1 = zone.axis1;
+	params.movementFactor = 3.5f;
+	params.cutoffMagStep = 25;
+	params.checkCaps = true;
+	params.nbCaps = caps.size()/4;
+	params.caps = caps.constData();
+	params.withExtinction = true;
+	// A rotation about the y axis
+	const double a = 0.7;
+	params.altAzRow[0] = -std::sin(a);
+	params.altAzRow[1] = 0.;
+	params.altAzRow[2] = std::cos(a);
+	params.altAzRow[3] = 0.;
+	params.extinctionCoefficient = 0.2f;
+	params.undergroundExtinctionMode = 0;
+	params.k = 0.25f;
+}
+
+void TestZoneSoA::testDecoding()
+{
+	QCOMPARE(soa.size, stars.size());
+	for (int i=0;i<stars.size();++i)
+	{
+		QCOMPARE(soa.x0[i], (float)stars[i].getX0());
+		QCOMPARE(soa.x1[i], (float)stars[i].getX1());
+		QCOMPARE(soa.dx0[i], (float)stars[i].getDx0());
+		QCOMPARE(soa.dx1[i], (float)stars[i].getDx1());
+		QCOMPARE((int)soa.mag[i], stars[i].getMag());
+		QCOMPARE((int)soa.bV[i], stars[i].getBVIndex());
+	}
+	QCOMPARE(stars[0].getMag(), 0);
+	QCOMPARE(stars[NB_STARS-1].getMag(), 31);
+}
+
+int TestZoneSoA::cullPacked(ZoneSoACullResult& result) const
+{
+	Extinction extinction;
+	extinction.setExtinctionCoefficient(params.extinctionCoefficient);
+	extinction.setUndergroundExtinctionMode(Extinction::UndergroundExtinctionZero);
+	int nb = 0;
+	const Star2* lastStar = zone.getStars() + zone.size;
+	for (const Star2* s=zone.getStars();s<lastStar;++s)
+	{
+		if (s->getMag() > params.cutoffMagStep)
+			break;
+		Vec3f vf;
+		s->getJ2000Pos(&zone, params.movementFactor, vf);
+		vf.normalize();
+		bool isVisible = true;
+		for (int c=0;c<caps.size();c+=4)
+		{
+			if (vf[0]*caps[c]+vf[1]*caps[c+1]+vf[2]*caps[c+2]<caps[c+3])
+				isVisible = false;
+		}
+		if (!isVisible)
+			continue;
+
+		Vec3f altAz(vf);
+		altAz.normalize();
+		const float cosZ = params.altAzRow[0]*altAz[0] + params.altAzRow[1]*altAz[1] + params.altAzRow[2]*altAz[2] + params.altAzRow[3];
+		float extMagShift = 0.f;
+		extinction.forward(Vec3f(std::sqrt(1.f-cosZ*cosZ), 0.f, cosZ), &extMagShift);
+		const int extinctedMagIndex = s->getMag() + (int)(extMagShift/params.k);
+		if (extinctedMagIndex >= params.cutoffMagStep)
+			continue;
+
+		result.index[nb] = s-zone.getStars();
+		result.x[nb] = vf[0];
+		result.y[nb] = vf[1];
+		result.z[nb] = vf[2];
+		result.magIndex[nb] = extinctedMagIndex;
+		result.twinkleFactor[nb] = qMin(1.0f, 1.0f-0.9f*cosZ);
+		++nb;
+	}
+	return nb;
+}
+
+bool TestZoneSoA::isNearEdge(int index) const
+{
+	Vec3f vf;
+	stars[index].getJ2000Pos(&zone, params.movementFactor, vf);
+	vf.normalize();
+	for (int c=0;c<caps.size();c+=4)
+	{
+		if (std::fabs(vf[0]*caps[c]+vf[1]*caps[c+1]+vf[2]*caps[c+2]-caps[c+3])<1e-5)
+			return true;
+	}
+	Extinction extinction;
+	extinction.setExtinctionCoefficient(params.extinctionCoefficient);
+	extinction.setUndergroundExtinctionMode(Extinction::UndergroundExtinctionZero);
+	const float cosZ = params.altAzRow[0]*vf[0] + params.altAzRow[1]*vf[1] + params.altAzRow[2]*vf[2] + params.altAzRow[3];
+	float extMagShift = 0.f;
+	extinction.forward(Vec3f(std::sqrt(1.f-cosZ*cosZ), 0.f, cosZ), &extMagShift);
+	const float step = extMagShift/params.k;
+	return std::fabs(step-std::floor(step+0.5f))<1e-4f;
+}
+
+void TestZoneSoA::testKernels_data()
+{
+	QTest::addColumn<int>("kernel");
+	QTest::newRow("Scalar") << (int)ZoneSoAKernelScalar;
+	QTest::newRow("SSE2") << (int)ZoneSoAKernelSSE2;
+	QTest::newRow("AVX2") << (int)ZoneSoAKernelAVX2;
+}
+
+void TestZoneSoA::testKernels()
+{
+	QFETCH(int, kernel);
+	if (!isZoneSoAKernelSupported((ZoneSoAKernel)kernel))
+		QSKIP("Not supported by this CPU");
+
+	ZoneSoACullResult expected, result;
+	expected.resize(soa.size);
+	result.resize(soa.size);
+	const int nbExpected = cullPacked(expected);
+	const int nb = cullZoneSoA((ZoneSoAKernel)kernel, soa, params, result);
+	// Make sure that all the tests are actually exercised
+	QVERIFY(nbExpected>NB_STARS/10);
+	QVERIFY(nbExpected<NB_STARS/2);
+
+	// The kernels compute in float what the packed path computes partly in double, so the
+	// stars on the edges of the caps or of the magnitude steps may be culled differently.
+	int i = 0, j = 0, nbNearEdge = 0;
+	while (i<nb || j<nbExpected)
+	{
+		if (j==nbExpected || (i<nb && result.index[i]<expected.index[j]))
+		{
+			QVERIFY(isNearEdge(result.index[i]));
+			++nbNearEdge;
+			++i;
+			continue;
+		}
+		if (i==nb || expected.index[j]<result.index[i])
+		{
+			QVERIFY(isNearEdge(expected.index[j]));
+			++nbNearEdge;
+			++j;
+			continue;
+		}
+		QVERIFY(std::fabs(result.x[i]-expected.x[j])<1e-6f);
+		QVERIFY(std::fabs(result.y[i]-expected.y[j])<1e-6f);
+		QVERIFY(std::fabs(result.z[i]-expected.z[j])<1e-6f);
+		if (result.magIndex[i]!=expected.magIndex[j])
+		{
+			QVERIFY(isNearEdge(result.index[i]));
+			QVERIFY(qAbs(result.magIndex[i]-expected.magIndex[j])<=1);
+			++nbNearEdge;
+		}
+		QVERIFY(std::fabs(result.twinkleFactor[i]-expected.twinkleFactor[j])<1e-5f);
+		++i;
+		++j;
+	}
+	QVERIFY(nbNearEdge<NB_STARS/1000);
+}
+
+void TestZoneSoA::benchmarkPacked()
+{
+	ZoneSoACullResult result;
+	result.resize(soa.size);
+	QBENCHMARK {
+		cullPacked(result);
+	}
+}
+
+void TestZoneSoA::benchmarkSoA_data()
+{
+	testKernels_data();
+}
+
+void TestZoneSoA::benchmarkSoA()
+{
+	QFETCH(int, kernel);
+	if (!isZoneSoAKernelSupported((ZoneSoAKernel)kernel))
+		QSKIP("Not supported by this CPU");
+
+	ZoneSoACullResult result;
+	result.resize(soa.size);
+	QBENCHMARK {
+		cullZoneSoA((ZoneSoAKernel)kernel, soa, params, result);
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTZONESOA_HPP_
+#define _TESTZONESOA_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+#include "RefractionExtinction.hpp"
+#include "Star.hpp"
+#include "ZoneSoA.hpp"
+
+class TestZoneSoA : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testDecoding();
+	void testKernels_data();
+	void testKernels();
+	void benchmarkPacked();
+	void benchmarkSoA_data();
+	void benchmarkSoA();
+private:
+	//! Cull the packed stars like SpecialZoneArray::draw does.
+	int cullPacked(ZoneSoACullResult& result) const;
+	//! Whether a star is so close to the edge of a cap or to a magnitude step that the
+	//! rounding errors of the float kernels can change its culling or its magnitude index.
+	bool isNearEdge(int index) const;
+
+	QVector<Star2> stars;
+	SpecialZoneData<Star2> zone;
+	ZoneSoA soa;
+	ZoneSoACullParams params;
+	QVector<double> caps;
+};
+
+#endif // _TESTZONESOA_HPP_